@@ -0,0 +1,166 @@
+/**
+ * @file ArmKinematics.h
+ * @brief Modelo geométrico (IK de forma fechada e FK) parametrizado pelo modelo do braço (ArmModel.h).
+ *
+ * Elos, pose neutra e índices das juntas vêm do tipo Arm como constantes de compilação; os limites
+ * de software são passados por quem chama. InverseKinematics usa ArmKinematics<ActiveArm>;
+ * host/arm_models.cpp instancia as duas variantes.
+ */
+#ifndef ARM_KINEMATICS_H
+#define ARM_KINEMATICS_H
+
+#include "Config.h"
+#include "FastMath.h"
+
+#include <math.h>
+
+template <class Arm>
+struct ArmKinematics
+{
+    static constexpr ArmKinematicsConfig LINKS = Arm::kinematics();
+    static constexpr NeutralPose NEUTRAL = Arm::neutral();
+
+    /**
+     * @brief IK de um ramo do cotovelo: elbowSign = +1 é o ramo de acos (o de solveXYZ), -1 o espelhado.
+     * @param lo, hi Limites de software por junta (graus).
+     * @param inexact [out] O alcance foi cortado ou algum ângulo limitado (a ponta não chega ao ponto).
+     * @param mirrorable [out] O outro ramo é distinto (cotovelo nem esticado nem todo dobrado).
+     * @return false para alvo degenerado (na origem do ombro) ou resultado não finito.
+     */
+    static bool solveBranch(float x, float y, float z, float elbowSign, const int lo[Arm::JOINTS],
+                            const int hi[Arm::JOINTS], float angles[Arm::JOINTS], bool &inexact, bool &mirrorable)
+    {
+        inexact = false;
+        mirrorable = false;
+        const float planar = sqrtf((x * x) + (y * y));
+        const float baseAngleDeg = radToDeg(KinMath::atan2(y, x)) + NEUTRAL.base;
+        angles[Arm::BASE] = clampTracked(baseAngleDeg, lo, hi, Arm::BASE, inexact);
+
+        const float elevation = z - LINKS.baseHeightMm;
+        const float rawDistance = sqrtf((planar * planar) + (elevation * elevation));
+        if (rawDistance < 1e-3f)
+        {
+            return false;
+        }
+
+        const float wristExtension = LINKS.wristOffsetMm + LINKS.gripperLenMm;
+
+        float clippedDistance = clampf(rawDistance, LINKS.minReachMm, LINKS.maxReachMm);
+        if (clippedDistance <= wristExtension + 5.0f)
+        {
+            clippedDistance = wristExtension + 5.0f;
+        }
+
+        float wristDistance = clippedDistance - wristExtension;
+        if (wristDistance < 5.0f)
+        {
+            wristDistance = 5.0f;
+        }
+
+        inexact = inexact || (wristDistance + wristExtension) != rawDistance;
+
+        const float scale = wristDistance / rawDistance;
+        const float effPlanar = planar * scale;
+        const float effElevation = elevation * scale;
+
+        const float L1 = LINKS.upperLenMm;
+        const float L2 = LINKS.forearmLenMm;
+
+        float cosElbow = ((effPlanar * effPlanar) + (effElevation * effElevation) - (L1 * L1) - (L2 * L2)) / (2.0f * L1 * L2);
+        cosElbow = clampf(cosElbow, -1.0f, 1.0f);
+        mirrorable = cosElbow > -1.0f && cosElbow < 1.0f;
+        const float elbowRad = elbowSign * KinMath::acos(cosElbow);
+        float sinElbow, cosElbowRad;
+        KinMath::sinCos(elbowRad, sinElbow, cosElbowRad);
+
+        const float shoulderRad = KinMath::atan2(effElevation, effPlanar) - KinMath::atan2(L2 * sinElbow, L1 + (L2 * cosElbowRad));
+        if (!isFinite(shoulderRad) || !isFinite(elbowRad))
+        {
+            return false;
+        }
+
+        float targetPitchRad = KinMath::atan2(elevation, planar);
+        if (!isFinite(targetPitchRad))
+        {
+            targetPitchRad = 0.0f;
+        }
+        const float wristPitchRad = targetPitchRad - (shoulderRad + elbowRad);
+
+        angles[Arm::SHOULDER] = clampTracked(radToDeg(shoulderRad) + NEUTRAL.shoulder, lo, hi, Arm::SHOULDER, inexact);
+        angles[Arm::SHOULDER_MIRROR] = angles[Arm::SHOULDER];
+        inexact = inexact || angles[Arm::SHOULDER_MIRROR] < lo[Arm::SHOULDER_MIRROR] ||
+                  angles[Arm::SHOULDER_MIRROR] > hi[Arm::SHOULDER_MIRROR];
+        angles[Arm::ELBOW] = clampTracked(radToDeg(elbowRad) + NEUTRAL.elbow, lo, hi, Arm::ELBOW, inexact);
+        angles[Arm::HAND] = clampTracked(radToDeg(wristPitchRad) + NEUTRAL.hand, lo, hi, Arm::HAND, inexact);
+
+        const float wristRotateDeg = NEUTRAL.wristRotate + (baseAngleDeg - NEUTRAL.base);
+        angles[Arm::WRIST_ROTATE] = clampTracked(wristRotateDeg, lo, hi, Arm::WRIST_ROTATE, inexact);
+        angles[Arm::GRIPPER] = clampf(NEUTRAL.gripper, lo[Arm::GRIPPER], hi[Arm::GRIPPER]);
+
+        return true;
+    }
+
+    /**
+     * @brief FK: posição XYZ (mm) da ponta da garra para os ângulos lógicos dados.
+     * @return false se algum eixo não for finito.
+     */
+    static bool forward(const float angles[Arm::JOINTS], float &x, float &y, float &z)
+    {
+        const float baseRad = degToRad(angles[Arm::BASE] - NEUTRAL.base);
+        const float shoulderRad = degToRad(angles[Arm::SHOULDER] - NEUTRAL.shoulder);
+        const float elbowRad = degToRad(angles[Arm::ELBOW] - NEUTRAL.elbow);
+        const float wristRad = degToRad(angles[Arm::HAND] - NEUTRAL.hand);
+
+        const float L1 = LINKS.upperLenMm;
+        const float L2 = LINKS.forearmLenMm;
+        const float wristExtension = LINKS.wristOffsetMm + LINKS.gripperLenMm;
+
+        const float joint2 = shoulderRad;
+        const float joint3 = shoulderRad + elbowRad;
+        const float joint4 = joint3 + wristRad;
+
+        float sin2, cos2, sin3, cos3, sin4, cos4, sinBase, cosBase;
+        KinMath::sinCos(joint2, sin2, cos2);
+        KinMath::sinCos(joint3, sin3, cos3);
+        KinMath::sinCos(joint4, sin4, cos4);
+        KinMath::sinCos(baseRad, sinBase, cosBase);
+
+        const float planarReach = (cos2 * L1) + (cos3 * L2) + (cos4 * wristExtension);
+        const float verticalOffset = (sin2 * L1) + (sin3 * L2) + (sin4 * wristExtension);
+
+        x = planarReach * cosBase;
+        y = planarReach * sinBase;
+        z = LINKS.baseHeightMm + verticalOffset;
+
+        return isFinite(x) && isFinite(y) && isFinite(z);
+    }
+
+private:
+    static float clampf(float value, float minValue, float maxValue)
+    {
+        if (value < minValue)
+            return minValue;
+        if (value > maxValue)
+            return maxValue;
+        return value;
+    }
+
+    static float clampTracked(float value, const int lo[Arm::JOINTS], const int hi[Arm::JOINTS], int idx, bool &limited)
+    {
+        const float clamped = clampf(value, static_cast<float>(lo[idx]), static_cast<float>(hi[idx]));
+        limited = limited || clamped != value;
+        return clamped;
+    }
+
+    static float radToDeg(float rad) { return rad * (180.0f / PI); }
+    static float degToRad(float deg) { return deg * (PI / 180.0f); }
+    static bool isFinite(float value) { return !isnan(value) && !isinf(value); }
+};
+
+// Definições dos membros constexpr (exigidas pelo C++11 quando usados por referência)
+template <class Arm>
+constexpr ArmKinematicsConfig ArmKinematics<Arm>::LINKS;
+template <class Arm>
+constexpr NeutralPose ArmKinematics<Arm>::NEUTRAL;
+
+#endif // ARM_KINEMATICS_H
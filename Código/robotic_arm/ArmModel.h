@@ -0,0 +1,152 @@
+/**
+ * @file ArmModel.h
+ * @brief Modelos físicos do braço (traits): número de juntas, juntas acopladas, elos, limites, faixas de
+ * pulso dos servos e pose neutra.
+ *
+ * Cada variante é um tipo com membros constexpr; o firmware usa o modelo escolhido por ARM_MODEL
+ * (Config.h, typedef ActiveArm) e os templates de ArmKinematics.h e das estruturas da EEPROM são
+ * parametrizados por ele. O build de host compila e verifica as duas variantes (host/arm_models.cpp).
+ */
+#ifndef ARM_MODEL_H
+#define ARM_MODEL_H
+
+#include <stdint.h>
+
+struct ArmKinematicsConfig
+{
+  float baseHeightMm;
+  float upperLenMm;
+  float forearmLenMm;
+  float wristOffsetMm;
+  float gripperLenMm;
+  float minReachMm;
+  float maxReachMm;
+};
+
+struct NeutralPose
+{
+  int base;
+  int shoulder;
+  int elbow;
+  int hand;
+  int wristRotate;
+  int gripper;
+};
+
+/**
+ * @brief Dados de uma junta: pino do ESP32, limites seguros de fábrica e ângulo de repouso (graus).
+ */
+struct JointSpec
+{
+  uint8_t pin;
+  uint8_t safeMin;
+  uint8_t safeMax;
+  uint8_t home;
+};
+
+// Tabelas por junta (const em escopo de namespace: cada unidade de compilação tem a sua cópia na flash)
+constexpr JointSpec ARM_MK1_JOINTS[7] = {
+    {18, 0, 180, 90},   // Base
+    {4, 95, 180, 130},  // Ombro1
+    {13, 95, 180, 130}, // Ombro2 (acompanha o Ombro1)
+    {27, 50, 180, 100}, // Cotovelo
+    {26, 0, 180, 70},   // Mão
+    {33, 60, 180, 120}, // Pulso
+    {32, 55, 155, 100}  // Garra
+};
+
+// Faixa de pulso (µs) de cada servo, correspondente a 0° e 180° (após o offset). Os padrões são os
+// mesmos da ESP32Servo, preservando calibrações existentes; com writeMicroseconds, cada µs é ~0.1°.
+constexpr uint16_t ARM_MK1_PULSE_MIN_US[7] = {544, 544, 544, 544, 544, 544, 544};
+constexpr uint16_t ARM_MK1_PULSE_MAX_US[7] = {2400, 2400, 2400, 2400, 2400, 2400, 2400};
+
+// Limites dinâmicos (perfis trapezoidal e curva S): o punho (4, 5) e a garra (6) são mais fracos
+constexpr float ARM_MK1_MAX_VELOCITY[7] = {60, 45, 45, 60, 45, 45, 60};     // graus/s
+constexpr float ARM_MK1_MAX_ACCEL[7] = {180, 120, 120, 180, 120, 120, 150}; // graus/s²
+constexpr float ARM_MK1_MAX_JERK[7] = {900, 600, 600, 900, 600, 600, 750};  // graus/s³
+
+constexpr JointSpec ARM_MK2_JOINTS[7] = {
+    {19, 0, 180, 90},   // Base
+    {21, 90, 180, 125}, // Ombro1
+    {22, 90, 180, 125}, // Ombro2 (acompanha o Ombro1)
+    {23, 45, 180, 95},  // Cotovelo
+    {25, 0, 180, 70},   // Mão
+    {14, 30, 150, 90},  // Pulso
+    {16, 50, 150, 100}  // Garra
+};
+
+// Mesmos servos do Mk1; ficam separados para serem medidos e ajustados nesta montagem
+constexpr uint16_t ARM_MK2_PULSE_MIN_US[7] = {544, 544, 544, 544, 544, 544, 544};
+constexpr uint16_t ARM_MK2_PULSE_MAX_US[7] = {2400, 2400, 2400, 2400, 2400, 2400, 2400};
+
+constexpr float ARM_MK2_MAX_VELOCITY[7] = {60, 45, 45, 60, 45, 45, 60};     // graus/s
+constexpr float ARM_MK2_MAX_ACCEL[7] = {180, 120, 120, 180, 120, 120, 150}; // graus/s²
+constexpr float ARM_MK2_MAX_JERK[7] = {900, 600, 600, 900, 600, 600, 750};  // graus/s³
+
+/**
+ * @brief Braço original: 7 servos, ombro duplo (servo 2 repete o 1), antebraço de 130 mm.
+ */
+struct ArmModelMk1
+{
+  static constexpr int JOINTS = 7;
+  static constexpr int BASE = 0;
+  static constexpr int SHOULDER = 1;
+  static constexpr int SHOULDER_MIRROR = 2; // Acoplada: recebe sempre o ângulo de SHOULDER
+  static constexpr int ELBOW = 3;
+  static constexpr int HAND = 4;
+  static constexpr int WRIST_ROTATE = 5;
+  static constexpr int GRIPPER = 6;
+
+  static constexpr ArmKinematicsConfig kinematics()
+  {
+    // baseHeight, upper, forearm, wristOffset, gripper, minReach, maxReach (mm)
+    return {100.0f, 120.0f, 130.0f, 40.0f, 50.0f, 80.0f, 330.0f};
+  }
+
+  static constexpr NeutralPose neutral()
+  {
+    // base, shoulder, elbow, hand, wristRotate, gripper
+    return {90, 130, 100, 70, 120, 100};
+  }
+
+  static constexpr JointSpec joint(int idx) { return ARM_MK1_JOINTS[idx]; }
+  static constexpr const uint16_t *pulseMinUs() { return ARM_MK1_PULSE_MIN_US; }
+  static constexpr const uint16_t *pulseMaxUs() { return ARM_MK1_PULSE_MAX_US; }
+  static constexpr const float *maxVelocity() { return ARM_MK1_MAX_VELOCITY; }
+  static constexpr const float *maxAccel() { return ARM_MK1_MAX_ACCEL; }
+  static constexpr const float *maxJerk() { return ARM_MK1_MAX_JERK; }
+};
+
+/**
+ * @brief Segunda variante: mesma topologia, base mais baixa, antebraço de 150 mm e outra pinagem.
+ */
+struct ArmModelMk2
+{
+  static constexpr int JOINTS = 7;
+  static constexpr int BASE = 0;
+  static constexpr int SHOULDER = 1;
+  static constexpr int SHOULDER_MIRROR = 2;
+  static constexpr int ELBOW = 3;
+  static constexpr int HAND = 4;
+  static constexpr int WRIST_ROTATE = 5;
+  static constexpr int GRIPPER = 6;
+
+  static constexpr ArmKinematicsConfig kinematics()
+  {
+    return {85.0f, 120.0f, 150.0f, 40.0f, 50.0f, 80.0f, 350.0f};
+  }
+
+  static constexpr NeutralPose neutral()
+  {
+    return {90, 125, 95, 70, 90, 100};
+  }
+
+  static constexpr JointSpec joint(int idx) { return ARM_MK2_JOINTS[idx]; }
+  static constexpr const uint16_t *pulseMinUs() { return ARM_MK2_PULSE_MIN_US; }
+  static constexpr const uint16_t *pulseMaxUs() { return ARM_MK2_PULSE_MAX_US; }
+  static constexpr const float *maxVelocity() { return ARM_MK2_MAX_VELOCITY; }
+  static constexpr const float *maxAccel() { return ARM_MK2_MAX_ACCEL; }
+  static constexpr const float *maxJerk() { return ARM_MK2_MAX_JERK; }
+};
+
+#endif // ARM_MODEL_H
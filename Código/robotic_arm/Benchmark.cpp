@@ -0,0 +1,267 @@
+/**
+ * @file Benchmark.cpp
+ * @brief Implementação das medições do comando 'bench'.
+ * O tempo vem de micros() e os ciclos de ESP.getCycleCount() (contador de 32 bits do core:
+ * BENCH_MAX_ITERATIONS mantém cada kernel longe da volta do contador).
+ */
+#include "Benchmark.h"
+#include "MotionController.h"
+#include "InverseKinematics.h"
+#include "Workspace.h"
+#include "FastMath.h"
+#include "CommandParser.h"
+#include "CommandBus.h"
+#include "PoseManager.h"
+#include "Sequencer.h"
+
+namespace Benchmark
+{
+    static volatile float sinkF = 0.0f; // Impede que o compilador descarte os resultados
+    static volatile uint32_t sinkU = 0;
+
+    // Pontos de teste do IK: cinemática direta de poses típicas (todos alcançáveis)
+    static const int IK_POSES = 4;
+    static const float IK_POSE_ANGLES[IK_POSES][NUM_SERVOS] = {
+        {90, 130, 130, 100, 70, 120, 100},
+        {45, 110, 110, 80, 90, 90, 100},
+        {135, 150, 150, 120, 60, 100, 100},
+        {70, 100, 100, 60, 110, 60, 150}};
+
+    // Lote do IK: pontos entre as poses acima, em estrutura de arrays (estático: fora da pilha da task)
+    static const int IK_BATCH_POINTS = 32;
+    static float batchX[IK_BATCH_POINTS];
+    static float batchY[IK_BATCH_POINTS];
+    static float batchZ[IK_BATCH_POINTS];
+    static float batchJoints[NUM_SERVOS][IK_BATCH_POINTS];
+    static uint8_t batchStatus[IK_BATCH_POINTS];
+    static float dlsSeeds[IK_BATCH_POINTS][NUM_SERVOS]; // Semente do IK iterativo (pose do "tick anterior")
+    static float dlsPitch[IK_BATCH_POINTS];
+
+    // Nomes buscados no kernel de pose: as poses salvas e um nome inexistente
+    static char lookupNames[MAX_POSES + 1][POSE_NAME_LEN];
+
+    /**
+     * @brief Tempo total de 'iterations' chamadas de um kernel.
+     */
+    struct Timing
+    {
+        unsigned long elapsedUs;
+        uint32_t cycles;
+    };
+
+    /**
+     * @brief Executa fn(n) 'iterations' vezes e devolve o tempo (sem exibir nada).
+     */
+    template <typename Fn>
+    Timing timeKernel(uint32_t iterations, Fn fn)
+    {
+        const uint32_t startCycles = ESP.getCycleCount();
+        const unsigned long startUs = micros();
+        for (uint32_t n = 0; n < iterations; n++)
+        {
+            fn(n);
+        }
+        Timing timing;
+        timing.elapsedUs = micros() - startUs;
+        timing.cycles = ESP.getCycleCount() - startCycles;
+        return timing;
+    }
+
+    /**
+     * @brief Executa fn(n) 'iterations' vezes e exibe a linha do CSV.
+     * @param unitsPerCall Itens processados por fn (os tempos saem divididos por item).
+     */
+    template <typename Fn>
+    void measure(const char *kernel, uint32_t iterations, Fn fn, uint32_t unitsPerCall = 1)
+    {
+        const Timing timing = timeKernel(iterations, fn);
+        printResult(kernel, iterations * unitsPerCall, timing.elapsedUs, timing.cycles);
+    }
+
+    void printResult(const char *kernel, uint32_t calls, unsigned long elapsedUs, uint32_t cycles)
+    {
+        Serial.print(F("BENCH,"));
+        Serial.print(FIRMWARE_VERSION);
+        Serial.print(F(","));
+        Serial.print(ESP.getCpuFreqMHz());
+        Serial.print(F(","));
+        Serial.print(kernel);
+        Serial.print(F(","));
+        Serial.print(calls);
+        Serial.print(F(","));
+        Serial.print(elapsedUs * 1000.0 / calls, 1);
+        Serial.print(F(","));
+        Serial.println((uint32_t)(cycles / calls));
+    }
+
+    void printHeader()
+    {
+        Serial.println(F("BENCH,firmware,cpu_mhz,kernel,iterations,ns_per_call,cycles_per_call"));
+    }
+
+    void runComms(uint32_t iterations)
+    {
+        // --- InverseKinematics: solveXYZ ponto a ponto vs. solveBatch (mesmos pontos) ---
+        float points[IK_POSES][3];
+        for (int p = 0; p < IK_POSES; p++)
+        {
+            InverseKinematics::estimateXYZ(IK_POSE_ANGLES[p], points[p][0], points[p][1], points[p][2]);
+        }
+        const int perSegment = IK_BATCH_POINTS / IK_POSES;
+        for (int i = 0; i < IK_BATCH_POINTS; i++)
+        {
+            const float *a = points[i / perSegment];
+            const float *b = points[(i / perSegment + 1) % IK_POSES];
+            const float t = static_cast<float>(i % perSegment) / perSegment;
+            batchX[i] = a[0] + (b[0] - a[0]) * t;
+            batchY[i] = a[1] + (b[1] - a[1]) * t;
+            batchZ[i] = a[2] + (b[2] - a[2]) * t;
+        }
+        measure("ik_solve", iterations, [](uint32_t n) {
+            (void)n;
+            float angles[NUM_SERVOS];
+            for (int i = 0; i < IK_BATCH_POINTS; i++)
+            {
+                InverseKinematics::solveXYZ(batchX[i], batchY[i], batchZ[i], angles);
+                batchJoints[3][i] = angles[3];
+            }
+            sinkF = batchJoints[3][n % IK_BATCH_POINTS];
+        }, IK_BATCH_POINTS);
+
+        float *joints[NUM_SERVOS];
+        for (int j = 0; j < NUM_SERVOS; j++)
+            joints[j] = batchJoints[j];
+        measure("ik_batch", iterations, [&joints](uint32_t n) {
+            InverseKinematics::solveBatch(batchX, batchY, batchZ, IK_BATCH_POINTS, joints, batchStatus);
+            sinkF = batchJoints[3][n % IK_BATCH_POINTS];
+        }, IK_BATCH_POINTS);
+
+        // --- Trigonometria da cinemática: libm x FastMath (atan2 + acos + sin/cos por chamada) ---
+        measure("trig_libm", iterations, [](uint32_t n) {
+            const int i = n % IK_BATCH_POINTS;
+            const float angle = atan2f(batchY[i], batchX[i]);
+            sinkF = acosf(batchZ[i] * 0.002f) + sinf(angle) + cosf(angle);
+        });
+        measure("trig_fast", iterations, [](uint32_t n) {
+            const int i = n % IK_BATCH_POINTS;
+            const float angle = FastMath::atan2(batchY[i], batchX[i]);
+            float s, c;
+            FastMath::sinCos(angle, s, c);
+            sinkF = FastMath::acos(batchZ[i] * 0.002f) + s + c;
+        });
+
+        // --- IK iterativo (solvePose) com semente de um tick: solução do lote deslocada 0.5° ---
+        for (int i = 0; i < IK_BATCH_POINTS; i++)
+        {
+            for (int j = 0; j < NUM_SERVOS; j++)
+            {
+                dlsSeeds[i][j] = batchJoints[j][i] + ((j >= 1 && j <= 4) ? 0.5f : 0.0f);
+            }
+            dlsPitch[i] = (batchJoints[1][i] - IK_NEUTRAL.shoulder) + (batchJoints[3][i] - IK_NEUTRAL.elbow) +
+                          (batchJoints[4][i] - IK_NEUTRAL.hand);
+        }
+        measure("ik_dls_warm", iterations, [](uint32_t n) {
+            float angles[NUM_SERVOS];
+            InverseKinematics::PoseReport report;
+            for (int i = 0; i < IK_BATCH_POINTS; i++)
+            {
+                InverseKinematics::solvePose(batchX[i], batchY[i], batchZ[i], dlsPitch[i], 0.0f, dlsSeeds[i], angles,
+                                             report);
+                batchJoints[3][i] = angles[3];
+            }
+            sinkF = batchJoints[3][n % IK_BATCH_POINTS];
+        }, IK_BATCH_POINTS);
+
+        // --- Workspace: classificação O(1) e semente interpolada (mesmos pontos) ---
+        measure("ws_classify", iterations, [](uint32_t n) {
+            (void)n;
+            uint32_t inside = 0;
+            for (int i = 0; i < IK_BATCH_POINTS; i++)
+            {
+                inside += Workspace::classify(batchX[i], batchY[i], batchZ[i]) == Workspace::INSIDE;
+            }
+            sinkU = inside;
+        }, IK_BATCH_POINTS);
+
+        measure("ws_seed", iterations, [](uint32_t n) {
+            float angles[NUM_SERVOS];
+            for (int i = 0; i < IK_BATCH_POINTS; i++)
+            {
+                Workspace::seed(batchX[i], batchY[i], batchZ[i], angles);
+                batchJoints[3][i] = angles[3];
+            }
+            sinkF = batchJoints[3][n % IK_BATCH_POINTS];
+        }, IK_BATCH_POINTS);
+
+        // --- calcCRC16 sobre o bloco de configuração (StoredDataV2) ---
+        MotionController::Limits limits;
+        MotionController::getLimits(limits);
+        StoredDataV2 sd;
+        memset(&sd, 0, sizeof(sd));
+        sd.magic = EEPROM_MAGIC;
+        sd.version = 2;
+        for (int i = 0; i < NUM_SERVOS; i++)
+        {
+            sd.current[i] = (uint8_t)IK_POSE_ANGLES[0][i];
+            sd.minv[i] = (uint8_t)limits.minAngles[i];
+            sd.maxv[i] = (uint8_t)limits.maxAngles[i];
+            sd.offs[i] = (int8_t)limits.offsets[i];
+        }
+        measure("crc16_v2", iterations, [&sd](uint32_t n) {
+            sd.version = (uint8_t)n; // Varia a entrada a cada chamada
+            sinkU = calcCRC16((uint8_t *)&sd, sizeof(sd) - 2);
+        });
+
+        // --- Busca de pose pelo nome no índice em RAM ---
+        int names = 0;
+        for (int i = 0; i < MAX_POSES; i++)
+        {
+            if (PoseManager::slotName(i, lookupNames[names]))
+                names++;
+        }
+        strncpy(lookupNames[names++], "~bench~", POSE_NAME_LEN); // Não existe: a sondagem vai até uma posição vazia
+        measure("pose_index", iterations, [names](uint32_t n) {
+            sinkU = (uint32_t)PoseManager::findSlot(lookupNames[n % names]);
+        });
+
+        // --- CommandParser::processCommand (o comando é descartado pelo dry-run) ---
+        CommandBus::setDryRun(true);
+        measure("parse_move", iterations, [](uint32_t n) {
+            (void)n;
+            CommandParser::processCommand("move 90 130 130 100 70 120 100 1500");
+        });
+        CommandBus::setDryRun(false);
+    }
+
+    bool runMotion(uint32_t iterations)
+    {
+        if (MotionController::isMoving() || Sequencer::isRunning())
+        {
+            CommandBus::reply(CommandBus::Reply::BENCH_BUSY);
+            return false;
+        }
+
+        MotionController::holdTicker(true);
+
+        // Segmento longo da posição atual até ela mesma: o tick percorre o caminho completo
+        // (perfil, encadeamento, snapshot, saída com pulsos inalterados) sem mover os servos
+        MotionController::Snapshot snap;
+        MotionController::getSnapshot(snap);
+        if (!MotionController::startSmoothMove(snap.angles, BENCH_TICK_SEGMENT_MS))
+        {
+            MotionController::holdTicker(false);
+            return false;
+        }
+        const Timing timing = timeKernel(iterations, [](uint32_t n) {
+            (void)n;
+            MotionController::interpolate();
+        });
+
+        MotionController::stop(); // Descarta o segmento sintético
+        MotionController::holdTicker(false);
+        // A linha do CSV é exibida pelo core de comunicação (CommandBus::printReplies)
+        CommandBus::reply(CommandBus::Reply::BENCH_MOTION_TICK, iterations, timing.elapsedUs, timing.cycles);
+        return true;
+    }
+
+} // namespace Benchmark
@@ -0,0 +1,47 @@
+/**
+ * @file Benchmark.h
+ * @brief Medição dos caminhos críticos do firmware (comando 'bench' e host/bench_firmware).
+ *
+ * Cada kernel é chamado N vezes com entradas representativas; o resultado sai em CSV,
+ * uma linha por kernel, prefixada por "BENCH" para ser filtrada do restante do log:
+ *   BENCH,firmware,cpu_mhz,kernel,iterations,ns_per_call,cycles_per_call
+ * Nos kernels de IK uma "chamada" é um ponto, para comparar solveXYZ e solveBatch direto.
+ */
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "Config.h"
+
+namespace Benchmark
+{
+
+    /**
+     * @brief Exibe o cabeçalho do CSV.
+     */
+    void printHeader();
+
+    /**
+     * @brief Exibe a linha do CSV de um kernel (tempos divididos por 'calls').
+     * Usado também por CommandBus::printReplies para o resultado de runMotion().
+     */
+    void printResult(const char *kernel, uint32_t calls, unsigned long elapsedUs, uint32_t cycles);
+
+    /**
+     * @brief Mede os kernels sem estado de movimento: InverseKinematics::solveXYZ em laço e
+     * solveBatch sobre o mesmo lote de pontos, calcCRC16 sobre StoredDataV2, a busca de pose pelo nome (índice em
+     * RAM, sobre as poses salvas e um nome inexistente) e CommandParser::processCommand
+     * ('move', com o CommandBus em dry-run). Roda no core de comunicação.
+     */
+    void runComms(uint32_t iterations);
+
+    /**
+     * @brief Mede um tick de MotionController com um segmento em andamento (parado na posição
+     * atual, então os servos não se movem). Roda no core de movimento, com o ticker suspenso;
+     * a linha do CSV (ou o erro) volta como CommandBus::Reply.
+     * @return false se o braço estiver em movimento ou executando uma macro.
+     */
+    bool runMotion(uint32_t iterations);
+
+} // namespace Benchmark
+
+#endif // BENCHMARK_H
@@ -6,7 +6,9 @@
 
 #include "Calibration.h"
 #include "MotionController.h"
-#include <Arduino.h>
+#include "CommandBus.h"
+#include "ServoOutput.h"
+#include "Platform.h"
 
 namespace Calibration
 {
@@ -16,7 +18,11 @@ namespace Calibration
         int idx, val;
         if (sscanf(input, "min %d %d", &idx, &val) == 2 && idx >= 0 && idx < NUM_SERVOS)
         {
-            minAngles[idx] = constrain(val, 0, 180);
+            // O valor é aplicado pelo core de movimento, único escritor dos limites
+            CommandBus::Command set = CommandBus::make(CommandBus::SET_MIN);
+            set.arg = (uint8_t)(1 << idx);
+            set.angles[idx] = (float)constrain(val, 0, 180);
+            CommandBus::post(set);
             Serial.print(F("Minimo do servo "));
             Serial.print(idx);
             Serial.print(F(" definido para "));
@@ -34,7 +40,10 @@ namespace Calibration
         int idx, val;
         if (sscanf(input, "max %d %d", &idx, &val) == 2 && idx >= 0 && idx < NUM_SERVOS)
         {
-            maxAngles[idx] = constrain(val, 0, 180);
+            CommandBus::Command set = CommandBus::make(CommandBus::SET_MAX);
+            set.arg = (uint8_t)(1 << idx);
+            set.angles[idx] = (float)constrain(val, 0, 180);
+            CommandBus::post(set);
             Serial.print(F("Maximo do servo "));
             Serial.print(idx);
             Serial.print(F(" definido para "));
@@ -52,10 +61,11 @@ namespace Calibration
         int idx, val;
         if (sscanf(input, "offset %d %d", &idx, &val) == 2 && idx >= 0 && idx < NUM_SERVOS)
         {
-            offsets[idx] = constrain(val, -90, 90);
-
-            int correctedAngle = constrain(currentAngles[idx] + offsets[idx], 0, 180);
-            servos[idx].write(correctedAngle);
+            // O core de movimento aplica o offset e reescreve o servo
+            CommandBus::Command set = CommandBus::make(CommandBus::SET_OFFSET);
+            set.arg = (uint8_t)(1 << idx);
+            set.angles[idx] = (float)constrain(val, -90, 90);
+            CommandBus::post(set);
             Serial.print(F("Offset do servo "));
             Serial.print(idx);
             Serial.print(F(" ajustado para "));
@@ -70,60 +80,53 @@ namespace Calibration
         }
     }
 
-    void alignShoulders(const char *input)
+    void alignShoulders(unsigned long duration)
     {
-        unsigned long duration = 0;
-        sscanf(input, "align ombro %lu", &duration);
-
-        int media = (currentAngles[1] + currentAngles[2]) / 2;
-
         int tempTarget[NUM_SERVOS];
-        for (int i = 0; i < NUM_SERVOS; i++)
-            tempTarget[i] = currentAngles[i];
-        tempTarget[1] = media;
-        tempTarget[2] = media;
+        MotionController::getPlannedTarget(tempTarget);
+
+        int media = (tempTarget[ActiveArm::SHOULDER] + tempTarget[ActiveArm::SHOULDER_MIRROR]) / 2;
+        tempTarget[ActiveArm::SHOULDER] = media;
+        tempTarget[ActiveArm::SHOULDER_MIRROR] = media;
 
-        if (duration == 0)
+        const bool calculated = duration == 0;
+        if (calculated)
         {
             duration = MotionController::calculateDurationBySpeed(tempTarget);
-            Serial.print(F("Alinhando ombros para "));
-            Serial.print(media);
-            Serial.print(F("° (duracao calc: "));
-            Serial.print(duration);
-            Serial.println(F(" ms)..."));
-        }
-        else
-        {
-            Serial.print(F("Alinhando ombros para "));
-            Serial.print(media);
-            Serial.print(F("° (duracao: "));
-            Serial.print(duration);
-            Serial.println(F(" ms)..."));
         }
+        CommandBus::reply(CommandBus::Reply::ALIGNING_SHOULDERS, (uint32_t)media, duration, calculated ? 1 : 0);
 
         MotionController::startSmoothMove(tempTarget, duration);
     }
 
     void printStatus()
     {
+        // Cópia consistente publicada pelo tick de movimento (pode rodar no outro core)
+        MotionController::Snapshot snap;
+        MotionController::getSnapshot(snap);
+        MotionController::Limits limits;
+        MotionController::getLimits(limits);
+
         Serial.println(F("\n--- Status Atual dos Servos ---"));
         for (int i = 0; i < NUM_SERVOS; i++)
         {
             Serial.print(F("Servo "));
             Serial.print(i);
             Serial.print(F(" | Logico:"));
-            Serial.print(currentAngles[i]);
+            Serial.print(snap.angles[i], 1);
             Serial.print(F("° | Min:"));
-            Serial.print(minAngles[i]);
+            Serial.print(limits.minAngles[i]);
             Serial.print(F("° | Max:"));
-            Serial.print(maxAngles[i]);
+            Serial.print(limits.maxAngles[i]);
             Serial.print(F("° | Offset:"));
-            if (offsets[i] >= 0)
+            if (limits.offsets[i] >= 0)
                 Serial.print(F("+"));
-            Serial.print(offsets[i]);
+            Serial.print(limits.offsets[i]);
             Serial.print(F("° | Fisico(out):"));
-            Serial.print(constrain(currentAngles[i] + offsets[i], 0, 180));
-            Serial.println(F("°"));
+            Serial.print(constrain(snap.angles[i] + limits.offsets[i], 0.0f, 180.0f), 1);
+            Serial.print(F("° | Pulso:"));
+            Serial.print(ServoOutput::physicalToPulseUs(i, snap.angles[i] + limits.offsets[i]));
+            Serial.println(F("us"));
         }
     }
 
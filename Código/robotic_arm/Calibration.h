@@ -32,9 +32,10 @@ namespace Calibration
 
     /**
      * @brief Alinha os servos do ombro (1 e 2) pela média de suas posições.
-     * @param input A string de comando completa (ex: "align ombro 1000").
+     * Executado no core de movimento (comando ALIGN_SHOULDERS do CommandBus).
+     * @param duration Duração em ms (0 = calculada automaticamente).
      */
-    void alignShoulders(const char *input);
+    void alignShoulders(unsigned long duration);
 
     /**
      * @brief Exibe os valores atuais, limites e offsets de todos os servos na Serial.
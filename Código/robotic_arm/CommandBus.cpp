@@ -0,0 +1,685 @@
+/**
+ * @file CommandBus.cpp
+ * @brief Implementação da fila de comandos entre os cores.
+ * post() e printReplies() rodam na task de comunicação; dispatch() e reply() rodam no loop()
+ * do core de movimento, que é o único a chamar MotionController, Sequencer e
+ * PoseManager::loadPoseByName.
+ */
+#include "CommandBus.h"
+#include "LockFree.h"
+#include "MotionController.h"
+#include "Sequencer.h"
+#include "PoseManager.h"
+#include "Calibration.h"
+#include "Benchmark.h"
+#include "Workspace.h"
+#include "InverseKinematics.h"
+#include "MotionProfile.h"
+
+namespace CommandBus
+{
+    static SpscQueue<Command, COMMAND_QUEUE_SIZE> queue;
+    static volatile uint32_t droppedCommands = 0; // Escrito só pelo produtor
+    static bool dryRun = false;                    // Acessado só pelo produtor
+
+    // Respostas: o core de movimento produz, a comunicação consome e imprime
+    static SpscQueue<Reply, REPLY_QUEUE_SIZE> replies;
+    static volatile uint32_t droppedReplies = 0; // Escrito só pelo core de movimento
+    static uint32_t reportedDrops = 0;           // Acessado só pela comunicação
+
+    // Pontos recebidos por SPLINE_POINT até o SPLINE_RUN (somente o consumidor acessa)
+    static float splinePoints[MOTION_QUEUE_SIZE][NUM_SERVOS];
+    static int splineCount = 0;
+
+    Command make(Type type)
+    {
+        Command cmd;
+        memset(&cmd, 0, sizeof(cmd));
+        cmd.type = type;
+        return cmd;
+    }
+
+    void setDryRun(bool enabled)
+    {
+        dryRun = enabled;
+    }
+
+    bool post(const Command &cmd)
+    {
+        if (dryRun || queue.push(cmd))
+        {
+            return true;
+        }
+        droppedCommands = droppedCommands + 1;
+        Serial.println(F("ERRO: Fila de comandos cheia. Comando descartado."));
+        return false;
+    }
+
+    bool hasRoom(uint8_t count)
+    {
+        return dryRun || queue.capacity() - queue.size() >= count;
+    }
+
+    /**
+     * @brief Move as juntas da máscara, mantendo as demais no fim do movimento já enfileirado.
+     */
+    void executeMove(const Command &cmd)
+    {
+        float target[NUM_SERVOS];
+        MotionController::getPlannedTarget(target);
+        for (int i = 0; i < NUM_SERVOS; i++)
+        {
+            if (cmd.arg & (1 << i))
+            {
+                target[i] = cmd.angles[i];
+            }
+            // Garante que os ângulos alvos estejam dentro dos limites de software (min/max)
+            target[i] = constrain(target[i], (float)minAngles[i], (float)maxAngles[i]);
+        }
+
+        unsigned long duration = cmd.duration;
+        if (duration == 0)
+        {
+            duration = MotionController::calculateDurationBySpeed(target);
+            reply(Reply::AUTO_DURATION, duration);
+        }
+        MotionController::startSmoothMove(target, duration);
+    }
+
+    uint32_t branchFlags(const InverseKinematics::IkBranch &branch)
+    {
+        return (branch.elbow == InverseKinematics::ELBOW_UP ? IK_BRANCH_UP : 0) |
+               (branch.exact ? IK_BRANCH_EXACT : 0);
+    }
+
+    void printBranch(uint32_t flags, float cost)
+    {
+        Serial.print((flags & IK_BRANCH_UP) ? F("cotovelo acima (") : F("cotovelo abaixo ("));
+        Serial.print(cost, 0);
+        Serial.print((flags & IK_BRANCH_EXACT) ? F(" ms)") : F(" ms, limitado)"));
+    }
+
+    /**
+     * @brief Resolve os dois ramos do cotovelo e move pelo que chega mais rápido a partir do fim da
+     * fila (modelo de duração do perfil ativo); o outro é exibido como alternativa.
+     */
+    void executeMoveIk(const Command &cmd)
+    {
+        float from[NUM_SERVOS];
+        MotionController::getPlannedTarget(from);
+        InverseKinematics::IkBranch branches[InverseKinematics::IK_MAX_BRANCHES];
+        const int count = InverseKinematics::solveBranches(cmd.angles[0], cmd.angles[1], cmd.angles[2], from, branches,
+                                                           MotionController::durationBetween);
+        if (count == 0)
+        {
+            reply(Reply::IK_UNREACHABLE);
+            return;
+        }
+
+        Reply chosen = makeReply(Reply::IK_BRANCHES);
+        chosen.ints[0] = (uint32_t)count;
+        chosen.ints[1] = branchFlags(branches[0]);
+        chosen.reals[0] = branches[0].cost;
+        if (count > 1)
+        {
+            chosen.ints[1] |= branchFlags(branches[1]) << IK_BRANCH_ALT_SHIFT;
+            chosen.reals[1] = branches[1].cost;
+        }
+        reply(chosen);
+
+        Command move = make(MOVE);
+        move.arg = ALL_JOINTS;
+        move.duration = cmd.duration;
+        memcpy(move.angles, branches[0].angles, sizeof(move.angles));
+        executeMove(move);
+    }
+
+    /**
+     * @brief Resolve o IK iterativo partindo do fim do movimento já enfileirado e move todas as juntas.
+     * Se essa semente não convergir, tenta de novo a partir da grade do Workspace.
+     */
+    void executeMovePose(const Command &cmd)
+    {
+        float seed[NUM_SERVOS];
+        MotionController::getPlannedTarget(seed);
+        Command move = make(MOVE);
+        move.arg = ALL_JOINTS;
+        move.duration = cmd.duration;
+        InverseKinematics::PoseReport report;
+        bool converged = InverseKinematics::solvePose(cmd.angles[0], cmd.angles[1], cmd.angles[2], cmd.angles[3],
+                                                      cmd.angles[4], seed, move.angles, report);
+        float gridSeed[NUM_SERVOS];
+        if (!converged && Workspace::seed(cmd.angles[0], cmd.angles[1], cmd.angles[2], gridSeed))
+        {
+            gridSeed[6] = seed[6];
+            float retryAngles[NUM_SERVOS];
+            InverseKinematics::PoseReport retry;
+            converged = InverseKinematics::solvePose(cmd.angles[0], cmd.angles[1], cmd.angles[2], cmd.angles[3],
+                                                     cmd.angles[4], gridSeed, retryAngles, retry);
+            retry.iterations += report.iterations; // Cabe: PoseReport::iterations tem 16 bits
+            if (converged || retry.positionErrorMm < report.positionErrorMm)
+            {
+                memcpy(move.angles, retryAngles, sizeof(retryAngles));
+                report = retry;
+            }
+        }
+
+        Reply result = makeReply(Reply::POSE_REPORT);
+        result.ints[0] = report.iterations;
+        result.ints[1] = report.jointLimited ? 1 : 0;
+        result.reals[0] = report.positionErrorMm;
+        result.reals[1] = report.pitchErrorDeg;
+        result.reals[2] = report.rollErrorDeg;
+        reply(result);
+        if (!converged)
+        {
+            reply(Reply::POSE_UNREACHABLE);
+            return;
+        }
+        executeMove(move);
+    }
+
+    void executeStop()
+    {
+        // Interrompe a macro (se houver) e desacelera até o repouso, descartando a fila
+        if (Sequencer::isRunning())
+        {
+            Sequencer::stopMacro();
+        }
+        else
+        {
+            MotionController::stop();
+        }
+        splineCount = 0;
+        reply(Reply::STOPPING);
+    }
+
+    void executePause()
+    {
+        if (Sequencer::isRunning())
+        {
+            Sequencer::pauseMacro();
+        }
+        else if (MotionController::pause())
+        {
+            reply(Reply::MOTION_PAUSED);
+        }
+        else
+        {
+            reply(Reply::ALREADY_PAUSED);
+        }
+    }
+
+    void executeResume()
+    {
+        if (Sequencer::isPaused())
+        {
+            Sequencer::resumeMacro();
+        }
+        else if (MotionController::resume())
+        {
+            reply(Reply::MOTION_RESUMED);
+        }
+        else
+        {
+            reply(Reply::NOT_PAUSED);
+        }
+    }
+
+    void execute(const Command &cmd)
+    {
+        switch (cmd.type)
+        {
+        case MOVE:
+            executeMove(cmd);
+            break;
+
+        case MOVE_LINEAR:
+            MotionController::startLinearMove(cmd.angles, cmd.angles[3]);
+            break;
+
+        case MOVE_IK:
+            executeMoveIk(cmd);
+            break;
+
+        case MOVE_POSE:
+            executeMovePose(cmd);
+            break;
+
+        case POSE_LOAD:
+            if (cmd.duration > 0)
+                PoseManager::loadPoseByName(cmd.name, cmd.duration);
+            else
+                PoseManager::loadPoseByName(cmd.name);
+            break;
+
+        case SPLINE_POINT:
+            if (splineCount < MOTION_QUEUE_SIZE)
+            {
+                memcpy(splinePoints[splineCount], cmd.angles, sizeof(cmd.angles));
+                splineCount++;
+            }
+            break;
+
+        case SPLINE_RUN:
+            // Um ponto perdido no caminho não vira um spline mais curto
+            if (splineCount == cmd.arg)
+                MotionController::startSpline(splinePoints, splineCount);
+            else
+                reply(Reply::SPLINE_INCOMPLETE);
+            splineCount = 0;
+            break;
+
+        case MACRO_PLAY:
+            Sequencer::startMacro(cmd.name, cmd.arg != 0);
+            break;
+
+        case MACRO_STOP:
+            Sequencer::stopMacro();
+            break;
+
+        case STOP:
+            executeStop();
+            break;
+
+        case PAUSE:
+            executePause();
+            break;
+
+        case RESUME:
+            executeResume();
+            break;
+
+        case PROFILE:
+            MotionController::setProfile((MotionProfile::Type)cmd.arg);
+            reply(Reply::PROFILE_SET, (uint32_t)MotionController::getProfile());
+            break;
+
+        case ALIGN_SHOULDERS:
+            Calibration::alignShoulders(cmd.duration);
+            break;
+
+        // Limites e offsets só mudam aqui: o tick de movimento os lê sem lock e o core de
+        // comunicação lê a cópia publicada (MotionController::getLimits)
+        case SET_MIN:
+        case SET_MAX:
+        {
+            int *limit = cmd.type == SET_MIN ? minAngles : maxAngles;
+            for (int i = 0; i < NUM_SERVOS; i++)
+            {
+                if (cmd.arg & (1 << i))
+                    limit[i] = (int)cmd.angles[i];
+            }
+            Workspace::rebuild();
+            MotionController::publishLimits();
+            break;
+        }
+
+        case SET_OFFSET:
+            for (int i = 0; i < NUM_SERVOS; i++)
+            {
+                if (cmd.arg & (1 << i))
+                {
+                    offsets[i] = (int)cmd.angles[i];
+                    MotionController::refreshServo(i);
+                }
+            }
+            MotionController::publishLimits();
+            break;
+
+        case BENCH:
+            Benchmark::runMotion(cmd.duration);
+            break;
+        }
+    }
+
+    void dispatch()
+    {
+        Command cmd;
+        while (queue.pop(cmd))
+        {
+            execute(cmd);
+        }
+    }
+
+    void printStats()
+    {
+        Serial.print(F("Fila de comandos: "));
+        Serial.print(queue.size());
+        Serial.print(F("/"));
+        Serial.print(queue.capacity());
+        Serial.print(F(" | Descartados: "));
+        Serial.print(droppedCommands);
+        Serial.print(F(" | Respostas descartadas: "));
+        Serial.println(droppedReplies);
+    }
+
+    Reply makeReply(Reply::Code code)
+    {
+        Reply r;
+        memset(&r, 0, sizeof(r));
+        r.code = code;
+        return r;
+    }
+
+    void reply(const Reply &r)
+    {
+        if (!replies.push(r))
+        {
+            droppedReplies = droppedReplies + 1;
+        }
+    }
+
+    void reply(Reply::Code code, uint32_t a, uint32_t b, uint32_t c)
+    {
+        Reply r = makeReply(code);
+        r.ints[0] = a;
+        r.ints[1] = b;
+        r.ints[2] = c;
+        reply(r);
+    }
+
+    void replyNamed(Reply::Code code, const char *name, uint32_t a, uint32_t b)
+    {
+        Reply r = makeReply(code);
+        strncpy(r.name, name, POSE_NAME_LEN - 1);
+        r.ints[0] = a;
+        r.ints[1] = b;
+        reply(r);
+    }
+
+    /**
+     * @brief Texto de uma resposta (os mesmos que o core de movimento exibia diretamente).
+     */
+    void printReply(const Reply &r)
+    {
+        switch (r.code)
+        {
+        case Reply::AUTO_DURATION:
+            Serial.print(F("Duracao nao fornecida. Calculando duracao automatica: "));
+            Serial.print(r.ints[0]);
+            Serial.println(F(" ms."));
+            break;
+
+        case Reply::IK_UNREACHABLE:
+            Serial.println(F("ERRO: Ponto fora do alcance da cinematica inversa."));
+            break;
+
+        case Reply::IK_BRANCHES:
+            Serial.print(F("IK: ramo "));
+            printBranch(r.ints[1], r.reals[0]);
+            if (r.ints[0] > 1)
+            {
+                Serial.print(F(" | alternativa: "));
+                printBranch(r.ints[1] >> IK_BRANCH_ALT_SHIFT, r.reals[1]);
+            }
+            Serial.println();
+            break;
+
+        case Reply::POSE_REPORT:
+            Serial.print(F("IKP: "));
+            Serial.print(r.ints[0]);
+            Serial.print(F(" iteracoes | erro posicao "));
+            Serial.print(r.reals[0], 2);
+            Serial.print(F(" mm | erro pitch "));
+            Serial.print(r.reals[1], 2);
+            Serial.print(F(" graus | erro roll "));
+            Serial.print(r.reals[2], 1);
+            Serial.println(r.ints[1] ? F(" graus | junta no limite") : F(" graus"));
+            break;
+
+        case Reply::POSE_UNREACHABLE:
+            Serial.println(F("ERRO: ikp: pose fora do alcance ou dos limites. Braco nao movido."));
+            break;
+
+        case Reply::STOPPING:
+            Serial.println(F("Parando (rampa de desaceleracao)..."));
+            break;
+
+        case Reply::MOTION_PAUSED:
+            Serial.println(F("Movimento pausado. Use 'resume' para continuar."));
+            break;
+
+        case Reply::ALREADY_PAUSED:
+            Serial.println(F("AVISO: Movimento ja esta pausado."));
+            break;
+
+        case Reply::MOTION_RESUMED:
+            Serial.println(F("Movimento retomado."));
+            break;
+
+        case Reply::NOT_PAUSED:
+            Serial.println(F("AVISO: Movimento nao esta pausado."));
+            break;
+
+        case Reply::SPLINE_INCOMPLETE:
+            Serial.println(F("ERRO: Pontos do spline incompletos. Spline descartado."));
+            break;
+
+        case Reply::PROFILE_SET:
+            Serial.print(F("Perfil de movimento: "));
+            Serial.println(MotionProfile::name((MotionProfile::Type)r.ints[0]));
+            break;
+
+        case Reply::ALIGNING_SHOULDERS:
+            Serial.print(F("Alinhando ombros para "));
+            Serial.print(r.ints[0]);
+            Serial.print(r.ints[2] ? F("° (duracao calc: ") : F("° (duracao: "));
+            Serial.print(r.ints[1]);
+            Serial.println(F(" ms)..."));
+            break;
+
+        case Reply::POSE_LOADING:
+            Serial.print(F("Carregando pose '"));
+            Serial.print(r.name);
+            Serial.print(r.ints[1] ? F("' (duracao calc: ") : F("' (duracao: "));
+            Serial.print(r.ints[0]);
+            Serial.println(F(" ms)..."));
+            break;
+
+        case Reply::POSE_NOT_FOUND:
+            Serial.print(F("ERRO: Pose '"));
+            Serial.print(r.name);
+            Serial.println(F("' nao encontrada."));
+            break;
+
+        case Reply::BENCH_BUSY:
+            Serial.println(F("ERRO: motion_tick exige o braco parado (sem movimento ou macro)."));
+            break;
+
+        case Reply::BENCH_MOTION_TICK:
+            Benchmark::printResult("motion_tick", r.ints[0], r.ints[1], r.ints[2]);
+            break;
+
+        case Reply::OUT_OF_LIMITS:
+            Serial.print(F("ERRO: Servo "));
+            Serial.print(r.ints[0]);
+            Serial.print(F(" fora dos limites ("));
+            Serial.print(r.ints[1]);
+            Serial.print(F("-"));
+            Serial.print(r.ints[2]);
+            Serial.print(F("). Valor recebido: "));
+            Serial.println(r.reals[0]);
+            break;
+
+        case Reply::DURATION_EXTENDED:
+            Serial.print(F("AVISO: Duracao estendida para "));
+            Serial.print(r.ints[0]);
+            Serial.println(F(" ms (limites de velocidade/aceleracao das juntas)."));
+            break;
+
+        case Reply::MOTION_QUEUE_FULL:
+            Serial.println(F("ERRO: Fila de movimento cheia. Segmento descartado."));
+            break;
+
+        case Reply::SPLINE_SIZE:
+            Serial.print(F("ERRO: Spline aceita de 1 a "));
+            Serial.print(MOTION_QUEUE_SIZE);
+            Serial.println(F(" pontos."));
+            break;
+
+        case Reply::SPLINE_NO_ROOM:
+            Serial.println(F("ERRO: Fila de movimento sem espaco para o spline."));
+            break;
+
+        case Reply::LINEAR_UNREACHABLE:
+            Serial.print(F("ERRO: movel: trecho inalcancavel em ("));
+            Serial.print(r.reals[0]);
+            Serial.print(F(", "));
+            Serial.print(r.reals[1]);
+            Serial.print(F(", "));
+            Serial.print(r.reals[2]);
+            Serial.print(F(") mm, "));
+            Serial.print(r.ints[0]);
+            Serial.print(F("% da reta: "));
+            if (r.ints[1] & InverseKinematics::IK_INVALID)
+                Serial.println(F("ponto invalido."));
+            else if (r.ints[1] & InverseKinematics::IK_REACH_CLIPPED)
+                Serial.println(F("fora do alcance do braco."));
+            else if (r.ints[1] & InverseKinematics::IK_JOINT_LIMITED)
+                Serial.println(F("junta no limite de software."));
+            else
+                Serial.println(F("salto de junta (singularidade)."));
+            break;
+
+        case Reply::LINEAR_BAD_START:
+            Serial.println(F("ERRO: movel: posicao inicial invalida."));
+            break;
+
+        case Reply::LINEAR_AT_POINT:
+            Serial.println(F("AVISO: movel: a ponta ja esta no ponto."));
+            break;
+
+        case Reply::LINEAR_OUTSIDE:
+            Serial.println(F("ERRO: movel: alvo fora da area de trabalho."));
+            break;
+
+        case Reply::LINEAR_SPEED_LIMITED:
+            Serial.print(F("AVISO: movel limitado a "));
+            Serial.print(r.reals[0]);
+            Serial.println(F(" mm/s pelas juntas."));
+            break;
+
+        case Reply::LINEAR_QUEUED:
+            Serial.print(F("movel: "));
+            Serial.print(r.reals[0]);
+            Serial.print(F(" mm em "));
+            Serial.print(r.ints[0]);
+            Serial.println(r.ints[1] ? F(" ms (apos alinhar o punho).") : F(" ms."));
+            break;
+
+        case Reply::MACRO_MISSING_POSE:
+            Serial.print(F("ERRO: Passo "));
+            Serial.print(r.ints[0]);
+            Serial.print(F(": pose de id "));
+            Serial.print(r.ints[1]);
+            Serial.println(F(" nao encontrada (apagada). Abortando macro."));
+            break;
+
+        case Reply::MACRO_READ_FAILED:
+            Serial.println(F("ERRO: Falha ao ler os passos da macro na flash. Abortando macro."));
+            break;
+
+        case Reply::MACRO_STEP_POSE:
+            Serial.print(F("  Passo "));
+            Serial.print(r.ints[0]);
+            Serial.print(F(": Carregando pose '"));
+            Serial.print(r.name);
+            Serial.print(F("' (duracao calc: "));
+            Serial.print(r.ints[1]);
+            Serial.println(F(" ms)..."));
+            break;
+
+        case Reply::MACRO_ENQUEUE_FAILED:
+            Serial.println(F("ERRO: Falha ao enfileirar o movimento. Abortando macro."));
+            break;
+
+        case Reply::MACRO_STEP_SPLINE:
+            Serial.print(F("  Passos "));
+            Serial.print(r.ints[0]);
+            Serial.print(F("-"));
+            Serial.print(r.ints[1]);
+            Serial.print(F(": Spline por "));
+            Serial.print(r.ints[2]);
+            Serial.println(F(" poses..."));
+            break;
+
+        case Reply::MACRO_SPLINE_FAILED:
+            Serial.println(F("ERRO: Falha ao enfileirar o spline. Abortando macro."));
+            break;
+
+        case Reply::MACRO_BUSY:
+            Serial.println(F("ERRO: Sequenciador já está em execução."));
+            break;
+
+        case Reply::MACRO_EMPTY:
+            Serial.println(F("ERRO: Macro está vazia."));
+            break;
+
+        case Reply::MACRO_STARTED:
+            Serial.print(F("Iniciando Macro '"));
+            Serial.print(r.name);
+            Serial.print(F("' ("));
+            Serial.print(r.ints[0]);
+            Serial.print(F(" passos"));
+            if (r.ints[1])
+                Serial.print(F(", spline"));
+            Serial.println(F(")..."));
+            break;
+
+        case Reply::MACRO_NOT_FOUND:
+            Serial.print(F("ERRO: Macro '"));
+            Serial.print(r.name);
+            Serial.println(F("' nao encontrada."));
+            break;
+
+        case Reply::MACRO_STOPPED:
+            Serial.println(F("Macro interrompida."));
+            break;
+
+        case Reply::MACRO_PAUSED:
+            Serial.print(F("Macro pausada no passo "));
+            Serial.print(r.ints[0]);
+            Serial.println(F("."));
+            break;
+
+        case Reply::MACRO_RESUMED:
+            Serial.print(F("Macro retomada no passo "));
+            Serial.print(r.ints[0]);
+            Serial.println(F("."));
+            break;
+
+        case Reply::MACRO_STEP_DONE:
+            Serial.print(F("  Passo "));
+            Serial.print(r.ints[0]);
+            Serial.print(F(" concluido. Aguardando "));
+            Serial.print(r.ints[1]);
+            Serial.println(F(" ms..."));
+            break;
+
+        case Reply::MACRO_DONE:
+            Serial.print(F("Macro '"));
+            Serial.print(r.name);
+            Serial.println(F("' concluida."));
+            break;
+        }
+    }
+
+    void printReplies()
+    {
+        Reply r;
+        while (replies.pop(r))
+        {
+            printReply(r);
+        }
+        const uint32_t dropped = droppedReplies;
+        if (dropped != reportedDrops)
+        {
+            Serial.print(F("AVISO: "));
+            Serial.print(dropped - reportedDrops);
+            Serial.println(F(" mensagens do core de movimento descartadas (fila de respostas cheia)."));
+            reportedDrops = dropped;
+        }
+    }
+
+} // namespace CommandBus
@@ -0,0 +1,189 @@
+/**
+ * @file CommandBus.h
+ * @brief Passagem de comandos do core de comunicação para o core de movimento.
+ *
+ * O CommandParser e o RosInterface (task de comunicação, COMMS_TASK_CORE) apenas interpretam
+ * o texto/mensagem e publicam um Command em uma fila SPSC sem lock. O loop() (core de
+ * movimento) executa os comandos em dispatch(), junto com o Sequencer, então todo o estado
+ * do movimento e das macros é alterado por um único core.
+ *
+ * No sentido contrário, o core de movimento não escreve na Serial: erros e avisos voltam como
+ * Reply (código e valores) em uma segunda fila SPSC, e printReplies() os formata no core de
+ * comunicação.
+ */
+#ifndef COMMAND_BUS_H
+#define COMMAND_BUS_H
+
+#include "Config.h"
+
+namespace CommandBus
+{
+
+    /**
+     * @brief Tipos de comando executados no core de movimento.
+     */
+    enum Type : uint8_t
+    {
+        MOVE,            /**< Move as juntas de 'mask' para 'angles' (as demais ficam no alvo planejado). */
+        MOVE_LINEAR,     /**< Reta cartesiana até angles[0..2] (mm) a angles[3] mm/s (0 = padrão). */
+        MOVE_IK,         /**< IK até angles[0..2] (mm) pelo ramo do cotovelo mais rápido de alcançar. */
+        MOVE_POSE,       /**< IK iterativo até angles[0..2] (mm) com pitch angles[3] e roll angles[4] (graus). */
+        POSE_LOAD,       /**< Carrega a pose 'name'. */
+        SPLINE_POINT,    /**< Acumula 'angles' como ponto de passagem do próximo SPLINE_RUN. */
+        SPLINE_RUN,      /**< Enfileira o spline pelos pontos acumulados ('arg' = pontos enviados; outro total descarta o spline). */
+        MACRO_PLAY,      /**< Executa a macro 'name' ('arg' = 1 para spline). */
+        MACRO_STOP,      /**< Interrompe a macro e para o braço. */
+        STOP,            /**< Parada controlada (macro, se houver, e movimento). */
+        PAUSE,           /**< Pausa (macro, se houver, e movimento). */
+        RESUME,          /**< Retoma o que foi pausado. */
+        PROFILE,         /**< Seleciona o perfil de velocidade 'arg'. */
+        ALIGN_SHOULDERS, /**< Alinha os servos 1 e 2 pela média. */
+        SET_MIN,         /**< Limite mínimo das juntas de 'mask' = angles; refaz o mapa do Workspace. */
+        SET_MAX,         /**< Limite máximo das juntas de 'mask' = angles; refaz o mapa do Workspace. */
+        SET_OFFSET,      /**< Offset das juntas de 'mask' = angles; reescreve os servos. */
+        BENCH            /**< Mede o tick de movimento ('duration' = iterações). */
+    };
+
+    /**
+     * @brief Comando enviado pela fila (cópia por valor, sem ponteiros).
+     */
+    struct Command
+    {
+        Type type;
+        uint8_t arg;              /**< Máscara de juntas (MOVE, SET_*), perfil ou flag. */
+        unsigned long duration;   /**< Duração em ms (0 = calculada automaticamente) ou iterações (BENCH). */
+        float angles[NUM_SERVOS]; /**< Ângulos lógicos (MOVE, SPLINE_POINT) ou ponto cartesiano (MOVE_LINEAR, MOVE_IK, MOVE_POSE). */
+        char name[POSE_NAME_LEN]; /**< Nome da pose ou macro. */
+    };
+
+    /** @brief Máscara com todas as juntas (MOVE, SET_*). */
+    const uint8_t ALL_JOINTS = (1 << NUM_SERVOS) - 1;
+
+    /**
+     * @brief Cria um comando zerado do tipo informado.
+     */
+    Command make(Type type);
+
+    /**
+     * @brief Publica um comando (somente a task de comunicação: produtor único).
+     * @return false se a fila estiver cheia (o comando é descartado e contado).
+     */
+    bool post(const Command &cmd);
+
+    /**
+     * @brief Há espaço para 'count' comandos (somente o produtor: só o consumidor libera posições,
+     * então os próximos 'count' post() não falham). Usado para publicar um spline inteiro ou nada.
+     */
+    bool hasRoom(uint8_t count);
+
+    /**
+     * @brief Com dry-run ligado, post() aceita e descarta os comandos (benchmark do parser).
+     * Somente o produtor (task de comunicação) usa.
+     */
+    void setDryRun(bool enabled);
+
+    /**
+     * @brief Executa todos os comandos pendentes. Chamado pelo loop() no core de movimento
+     * (consumidor único).
+     */
+    void dispatch();
+
+    /**
+     * @brief Exibe a ocupação da fila e os comandos descartados (usado pelo comando 'status').
+     */
+    void printStats();
+
+    /**
+     * @brief Resposta do core de movimento (cópia por valor). O texto de cada código é montado
+     * por printReplies() no core de comunicação.
+     */
+    struct Reply
+    {
+        enum Code : uint8_t
+        {
+            AUTO_DURATION,        /**< Duração calculada: ints[0] ms. */
+            IK_UNREACHABLE,       /**< MOVE_IK sem solução. */
+            IK_BRANCHES,          /**< Ramos do MOVE_IK: ints[0] = quantos, ints[1] = flags IK_BRANCH_*, reals[0..1] = custos (ms). */
+            POSE_REPORT,          /**< MOVE_POSE: ints[0] iterações, ints[1] junta no limite, reals[0..2] erros de posição/pitch/roll. */
+            POSE_UNREACHABLE,     /**< MOVE_POSE sem convergência. */
+            STOPPING,             /**< Parada com rampa iniciada. */
+            MOTION_PAUSED,        /**< Movimento pausado. */
+            ALREADY_PAUSED,       /**< Pausa pedida com o movimento já pausado. */
+            MOTION_RESUMED,       /**< Movimento retomado. */
+            NOT_PAUSED,           /**< Retomada pedida sem pausa. */
+            SPLINE_INCOMPLETE,    /**< SPLINE_RUN com pontos perdidos. */
+            PROFILE_SET,          /**< Perfil ativo: ints[0] = MotionProfile::Type. */
+            ALIGNING_SHOULDERS,   /**< ints[0] ângulo, ints[1] duração (ms), ints[2] = 1 se calculada. */
+            POSE_LOADING,         /**< Pose 'name': ints[0] duração (ms), ints[1] = 1 se calculada. */
+            POSE_NOT_FOUND,       /**< Pose 'name' inexistente. */
+            BENCH_BUSY,           /**< 'bench' com o braço em movimento. */
+            BENCH_MOTION_TICK,    /**< Linha motion_tick: ints[0] iterações, ints[1] µs, ints[2] ciclos. */
+            OUT_OF_LIMITS,        /**< ints[0] servo, ints[1..2] limites, reals[0] valor recebido. */
+            DURATION_EXTENDED,    /**< Duração estendida para ints[0] ms. */
+            MOTION_QUEUE_FULL,    /**< Fila de movimento cheia. */
+            SPLINE_SIZE,          /**< Spline com pontos demais ou nenhum. */
+            SPLINE_NO_ROOM,       /**< Fila de movimento sem espaço para o spline. */
+            LINEAR_UNREACHABLE,   /**< movel: reals[0..2] ponto (mm), ints[0] % da reta, ints[1] status do IK. */
+            LINEAR_BAD_START,     /**< movel: posição inicial inválida. */
+            LINEAR_AT_POINT,      /**< movel: a ponta já está no ponto. */
+            LINEAR_OUTSIDE,       /**< movel: alvo fora da área de trabalho. */
+            LINEAR_SPEED_LIMITED, /**< movel: velocidade limitada a reals[0] mm/s. */
+            LINEAR_QUEUED,        /**< movel: reals[0] mm em ints[0] ms, ints[1] = 1 se alinha o punho antes. */
+            MACRO_MISSING_POSE,   /**< Passo ints[0] com a pose de id ints[1] apagada. */
+            MACRO_READ_FAILED,    /**< Falha ao ler os passos na flash. */
+            MACRO_STEP_POSE,      /**< Passo ints[0] carrega a pose 'name' em ints[1] ms. */
+            MACRO_ENQUEUE_FAILED, /**< Falha ao enfileirar o movimento do passo. */
+            MACRO_STEP_SPLINE,    /**< Passos ints[0]-ints[1] em um spline de ints[2] poses. */
+            MACRO_SPLINE_FAILED,  /**< Falha ao enfileirar o spline. */
+            MACRO_BUSY,           /**< Sequenciador já em execução. */
+            MACRO_EMPTY,          /**< Macro sem passos. */
+            MACRO_STARTED,        /**< Macro 'name' com ints[0] passos, ints[1] = 1 em spline. */
+            MACRO_NOT_FOUND,      /**< Macro 'name' inexistente. */
+            MACRO_STOPPED,        /**< Macro interrompida. */
+            MACRO_PAUSED,         /**< Macro pausada no passo ints[0]. */
+            MACRO_RESUMED,        /**< Macro retomada no passo ints[0]. */
+            MACRO_STEP_DONE,      /**< Passo ints[0] concluído, espera de ints[1] ms. */
+            MACRO_DONE            /**< Macro 'name' concluída. */
+        };
+
+        Code code;
+        uint32_t ints[3];
+        float reals[3];
+        char name[POSE_NAME_LEN];
+    };
+
+    /** @brief Flags de Reply::IK_BRANCHES (ramo escolhido e alternativa). */
+    const uint32_t IK_BRANCH_UP = 0x01;      /**< Ramo escolhido com o cotovelo acima. */
+    const uint32_t IK_BRANCH_EXACT = 0x02;   /**< Ramo escolhido sem limite de junta. */
+    const uint32_t IK_BRANCH_ALT_SHIFT = 2;  /**< As flags da alternativa vêm deslocadas deste valor. */
+
+    /**
+     * @brief Cria uma resposta zerada com o código informado.
+     */
+    Reply makeReply(Reply::Code code);
+
+    /**
+     * @brief Publica uma resposta (somente o core de movimento: produtor único).
+     * Com a fila cheia a resposta é descartada e contada.
+     */
+    void reply(const Reply &r);
+
+    /**
+     * @brief Atalho para respostas só com valores inteiros.
+     */
+    void reply(Reply::Code code, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0);
+
+    /**
+     * @brief Atalho para respostas com um nome (pose ou macro) e valores inteiros.
+     */
+    void replyNamed(Reply::Code code, const char *name, uint32_t a = 0, uint32_t b = 0);
+
+    /**
+     * @brief Exibe as respostas pendentes do core de movimento. Chamado pela task de
+     * comunicação (consumidor único).
+     */
+    void printReplies();
+
+} // namespace CommandBus
+
+#endif // COMMAND_BUS_H
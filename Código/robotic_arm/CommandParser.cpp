@@ -4,21 +4,26 @@
  */
 #include "CommandParser.h"
 #include "Config.h"
+#include "CommandBus.h"
 #include "MotionController.h"
 #include "Calibration.h" 
 #include "Storage.h"     
 #include "PoseManager.h"
 #include "MacroManager.h"
-#include "Sequencer.h"
+#include "InverseKinematics.h"
+#include "Workspace.h"
+#include "ServoOutput.h"
+#include "Benchmark.h"
+#include "Perf.h"
 
 namespace CommandParser
 {
     // --- Variáveis de Estado para Gravação de Macro ---
     static bool isRecording = false; // Flag que indica se estamos no modo de gravação
-    static Macro recordingMacro;     // Buffer temporário para a macro sendo gravada
+                                     // (os passos ficam no buffer de gravação do MacroManager)
     
     // --- Buffer Estático para Comandos (Evita fragmentação de heap) ---
-    static char cmdBuffer[64];
+    static char cmdBuffer[128]; // Comporta 'spline' com várias poses
     static uint8_t bufIdx = 0;
 
     /**
@@ -26,21 +31,22 @@ namespace CommandParser
      */
     void handleSetCommand(const char* input)
     {
-        int tempTarget[NUM_SERVOS];
-        for (int i = 0; i < NUM_SERVOS; i++)
-            tempTarget[i] = currentAngles[i];
+        // Só as juntas da máscara mudam; as demais partem do fim do movimento já enfileirado
+        // (resolvido no core de movimento), para que comandos 'set' seguidos se acumulem
+        CommandBus::Command cmd = CommandBus::make(CommandBus::MOVE);
 
         unsigned long duration = 0; // 0 = gatilho para cálculo automático
-        int angle = 0;
+        float angle = 0;
         int servo_idx = -1;
 
         if (strncmp(input, "set ombro ", 10) == 0)
         {
-            int params = sscanf(input, "set ombro %d %lu", &angle, &duration);
+            int params = sscanf(input, "set ombro %f %lu", &angle, &duration);
             if (params >= 1)
             {
-                tempTarget[1] = angle;
-                tempTarget[2] = angle;
+                cmd.angles[ActiveArm::SHOULDER] = angle;
+                cmd.angles[ActiveArm::SHOULDER_MIRROR] = angle;
+                cmd.arg = (1 << ActiveArm::SHOULDER) | (1 << ActiveArm::SHOULDER_MIRROR);
                 Serial.print(F("Ajustando ombros para "));
                 Serial.print(angle);
                 Serial.print(F("° (duracao: "));
@@ -55,10 +61,11 @@ namespace CommandParser
         }
         else if (strncmp(input, "set ", 4) == 0)
         {
-            int params = sscanf(input, "set %d %d %lu", &servo_idx, &angle, &duration);
+            int params = sscanf(input, "set %d %f %lu", &servo_idx, &angle, &duration);
             if (params >= 2 && servo_idx >= 0 && servo_idx < NUM_SERVOS)
             {
-                tempTarget[servo_idx] = angle;
+                cmd.angles[servo_idx] = angle;
+                cmd.arg = 1 << servo_idx;
                 Serial.print(F("Ajustando servo "));
                 Serial.print(servo_idx);
                 Serial.print(F(" para "));
@@ -76,23 +83,9 @@ namespace CommandParser
             return;
         }
 
-        // 1. Garante que os ângulos alvos estejam dentro dos limites de software (min/max)
-        for (int i = 0; i < NUM_SERVOS; i++) 
-        {
-            tempTarget[i] = constrain(tempTarget[i], minAngles[i], maxAngles[i]);
-        }
-
-        // 2. Se a duração não foi fornecida (duration == 0), calcula a duração padrão
-        if (duration == 0) 
-        {
-            duration = MotionController::calculateDurationBySpeed(tempTarget);
-            Serial.print(F("Duracao nao fornecida. Calculando duracao automatica: "));
-            Serial.print(duration);
-            Serial.println(F(" ms."));
-        }
-
-        // Inicia o movimento suave
-        MotionController::startSmoothMove(tempTarget, duration);
+        // Limites (min/max) e duração automática (duration == 0) são aplicados no core de movimento
+        cmd.duration = duration;
+        CommandBus::post(cmd);
     }
     
     /**
@@ -101,14 +94,15 @@ namespace CommandParser
      */
     void handleMoveCommand(const char* input)
     {
-        int targetAngles[NUM_SERVOS];
+        CommandBus::Command cmd = CommandBus::make(CommandBus::MOVE);
+        float *targetAngles = cmd.angles;
         unsigned long duration = 0;
         int paramsFound = 0;
 
         // Formato: move S0 S1 S2 S3 S4 S5 S6 [tempo]
         paramsFound = sscanf(
             input, 
-            "move %d %d %d %d %d %d %d %lu", 
+            "move %f %f %f %f %f %f %f %lu", 
             &targetAngles[0], &targetAngles[1], &targetAngles[2], &targetAngles[3], 
             &targetAngles[4], &targetAngles[5], &targetAngles[6], &duration
         );
@@ -116,30 +110,181 @@ namespace CommandParser
         // O comando 'move' deve ter exatamente NUM_SERVOS (7) parâmetros de ângulo
         if (paramsFound >= NUM_SERVOS) 
         {
-            // 1. Garante que os ângulos alvos estejam dentro dos limites de software (min/max)
-            for (int i = 0; i < NUM_SERVOS; i++) 
+            // Limites (min/max) e duração automática (paramsFound == NUM_SERVOS -> 0)
+            // são aplicados no core de movimento
+            cmd.arg = CommandBus::ALL_JOINTS;
+            cmd.duration = (paramsFound == NUM_SERVOS) ? 0 : duration;
+            CommandBus::post(cmd);
+        } 
+        else 
+        {
+            Serial.println(F("Formato inválido. Use: move <s0> <s1> <s2> <s3> <s4> <s5> <s6> [tempo]"));
+        }
+    }
+
+
+    /**
+     * @brief Função auxiliar interna para tratar o comando 'ik'.
+     * O ramo do cotovelo é escolhido pelo tempo a partir do fim da fila, no core de movimento.
+     */
+    void handleIkCommand(const char* input)
+    {
+        float x, y, z;
+        unsigned long duration = 0;
+        int params = sscanf(input, "ik %f %f %f %lu", &x, &y, &z, &duration);
+        if (params < 3)
+        {
+            Serial.println(F("Formato inválido. Use: ik <x> <y> <z> [tempo]"));
+            return;
+        }
+
+        if (Workspace::classify(x, y, z) == Workspace::OUTSIDE)
+        {
+            Serial.println(F("AVISO: ponto fora da area de trabalho; o IK limita alcance e juntas."));
+        }
+
+        Serial.print(F("IK: movendo para ("));
+        Serial.print(x);
+        Serial.print(F(", "));
+        Serial.print(y);
+        Serial.print(F(", "));
+        Serial.print(z);
+        Serial.println(F(") mm..."));
+        CommandBus::Command cmd = CommandBus::make(CommandBus::MOVE_IK);
+        cmd.angles[0] = x;
+        cmd.angles[1] = y;
+        cmd.angles[2] = z;
+        cmd.duration = (params == 3) ? 0 : duration;
+        CommandBus::post(cmd);
+    }
+
+    /**
+     * @brief Função auxiliar interna para tratar o comando 'ikp'.
+     * O IK iterativo parte do fim da fila, então é resolvido no core de movimento.
+     */
+    void handleIkPoseCommand(const char* input)
+    {
+        CommandBus::Command cmd = CommandBus::make(CommandBus::MOVE_POSE);
+        int params = sscanf(input, "ikp %f %f %f %f %f %lu", &cmd.angles[0], &cmd.angles[1], &cmd.angles[2],
+                            &cmd.angles[3], &cmd.angles[4], &cmd.duration);
+        if (params < 4)
+        {
+            Serial.println(F("Formato inválido. Use: ikp <x> <y> <z> <pitch> [roll] [tempo]"));
+            return;
+        }
+        if (params == 4)
+        {
+            cmd.angles[4] = 0.0f; // Roll que acompanha a base (como no 'ik')
+        }
+        CommandBus::post(cmd);
+    }
+
+    /**
+     * @brief Função auxiliar interna para tratar o comando 'movel'.
+     * A reta é verificada e planejada no core de movimento (a partir do fim da fila).
+     */
+    void handleMoveLinearCommand(const char* input)
+    {
+        CommandBus::Command cmd = CommandBus::make(CommandBus::MOVE_LINEAR);
+        int params = sscanf(input, "movel %f %f %f %f", &cmd.angles[0], &cmd.angles[1], &cmd.angles[2], &cmd.angles[3]);
+        if (params < 3)
+        {
+            Serial.println(F("Formato inválido. Use: movel <x> <y> <z> [mm/s]"));
+            return;
+        }
+        if (params == 3)
+        {
+            cmd.angles[3] = 0.0f; // Velocidade padrão (LINEAR_DEFAULT_SPEED)
+        }
+        CommandBus::post(cmd);
+    }
+
+    /**
+     * @brief Função auxiliar interna para tratar o comando 'profile'.
+     * Seleciona o perfil de velocidade dos próximos movimentos.
+     */
+    void handleProfileCommand(const char* input)
+    {
+        char name[10] = {0};
+        if (sscanf(input, "profile %9s", name) == 1)
+        {
+            CommandBus::Command cmd = CommandBus::make(CommandBus::PROFILE);
+            if (strcmp(name, "ease") == 0)
+                cmd.arg = MotionProfile::EASE_QUAD;
+            else if (strcmp(name, "trap") == 0)
+                cmd.arg = MotionProfile::TRAPEZOID;
+            else if (strcmp(name, "scurve") == 0)
+                cmd.arg = MotionProfile::MIN_JERK;
+            else
             {
-                targetAngles[i] = constrain(targetAngles[i], minAngles[i], maxAngles[i]);
+                Serial.println(F("Formato inválido. Use: profile <ease|trap|scurve>"));
+                return;
             }
+            CommandBus::post(cmd); // O core de movimento confirma o perfil selecionado
+            return;
+        }
+        Serial.print(F("Perfil de movimento: "));
+        Serial.println(MotionProfile::name(MotionController::getProfile()));
+    }
 
-            // 2. Se a duração não foi fornecida (paramsFound == NUM_SERVOS), calcula a duração padrão
-            if (paramsFound == NUM_SERVOS) 
+    /**
+     * @brief Função auxiliar interna para tratar o comando 'spline'.
+     * Percorre as poses listadas em uma trajetória contínua, parando só na última.
+     */
+    void handleSplineCommand(const char* input)
+    {
+        char names[sizeof(cmdBuffer)];
+        strncpy(names, input + 7, sizeof(names) - 1); // Pula "spline "
+        names[sizeof(names) - 1] = '\0';
+
+        float waypoints[MOTION_QUEUE_SIZE][NUM_SERVOS];
+        int count = 0;
+        for (char *name = strtok(names, " "); name != NULL; name = strtok(NULL, " "))
+        {
+            if (count >= MOTION_QUEUE_SIZE)
             {
-                duration = MotionController::calculateDurationBySpeed(targetAngles);
-                Serial.print(F("Duracao nao fornecida. Calculando duracao automatica: "));
-                Serial.print(duration);
-                Serial.println(F(" ms."));
+                Serial.print(F("ERRO: Maximo de "));
+                Serial.print(MOTION_QUEUE_SIZE);
+                Serial.println(F(" poses por spline."));
+                return;
             }
-            
-            // 3. Inicia o movimento suave
-            MotionController::startSmoothMove(targetAngles, duration);
-        } 
-        else 
+            if (!PoseManager::findPose(name, waypoints[count]))
+            {
+                Serial.print(F("ERRO: Pose '"));
+                Serial.print(name);
+                Serial.println(F("' nao encontrada."));
+                return;
+            }
+            count++;
+        }
+        if (count == 0)
         {
-            Serial.println(F("Formato inválido. Use: move <s0> <s1> <s2> <s3> <s4> <s5> <s6> [tempo]"));
+            Serial.println(F("Formato inválido. Use: spline <pose1> <pose2> ..."));
+            return;
         }
-    }
 
+        // Os pontos seguem um a um pela fila e são acumulados no core de movimento: o spline só é
+        // publicado se couber inteiro (pontos + SPLINE_RUN)
+        if (!CommandBus::hasRoom(count + 1))
+        {
+            Serial.println(F("ERRO: Fila de comandos cheia. Spline descartado."));
+            return;
+        }
+        Serial.print(F("Spline por "));
+        Serial.print(count);
+        Serial.println(F(" poses..."));
+        bool posted = true;
+        for (int i = 0; i < count && posted; i++)
+        {
+            CommandBus::Command point = CommandBus::make(CommandBus::SPLINE_POINT);
+            memcpy(point.angles, waypoints[i], sizeof(point.angles));
+            posted = CommandBus::post(point);
+        }
+        CommandBus::Command run = CommandBus::make(CommandBus::SPLINE_RUN);
+        run.arg = (uint8_t)count;
+        if (!posted || !CommandBus::post(run))
+            Serial.println(F("ERRO: Spline descartado (fila de comandos cheia)."));
+    }
 
     /**
      * @brief Exibe o menu de ajuda na Serial.
@@ -151,6 +296,15 @@ namespace CommandParser
         Serial.println(F("  move <s0> <s1> ... <s6> [tempo] -> Move todos os servos (tempo opcional, auto-calculado)."));
         Serial.println(F("  set <idx> <ang> [tempo]         -> Move um servo específico."));
         Serial.println(F("  set ombro <ang> [tempo]         -> Move os servos 1 e 2 juntos."));
+        Serial.println(F("  ik <x> <y> <z> [tempo]          -> Move a ponta para o ponto XYZ em mm (cinemática inversa)."));
+        Serial.println(F("  ikp <x> <y> <z> <pitch> [roll] [tempo] -> IK iterativo com pitch/roll da ferramenta (graus)."));
+        Serial.println(F("  movel <x> <y> <z> [mm/s]        -> Leva a ponta em linha reta até o ponto XYZ (IK a cada tick)."));
+        Serial.println(F("  spline <pose1> <pose2> ...      -> Passa pelas poses em uma curva contínua (para só na última)."));
+        Serial.println(F("  (movimentos são enfileirados e encadeados sem parar nos pontos intermediários)"));
+        Serial.println(F("  profile [ease|trap|scurve]      -> Seleciona o perfil de velocidade (trapezoidal, curva S ou legado)."));
+        Serial.println(F("  stop                            -> Desacelera até parar e descarta a fila (e a macro)."));
+        Serial.println(F("  pause                           -> Desacelera até parar mantendo a fila (e a macro)."));
+        Serial.println(F("  resume                          -> Continua o segmento/passo interrompido por 'pause'."));
         Serial.println(F("-----------------------------------------Comandos de Poses (Pontos Fixos):-----------------------------------------"));
         Serial.println(F("  pose save <nome>                -> Salva a posição atual (ex: HOME)."));
         Serial.println(F("  pose load <nome> [tempo]        -> Carrega a pose e move (tempo opcional)."));
@@ -161,26 +315,30 @@ namespace CommandParser
         Serial.println(F("  macro add <pose> <delay>        -> Adiciona a pose e o tempo de espera (só durante a gravação)."));
         Serial.println(F("  macro save                      -> Salva a macro em gravação."));
         Serial.println(F("  macro list                      -> Lista todas as macros salvas."));
-        Serial.println(F("  macro play <nome>               -> Executa a macro de forma não-bloqueante."));
-        Serial.println(F("  macro stop                      -> Interrompe a execução atual da macro."));
+        Serial.println(F("  macro play <nome> [spline]      -> Executa a macro (spline: sem parar entre passos sem espera)."));
+        Serial.println(F("  macro stop                      -> Interrompe a macro e desacelera o braço até parar."));
         Serial.println(F("  macro delete <nome> [ou all]    -> Apaga uma macro ou todas."));
         Serial.println(F("-----------------------------------------Comandos de Calibração/Sistema:-----------------------------------------"));
         Serial.println(F("  offset <idx> <valor>            -> Ajusta o offset de calibração do servo (+/-)."));
         Serial.println(F("  min <idx> <ang>                 -> Define o limite mínimo de software."));
         Serial.println(F("  max <idx> <ang>                 -> Define o limite máximo de software."));
         Serial.println(F("  align ombro [tempo]             -> Alinha servos 1 e 2 pela média."));
-        Serial.println(F("  status                          -> Exibe posições, limites e offsets atuais."));
-        Serial.println(F("  save                            -> Salva calibração e última posição na EEPROM."));
+        Serial.println(F("  status                          -> Exibe posições, limites, offsets e estatísticas do tick de movimento."));
+        Serial.println(F("  bench [n]                       -> Mede tick, IK, CRC e parser (n chamadas; CSV com ns e ciclos)."));
+        Serial.println(F("  perf [reset | every <ms>]       -> Tempos min/media/p99/max do loop e dos módulos (CSV)."));
+        Serial.println(F("  workspace                       -> Grade de alcançabilidade do IK: memória e erros medidos."));
+        Serial.println(F("  save                            -> Salva calibração e última posição na flash."));
+        Serial.println(F("  sync [quiet <ms>]               -> Grava na flash as edições pendentes; estatísticas de commit."));
         Serial.println(F("  load                            -> Carrega calibração e move para a última posição."));
         Serial.println(F("  help                            -> Exibe este menu."));
         Serial.println(F("\n--- Modo Gravação ---"));
         if (isRecording) {
             Serial.print(F("Gravacao ATIVA: Macro '"));
-        Serial.print(recordingMacro.name);
+        Serial.print(MacroManager::recordingName());
         Serial.print(F("'. Proximo Passo: "));
-        Serial.print(recordingMacro.numSteps + 1);
+        Serial.print(MacroManager::recordingLength() + 1);
         Serial.print(F("/"));
-        Serial.println(MAX_STEPS_PER_MACRO);
+        Serial.println(MACRO_MAX_STEPS);
         } else {
             Serial.println(F("Gravação INATIVA. Use 'macro create <nome>' para começar."));
         }
@@ -203,23 +361,17 @@ namespace CommandParser
                 unsigned long delay_ms = 0;
                 if (sscanf(cmd, "macro add %s %lu", poseName, &delay_ms) == 2)
                 {
-                    if (recordingMacro.numSteps < MAX_STEPS_PER_MACRO)
+                    // Os passos são gravados pelo id da pose: ela precisa existir
+                    if (MacroManager::addStep(poseName, delay_ms))
                     {
-                        strncpy(recordingMacro.steps[recordingMacro.numSteps].poseName, poseName, POSE_NAME_LEN - 1);
-                        recordingMacro.steps[recordingMacro.numSteps].delay_ms = delay_ms;
-                        recordingMacro.numSteps++;
                         Serial.print(F("Passo adicionado: Pose '"));
                         Serial.print(poseName);
                         Serial.print(F("', Delay "));
-                        Serial.print(delay_ms);
+                        Serial.print(min(delay_ms, MACRO_MAX_DELAY_MS));
                         Serial.print(F(" ms. Total: "));
-                        Serial.print(recordingMacro.numSteps);
+                        Serial.print(MacroManager::recordingLength());
                         Serial.print(F("/"));
-                        Serial.println(MAX_STEPS_PER_MACRO);
-                    }
-                    else
-                    {
-                        Serial.println(F("AVISO: Limite de passos atingido. Salve a macro."));
+                        Serial.println(MACRO_MAX_STEPS);
                     }
                 }
                 else
@@ -229,7 +381,7 @@ namespace CommandParser
             }
             else if (strcmp(cmd, "macro save") == 0)
             {
-                if (MacroManager::saveMacro(recordingMacro))
+                if (MacroManager::saveRecording())
                 {
                     isRecording = false; // Gravação concluída e salva
                 }
@@ -248,26 +400,54 @@ namespace CommandParser
         {
             handleMoveCommand(cmd);
         }
+        else if (strncmp(cmd, "ikp ", 4) == 0)
+        {
+            handleIkPoseCommand(cmd);
+        }
+        else if (strncmp(cmd, "ik ", 3) == 0)
+        {
+            handleIkCommand(cmd);
+        }
+        else if (strncmp(cmd, "movel ", 6) == 0)
+        {
+            handleMoveLinearCommand(cmd);
+        }
+        else if (strncmp(cmd, "profile", 7) == 0)
+        {
+            handleProfileCommand(cmd);
+        }
+        else if (strncmp(cmd, "spline ", 7) == 0)
+        {
+            handleSplineCommand(cmd);
+        }
+        else if (strcmp(cmd, "stop") == 0)
+        {
+            CommandBus::post(CommandBus::make(CommandBus::STOP));
+        }
+        else if (strcmp(cmd, "pause") == 0)
+        {
+            CommandBus::post(CommandBus::make(CommandBus::PAUSE));
+        }
+        else if (strcmp(cmd, "resume") == 0)
+        {
+            CommandBus::post(CommandBus::make(CommandBus::RESUME));
+        }
         // ** Macros **
         else if (strncmp(cmd, "macro create ", 13) == 0)
         {
             char name[POSE_NAME_LEN];
             if (sscanf(cmd, "macro create %s", name) == 1)
             {
-                if (!MacroManager::loadMacroByName(name, recordingMacro))
+                // Macro existente: os passos salvos são carregados e a gravação continua deles
+                if (MacroManager::beginRecording(name))
                 {
-                    Macro emptyMacro = {0};
-                    recordingMacro = emptyMacro;
-                    strncpy(recordingMacro.name, name, POSE_NAME_LEN - 1);
-                    recordingMacro.name[POSE_NAME_LEN - 1] = 0;
+                    isRecording = true;
+                    Serial.print(F("MODO GRAVACAO ATIVADO para macro '"));
+                    Serial.print(MacroManager::recordingName());
+                    Serial.println(F("'."));
+                    Serial.println(F("Use 'macro add <pose> <delay_ms>' e 'macro save' para finalizar."));
+                    printHelp();
                 }
-                
-                isRecording = true;
-                Serial.print(F("MODO GRAVACAO ATIVADO para macro '"));
-                Serial.print(recordingMacro.name);
-                Serial.println(F("'."));
-                Serial.println(F("Use 'macro add <pose> <delay_ms>' e 'macro save' para finalizar."));
-                printHelp();
             }
             else
             {
@@ -277,21 +457,27 @@ namespace CommandParser
         else if (strncmp(cmd, "macro play ", 11) == 0)
         {
             char name[POSE_NAME_LEN];
-            if (sscanf(cmd, "macro play %s", name) == 1)
+            char mode[8] = {0};
+            int params = sscanf(cmd, "macro play %9s %7s", name, mode);
+            if (params == 1 || (params == 2 && strcmp(mode, "spline") == 0))
             {
-                Sequencer::startMacro(name);
+                CommandBus::Command play = CommandBus::make(CommandBus::MACRO_PLAY);
+                snprintf(play.name, sizeof(play.name), "%s", name);
+                play.arg = (params == 2) ? 1 : 0;
+                CommandBus::post(play);
             }
             else
             {
-                Serial.println(F("Formato: macro play <nome>"));
+                Serial.println(F("Formato: macro play <nome> [spline]"));
             }
         }
         else if (strcmp(cmd, "macro stop") == 0)
         {
-            Sequencer::stopMacro();
+            CommandBus::post(CommandBus::make(CommandBus::MACRO_STOP));
         }
         else if (strcmp(cmd, "macro list") == 0)
         {
+            PERF_SCOPE(Perf::SERIAL_PRINT);
             MacroManager::listMacros();
         }
         else if (strncmp(cmd, "macro delete ", 13) == 0)
@@ -309,7 +495,7 @@ namespace CommandParser
             if (sscanf(cmd, "pose save %s", name) == 1)
             {
                 PoseManager::savePose(name);
-                Storage::saveToEEPROM();
+                Storage::saveState();
             }
             else
             {
@@ -318,6 +504,7 @@ namespace CommandParser
         }
         else if (strcmp(cmd, "pose list") == 0)
         {
+            PERF_SCOPE(Perf::SERIAL_PRINT);
             PoseManager::listPoses();
         }
         else if (strncmp(cmd, "pose delete ", 12) == 0)
@@ -332,15 +519,14 @@ namespace CommandParser
         {
             char name[POSE_NAME_LEN];
             unsigned long duration = 0;
-            int params = sscanf(cmd, "pose load %s %lu", name, &duration);
+            int params = sscanf(cmd, "pose load %9s %lu", name, &duration);
 
-            if (params == 1)
-            {
-                PoseManager::loadPoseByName(name);
-            }
-            else if (params == 2)
+            if (params == 1 || params == 2)
             {
-                PoseManager::loadPoseByName(name, duration);
+                CommandBus::Command load = CommandBus::make(CommandBus::POSE_LOAD);
+                snprintf(load.name, sizeof(load.name), "%s", name);
+                load.duration = (params == 2) ? duration : 0; // 0 = duração automática
+                CommandBus::post(load);
             }
             else
             {
@@ -367,24 +553,102 @@ namespace CommandParser
         }
         else if (strncmp(cmd, "align ombro", 11) == 0)
         {
-            Calibration::alignShoulders(cmd); 
+            CommandBus::Command align = CommandBus::make(CommandBus::ALIGN_SHOULDERS);
+            sscanf(cmd, "align ombro %lu", &align.duration);
+            CommandBus::post(align);
         }
         // ** Sistema **
         else if (strcmp(cmd, "save") == 0)
         {
-            Storage::saveToEEPROM(); 
+            Storage::saveState(); 
         }
         else if (strcmp(cmd, "load") == 0)
         {
-            Storage::loadFromEEPROM(true);
+            Storage::loadState(true);
         }
         else if (strcmp(cmd, "help") == 0 || strcmp(cmd, "h") == 0)
         {
+            PERF_SCOPE(Perf::SERIAL_PRINT);
             printHelp();
         }
+        else if (strcmp(cmd, "bench") == 0 || strncmp(cmd, "bench ", 6) == 0)
+        {
+            unsigned long iterations = BENCH_DEFAULT_ITERATIONS;
+            sscanf(cmd, "bench %lu", &iterations);
+            iterations = constrain(iterations, 1UL, BENCH_MAX_ITERATIONS);
+
+            // IK, CRC e parser rodam aqui; o tick é medido no core de movimento
+            Benchmark::printHeader();
+            Benchmark::runComms(iterations);
+            CommandBus::Command bench = CommandBus::make(CommandBus::BENCH);
+            bench.duration = iterations;
+            CommandBus::post(bench);
+        }
+        else if (strcmp(cmd, "perf") == 0)
+        {
+            Perf::print();
+        }
+        else if (strcmp(cmd, "perf reset") == 0)
+        {
+            Perf::reset();
+            Serial.println(F("Sondas de desempenho zeradas."));
+        }
+        else if (strncmp(cmd, "perf every ", 11) == 0)
+        {
+            unsigned long periodMs = 0;
+            if (sscanf(cmd, "perf every %lu", &periodMs) == 1)
+            {
+                Perf::setEmitPeriod(periodMs);
+                Serial.print(F("Relatorio 'perf' a cada "));
+                Serial.print(periodMs);
+                Serial.println(F(" ms (0 = desligado)."));
+            }
+            else
+            {
+                Serial.println(F("Formato: perf every <ms>"));
+            }
+        }
+        else if (strcmp(cmd, "sync") == 0)
+        {
+            const Storage::SyncResult result = Storage::sync();
+            if (result == Storage::SYNC_DEFERRED)
+            {
+                Serial.println(F("AVISO: Braco em movimento; as edicoes serao gravadas quando ele parar."));
+            }
+            else if (result == Storage::SYNC_FAILED)
+            {
+                Serial.println(F("ERRO ao gravar o log da flash!"));
+            }
+            Storage::printCommitStats();
+        }
+        else if (strncmp(cmd, "sync quiet ", 11) == 0)
+        {
+            unsigned long quietMs = 0;
+            if (sscanf(cmd, "sync quiet %lu", &quietMs) == 1)
+            {
+                Storage::setQuietTime(quietMs);
+                Serial.print(F("Gravacao na flash apos "));
+                Serial.print(quietMs);
+                Serial.println(F(" ms sem edicoes (com macro em execucao, so com o braco parado)."));
+            }
+            else
+            {
+                Serial.println(F("Formato: sync quiet <ms>"));
+            }
+        }
         else if (strcmp(cmd, "status") == 0)
         {
+            PERF_SCOPE(Perf::SERIAL_PRINT);
             Calibration::printStatus();
+            MotionController::printStats();
+            ServoOutput::printStats();
+            CommandBus::printStats();
+            Storage::printCommitStats();
+        }
+        else if (strcmp(cmd, "workspace") == 0)
+        {
+            PERF_SCOPE(Perf::SERIAL_PRINT);
+            Workspace::printStatus();
         }
         else
         {
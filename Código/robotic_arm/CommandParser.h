@@ -20,6 +20,12 @@ namespace CommandParser
      */
     void handleSerialInput();
 
+    /**
+     * @brief Interpreta e executa um comando já em minúsculas (sem o '\n').
+     * Usado pela leitura da Serial e pelo benchmark do parser.
+     */
+    void processCommand(const char *cmd);
+
 } // namespace CommandParser
 
 #endif // COMMAND_PARSER_H
@@ -4,67 +4,159 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
-#include <Arduino.h>
-#include <EEPROM.h>
-#include <ESP32Servo.h>
+#include "Platform.h" // Arduino/EEPROM/Servo (ESP32) ou HAL nativa (HOST_BUILD)
+#include "ArmModel.h"
 
 // --- Configurações Globais ---
-const int NUM_SERVOS = 7; // [0]Base, [1]Ombro1, [2]Ombro2, [3]Cotovelo, [4]Mão, [5]Pulso, [6]Garra
-const int EEPROM_SIZE = 4096;
+const char FIRMWARE_VERSION[] = "5.0"; // Versão reportada no boot e nos resultados do 'bench'
+
+// Modelo físico do braço (ArmModel.h): pinos, elos, limites seguros e pose neutra.
+// 0 = Mk1 (antebraço de 130 mm), 1 = Mk2 (antebraço de 150 mm, outra pinagem).
+#ifndef ARM_MODEL
+#define ARM_MODEL 0
+#endif
+#if ARM_MODEL == 1
+typedef ArmModelMk2 ActiveArm;
+#else
+typedef ArmModelMk1 ActiveArm;
+#endif
+
+const int NUM_SERVOS = ActiveArm::JOINTS; // [0]Base, [1]Ombro1, [2]Ombro2, [3]Cotovelo, [4]Mão, [5]Pulso, [6]Garra
+// Os comandos ('move', ROS) e as tabelas por junta (abaixo e em ArmModel.h) assumem o layout de 7 servos
+static_assert(NUM_SERVOS == 7, "Config.h: tabelas por junta e comandos assumem 7 servos");
+const int EEPROM_SIZE = 4096; // EEPROM legada: só lida na importação para o log da flash
 const uint32_t EEPROM_MAGIC = 0xDEADBEEF;
 
-// Mapeamento dos pinos do ESP32 para cada servo
-const int servoPins[NUM_SERVOS] = {18, 4, 13, 27, 26, 33, 32};
+// Faixa de pulso (µs) de cada servo do modelo ativo, correspondente a 0° e 180° (ArmModel.h)
+constexpr const uint16_t *SERVO_PULSE_MIN_US = ActiveArm::pulseMinUs();
+constexpr const uint16_t *SERVO_PULSE_MAX_US = ActiveArm::pulseMaxUs();
 
 // --- Configuração de Poses e Macros ---
-const int MAX_POSES = 10;
+// Slots do índice em RAM; o espaço para gravá-los vem do log da flash (ver Storage::printLibrarySpace)
+const int MAX_POSES = 512;
 const int POSE_NAME_LEN = 10;
-const int MAX_MACROS = 5;           // Número máximo de rotinas (Macros) que podem ser salvas
-const int MAX_STEPS_PER_MACRO = 16; // Número máximo de passos em uma Macro
+const int MAX_MACROS = 128;            // Número máximo de rotinas (Macros) que podem ser salvas
+const int MACRO_MAX_STEPS = 1024;      // Passos de uma macro (buffer de gravação de 4 KB; na execução são lidos da flash)
+const int MACRO_STEP_WINDOW = 16;      // Passos lidos da flash de cada vez pelo Sequencer
+const int MAX_POSES_V1 = 10;           // Slots do formato V1 (lidos só na migração)
+const int MAX_MACROS_V1 = 5;
+const int MAX_POSES_V2 = 64;           // Slots do formato compacto V2 (lidos só na migração)
+const int MAX_MACROS_V2 = 32;
+const int MAX_STEPS_PER_MACRO_V2 = 16; // Passos por macro nos formatos V1 e V2
 
 // --- Configuração de Velocidade ---
-const int DEFAULT_SPEED_MS_PER_DEGREE = 25;
-const int MIN_MOVE_DURATION = 300;
-
-struct ArmKinematicsConfig
-{
-  float baseHeightMm;
-  float upperLenMm;
-  float forearmLenMm;
-  float wristOffsetMm;
-  float gripperLenMm;
-  float minReachMm;
-  float maxReachMm;
-};
+const int DEFAULT_SPEED_MS_PER_DEGREE = 25; // Usado pelo perfil legado EaseInOutQuad
+const int MIN_MOVE_DURATION = 300;          // Duração mínima do perfil legado EaseInOutQuad
 
-struct NeutralPose
-{
-  int base;
-  int shoulder;
-  int elbow;
-  int hand;
-  int wristRotate;
-  int gripper;
-};
+// --- Limites Dinâmicos por Junta (perfis trapezoidal e curva S) ---
+// Do modelo ativo (ArmModel.h): cada variante tem as suas tabelas.
+constexpr const float *JOINT_MAX_VELOCITY = ActiveArm::maxVelocity(); // graus/s
+constexpr const float *JOINT_MAX_ACCEL = ActiveArm::maxAccel();       // graus/s²
+constexpr const float *JOINT_MAX_JERK = ActiveArm::maxJerk();         // graus/s³
+const uint8_t MOTION_DEFAULT_PROFILE = 1; // 0 = EaseInOutQuad (legado), 1 = Trapezoidal, 2 = Curva S (jerk mínimo)
 
-constexpr ArmKinematicsConfig ARM_KINEMATICS = {
-    100.0f, // baseHeightMm
-    120.0f, // upperLenMm
-    130.0f, // forearmLenMm
-    40.0f,  // wristOffsetMm
-    50.0f,  // gripperLenMm
-    80.0f,  // minReachMm
-    330.0f  // maxReachMm
-};
+// 1 = interpolação repouso-a-repouso em ponto fixo Q16 (tabelas constexpr, sem float/pow por tick).
+// 0 = interpolação em ponto flutuante. Diferença máxima entre os dois: < 0.006° em 180°.
+#ifndef MOTION_FIXED_POINT
+#define MOTION_FIXED_POINT 1
+#endif
 
-constexpr NeutralPose IK_NEUTRAL = {
-    90,  // base
-    130, // shoulder
-    100, // elbow
-    70,  // hand
-    120, // wristRotate
-    100  // gripper
-};
+// --- Configuração do Motor de Movimento (Tick Fixo) ---
+// 1 = interpolação roda em uma task FreeRTOS dedicada, disparada por um timer de hardware (esp_timer).
+// 0 = interpolação chamada a partir do loop() principal (modo legado), limitada à mesma taxa.
+#ifndef MOTION_USE_TASK
+#define MOTION_USE_TASK 1
+#endif
+const int MOTION_TICK_HZ = 200;         // Taxa fixa de interpolação (ex: 200 Hz ou 500 Hz)
+const int MIN_PROFILE_DURATION = 2 * 1000 / MOTION_TICK_HZ; // Duração automática mínima (2 ticks) dos perfis dinâmicos
+const int MOTION_TASK_CORE = 1;         // Core onde a task de movimento é fixada
+const int MOTION_TASK_PRIORITY = 5;     // Acima do loop() (prioridade 1)
+const int MOTION_TASK_STACK_SIZE = 4096; // Pilha da task de movimento (bytes)
+const int MOTION_QUEUE_SIZE = 16;        // Segmentos na fila (look-ahead); splines de macro mais longos são divididos
+
+// --- Divisão entre Cores (Comunicação x Movimento) ---
+// 1 = Serial/micro-ROS rodam em uma task fixada em COMMS_TASK_CORE e apenas publicam comandos no
+//     CommandBus; o loop() (core 1, junto com o tick de movimento) executa os comandos e o Sequencer.
+// 0 = tudo no loop() principal (modo legado de um core), usando o mesmo CommandBus.
+#ifndef COMMS_USE_TASK
+#define COMMS_USE_TASK 1
+#endif
+const int COMMS_TASK_CORE = 0;          // Core da comunicação (o mesmo da pilha Wi-Fi/BT, quando usada)
+const int COMMS_TASK_PRIORITY = 1;      // Mesma prioridade do loop()
+const int COMMS_TASK_STACK_SIZE = 8192; // Pilha da task de comunicação (bytes); parsing e micro-ROS
+const int COMMAND_QUEUE_SIZE = 32;      // Posições da fila de comandos (comporta 31 comandos pendentes)
+const int REPLY_QUEUE_SIZE = 32;        // Posições da fila de respostas do core de movimento (CommandBus::reply)
+
+// --- Sondas de Desempenho ('perf') ---
+// 1 = mede loop(), módulos, commits do armazenamento e saídas longas na Serial (ciclos, histograma em RAM fixa).
+// 0 = as sondas são removidas do código; 'perf' apenas informa que estão desativadas.
+#ifndef PERF_PROBES
+#define PERF_PROBES 1
+#endif
+const unsigned long PERF_EMIT_PERIOD_MS = 0; // Emissão automática do relatório 'perf' (0 = desligada)
+
+// --- Gravação adiada (Storage::markDirty / Storage::service) ---
+// Os saves só alteram o estado em RAM; vários saves viram um único commit no log da flash
+// (um registro por slot alterado). Antes de desligar: 'sync'. O commit só acontece com o braço
+// parado: apagar/gravar a flash desliga o cache dos dois cores e o tick de movimento não está na
+// IRAM, então ele fica parado até o commit terminar.
+const unsigned long STORAGE_IDLE_COMMIT_MS = 250;   // Braço parado e sem edições há este tempo: grava
+const unsigned long STORAGE_QUIET_COMMIT_MS = 3000; // Sem edições há este tempo: grava com macro em execução, na espera de um passo ('sync quiet <ms>')
+// 1 = grava a última posição (7 B de ângulos, registro de 16 B) ao fim de cada movimento; 0 = só no 'save'
+#ifndef STORAGE_SAVE_POSITION_ON_STOP
+#define STORAGE_SAVE_POSITION_ON_STOP 1
+#endif
+
+// --- Log de Registros na Flash (LogStore) ---
+const char LOG_PARTITION_LABEL[] = "armlog"; // Partição de dados do partitions.csv
+const uint32_t LOG_SECTOR_SIZE = 4096;       // Setor de apagamento da flash SPI
+const int LOG_MAX_SECTORS = 64;              // Setores usados da partição (no máximo 256 KB)
+const int LOG_RESERVE_SECTORS = 3;           // Folga (setores) que o snapshot ainda precisa ter livre
+const int LOG_MAX_PAYLOAD = 256;             // Maior fragmento (bytes de dados); registros maiores são fragmentados
+
+// --- Benchmark ('bench') ---
+const unsigned long BENCH_DEFAULT_ITERATIONS = 1000; // Chamadas por kernel
+const unsigned long BENCH_MAX_ITERATIONS = 20000;    // Mantém cada kernel bem abaixo da volta do contador de ciclos
+const unsigned long BENCH_TICK_SEGMENT_MS = 60000;   // Segmento parado usado para medir o tick de movimento
+
+// Elos e pose neutra do IK do modelo ativo (ArmModel.h)
+constexpr ArmKinematicsConfig ARM_KINEMATICS = ActiveArm::kinematics();
+constexpr NeutralPose IK_NEUTRAL = ActiveArm::neutral();
+
+// 1 = IK/FK usam as aproximações polinomiais de FastMath.h (atan2/acos/sin/cos, erro < 2e-6 rad).
+// 0 = libm (atan2f/acosf/sinf/cosf). solveBatch usa sempre o atan2 polinomial (sem desvios).
+#ifndef KINEMATICS_FAST_MATH
+#define KINEMATICS_FAST_MATH 1
+#endif
+
+// Peso de cada junta no custo padrão dos ramos do IK (InverseKinematics::weightedJointDistance).
+// O comando 'ik' usa o tempo do modelo de duração (MotionController::durationBetween).
+const float IK_BRANCH_WEIGHTS[NUM_SERVOS] = {1.0f, 1.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f}; // Servo 2 repete o 1
+
+// --- Movimento Linear Cartesiano ('movel') ---
+// A ponta percorre uma reta em XYZ; o IK é resolvido a cada tick de movimento.
+const float LINEAR_DEFAULT_SPEED = 40.0f;   // mm/s quando a velocidade não é informada
+const float LINEAR_MAX_SPEED = 150.0f;      // mm/s (as juntas podem limitar ainda mais)
+const float LINEAR_MAX_ACCEL = 200.0f;      // mm/s²
+const float LINEAR_MAX_JERK = 1000.0f;      // mm/s³ (curva S)
+const float LINEAR_CHECK_STEP_MM = 2.0f;    // Espaçamento dos pontos da reta verificados antes de mover
+const float LINEAR_MAX_JOINT_STEP = 5.0f;   // Graus entre pontos vizinhos; acima disso há singularidade/troca de ramo
+const float LINEAR_ALIGN_TOLERANCE = 0.5f;  // Graus; acima disso a pose inicial é alinhada ao IK antes da reta
+
+// --- Área de Trabalho Pré-Calculada (Workspace) ---
+// Grade (distância planar x elevação) com os ângulos do IK, gerada na compilação e guardada na flash.
+// Tabela: 6 bytes por nó (34 x 67 nós com 10 mm = 13.7 KB); mapa de alcançabilidade: 1 bit por nó em RAM.
+const int WORKSPACE_CELL_MM = 10;
+
+// --- IK Iterativo (Mínimos Quadrados Amortecidos, 'ikp') ---
+// Posição + pitch da ferramenta; parte da pose atual e respeita os limites dentro das iterações.
+const int IK_DLS_MAX_ITERATIONS = 16;
+static_assert(IK_DLS_MAX_ITERATIONS < 0x8000, "Config.h: PoseReport::iterations soma duas tentativas em 16 bits");
+const float IK_DLS_TOLERANCE_MM = 0.1f;     // Erro de posição aceito
+const float IK_DLS_TOLERANCE_DEG = 0.1f;    // Erro de pitch aceito
+const float IK_DLS_DAMPING_MM = 5.0f;       // Amortecimento (lambda): limita o passo perto de singularidades
+const float IK_DLS_PITCH_WEIGHT_MM = 100.0f; // mm equivalentes a 1 rad de erro de pitch
+const float IK_DLS_MAX_STEP_DEG = 20.0f;    // Maior variação de junta por iteração
 
 // --- Estruturas de Dados ---
 
@@ -81,19 +173,22 @@ struct StoredData
 };
 
 /**
- * @brief Estrutura OTIMIZADA V2 para salvar estado (35 bytes vs 116 bytes V1).
+ * @brief Estrutura OTIMIZADA V2 para salvar estado (35 bytes vs 116 bytes V1 com 7 juntas).
  * Usa uint8_t para ângulos (0-180° cabe em 1 byte) e inclui CRC16 para validação.
+ * O tamanho segue o número de juntas do modelo (Arm::JOINTS).
  */
-struct StoredDataV2
+template <class Arm>
+struct StoredDataV2Layout
 {
-  uint32_t magic;              /**< Identificador de dados válidos (0xDEADBEEF). */
-  uint8_t version;             /**< Versão do formato (2). */
-  uint8_t current[NUM_SERVOS]; /**< Última posição conhecida (0-180°). */
-  uint8_t minv[NUM_SERVOS];    /**< Limites mínimos (0-180°). */
-  uint8_t maxv[NUM_SERVOS];    /**< Limites máximos (0-180°). */
-  int8_t offs[NUM_SERVOS];     /**< Offsets de calibração (-127 a +127). */
-  uint16_t crc16;              /**< CRC16 para validação de integridade. */
+  uint32_t magic;               /**< Identificador de dados válidos (0xDEADBEEF). */
+  uint8_t version;              /**< Versão do formato (2). */
+  uint8_t current[Arm::JOINTS]; /**< Última posição conhecida (0-180°). */
+  uint8_t minv[Arm::JOINTS];    /**< Limites mínimos (0-180°). */
+  uint8_t maxv[Arm::JOINTS];    /**< Limites máximos (0-180°). */
+  int8_t offs[Arm::JOINTS];     /**< Offsets de calibração (-127 a +127). */
+  uint16_t crc16;               /**< CRC16 para validação de integridade. */
 } __attribute__((packed));
+typedef StoredDataV2Layout<ActiveArm> StoredDataV2;
 
 /**
  * @brief Estrutura para salvar uma pose (conjunto de ângulos) - V1 LEGACY.
@@ -104,23 +199,30 @@ struct Pose
   int angles[NUM_SERVOS];   /**< Ângulos para cada servo. */
 };
 
+const uint8_t RECORD_USED = 0x01; /**< Bit de 'flags' dos registros compactos: slot ocupado. */
+
 /**
- * @brief Estrutura OTIMIZADA para pose (8 bytes vs 38 bytes V1).
+ * @brief Estado de um slot compacto (pose ou macro) lido da EEPROM.
  */
-struct PoseCompact
+enum RecordState : uint8_t
 {
-  uint8_t angles[NUM_SERVOS]; /**< Ângulos (0-180°, 1 byte cada). */
-  uint8_t flags;              /**< Flags reservadas para uso futuro. */
-} __attribute__((packed));
-
-// --- Endereços de Memória (Start) ---
-// V1 (LEGACY - compatibilidade temporária)
-const int POSES_START = sizeof(StoredData);
-const int MACROS_START = POSES_START + (MAX_POSES * sizeof(struct Pose));
+  RECORD_EMPTY,  /**< Slot livre. */
+  RECORD_VALID,  /**< Ocupado e com CRC correto. */
+  RECORD_CORRUPT /**< Ocupado, mas o CRC não confere (tratado como livre ao salvar). */
+};
 
-// V2 (OTIMIZADO - novo formato)
-const int POSES_START_V2 = sizeof(StoredDataV2);
-const int MACROS_START_V2 = POSES_START_V2 + (MAX_POSES * sizeof(PoseCompact));
+/**
+ * @brief Estrutura OTIMIZADA para pose (10 bytes vs 38 bytes V1 com 7 juntas).
+ * O nome fica na NameTable; o CRC cobre o nome e a pose.
+ */
+template <class Arm>
+struct PoseCompactLayout
+{
+  uint8_t angles[Arm::JOINTS]; /**< Ângulos (0-180°, 1 byte cada). */
+  uint8_t flags;               /**< RECORD_USED; demais bits reservados. */
+  uint16_t crc16;              /**< CRC16 do nome + ângulos + flags. */
+} __attribute__((packed));
+typedef PoseCompactLayout<ActiveArm> PoseCompact;
 
 /**
  * @brief Estrutura para definir um único passo dentro de uma Macro - V1 LEGACY.
@@ -136,51 +238,128 @@ struct MacroStep
  */
 struct MacroStepCompact
 {
-  uint8_t poseIndex; /**< Índice da pose (0-9 para MAX_POSES=10). */
+  uint8_t poseIndex; /**< Slot da pose (0 a MAX_POSES_V2-1) ou MACRO_STEP_NO_POSE. */
   uint16_t delay_ms; /**< Delay em ms (0-65535, ~65 segundos). */
 } __attribute__((packed));
 
+const uint8_t MACRO_STEP_NO_POSE = 0xFF;     /**< Passo cuja pose foi apagada (a macro aborta nele). */
+const unsigned long MACRO_MAX_DELAY_MS = 65535; /**< Maior espera que cabe em MacroStepCompact. */
+
 /**
  * @brief Estrutura para definir uma sequência completa de movimentos e esperas - V1 LEGACY.
  */
 struct Macro
 {
-  char name[POSE_NAME_LEN];             /**< Nome da Macro. */
-  int numSteps;                         /**< Número de passos atualmente usados na sequência. */
-  MacroStep steps[MAX_STEPS_PER_MACRO]; /**< Lista de passos da rotina. */
+  char name[POSE_NAME_LEN];                /**< Nome da Macro. */
+  int numSteps;                            /**< Número de passos atualmente usados na sequência. */
+  MacroStep steps[MAX_STEPS_PER_MACRO_V2]; /**< Lista de passos da rotina. */
 };
 
 /**
- * @brief Estrutura OTIMIZADA de Macro (50 bytes vs 238 bytes V1).
+ * @brief Estrutura OTIMIZADA de Macro (52 bytes vs 238 bytes V1) - V2 LEGACY.
  */
 struct MacroCompact
 {
-  uint8_t numSteps;                            /**< Número de passos (0-16). */
-  uint8_t flags;                               /**< Flags reservadas. */
-  MacroStepCompact steps[MAX_STEPS_PER_MACRO]; /**< Passos compactos. */
+  uint8_t numSteps;                               /**< Número de passos (0-16). */
+  uint8_t flags;                                  /**< RECORD_USED; demais bits reservados. */
+  MacroStepCompact steps[MAX_STEPS_PER_MACRO_V2]; /**< Passos compactos. */
+  uint16_t crc16;                                 /**< CRC16 do nome + passos + flags. */
 } __attribute__((packed));
 
-// --- Tabela de Nomes (para UI) ---
+// --- Tabela de Nomes ---
 /**
- * @brief Tabela de nomes das poses e macros (mantida em RAM para interface).
- * Estruturas compactas não armazenam nomes para economizar EEPROM.
+ * @brief Tabela de nomes das poses e macros, gravada à parte dos registros compactos
+ * (slot i da tabela = slot i das poses/macros). Nome vazio = slot livre.
  */
 struct NameTable
 {
-  char poseNames[MAX_POSES][POSE_NAME_LEN];   /**< Nomes das poses. */
-  char macroNames[MAX_MACROS][POSE_NAME_LEN]; /**< Nomes das macros. */
+  char poseNames[MAX_POSES_V2][POSE_NAME_LEN];   /**< Nomes das poses. */
+  char macroNames[MAX_MACROS_V2][POSE_NAME_LEN]; /**< Nomes das macros. */
+};
+
+/**
+ * @brief Cabeçalho da biblioteca V2 (poses + macros). Sem ele, o boot migra os slots V1.
+ */
+struct LibraryHeaderV2
+{
+  uint32_t magic;        /**< LIBRARY_MAGIC. */
+  uint8_t version;       /**< Versão do formato (2). */
+  uint8_t poseCapacity;  /**< MAX_POSES_V2 com que a biblioteca foi formatada. */
+  uint8_t macroCapacity; /**< MAX_MACROS_V2 com que a biblioteca foi formatada. */
+  uint16_t crc16;        /**< CRC16 dos campos acima. */
+} __attribute__((packed));
+
+const uint32_t LIBRARY_MAGIC = 0x3242494C; // "LIB2"
+
+// --- Endereços de Memória (Start) ---
+// V1 (LEGACY - lido apenas pela migração)
+const int POSES_START = sizeof(StoredData);
+const int MACROS_START = POSES_START + (MAX_POSES_V1 * sizeof(struct Pose));
+
+// V2: calibração | cabeçalho | nomes | poses | macros
+const int LIBRARY_START_V2 = sizeof(StoredDataV2);
+const int NAMES_START_V2 = LIBRARY_START_V2 + sizeof(LibraryHeaderV2);
+const int POSES_START_V2 = NAMES_START_V2 + sizeof(NameTable);
+const int MACROS_START_V2 = POSES_START_V2 + (MAX_POSES_V2 * sizeof(PoseCompact));
+const int LIBRARY_END_V2 = MACROS_START_V2 + (MAX_MACROS_V2 * sizeof(MacroCompact));
+static_assert(LIBRARY_END_V2 <= EEPROM_SIZE, "Config.h: poses e macros V2 nao cabem na EEPROM");
+static_assert(MAX_POSES_V2 < MACRO_STEP_NO_POSE, "Config.h: indice de pose precisa caber em MacroStepCompact");
+
+// --- Registros do Log da Flash (Storage <-> LogStore) ---
+/**
+ * @brief Tipos de registro gravados pelo Storage (0x01-0x0F são reservados ao LogStore).
+ * O id é o slot (poses e macros) ou 0. Um registro sem dados apaga a chave.
+ */
+enum LogRecordType : uint8_t
+{
+  LOG_RECORD_CONFIG = 0x10,       /**< StoredDataV2: calibração e posição (comando 'save'). */
+  LOG_RECORD_POSITION = 0x11,     /**< Só a última posição (fim de movimento). */
+  LOG_RECORD_POSE = 0x20,         /**< PoseRecord do slot 'id'. */
+  LOG_RECORD_MACRO = 0x22,        /**< MacroRecordHeader + numSteps MacroStepRecord do slot 'id' (fragmentado se longo). */
+  LOG_RECORD_POSE_LAST_ID = 0x23  /**< Maior id de pose já usado (gravado nos snapshots). */
 };
 
+const uint16_t POSE_ID_NONE = 0; /**< Id de pose inválido (passo de uma pose que não existe mais). */
+
+/**
+ * @brief Dados de um registro de pose no log.
+ */
+struct PoseRecord
+{
+  char name[POSE_NAME_LEN];   /**< Nome (terminado em nulo). */
+  uint8_t angles[NUM_SERVOS]; /**< Ângulos (0-180°). */
+  uint16_t id;                /**< Id permanente da pose (os passos das macros apontam para ele). */
+} __attribute__((packed));
+
+/**
+ * @brief Passo de macro no log: a pose pelo id, então apagar a pose ou reaproveitar o slot não
+ * muda a macro (o passo deixa de achar a pose e a macro aborta nele).
+ */
+struct MacroStepRecord
+{
+  uint16_t poseId;   /**< PoseRecord::id, ou POSE_ID_NONE. */
+  uint16_t delay_ms; /**< Espera após atingir a pose (até MACRO_MAX_DELAY_MS). */
+} __attribute__((packed));
+
+/**
+ * @brief Início de um registro de macro no log; seguem numSteps MacroStepRecord.
+ */
+struct MacroRecordHeader
+{
+  char name[POSE_NAME_LEN]; /**< Nome (terminado em nulo). */
+  uint16_t numSteps;        /**< Passos que seguem o cabeçalho. */
+} __attribute__((packed));
+
 // --- Funções Utilitárias ---
 /**
  * @brief Calcula CRC16 (padrão Modbus) para validação de dados.
  * @param data Ponteiro para os dados.
  * @param len Tamanho dos dados em bytes.
+ * @param crc Valor inicial; passe o CRC de um bloco anterior para cobrir dois blocos seguidos.
  * @return Valor CRC16 calculado.
  */
-inline uint16_t calcCRC16(const uint8_t *data, size_t len)
+inline uint16_t calcCRC16(const uint8_t *data, size_t len, uint16_t crc = 0xFFFF)
 {
-  uint16_t crc = 0xFFFF;
   for (size_t i = 0; i < len; i++)
   {
     crc ^= data[i];
@@ -202,7 +381,8 @@ inline uint16_t calcCRC16(const uint8_t *data, size_t len)
 // --- Variáveis Globais Core (Extern) ---
 
 // Variáveis de calibração e posição
-extern int currentAngles[NUM_SERVOS]; /**< Última posição lógica interpolada de cada servo (0-180°). */
+extern int currentAngles[NUM_SERVOS]; /**< Última posição lógica interpolada de cada servo, arredondada (0-180°). */
+extern float currentAnglesF[NUM_SERVOS]; /**< Posição lógica interpolada com fração de grau (usada na saída em µs). */
 extern int minAngles[NUM_SERVOS];     /**< Ângulo mínimo permitido (limite de software). */
 extern int maxAngles[NUM_SERVOS];     /**< Ângulo máximo permitido (limite de software). */
 extern int offsets[NUM_SERVOS];       /**< Offset de calibração aplicado antes de escrever no servo (-90 a +90). */
@@ -0,0 +1,149 @@
+/**
+ * @file FastMath.h
+ * @brief Aproximações polinomiais de atan2, acos, sin e cos para a cinemática (IK/FK).
+ *
+ * A FPU do ESP32 só tem soma, multiplicação e raiz em precisão simples: as funções da libm
+ * (atan2f/acosf/sinf/cosf) são rotinas em software com desvios e redução de argumento geral.
+ * Aqui cada função é um polinômio minimax curto com redução de argumento simples.
+ * Erros máximos medidos contra a libm em double (host/bench_fast_math.cpp, grade densa):
+ *
+ * | Função        | Domínio          | Erro absoluto máximo |
+ * | ------------- | ---------------- | -------------------- |
+ * | atan2(y, x)   | qualquer (y, x)  | 2.0e-6 rad           |
+ * | acos(x)       | [-1, 1]          | 4.3e-7 rad           |
+ * | sin/cos(x)    | [-100, 100] rad  | 9.2e-8               |
+ *
+ * KinMath escolhe, por build, entre estas aproximações e a libm (KINEMATICS_FAST_MATH, Config.h).
+ */
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+
+#include "Config.h"
+
+#include <math.h>
+
+namespace FastMath
+{
+
+    /**
+     * @brief atan2 sem desvios (só aritmética e seleções): vetorizável em InverseKinematics::solveBatch.
+     * Polinômio de grau 11 em atan(a), a = min/max em [0, 1].
+     */
+    inline float atan2(float y, float x)
+    {
+        const float ax = fabsf(x);
+        const float ay = fabsf(y);
+        const float mn = ax < ay ? ax : ay;
+        const float mx = ax < ay ? ay : ax;
+        const float a = mn / (mx + 1e-30f);
+        const float s = a * a;
+        float r = ((((((-0.0117212f * s) + 0.05265332f) * s - 0.11643287f) * s + 0.19354346f) * s - 0.33262347f) * s +
+                   0.99997726f) * a;
+        r = ay > ax ? 1.57079637f - r : r;
+        r = x < 0.0f ? 3.14159274f - r : r;
+        return y < 0.0f ? -r : r;
+    }
+
+    /**
+     * @brief acos(x) = sqrt(1 - |x|)·P(|x|) (Abramowitz & Stegun 4.4.46), refletido para x < 0.
+     * Entradas fora de [-1, 1] são limitadas.
+     */
+    inline float acos(float x)
+    {
+        float ax = fabsf(x);
+        ax = ax > 1.0f ? 1.0f : ax;
+        const float p = (((((((-0.0012624911f * ax + 0.0066700901f) * ax - 0.0170881256f) * ax + 0.0308918810f) * ax -
+                             0.0501743046f) * ax + 0.0889789874f) * ax - 0.2145988016f) * ax + 1.5707963050f) *
+                        sqrtf(1.0f - ax);
+        return x < 0.0f ? 3.14159274f - p : p;
+    }
+
+    /**
+     * @brief Seno e cosseno com uma redução só: x = k·PI/2 + r, |r| <= PI/4 (PI/2 em três partes,
+     * Cody-Waite), e polinômios minimax de grau 7 (sin) e 8 (cos) em r.
+     * Válido para |x| < 1e5 rad (k cabe em int e a redução mantém a precisão).
+     */
+    inline void sinCos(float x, float &s, float &c)
+    {
+        const float q = x * 0.636619772f; // 2/PI
+        const int k = static_cast<int>(q >= 0.0f ? q + 0.5f : q - 0.5f);
+        const float kf = static_cast<float>(k);
+        const float r = ((x - kf * 1.5703125f) - kf * 4.837512969970703125e-4f) - kf * 7.54978995489188216e-8f;
+        const float z = r * r;
+        const float sr = r + r * z * (-1.6666654611e-1f + z * (8.3321608736e-3f + z * -1.9515295891e-4f));
+        const float cr = 1.0f - 0.5f * z + z * z * (4.166664568298827e-2f + z * (-1.388731625493765e-3f +
+                                                                                 z * 2.443315711809948e-5f));
+        switch (k & 3)
+        {
+        case 0:
+            s = sr;
+            c = cr;
+            break;
+        case 1:
+            s = cr;
+            c = -sr;
+            break;
+        case 2:
+            s = -sr;
+            c = -cr;
+            break;
+        default:
+            s = -cr;
+            c = sr;
+            break;
+        }
+    }
+
+    inline float sin(float x)
+    {
+        float s, c;
+        sinCos(x, s, c);
+        return s;
+    }
+
+    inline float cos(float x)
+    {
+        float s, c;
+        sinCos(x, s, c);
+        return c;
+    }
+
+} // namespace FastMath
+
+/**
+ * @brief Trigonometria usada pela cinemática: FastMath (KINEMATICS_FAST_MATH = 1) ou libm (0).
+ */
+namespace KinMath
+{
+
+#if KINEMATICS_FAST_MATH
+    inline float atan2(float y, float x) { return FastMath::atan2(y, x); }
+    inline float acos(float x) { return FastMath::acos(x); }
+    inline void sinCos(float x, float &s, float &c) { FastMath::sinCos(x, s, c); }
+#else
+    inline float atan2(float y, float x) { return atan2f(y, x); }
+    inline float acos(float x) { return acosf(x); }
+    inline void sinCos(float x, float &s, float &c)
+    {
+        s = sinf(x);
+        c = cosf(x);
+    }
+#endif
+
+    inline float sin(float x)
+    {
+        float s, c;
+        sinCos(x, s, c);
+        return s;
+    }
+
+    inline float cos(float x)
+    {
+        float s, c;
+        sinCos(x, s, c);
+        return c;
+    }
+
+} // namespace KinMath
+
+#endif // FAST_MATH_H
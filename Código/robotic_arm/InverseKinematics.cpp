@@ -1,5 +1,7 @@
 #include "InverseKinematics.h"
+#include "ArmKinematics.h"
 #include "Config.h"
+#include "FastMath.h"
 
 #include <math.h>
 
@@ -14,10 +16,9 @@ namespace
         return value;
     }
 
-    inline int clampServoAngle(float value, int servoIdx)
+    inline float clampServoAngle(float value, int servoIdx)
     {
-        const int rounded = static_cast<int>(roundf(value));
-        return constrain(rounded, minAngles[servoIdx], maxAngles[servoIdx]);
+        return clampf(value, static_cast<float>(minAngles[servoIdx]), static_cast<float>(maxAngles[servoIdx]));
     }
 
     inline float radToDeg(float rad)
@@ -36,96 +37,437 @@ namespace
     }
 
     constexpr float EPSILON = 1e-3f;
+
+    /**
+     * Versão sem desvios de clampf; soma em 'limited' se o valor estava fora do intervalo.
+     */
+    inline float clampFlag(float value, float minValue, float maxValue, int &limited)
+    {
+        limited |= static_cast<int>(value < minValue) | static_cast<int>(value > maxValue);
+        value = value < minValue ? minValue : value;
+        return value > maxValue ? maxValue : value;
+    }
 }
 
 namespace InverseKinematics
 {
-    bool solveXYZ(float x, float y, float z, int targetAngles[NUM_SERVOS])
+    namespace
     {
-        const float planar = sqrtf((x * x) + (y * y));
-        const float baseAngleRad = atan2f(y, x);
-        const float baseAngleDeg = radToDeg(baseAngleRad) + IK_NEUTRAL.base;
-        targetAngles[0] = clampServoAngle(baseAngleDeg, 0);
+        typedef ArmKinematics<ActiveArm> Kinematics;
 
-        const float elevation = z - ARM_KINEMATICS.baseHeightMm;
-        const float rawDistance = sqrtf((planar * planar) + (elevation * elevation));
-        if (rawDistance < EPSILON)
+        bool solveElbowBranch(float x, float y, float z, float elbowSign, float targetAngles[NUM_SERVOS], bool &inexact,
+                              bool &mirrorable)
         {
-            return false;
+            return Kinematics::solveBranch(x, y, z, elbowSign, minAngles, maxAngles, targetAngles, inexact, mirrorable);
         }
+    }
 
-        const float wristExtension = ARM_KINEMATICS.wristOffsetMm + ARM_KINEMATICS.gripperLenMm;
+    bool solveXYZ(float x, float y, float z, float targetAngles[NUM_SERVOS])
+    {
+        bool inexact, mirrorable;
+        return solveElbowBranch(x, y, z, 1.0f, targetAngles, inexact, mirrorable);
+    }
 
-        float clippedDistance = clampf(rawDistance, ARM_KINEMATICS.minReachMm, ARM_KINEMATICS.maxReachMm);
-        if (clippedDistance <= wristExtension + 5.0f)
+    float weightedJointDistance(const float from[NUM_SERVOS], const float to[NUM_SERVOS])
+    {
+        float cost = 0.0f;
+        for (int i = 0; i < NUM_SERVOS; i++)
         {
-            clippedDistance = wristExtension + 5.0f;
+            cost += IK_BRANCH_WEIGHTS[i] * fabsf(to[i] - from[i]);
         }
+        return cost;
+    }
 
-        float wristDistance = clippedDistance - wristExtension;
-        if (wristDistance < 5.0f)
+    int solveBranches(float x, float y, float z, const float from[NUM_SERVOS], IkBranch branches[IK_MAX_BRANCHES],
+                      BranchCost cost)
+    {
+        bool inexact, mirrorable;
+        if (!solveElbowBranch(x, y, z, 1.0f, branches[0].angles, inexact, mirrorable))
         {
-            wristDistance = 5.0f;
+            return 0;
         }
+        branches[0].elbow = ELBOW_DOWN;
+        branches[0].exact = !inexact;
+        branches[0].cost = cost(from, branches[0].angles);
 
-        const float scale = wristDistance / rawDistance;
-        const float effPlanar = planar * scale;
-        const float effElevation = elevation * scale;
-
-        const float L1 = ARM_KINEMATICS.upperLenMm;
-        const float L2 = ARM_KINEMATICS.forearmLenMm;
+        bool mirroredInexact, unused;
+        if (!mirrorable || !solveElbowBranch(x, y, z, -1.0f, branches[1].angles, mirroredInexact, unused))
+        {
+            return 1;
+        }
+        branches[1].elbow = ELBOW_UP;
+        branches[1].exact = !mirroredInexact;
+        branches[1].cost = cost(from, branches[1].angles);
 
-        float cosElbow = ((effPlanar * effPlanar) + (effElevation * effElevation) - (L1 * L1) - (L2 * L2)) / (2.0f * L1 * L2);
-        cosElbow = clampf(cosElbow, -1.0f, 1.0f);
-        const float elbowRad = acosf(cosElbow);
+        // Exatos primeiro; entre iguais, o de menor custo
+        const bool swapBranches = (branches[1].exact != branches[0].exact) ? branches[1].exact
+                                                                          : branches[1].cost < branches[0].cost;
+        if (swapBranches)
+        {
+            const IkBranch first = branches[0];
+            branches[0] = branches[1];
+            branches[1] = first;
+        }
+        return 2;
+    }
 
-        const float shoulderRad = atan2f(effElevation, effPlanar) - atan2f(L2 * sinf(elbowRad), L1 + (L2 * cosf(elbowRad)));
-        if (!isFinite(shoulderRad) || !isFinite(elbowRad))
+    namespace
+    {
+        /**
+         * Laço do lote. As saídas de cada junta são copiadas para ponteiros __restrict locais para o
+         * compilador não precisar testar sobreposição entre os buffers (o que impediria a vetorização).
+         */
+        void batchKernel(const float *__restrict x, const float *__restrict y, const float *__restrict z, int count,
+                         float *const joints[NUM_SERVOS], uint8_t *__restrict status)
         {
-            return false;
+            float *__restrict base = joints[ActiveArm::BASE];
+            float *__restrict shoulderOut = joints[ActiveArm::SHOULDER];
+            float *__restrict mirror = joints[ActiveArm::SHOULDER_MIRROR];
+            float *__restrict elbow = joints[ActiveArm::ELBOW];
+            float *__restrict hand = joints[ActiveArm::HAND];
+            float *__restrict wristRotate = joints[ActiveArm::WRIST_ROTATE];
+            float *__restrict gripperOut = joints[ActiveArm::GRIPPER];
+
+            // Limites e constantes carregados uma vez (não a cada ponto)
+            float lo[NUM_SERVOS];
+            float hi[NUM_SERVOS];
+            for (int j = 0; j < NUM_SERVOS; j++)
+            {
+                lo[j] = static_cast<float>(minAngles[j]);
+                hi[j] = static_cast<float>(maxAngles[j]);
+            }
+            const float L1 = ARM_KINEMATICS.upperLenMm;
+            const float L2 = ARM_KINEMATICS.forearmLenMm;
+            const float wristExtension = ARM_KINEMATICS.wristOffsetMm + ARM_KINEMATICS.gripperLenMm;
+            const float minClip = wristExtension + 5.0f;
+            const float inv2L1L2 = 1.0f / (2.0f * L1 * L2);
+            const float l1l2Sq = (L1 * L1) + (L2 * L2);
+            const float RAD_DEG = 180.0f / static_cast<float>(PI);
+            const float gripper = clampf(IK_NEUTRAL.gripper, lo[ActiveArm::GRIPPER], hi[ActiveArm::GRIPPER]);
+
+            // Mesmo modelo de solveXYZ, sem desvios nem chamadas à libm dentro do laço
+            for (int i = 0; i < count; i++)
+            {
+                const float px = x[i];
+                const float py = y[i];
+                const float planar = sqrtf((px * px) + (py * py));
+                const float baseDeg = (FastMath::atan2(py, px) * RAD_DEG) + IK_NEUTRAL.base;
+
+                const float elevation = z[i] - ARM_KINEMATICS.baseHeightMm;
+                const float rawDistance = sqrtf((planar * planar) + (elevation * elevation));
+                const bool valid = rawDistance >= EPSILON; // Falso também para NaN
+                const float safeDistance = valid ? rawDistance : 1.0f;
+
+                int reachClipped = 0;
+                float clipped = clampFlag(rawDistance, ARM_KINEMATICS.minReachMm, ARM_KINEMATICS.maxReachMm,
+                                          reachClipped);
+                reachClipped |= static_cast<int>(clipped < minClip);
+                clipped = clipped < minClip ? minClip : clipped;
+                float wristDistance = clipped - wristExtension;
+                wristDistance = wristDistance < 5.0f ? 5.0f : wristDistance;
+
+                const float scale = wristDistance / safeDistance;
+                const float effPlanar = planar * scale;
+                const float effElevation = elevation * scale;
+
+                float cosElbow = ((effPlanar * effPlanar) + (effElevation * effElevation) - l1l2Sq) * inv2L1L2;
+                cosElbow = cosElbow < -1.0f ? -1.0f : (cosElbow > 1.0f ? 1.0f : cosElbow);
+                const float sinElbow = sqrtf(1.0f - (cosElbow * cosElbow)); // Cotovelo em [0, PI]
+                const float elbowRad = FastMath::atan2(sinElbow, cosElbow);
+                // Cotovelo todo dobrado (alvo dentro do alcance mínimo): em solveXYZ, o seno de acos(-1) sai
+                // levemente negativo e o atan2 cai no ramo -PI; repetido aqui para os dois concordarem
+                const float sinTerm = cosElbow > -1.0f ? L2 * sinElbow : -1e-30f;
+                const float shoulderRad = FastMath::atan2(effElevation, effPlanar) -
+                                          FastMath::atan2(sinTerm, L1 + (L2 * cosElbow));
+                const float wristPitchRad = FastMath::atan2(elevation, planar) - (shoulderRad + elbowRad);
+
+                int limited = 0;
+                base[i] = clampFlag(baseDeg, lo[ActiveArm::BASE], hi[ActiveArm::BASE], limited);
+                const float shoulder = clampFlag((shoulderRad * RAD_DEG) + IK_NEUTRAL.shoulder,
+                                                 lo[ActiveArm::SHOULDER], hi[ActiveArm::SHOULDER], limited);
+                shoulderOut[i] = shoulder;
+                mirror[i] = clampFlag(shoulder, lo[ActiveArm::SHOULDER_MIRROR], hi[ActiveArm::SHOULDER_MIRROR], limited);
+                elbow[i] = clampFlag((elbowRad * RAD_DEG) + IK_NEUTRAL.elbow, lo[ActiveArm::ELBOW],
+                                     hi[ActiveArm::ELBOW], limited);
+                hand[i] = clampFlag((wristPitchRad * RAD_DEG) + IK_NEUTRAL.hand, lo[ActiveArm::HAND],
+                                    hi[ActiveArm::HAND], limited);
+                wristRotate[i] = clampFlag(IK_NEUTRAL.wristRotate + (baseDeg - IK_NEUTRAL.base),
+                                           lo[ActiveArm::WRIST_ROTATE], hi[ActiveArm::WRIST_ROTATE], limited);
+                gripperOut[i] = gripper;
+
+                const int flags = (reachClipped * IK_REACH_CLIPPED) | (limited * IK_JOINT_LIMITED);
+                status[i] = static_cast<uint8_t>(valid ? flags : IK_INVALID);
+            }
         }
+    }
 
-        float targetPitchRad = atan2f(elevation, planar);
-        if (!isFinite(targetPitchRad))
+    int solveBatch(const float *x, const float *y, const float *z, int count,
+                   float *const joints[NUM_SERVOS], uint8_t *status)
+    {
+        batchKernel(x, y, z, count, joints, status);
+
+        int solved = 0;
+        for (int i = 0; i < count; i++)
         {
-            targetPitchRad = 0.0f;
+            solved += status[i] != IK_INVALID ? 1 : 0;
         }
-        const float wristPitchRad = targetPitchRad - (shoulderRad + elbowRad);
+        return solved;
+    }
 
-        targetAngles[1] = clampServoAngle(radToDeg(shoulderRad) + IK_NEUTRAL.shoulder, 1);
-        targetAngles[2] = targetAngles[1];
-        targetAngles[3] = clampServoAngle(radToDeg(elbowRad) + IK_NEUTRAL.elbow, 3);
-        targetAngles[4] = clampServoAngle(radToDeg(wristPitchRad) + IK_NEUTRAL.hand, 4);
+    namespace
+    {
+        // Juntas do IK numérico: base, ombro (servos 1 e 2), cotovelo e punho
+        const int DLS_JOINTS = 4;
+        const int DLS_SERVO[DLS_JOINTS] = {ActiveArm::BASE, ActiveArm::SHOULDER, ActiveArm::ELBOW, ActiveArm::HAND};
 
-        const float wristRotateDeg = IK_NEUTRAL.wristRotate + (baseAngleDeg - IK_NEUTRAL.base);
-        targetAngles[5] = clampServoAngle(wristRotateDeg, 5);
-        targetAngles[6] = clampServoAngle(IK_NEUTRAL.gripper, 6);
+        /**
+         * FK de estimateXYZ e o Jacobiano analítico. q em rad, relativo a IK_NEUTRAL.
+         * pose = {x, y, z, pitch * IK_DLS_PITCH_WEIGHT_MM}; jac[linha][junta].
+         */
+        void poseAndJacobian(const float q[DLS_JOINTS], float pose[DLS_JOINTS], float jac[DLS_JOINTS][DLS_JOINTS])
+        {
+            const float wristExtension = ARM_KINEMATICS.wristOffsetMm + ARM_KINEMATICS.gripperLenMm;
+            const float joint2 = q[1];
+            const float joint3 = joint2 + q[2];
+            const float joint4 = joint3 + q[3];
 
-        return true;
+            // Alcance planar e vertical de cada junta até a ponta (cada junta move tudo o que vem depois)
+            float planar[3];
+            float vertical[3];
+            float sin2, cos2, sin3, cos3, sin4, cos4, sinBase, cosBase;
+            KinMath::sinCos(joint2, sin2, cos2);
+            KinMath::sinCos(joint3, sin3, cos3);
+            KinMath::sinCos(joint4, sin4, cos4);
+            KinMath::sinCos(q[0], sinBase, cosBase);
+            planar[2] = cos4 * wristExtension;
+            vertical[2] = sin4 * wristExtension;
+            planar[1] = (cos3 * ARM_KINEMATICS.forearmLenMm) + planar[2];
+            vertical[1] = (sin3 * ARM_KINEMATICS.forearmLenMm) + vertical[2];
+            planar[0] = (cos2 * ARM_KINEMATICS.upperLenMm) + planar[1];
+            vertical[0] = (sin2 * ARM_KINEMATICS.upperLenMm) + vertical[1];
+
+            pose[0] = planar[0] * cosBase;
+            pose[1] = planar[0] * sinBase;
+            pose[2] = ARM_KINEMATICS.baseHeightMm + vertical[0];
+            pose[3] = joint4 * IK_DLS_PITCH_WEIGHT_MM;
+
+            jac[0][0] = -pose[1];
+            jac[1][0] = pose[0];
+            jac[2][0] = 0.0f;
+            jac[3][0] = 0.0f;
+            for (int k = 1; k < DLS_JOINTS; k++)
+            {
+                jac[0][k] = -vertical[k - 1] * cosBase;
+                jac[1][k] = -vertical[k - 1] * sinBase;
+                jac[2][k] = planar[k - 1];
+                jac[3][k] = IK_DLS_PITCH_WEIGHT_MM;
+            }
+        }
+
+        /**
+         * Passo amortecido: resolve (JᵀJ + λ²I)·dq = Jᵀ·e por Cholesky (a matriz é positiva definida
+         * pelo λ²). Juntas fixas têm a coluna zerada, então saem com dq = 0.
+         */
+        void dampedStep(const float jac[DLS_JOINTS][DLS_JOINTS], const float err[DLS_JOINTS],
+                        const bool fixedJoint[DLS_JOINTS], float dq[DLS_JOINTS])
+        {
+            float a[DLS_JOINTS][DLS_JOINTS];
+            float b[DLS_JOINTS];
+            for (int i = 0; i < DLS_JOINTS; i++)
+            {
+                b[i] = 0.0f;
+                for (int r = 0; r < DLS_JOINTS; r++)
+                    b[i] += fixedJoint[i] ? 0.0f : jac[r][i] * err[r];
+                for (int j = 0; j <= i; j++)
+                {
+                    float sum = 0.0f;
+                    for (int r = 0; r < DLS_JOINTS; r++)
+                        sum += jac[r][i] * jac[r][j];
+                    a[i][j] = (fixedJoint[i] || fixedJoint[j]) ? 0.0f : sum;
+                }
+                a[i][i] += IK_DLS_DAMPING_MM * IK_DLS_DAMPING_MM;
+            }
+
+            // a = L·Lᵀ (L guardada no triângulo inferior)
+            for (int i = 0; i < DLS_JOINTS; i++)
+            {
+                for (int j = 0; j <= i; j++)
+                {
+                    float sum = a[i][j];
+                    for (int k = 0; k < j; k++)
+                        sum -= a[i][k] * a[j][k];
+                    a[i][j] = (i == j) ? sqrtf(sum) : sum / a[j][j];
+                }
+            }
+            for (int i = 0; i < DLS_JOINTS; i++) // L·y = b
+            {
+                float sum = b[i];
+                for (int k = 0; k < i; k++)
+                    sum -= a[i][k] * dq[k];
+                dq[i] = sum / a[i][i];
+            }
+            for (int i = DLS_JOINTS - 1; i >= 0; i--) // Lᵀ·dq = y
+            {
+                float sum = dq[i];
+                for (int k = i + 1; k < DLS_JOINTS; k++)
+                    sum -= a[k][i] * dq[k];
+                dq[i] = sum / a[i][i];
+            }
+        }
     }
 
-    bool estimateXYZ(const int angles[NUM_SERVOS], float &x, float &y, float &z)
+    bool solvePose(float x, float y, float z, float pitchDeg, float rollDeg, const float seed[NUM_SERVOS],
+                   float targetAngles[NUM_SERVOS], PoseReport &report)
     {
-        const float baseRad = degToRad(static_cast<float>(angles[0]) - IK_NEUTRAL.base);
-        const float shoulderRad = degToRad(static_cast<float>(angles[1]) - IK_NEUTRAL.shoulder);
-        const float elbowRad = degToRad(static_cast<float>(angles[3]) - IK_NEUTRAL.elbow);
-        const float wristRad = degToRad(static_cast<float>(angles[4]) - IK_NEUTRAL.hand);
+        const float neutral[DLS_JOINTS] = {IK_NEUTRAL.base, IK_NEUTRAL.shoulder, IK_NEUTRAL.elbow, IK_NEUTRAL.hand};
+        float lo[DLS_JOINTS];
+        float hi[DLS_JOINTS];
+        float q[DLS_JOINTS];
+        for (int k = 0; k < DLS_JOINTS; k++)
+        {
+            const int servo = DLS_SERVO[k];
+            lo[k] = degToRad(minAngles[servo] - neutral[k]);
+            hi[k] = degToRad(maxAngles[servo] - neutral[k]);
+        }
+        // Ombro: os servos acoplados recebem o mesmo ângulo, então valem os dois limites
+        lo[1] = degToRad(max(minAngles[ActiveArm::SHOULDER], minAngles[ActiveArm::SHOULDER_MIRROR]) - neutral[1]);
+        hi[1] = degToRad(min(maxAngles[ActiveArm::SHOULDER], maxAngles[ActiveArm::SHOULDER_MIRROR]) - neutral[1]);
+        for (int k = 0; k < DLS_JOINTS; k++)
+        {
+            q[k] = clampf(degToRad(seed[DLS_SERVO[k]] - neutral[k]), lo[k], hi[k]);
+        }
 
-        const float L1 = ARM_KINEMATICS.upperLenMm;
-        const float L2 = ARM_KINEMATICS.forearmLenMm;
-        const float wristExtension = ARM_KINEMATICS.wristOffsetMm + ARM_KINEMATICS.gripperLenMm;
+        const float goal[DLS_JOINTS] = {x, y, z, degToRad(pitchDeg) * IK_DLS_PITCH_WEIGHT_MM};
+        const float toleranceSq = IK_DLS_TOLERANCE_MM * IK_DLS_TOLERANCE_MM;
+        const float pitchTolerance = degToRad(IK_DLS_TOLERANCE_DEG) * IK_DLS_PITCH_WEIGHT_MM;
+        float best[DLS_JOINTS];
+        float bestError = INFINITY;
+        float bestPositionSq = 0.0f;
+        float bestPitch = 0.0f;
+        int stalled = 0;
+        int iteration = 0;
+        report.converged = false;
 
-        const float joint2 = shoulderRad;
-        const float joint3 = shoulderRad + elbowRad;
-        const float joint4 = joint3 + wristRad;
+        for (;;)
+        {
+            float pose[DLS_JOINTS];
+            float jac[DLS_JOINTS][DLS_JOINTS];
+            float err[DLS_JOINTS];
+            poseAndJacobian(q, pose, jac);
+            for (int r = 0; r < DLS_JOINTS; r++)
+                err[r] = goal[r] - pose[r];
+            const float positionSq = (err[0] * err[0]) + (err[1] * err[1]) + (err[2] * err[2]);
+            const float total = positionSq + (err[3] * err[3]);
+            if (!isFinite(total))
+                break;
 
-        const float planarReach = (cosf(joint2) * L1) + (cosf(joint3) * L2) + (cosf(joint4) * wristExtension);
-        const float verticalOffset = (sinf(joint2) * L1) + (sinf(joint3) * L2) + (sinf(joint4) * wristExtension);
+            // Guarda a melhor pose: longe da semente um passo pode piorar antes de convergir
+            if (total < bestError)
+            {
+                stalled = (total > bestError * 0.99f) ? stalled + 1 : 0;
+                bestError = total;
+                bestPositionSq = positionSq;
+                bestPitch = fabsf(err[3]);
+                for (int k = 0; k < DLS_JOINTS; k++)
+                    best[k] = q[k];
+            }
+            else
+            {
+                stalled++;
+            }
+            report.converged = bestPositionSq <= toleranceSq && bestPitch <= pitchTolerance;
+            // Sem progresso por 3 iterações: alvo fora do alcance ou bloqueado pelos limites
+            if (report.converged || iteration >= IK_DLS_MAX_ITERATIONS || stalled >= 3)
+                break;
 
-        x = planarReach * cosf(baseRad);
-        y = planarReach * sinf(baseRad);
-        z = ARM_KINEMATICS.baseHeightMm + verticalOffset;
+            // Juntas que sairiam do limite param nele; o erro que elas deixam de cobrir vai para as livres
+            bool fixedJoint[DLS_JOINTS] = {false, false, false, false};
+            float step[DLS_JOINTS] = {0.0f, 0.0f, 0.0f, 0.0f};
+            for (int pass = 0; pass < DLS_JOINTS; pass++)
+            {
+                float dq[DLS_JOINTS];
+                dampedStep(jac, err, fixedJoint, dq);
+                bool clipped = false;
+                for (int k = 0; k < DLS_JOINTS; k++)
+                {
+                    if (fixedJoint[k])
+                        continue;
+                    step[k] = dq[k];
+                    const float next = q[k] + dq[k];
+                    if (next >= lo[k] && next <= hi[k])
+                        continue;
+                    fixedJoint[k] = true;
+                    step[k] = clampf(next, lo[k], hi[k]) - q[k];
+                    for (int r = 0; r < DLS_JOINTS; r++)
+                        err[r] -= jac[r][k] * step[k];
+                    clipped = true;
+                }
+                if (!clipped)
+                    break;
+            }
 
-        return isFinite(x) && isFinite(y) && isFinite(z);
+            float largest = 0.0f;
+            for (int k = 0; k < DLS_JOINTS; k++)
+                largest = max(largest, fabsf(step[k]));
+            const float scale = largest > degToRad(IK_DLS_MAX_STEP_DEG) ? degToRad(IK_DLS_MAX_STEP_DEG) / largest : 1.0f;
+            for (int k = 0; k < DLS_JOINTS; k++)
+                q[k] = clampf(q[k] + (step[k] * scale), lo[k], hi[k]);
+            iteration++;
+        }
+
+        if (!(bestError < INFINITY)) // Alvo ou semente inválidos
+        {
+            for (int k = 0; k < DLS_JOINTS; k++)
+                best[k] = q[k];
+            bestPositionSq = INFINITY;
+            bestPitch = INFINITY;
+        }
+
+        report.iterations = static_cast<uint16_t>(iteration);
+        report.positionErrorMm = sqrtf(bestPositionSq);
+        report.pitchErrorDeg = radToDeg(bestPitch / IK_DLS_PITCH_WEIGHT_MM);
+        report.jointLimited = false;
+        for (int k = 0; k < DLS_JOINTS; k++)
+        {
+            targetAngles[DLS_SERVO[k]] = radToDeg(best[k]) + neutral[k];
+            report.jointLimited = report.jointLimited || best[k] <= lo[k] + 1e-4f || best[k] >= hi[k] - 1e-4f;
+        }
+        targetAngles[ActiveArm::SHOULDER_MIRROR] = targetAngles[ActiveArm::SHOULDER];
+
+        // Roll: o servo 5 acompanha a base (como em solveXYZ) mais o roll pedido; não afeta a posição
+        const float roll = IK_NEUTRAL.wristRotate + (targetAngles[0] - IK_NEUTRAL.base) + rollDeg;
+        targetAngles[5] = clampServoAngle(roll, 5);
+        report.rollErrorDeg = fabsf(roll - targetAngles[5]);
+        targetAngles[6] = clampServoAngle(seed[6], 6);
+        return report.converged;
+    }
+
+    bool solveXYZ(float x, float y, float z, int targetAngles[NUM_SERVOS])
+    {
+        float precise[NUM_SERVOS];
+        if (!solveXYZ(x, y, z, precise))
+        {
+            return false;
+        }
+        for (int i = 0; i < NUM_SERVOS; i++)
+        {
+            targetAngles[i] = static_cast<int>(roundf(precise[i]));
+        }
+        return true;
+    }
+
+    bool estimateXYZ(const int angles[NUM_SERVOS], float &x, float &y, float &z)
+    {
+        float precise[NUM_SERVOS];
+        for (int i = 0; i < NUM_SERVOS; i++)
+        {
+            precise[i] = static_cast<float>(angles[i]);
+        }
+        return estimateXYZ(precise, x, y, z);
+    }
+
+    bool estimateXYZ(const float angles[NUM_SERVOS], float &x, float &y, float &z)
+    {
+        return Kinematics::forward(angles, x, y, z);
     }
 }
@@ -11,11 +11,109 @@ namespace InverseKinematics
      * @param x Coordenada em mm no eixo X (frente do robô).
      * @param y Coordenada em mm no eixo Y (direita positiva).
      * @param z Coordenada em mm no eixo Z (cima positiva).
-     * @param targetAngles Array preenchido com os ângulos desejados (0-180°) na ordem dos servos.
+     * @param targetAngles Array preenchido com os ângulos desejados (0-180°, com fração) na ordem dos servos.
      * @return true se o ponto estiver dentro do alcance aproximado e os ângulos forem calculados.
      */
+    bool solveXYZ(float x, float y, float z, float targetAngles[NUM_SERVOS]);
+
+    /**
+     * @brief Versão com ângulos arredondados para graus inteiros.
+     */
     bool solveXYZ(float x, float y, float z, int targetAngles[NUM_SERVOS]);
 
+    /**
+     * @brief Ramo do cotovelo: as duas soluções de acos para o mesmo ponto.
+     */
+    enum ElbowBranch : uint8_t
+    {
+        ELBOW_DOWN, /**< Ramo de solveXYZ: o cotovelo fica abaixo da reta ombro-punho. */
+        ELBOW_UP    /**< Ramo espelhado: o cotovelo fica acima da reta. */
+    };
+
+    /** @brief Ramos possíveis por ponto (a base não tem meia-volta dentro de 0-180°). */
+    const int IK_MAX_BRANCHES = 2;
+
+    /**
+     * @brief Uma solução de solveBranches.
+     */
+    struct IkBranch
+    {
+        float angles[NUM_SERVOS]; /**< Ângulos do ramo, limitados como em solveXYZ. */
+        ElbowBranch elbow;
+        bool exact;               /**< Chega ao ponto sem cortar o alcance nem limitar juntas. */
+        float cost;               /**< Custo para chegar a partir de 'from' (menor é melhor). */
+    };
+
+    /**
+     * @brief Custo de ir de 'from' para 'to' (ex.: MotionController::durationBetween, em ms).
+     */
+    typedef float (*BranchCost)(const float from[NUM_SERVOS], const float to[NUM_SERVOS]);
+
+    /**
+     * @brief Custo padrão: soma de |variação| das juntas ponderada por IK_BRANCH_WEIGHTS.
+     */
+    float weightedJointDistance(const float from[NUM_SERVOS], const float to[NUM_SERVOS]);
+
+    /**
+     * @brief Enumera os ramos do cotovelo que alcançam o ponto e os ordena: exatos primeiro, depois
+     * pelo custo a partir de 'from'. branches[0] é o escolhido e branches[1] fica como alternativa.
+     * Com o cotovelo esticado ou todo dobrado os ramos coincidem e só um é devolvido.
+     * @return Número de ramos (0 se o ponto for inválido, como em solveXYZ).
+     */
+    int solveBranches(float x, float y, float z, const float from[NUM_SERVOS], IkBranch branches[IK_MAX_BRANCHES],
+                      BranchCost cost = weightedJointDistance);
+
+    /**
+     * @brief Resultado de cada ponto de solveBatch (flags combináveis).
+     */
+    enum BatchStatus : uint8_t
+    {
+        IK_OK = 0,            /**< Ponto alcançado dentro dos limites. */
+        IK_REACH_CLIPPED = 1, /**< Distância fora do alcance: resolvido para o ponto alcançável mais próximo. */
+        IK_JOINT_LIMITED = 2, /**< Algum ângulo foi limitado por minAngles/maxAngles. */
+        IK_INVALID = 4        /**< Ponto degenerado (sobre o ombro) ou coordenada inválida. */
+    };
+
+    /**
+     * @brief Resolve vários pontos de uma vez (visualização de trajetórias, checagem de área de trabalho).
+     * Entradas e saídas em estrutura de arrays; o laço não tem desvios nem chamadas à libm
+     * (atan2 polinomial; difere de solveXYZ em menos de 0.01°), então é vetorizado no host e enxuto no ESP32.
+     * @param x Coordenadas X em mm (count pontos). Idem para y e z.
+     * @param count Número de pontos.
+     * @param joints joints[j][i] recebe o ângulo do servo j para o ponto i (mesmo modelo de solveXYZ).
+     * @param status status[i] recebe as flags BatchStatus do ponto i.
+     * @return Número de pontos resolvidos (status diferente de IK_INVALID).
+     */
+    int solveBatch(const float *x, const float *y, const float *z, int count,
+                   float *const joints[NUM_SERVOS], uint8_t *status);
+
+    /**
+     * @brief Resultado de solvePose (iterações e resíduos da solução devolvida).
+     */
+    struct PoseReport
+    {
+        uint16_t iterations;   /**< Iterações de Gauss-Newton amortecido executadas (somadas nas novas tentativas). */
+        float positionErrorMm; /**< Distância entre a ponta (FK) e o alvo. */
+        float pitchErrorDeg;   /**< Erro do pitch da ferramenta. */
+        float rollErrorDeg;    /**< Diferença do roll pedido (limite do servo 5). */
+        bool converged;        /**< Posição e pitch dentro de IK_DLS_TOLERANCE_MM/_DEG. */
+        bool jointLimited;     /**< Alguma junta terminou no limite de software. */
+    };
+
+    /**
+     * @brief IK numérico (mínimos quadrados amortecidos) com orientação: posição, pitch e roll da ferramenta.
+     * Itera sobre a FK de estimateXYZ (base, ombro, cotovelo e punho) a partir de 'seed'; as juntas que
+     * batem no limite saem do passo e o restante do erro é redistribuído entre as livres.
+     * Com 'seed' = pose do tick anterior converge em 1-2 iterações (uso a cada tick de movimento).
+     * @param pitchDeg Ângulo da ferramenta em relação à horizontal (positivo para cima).
+     * @param rollDeg Rotação do punho somada à que acompanha a base (0 = mesmo roll de solveXYZ).
+     * @param seed Pose inicial (ex.: currentAnglesF). A garra é copiada dela.
+     * @param targetAngles Ângulos lógicos, sempre dentro de minAngles/maxAngles.
+     * @return report.converged.
+     */
+    bool solvePose(float x, float y, float z, float pitchDeg, float rollDeg, const float seed[NUM_SERVOS],
+                   float targetAngles[NUM_SERVOS], PoseReport &report);
+
     /**
      * @brief Calcula a cinemática direta aproximada de um conjunto de ângulos.
      * @param angles Ângulos lógicos (0-180°) na mesma ordem dos servos.
@@ -24,14 +122,19 @@ namespace InverseKinematics
      * @param z Saída Z em mm (cima positiva).
      * @return true se o cálculo foi realizado com sucesso.
      */
+    bool estimateXYZ(const float angles[NUM_SERVOS], float &x, float &y, float &z);
+
+    /**
+     * @brief Versão com ângulos inteiros.
+     */
     bool estimateXYZ(const int angles[NUM_SERVOS], float &x, float &y, float &z);
 
     /**
-     * @brief Conveniência para obter o XYZ da pose atual (currentAngles).
+     * @brief Conveniência para obter o XYZ da pose atual (currentAnglesF).
      */
     inline bool estimateCurrentXYZ(float &x, float &y, float &z)
     {
-        return estimateXYZ(currentAngles, x, y, z);
+        return estimateXYZ(currentAnglesF, x, y, z);
     }
 
 } // namespace InverseKinematics
@@ -0,0 +1,118 @@
+/**
+ * @file LockFree.h
+ * @brief Estruturas sem lock para troca de dados entre os dois cores do ESP32.
+ *
+ * - SpscQueue: fila circular de um produtor e um consumidor (comandos core 0 -> core 1).
+ * - SeqLock: publicação de um estado por um único escritor; leitores copiam e repetem
+ *   a leitura se ela coincidir com uma escrita. O escritor nunca espera pelos leitores.
+ */
+#ifndef LOCK_FREE_H
+#define LOCK_FREE_H
+
+#include <atomic>
+#include <stdint.h>
+
+/**
+ * @brief Fila circular sem lock para exatamente um produtor e um consumidor.
+ * Comporta N - 1 itens (uma posição fica livre para distinguir cheia de vazia).
+ */
+template <typename T, uint8_t N>
+class SpscQueue
+{
+public:
+    SpscQueue() : head(0), tail(0) {}
+
+    /**
+     * @brief Insere um item (somente o produtor).
+     * @return false se a fila estiver cheia.
+     */
+    bool push(const T &item)
+    {
+        const uint8_t t = tail.load(std::memory_order_relaxed);
+        const uint8_t next = (uint8_t)((t + 1) % N);
+        if (next == head.load(std::memory_order_acquire))
+            return false;
+        slots[t] = item;
+        tail.store(next, std::memory_order_release); // Publica o item ao consumidor
+        return true;
+    }
+
+    /**
+     * @brief Retira o item mais antigo (somente o consumidor).
+     * @return false se a fila estiver vazia.
+     */
+    bool pop(T &item)
+    {
+        const uint8_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+        item = slots[h];
+        head.store((uint8_t)((h + 1) % N), std::memory_order_release); // Libera a posição ao produtor
+        return true;
+    }
+
+    /**
+     * @brief Número aproximado de itens na fila (exato apenas para o produtor ou o consumidor).
+     */
+    uint8_t size() const
+    {
+        const uint8_t h = head.load(std::memory_order_acquire);
+        const uint8_t t = tail.load(std::memory_order_acquire);
+        return (uint8_t)((t + N - h) % N);
+    }
+
+    /** @brief Capacidade útil da fila. */
+    static constexpr uint8_t capacity() { return N - 1; }
+
+private:
+    T slots[N];
+    std::atomic<uint8_t> head; // Próxima posição a ler (escrita apenas pelo consumidor)
+    std::atomic<uint8_t> tail; // Próxima posição a escrever (escrita apenas pelo produtor)
+};
+
+/**
+ * @brief Seqlock de um único escritor.
+ * O contador é ímpar durante a escrita; o leitor repete a cópia se o contador
+ * mudou ou estava ímpar, então nunca observa um estado parcialmente escrito.
+ */
+template <typename T>
+class SeqLock
+{
+public:
+    SeqLock() : sequence(0), data() {}
+
+    /**
+     * @brief Publica um novo valor (somente o escritor; nunca bloqueia).
+     */
+    void write(const T &value)
+    {
+        const uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        data = value;
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copia o último valor publicado (qualquer número de leitores).
+     */
+    void read(T &out) const
+    {
+        for (;;)
+        {
+            const uint32_t before = sequence.load(std::memory_order_acquire);
+            if (before & 1)
+                continue; // Escrita em andamento no outro core
+            out = data;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before)
+                return;
+        }
+    }
+
+private:
+    std::atomic<uint32_t> sequence;
+    T data;
+};
+
+#endif // LOCK_FREE_H
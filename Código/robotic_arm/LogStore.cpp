@@ -0,0 +1,627 @@
+/**
+ * @file LogStore.cpp
+ * @brief Implementação do log de registros na flash.
+ *
+ * Setor: SectorHeader (16 B) + registros alinhados em 4 B até o primeiro cabeçalho apagado (0xFF).
+ * Registro: RecordHeader (8 B) + dados; o CRC16 cobre o cabeçalho e os dados.
+ * Registro fragmentado: primeiro fragmento com FRAGMENT_MORE e o tipo do registro, seguido de
+ * fragmentos RECORD_CONTINUATION (mesmo id) até um com FRAGMENT_LAST. Cada fragmento começa logo
+ * após o anterior, ou no primeiro registro do próximo setor do anel se não couber mais nenhum.
+ * A ordem dos setores vem do número de sequência gravado no cabeçalho ao abri-lo.
+ */
+#include "LogStore.h"
+
+#include <stddef.h>
+
+namespace LogStore
+{
+    namespace
+    {
+        const uint32_t SECTOR_MAGIC = 0x474F4C41; // "ALOG"
+        const uint8_t RECORD_SNAPSHOT_BEGIN = 0x01;
+        const uint8_t RECORD_SNAPSHOT_END = 0x02;
+        const uint8_t RECORD_CONTINUATION = 0x03;
+        const uint8_t FRAGMENT_LAST = 0xFF; // Último (ou único) fragmento do registro
+        const uint8_t FRAGMENT_MORE = 0xFE; // Os dados continuam no fragmento seguinte
+
+        struct SectorHeader
+        {
+            uint32_t magic;      // SECTOR_MAGIC
+            uint32_t seq;        // Ordem de abertura (1, 2, ...)
+            uint32_t eraseCount; // Apagamentos do setor, incluindo o atual
+            uint16_t reserved;
+            uint16_t crc16;
+        } __attribute__((packed));
+
+        struct RecordHeader
+        {
+            uint8_t type;  // 0xFF = espaço apagado
+            uint8_t flags; // FRAGMENT_LAST ou FRAGMENT_MORE
+            uint16_t id;
+            uint16_t length; // Bytes de dados; 0 = chave apagada
+            uint16_t crc16;  // Cabeçalho (sem este campo) + dados
+        } __attribute__((packed));
+
+        static_assert(sizeof(RecordHeader) == recordSize(0), "LogStore: cabecalho do registro com padding");
+        static_assert(sizeof(SectorHeader) % 4 == 0, "LogStore: registros precisam comecar alinhados");
+
+        const uint32_t SECTOR_PAYLOAD = LOG_SECTOR_SIZE - sizeof(SectorHeader); // Bytes de registros por setor
+        const uint32_t MIN_FRAGMENT = recordSize(4); // Menos espaço que isto no setor: o fragmento vai para o próximo
+
+        enum Walk : uint8_t
+        {
+            WALK_OK,      // Registro íntegro (dados no payload, se pedidos)
+            WALK_INVALID, // Tamanho coerente, mas o CRC não confere: pula para o próximo
+            WALK_END,     // Fim do que foi gravado no setor
+            WALK_BROKEN   // Cabeçalho ilegível: nada depois dele é confiável
+        };
+
+        const esp_partition_t *partition = NULL;
+        int sectorCount = 0;
+        // 0 = setor livre (apagado ou sem cabeçalho válido). Zerado antes de apagar: read() confere
+        // a sequência antes e depois de ler, de qualquer core
+        volatile uint32_t sectorSeq[LOG_MAX_SECTORS];
+        uint32_t sectorErases[LOG_MAX_SECTORS]; // Lido do cabeçalho no boot
+        uint32_t lastSeq = 0;
+
+        int head = -1;           // Setor em gravação (-1 = log vazio)
+        uint32_t headOffset = 0; // Próximo byte livre do setor 'head'
+        int tail = -1;           // Setor onde começa o último snapshot completo
+        uint32_t replayFrom = 0; // Endereço do BEGIN desse snapshot
+        uint32_t snapshotId = 0;
+
+        bool snapshotOpen = false;
+        uint32_t pendingId = 0;
+        uint32_t pendingBegin = 0;
+        int pendingSector = -1;
+
+        uint8_t payload[LOG_MAX_PAYLOAD];
+        uint8_t writeBuffer[sizeof(RecordHeader) + LOG_MAX_PAYLOAD];
+
+        // Estatísticas desta sessão
+        uint32_t appendCount = 0;
+        uint32_t appendedBytes = 0;
+        uint32_t eraseCount = 0;
+        uint32_t snapshotCount = 0;
+        uint32_t invalidRecords = 0;
+        uint32_t replayedRecords = 0;
+        unsigned long bootUs = 0;
+
+        uint32_t address(int sector, uint32_t offset)
+        {
+            return (uint32_t)sector * LOG_SECTOR_SIZE + offset;
+        }
+
+        bool readAt(uint32_t addr, void *dst, size_t size)
+        {
+            return esp_partition_read(partition, addr, dst, size) == ESP_OK;
+        }
+
+        uint16_t recordCrc(const RecordHeader &header, const uint8_t *data)
+        {
+            const uint16_t crc = calcCRC16((const uint8_t *)&header, offsetof(RecordHeader, crc16));
+            return calcCRC16(data, header.length, crc);
+        }
+
+        bool isErased(const RecordHeader &header)
+        {
+            const uint8_t *bytes = (const uint8_t *)&header;
+            for (size_t i = 0; i < sizeof(header); i++)
+            {
+                if (bytes[i] != 0xFF)
+                    return false;
+            }
+            return true;
+        }
+
+        /**
+         * @brief Lê o registro em 'offset' do setor; com withData, lê os dados em 'payload' e confere o CRC.
+         */
+        Walk readRecord(int sector, uint32_t offset, RecordHeader &header, bool withData)
+        {
+            if (offset + sizeof(RecordHeader) > LOG_SECTOR_SIZE)
+                return WALK_END;
+            if (!readAt(address(sector, offset), &header, sizeof(header)))
+                return WALK_BROKEN;
+            if (isErased(header))
+                return WALK_END;
+            if (offset + recordSize(header.length) > LOG_SECTOR_SIZE)
+                return WALK_BROKEN; // Cabeçalho cortado por uma queda de energia
+            if (!withData)
+                return WALK_OK;
+            if (header.length > LOG_MAX_PAYLOAD ||
+                !readAt(address(sector, offset + sizeof(header)), payload, header.length) ||
+                recordCrc(header, payload) != header.crc16)
+                return WALK_INVALID;
+            return WALK_OK;
+        }
+
+        bool isMarker(uint8_t type)
+        {
+            return type == RECORD_SNAPSHOT_BEGIN || type == RECORD_SNAPSHOT_END;
+        }
+
+        /**
+         * @brief Avança sector/offset para o fragmento seguinte ao que ocupa 'length' bytes em 'offset'.
+         */
+        void nextFragment(int &sector, uint32_t &offset, uint16_t length)
+        {
+            offset += recordSize(length);
+            if (LOG_SECTOR_SIZE - offset < MIN_FRAGMENT)
+            {
+                sector = (sector + 1) % sectorCount;
+                offset = sizeof(SectorHeader);
+            }
+        }
+
+        /**
+         * @brief Confere os fragmentos de um registro que começa em 'offset' (CRC de cada um).
+         * @param length [out] Soma dos dados de todos os fragmentos.
+         */
+        bool checkFragments(int sector, uint32_t offset, uint16_t id, uint32_t &length)
+        {
+            RecordHeader header;
+            length = 0;
+            for (bool first = true;; first = false)
+            {
+                const uint32_t seq = sectorSeq[sector];
+                if (seq == 0 || readRecord(sector, offset, header, true) != WALK_OK ||
+                    (!first && (header.type != RECORD_CONTINUATION || header.id != id)))
+                    return false;
+                length += header.length;
+                if (header.flags != FRAGMENT_MORE)
+                    return length <= 0xFFFF;
+                const int previous = sector;
+                nextFragment(sector, offset, header.length);
+                if (sector != previous && sectorSeq[sector] != seq + 1)
+                    return false; // O setor seguinte não é o que foi aberto depois deste
+            }
+        }
+
+        uint32_t markerId()
+        {
+            uint32_t id;
+            memcpy(&id, payload, sizeof(id));
+            return id;
+        }
+
+        int freeSectors()
+        {
+            if (head < 0)
+                return sectorCount;
+            if (tail < 0)
+                return sectorCount - 1;
+            return (tail - head - 1 + sectorCount) % sectorCount;
+        }
+
+        /**
+         * @brief Apaga o setor e grava o cabeçalho: ele passa a ser o setor em gravação.
+         */
+        bool openSector(int sector)
+        {
+            sectorSeq[sector] = 0; // Antes de apagar: invalida os RecordRef do setor
+            if (esp_partition_erase_range(partition, address(sector, 0), LOG_SECTOR_SIZE) != ESP_OK)
+                return false;
+            sectorErases[sector]++;
+            eraseCount++;
+
+            SectorHeader header;
+            header.magic = SECTOR_MAGIC;
+            header.seq = lastSeq + 1;
+            header.eraseCount = sectorErases[sector];
+            header.reserved = 0xFFFF;
+            header.crc16 = calcCRC16((const uint8_t *)&header, offsetof(SectorHeader, crc16));
+            if (esp_partition_write(partition, address(sector, 0), &header, sizeof(header)) != ESP_OK)
+                return false;
+            lastSeq = header.seq;
+            sectorSeq[sector] = header.seq;
+            head = sector;
+            headOffset = sizeof(header);
+            return true;
+        }
+
+        /**
+         * @brief Passa para o próximo setor do anel (ou, com o log vazio, para o menos apagado).
+         * @return false se o próximo setor ainda guardar o snapshot mais recente.
+         */
+        bool advance()
+        {
+            int next = 0;
+            if (head < 0)
+            {
+                for (int s = 1; s < sectorCount; s++)
+                {
+                    if (sectorErases[s] < sectorErases[next])
+                        next = s;
+                }
+            }
+            else
+            {
+                next = (head + 1) % sectorCount;
+                const int guard = tail >= 0 ? tail : (snapshotOpen ? pendingSector : -1);
+                if (next == guard)
+                    return false;
+            }
+            return openSector(next);
+        }
+
+        /**
+         * @brief Varre os cabeçalhos: ordem dos setores, último snapshot completo e fim do log.
+         */
+        void scan()
+        {
+            head = -1;
+            tail = -1;
+            snapshotId = 0;
+            lastSeq = 0;
+            snapshotOpen = false;
+
+            int order[LOG_MAX_SECTORS];
+            int used = 0;
+            for (int s = 0; s < sectorCount; s++)
+            {
+                SectorHeader header;
+                sectorSeq[s] = 0;
+                sectorErases[s] = 0;
+                if (!readAt(address(s, 0), &header, sizeof(header)) || header.magic != SECTOR_MAGIC ||
+                    header.crc16 != calcCRC16((const uint8_t *)&header, offsetof(SectorHeader, crc16)) ||
+                    header.seq == 0)
+                    continue;
+                sectorSeq[s] = header.seq;
+                sectorErases[s] = header.eraseCount;
+                lastSeq = max(lastSeq, header.seq);
+                // Inserção ordenada pela sequência (no máximo LOG_MAX_SECTORS setores)
+                int i = used++;
+                while (i > 0 && sectorSeq[order[i - 1]] > header.seq)
+                {
+                    order[i] = order[i - 1];
+                    i--;
+                }
+                order[i] = s;
+            }
+
+            uint32_t beginId = 0;
+            uint32_t beginAddr = 0;
+            bool haveBegin = false;
+            for (int i = 0; i < used; i++)
+            {
+                const int s = order[i];
+                uint32_t offset = sizeof(SectorHeader);
+                Walk walk;
+                RecordHeader header;
+                while ((walk = readRecord(s, offset, header, false)) == WALK_OK)
+                {
+                    if (isMarker(header.type) && readRecord(s, offset, header, true) == WALK_OK &&
+                        header.length == sizeof(uint32_t))
+                    {
+                        if (header.type == RECORD_SNAPSHOT_BEGIN)
+                        {
+                            beginId = markerId();
+                            beginAddr = address(s, offset);
+                            haveBegin = true;
+                        }
+                        else if (haveBegin && markerId() == beginId)
+                        {
+                            snapshotId = beginId;
+                            replayFrom = beginAddr;
+                            tail = (int)(beginAddr / LOG_SECTOR_SIZE);
+                        }
+                    }
+                    offset += recordSize(header.length);
+                }
+                head = s;
+                // Depois de um registro cortado o setor fica fechado: o próximo append abre outro
+                headOffset = walk == WALK_END ? offset : LOG_SECTOR_SIZE;
+            }
+        }
+    }
+
+    bool begin()
+    {
+        const unsigned long startUs = micros();
+        partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, LOG_PARTITION_LABEL);
+        if (partition == NULL)
+            return false;
+        sectorCount = (int)min(partition->size / LOG_SECTOR_SIZE, (uint32_t)LOG_MAX_SECTORS);
+        if (sectorCount < LOG_RESERVE_SECTORS + 2)
+        {
+            partition = NULL;
+            return false;
+        }
+        scan();
+        bootUs = micros() - startUs;
+        return true;
+    }
+
+    bool available()
+    {
+        return partition != NULL;
+    }
+
+    bool hasSnapshot()
+    {
+        return tail >= 0;
+    }
+
+    uint32_t replay(RecordHandler handler)
+    {
+        if (!hasSnapshot())
+            return 0;
+        const unsigned long startUs = micros();
+        int sector = tail;
+        uint32_t offset = replayFrom % LOG_SECTOR_SIZE;
+        for (;;)
+        {
+            RecordHeader header;
+            Walk walk;
+            while ((walk = readRecord(sector, offset, header, true)) != WALK_END && walk != WALK_BROKEN)
+            {
+                RecordRef ref = {address(sector, offset), sectorSeq[sector]};
+                if (walk == WALK_INVALID)
+                    invalidRecords++;
+                else if (header.flags == FRAGMENT_MORE && header.type != RECORD_CONTINUATION)
+                {
+                    // Registro fragmentado: só vale com todos os fragmentos (os seguintes são pulados abaixo)
+                    uint32_t length;
+                    const uint16_t firstLength = header.length;
+                    if (checkFragments(sector, offset, header.id, length))
+                    {
+                        handler(header.type, header.id, NULL, (uint16_t)length, ref);
+                        replayedRecords++;
+                    }
+                    else
+                    {
+                        invalidRecords++;
+                    }
+                    header.length = firstLength;
+                }
+                else if (!isMarker(header.type) && header.type != RECORD_CONTINUATION)
+                {
+                    handler(header.type, header.id, payload, header.length, ref);
+                    replayedRecords++;
+                }
+                offset += recordSize(header.length);
+            }
+            if (walk == WALK_BROKEN)
+                invalidRecords++;
+            const int next = (sector + 1) % sectorCount;
+            if (sector == head || sectorSeq[next] != sectorSeq[sector] + 1)
+                break;
+            sector = next;
+            offset = sizeof(SectorHeader);
+        }
+        bootUs += micros() - startUs;
+        return replayedRecords;
+    }
+
+    void format()
+    {
+        for (int s = 0; s < sectorCount; s++)
+        {
+            if (sectorSeq[s] != 0 && esp_partition_erase_range(partition, address(s, 0), LOG_SECTOR_SIZE) == ESP_OK)
+            {
+                sectorSeq[s] = 0;
+                sectorErases[s]++;
+                eraseCount++;
+            }
+        }
+        head = -1;
+        tail = -1;
+        snapshotOpen = false;
+    }
+
+    namespace
+    {
+        /**
+         * @brief Grava um fragmento em headOffset (o espaço já foi garantido por quem chama).
+         */
+        bool writeFragment(uint8_t type, uint8_t flags, uint16_t id, const uint8_t *data, uint16_t length)
+        {
+            RecordHeader header;
+            header.type = type;
+            header.flags = flags;
+            header.id = id;
+            header.length = length;
+            header.crc16 = recordCrc(header, data);
+            memcpy(writeBuffer, &header, sizeof(header));
+            if (length > 0)
+                memcpy(writeBuffer + sizeof(header), data, length);
+            if (esp_partition_write(partition, address(head, headOffset), writeBuffer, sizeof(header) + length) != ESP_OK)
+            {
+                headOffset = LOG_SECTOR_SIZE; // Não grava depois de um registro possivelmente cortado
+                return false;
+            }
+            headOffset += recordSize(length);
+            appendedBytes += recordSize(length);
+            return true;
+        }
+
+        /**
+         * @brief Grava um registro com os dados de 'data' ou, se for NULL, lidos de 'source'.
+         * Até LOG_MAX_PAYLOAD bytes, um fragmento só (vai inteiro para o próximo setor se não couber);
+         * acima disso, fragmentos que completam o setor atual.
+         */
+        bool appendRecord(uint8_t type, uint16_t id, const uint8_t *data, const RecordRef *source, uint16_t length,
+                          RecordRef *ref)
+        {
+            if (partition == NULL || (length > 0 && data == NULL && source == NULL))
+                return false;
+            const bool fragmented = length > LOG_MAX_PAYLOAD;
+            uint16_t done = 0;
+            do
+            {
+                const uint32_t room = head < 0 ? 0 : LOG_SECTOR_SIZE - headOffset;
+                if ((fragmented ? room < MIN_FRAGMENT : room < recordSize(length)) && !advance())
+                    return false;
+                const uint16_t chunk = (uint16_t)min((uint32_t)(length - done),
+                                                     min((uint32_t)LOG_MAX_PAYLOAD, LOG_SECTOR_SIZE - headOffset - recordSize(0)));
+                if (done == 0 && ref != NULL)
+                {
+                    ref->address = address(head, headOffset);
+                    ref->seq = sectorSeq[head];
+                }
+                const uint8_t *piece = data + done;
+                if (data == NULL)
+                {
+                    // Cópia: 'payload' está livre fora do replay
+                    if (chunk > 0 && !read(*source, done, payload, chunk))
+                        return false;
+                    piece = payload;
+                }
+                const uint8_t flags = done + chunk < length ? FRAGMENT_MORE : FRAGMENT_LAST;
+                if (!writeFragment(done == 0 ? type : RECORD_CONTINUATION, flags, id, piece, chunk))
+                    return false;
+                done += chunk;
+            } while (done < length);
+            appendCount++;
+            return true;
+        }
+    }
+
+    bool append(uint8_t type, uint16_t id, const void *data, uint16_t length, RecordRef *ref)
+    {
+        if (length > 0 && data == NULL)
+            return false;
+        return appendRecord(type, id, (const uint8_t *)data, NULL, length, ref);
+    }
+
+    bool copy(uint8_t type, uint16_t id, const RecordRef &source, uint16_t length, RecordRef *ref)
+    {
+        return appendRecord(type, id, NULL, &source, length, ref);
+    }
+
+    bool read(const RecordRef &ref, uint32_t offset, void *dst, uint32_t size)
+    {
+        if (partition == NULL || ref.seq == 0)
+            return false;
+        uint8_t *out = (uint8_t *)dst;
+        int sector = (int)(ref.address / LOG_SECTOR_SIZE);
+        uint32_t at = ref.address % LOG_SECTOR_SIZE;
+        uint32_t seq = ref.seq;
+        for (bool first = true; size > 0; first = false)
+        {
+            RecordHeader header;
+            if (sector >= sectorCount || sectorSeq[sector] != seq || !readAt(address(sector, at), &header, sizeof(header)) ||
+                header.length > LOG_MAX_PAYLOAD || (!first && header.type != RECORD_CONTINUATION))
+                return false;
+            if (offset < header.length)
+            {
+                const uint32_t n = min(size, header.length - offset);
+                if (!readAt(address(sector, at + sizeof(header) + offset), out, n))
+                    return false;
+                out += n;
+                size -= n;
+                offset = 0;
+            }
+            else
+            {
+                offset -= header.length;
+            }
+            // Conferido depois da leitura: o setor não foi apagado no meio dela
+            if (sectorSeq[sector] != seq || (size > 0 && header.flags != FRAGMENT_MORE))
+                return false;
+            const int previous = sector;
+            nextFragment(sector, at, header.length);
+            if (sector != previous)
+                seq++;
+        }
+        return true;
+    }
+
+    bool beginSnapshot()
+    {
+        snapshotOpen = false;
+        pendingId = snapshotId + 1;
+        if (!append(RECORD_SNAPSHOT_BEGIN, 0, &pendingId, sizeof(pendingId)))
+            return false;
+        pendingSector = head;
+        pendingBegin = address(head, headOffset - recordSize(sizeof(pendingId)));
+        snapshotOpen = true;
+        return true;
+    }
+
+    bool endSnapshot()
+    {
+        if (!snapshotOpen || !append(RECORD_SNAPSHOT_END, 0, &pendingId, sizeof(pendingId)))
+            return false;
+        snapshotOpen = false;
+        snapshotId = pendingId;
+        replayFrom = pendingBegin;
+        tail = pendingSector;
+        snapshotCount++;
+        return true;
+    }
+
+    uint32_t freeBytes()
+    {
+        if (partition == NULL)
+            return 0;
+        return freeSectors() * SECTOR_PAYLOAD + (head >= 0 ? LOG_SECTOR_SIZE - headOffset : 0);
+    }
+
+    uint32_t capacity()
+    {
+        if (partition == NULL)
+            return 0;
+        // O snapshot novo é gravado enquanto o anterior (e o setor atual) ainda ocupam o anel
+        return (sectorCount - LOG_RESERVE_SECTORS - 2) * SECTOR_PAYLOAD / 2;
+    }
+
+    bool needsCompaction(uint32_t liveBytes, uint32_t pendingBytes)
+    {
+        return partition != NULL && head >= 0 &&
+               freeBytes() < liveBytes + pendingBytes + LOG_RESERVE_SECTORS * SECTOR_PAYLOAD;
+    }
+
+    void printStats()
+    {
+        Serial.print(F("Log: particao '"));
+        Serial.print(LOG_PARTITION_LABEL);
+        if (partition == NULL)
+        {
+            Serial.println(F("' nao encontrada (dados so em RAM; ver partitions.csv)."));
+            return;
+        }
+        Serial.print(F("' "));
+        Serial.print(sectorCount);
+        Serial.print(F(" setores | setor atual "));
+        Serial.print(head);
+        Serial.print(F(" ("));
+        Serial.print(head >= 0 ? LOG_SECTOR_SIZE - headOffset : 0);
+        Serial.print(F(" B livres) | setores livres: "));
+        Serial.print(freeSectors());
+        Serial.print(F(" ("));
+        Serial.print(freeBytes());
+        Serial.print(F(" B)"));
+        Serial.print(F(" | snapshot #"));
+        Serial.println(snapshotId);
+
+        uint32_t minErases = sectorErases[0];
+        uint32_t maxErases = sectorErases[0];
+        for (int s = 1; s < sectorCount; s++)
+        {
+            minErases = min(minErases, sectorErases[s]);
+            maxErases = max(maxErases, sectorErases[s]);
+        }
+        Serial.print(F(" Registros gravados: "));
+        Serial.print(appendCount);
+        Serial.print(F(" ("));
+        Serial.print(appendedBytes);
+        Serial.print(F(" B) | snapshots: "));
+        Serial.print(snapshotCount);
+        Serial.print(F(" | apagamentos: "));
+        Serial.print(eraseCount);
+        Serial.print(F(" (por setor: min "));
+        Serial.print(minErases);
+        Serial.print(F(", max "));
+        Serial.print(maxErases);
+        Serial.print(F(") | boot: "));
+        Serial.print(bootUs);
+        Serial.print(F(" us, "));
+        Serial.print(replayedRecords);
+        Serial.print(F(" registros, "));
+        Serial.print(invalidRecords);
+        Serial.println(F(" invalidos"));
+    }
+
+} // namespace LogStore
@@ -0,0 +1,142 @@
+/**
+ * @file LogStore.h
+ * @brief Log de registros só de acréscimo em uma partição de dados da flash (partitions.csv).
+ *
+ * Cada registro (tipo, id, dados) é gravado no fim do setor atual com CRC16; o último registro de
+ * uma chave (tipo, id) vale. Os setores formam um anel: ao encher, o próximo é apagado (cada setor é
+ * apagado uma vez por volta, o que distribui o desgaste). Quando sobram menos de LOG_RESERVE_SECTORS
+ * setores livres, quem usa o log grava um snapshot (beginSnapshot(), todas as chaves vivas,
+ * endSnapshot()); os setores anteriores ao snapshot completo mais recente viram espaço livre.
+ * No boot, scan() localiza o último snapshot completo e replay() entrega os registros a partir dele.
+ * Uma gravação interrompida (queda de energia) falha no CRC e é ignorada: vale a versão anterior.
+ *
+ * Registros maiores que LOG_MAX_PAYLOAD são gravados em fragmentos seguidos (que ocupam o fim do
+ * setor e continuam no próximo); o registro só vale se todos os fragmentos estiverem íntegros. Os
+ * dados de um registro gravado são lidos sob demanda com read(), sem cópia em RAM.
+ *
+ * Gravado só pelo core de comunicação (Storage), sem sincronização própria. read() pode ser chamado
+ * de outro core: ele confere a sequência dos setores e falha se um deles for reaproveitado no meio.
+ */
+#ifndef LOG_STORE_H
+#define LOG_STORE_H
+
+#include "Config.h"
+
+namespace LogStore
+{
+
+    /**
+     * @brief Posição de um registro gravado: endereço do primeiro fragmento e a sequência do seu setor
+     * (detecta o setor apagado e reaproveitado depois de um snapshot).
+     */
+    struct RecordRef
+    {
+        uint32_t address;
+        uint32_t seq;
+    };
+
+    /**
+     * @brief Recebe cada registro válido durante o replay, na ordem em que foi gravado.
+     * @param data Dados do registro, ou NULL se ele for fragmentado (ler com read()).
+     * @param length 0 = a chave foi apagada.
+     */
+    typedef void (*RecordHandler)(uint8_t type, uint16_t id, const uint8_t *data, uint16_t length,
+                                  const RecordRef &ref);
+
+    /**
+     * @brief Localiza a partição LOG_PARTITION_LABEL e varre os cabeçalhos dos setores e registros.
+     * @return false se a partição não existir ou for pequena demais (o log fica indisponível).
+     */
+    bool begin();
+
+    /**
+     * @brief A partição foi encontrada.
+     */
+    bool available();
+
+    /**
+     * @brief Existe um snapshot completo (sem ele o conteúdo do log não é confiável).
+     */
+    bool hasSnapshot();
+
+    /**
+     * @brief Entrega os registros do último snapshot completo até o fim do log.
+     * @return Número de registros entregues.
+     */
+    uint32_t replay(RecordHandler handler);
+
+    /**
+     * @brief Apaga todos os setores usados (o próximo append começa um log novo).
+     */
+    void format();
+
+    /**
+     * @brief Acrescenta um registro (fragmentado se passar de LOG_MAX_PAYLOAD).
+     * @param data Dados (NULL com length 0 apaga a chave).
+     * @param ref [out] Opcional: onde o registro ficou, para read() e copy().
+     * @return false se a flash falhar ou o anel estiver cheio.
+     */
+    bool append(uint8_t type, uint16_t id, const void *data, uint16_t length, RecordRef *ref = NULL);
+
+    /**
+     * @brief Regrava um registro já gravado com outra chave ou no fim do log (snapshot), lendo-o
+     * da flash aos pedaços.
+     * @return false se a origem não puder ser lida ou a gravação falhar.
+     */
+    bool copy(uint8_t type, uint16_t id, const RecordRef &source, uint16_t length, RecordRef *ref = NULL);
+
+    /**
+     * @brief Lê 'size' bytes dos dados de um registro a partir de 'offset', atravessando os fragmentos.
+     * @return false se o registro não estiver mais no log (setor reaproveitado) ou for mais curto.
+     */
+    bool read(const RecordRef &ref, uint32_t offset, void *dst, uint32_t size);
+
+    /**
+     * @brief Marca o início de um snapshot. Os registros até endSnapshot() devem cobrir todas as chaves vivas.
+     */
+    bool beginSnapshot();
+
+    /**
+     * @brief Fecha o snapshot: a partir daqui o replay começa nele e o espaço anterior é liberado.
+     */
+    bool endSnapshot();
+
+    /**
+     * @brief O próximo commit deve ser um snapshot: depois de gravar 'pendingBytes', o espaço livre não
+     * caberia mais um snapshot de 'liveBytes' com LOG_RESERVE_SECTORS setores de folga.
+     */
+    bool needsCompaction(uint32_t liveBytes, uint32_t pendingBytes);
+
+    /**
+     * @brief Bytes ainda livres no anel (setores livres e o resto do setor atual).
+     */
+    uint32_t freeBytes();
+
+    /**
+     * @brief Maior volume de registros vivos que o log comporta: metade do anel sem a folga, para que
+     * o snapshot sempre caiba ao lado do anterior. 0 sem a partição.
+     */
+    uint32_t capacity();
+
+    /**
+     * @brief Espaço ocupado por um registro com 'length' bytes de dados (cabeçalho e alinhamento).
+     */
+    constexpr uint32_t recordSize(uint32_t length) { return (8 + length + 3) & ~3UL; }
+
+    /**
+     * @brief Espaço máximo ocupado por um registro de qualquer tamanho (um cabeçalho por fragmento).
+     */
+    constexpr uint32_t storedSize(uint32_t length)
+    {
+        return length <= (uint32_t)LOG_MAX_PAYLOAD ? recordSize(length)
+                                                   : length + (length / (LOG_MAX_PAYLOAD / 2) + 2) * recordSize(4);
+    }
+
+    /**
+     * @brief Exibe setores, espaço livre, desgaste (apagamentos por setor) e o custo do boot.
+     */
+    void printStats();
+
+} // namespace LogStore
+
+#endif // LOG_STORE_H
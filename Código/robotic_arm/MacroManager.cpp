@@ -1,44 +1,273 @@
 /**
  * MacroManager.cpp
  * Implementação da lógica de persistência das Macros.
+ * Em RAM fica só o índice de nomes e, por slot, a referência do registro no log e o número de passos;
+ * os passos (id da pose + espera) ficam no registro, lido sob demanda (gravação e MacroStream).
+ * Uma macro salva é gravada a partir do buffer de gravação (na hora, ou quando o braço parar); um
+ * snapshot copia o registro atual de flash para flash. No boot os slots voltam pelo replay do log (applyRecord) ou pela
+ * importação da EEPROM legada (importMacro/importEeprom).
  */
 #include "MacroManager.h"
+#include "NameIndex.h"
+#include "PoseManager.h"
+#include "Storage.h"
+
+#include <stddef.h>
 
 namespace MacroManager
 {
+    namespace
+    {
+        // Slots em RAM. Escritos só pelo core de comunicação; openStream/readSteps também rodam no
+        // core de movimento (Sequencer), por isso nome, referência e passos mudam juntos sob indexMux.
+        NameIndex<MAX_MACROS> nameIndex;
+        LogStore::RecordRef records[MAX_MACROS]; // seq 0 = sem registro no log
+        uint16_t stepCounts[MAX_MACROS];
+        bool dirtySlot[MAX_MACROS]; // Alterado desde o último flush
+        portMUX_TYPE indexMux = portMUX_INITIALIZER_UNLOCKED;
+
+        // Buffer de gravação, já no formato do registro (cabeçalho + passos). Depois do save guarda a
+        // macro salva até o flush gravá-la (stagedSlot).
+        uint8_t recordBuffer[sizeof(MacroRecordHeader) + MACRO_MAX_STEPS * sizeof(MacroStepRecord)];
+        char recordingMacroName[POSE_NAME_LEN];
+        uint16_t recordingSteps = 0;
+        int stagedSlot = -1;
+
+        int nameAddress(int index)
+        {
+            return NAMES_START_V2 + offsetof(NameTable, macroNames) + index * POSE_NAME_LEN;
+        }
+
+        int macroAddress(int index)
+        {
+            return MACROS_START_V2 + index * sizeof(MacroCompact);
+        }
+
+        uint16_t macroCrc(const char name[POSE_NAME_LEN], const MacroCompact &macro)
+        {
+            const uint16_t crc = calcCRC16((const uint8_t *)name, POSE_NAME_LEN);
+            return calcCRC16((const uint8_t *)&macro, sizeof(macro) - 2, crc);
+        }
+
+        uint16_t recordLength(uint16_t numSteps)
+        {
+            return sizeof(MacroRecordHeader) + numSteps * sizeof(MacroStepRecord);
+        }
+
+        MacroStepRecord *bufferSteps()
+        {
+            return (MacroStepRecord *)(recordBuffer + sizeof(MacroRecordHeader));
+        }
+
+        uint16_t stagedSteps()
+        {
+            MacroRecordHeader header;
+            memcpy(&header, recordBuffer, sizeof(header));
+            return header.numSteps;
+        }
+
+        void setSlot(int index, const char name[POSE_NAME_LEN], const LogStore::RecordRef &ref, uint16_t numSteps)
+        {
+            portENTER_CRITICAL(&indexMux);
+            nameIndex.insert(index, name);
+            records[index] = ref;
+            stepCounts[index] = numSteps;
+            portEXIT_CRITICAL(&indexMux);
+        }
+
+        void clearSlot(int index)
+        {
+            portENTER_CRITICAL(&indexMux);
+            nameIndex.remove(index);
+            records[index].seq = 0;
+            stepCounts[index] = 0;
+            portEXIT_CRITICAL(&indexMux);
+            dirtySlot[index] = true;
+            if (stagedSlot == index)
+                stagedSlot = -1;
+        }
+
+        int findSlot(const char *name)
+        {
+            portENTER_CRITICAL(&indexMux);
+            const int slot = nameIndex.find(name);
+            portEXIT_CRITICAL(&indexMux);
+            return slot;
+        }
+    }
+
+    RecordState readSlot(int index, char name[POSE_NAME_LEN], MacroCompact &macro)
+    {
+        EEPROM.get(macroAddress(index), macro);
+        for (int i = 0; i < POSE_NAME_LEN; i++)
+            name[i] = (char)EEPROM.read(nameAddress(index) + i);
+        if (!(macro.flags & RECORD_USED))
+        {
+            name[0] = '\0';
+            return RECORD_EMPTY;
+        }
+        if (name[POSE_NAME_LEN - 1] != '\0' || macroCrc(name, macro) != macro.crc16)
+        {
+            name[POSE_NAME_LEN - 1] = '\0';
+            return RECORD_CORRUPT;
+        }
+        return RECORD_VALID;
+    }
 
-    // Função auxiliar interna para ler uma macro
-    void readMacro(int index, Macro &macro)
+    void reset()
     {
-        EEPROM.get(MACROS_START + index * sizeof(Macro), macro);
+        portENTER_CRITICAL(&indexMux);
+        nameIndex.clear();
+        memset(records, 0, sizeof(records));
+        memset(stepCounts, 0, sizeof(stepCounts));
+        portEXIT_CRITICAL(&indexMux);
+        memset(dirtySlot, 0, sizeof(dirtySlot));
+        stagedSlot = -1;
+        recordingSteps = 0;
     }
 
-    // Função auxiliar interna para escrever uma macro
-    void writeMacro(int index, const Macro &macro)
+    void applyRecord(uint16_t id, uint16_t length, const LogStore::RecordRef &ref)
     {
-        EEPROM.put(MACROS_START + index * sizeof(Macro), macro);
+        if (id >= MAX_MACROS)
+            return;
+        if (length == 0)
+        {
+            clearSlot(id);
+            dirtySlot[id] = false; // Já está no log
+            return;
+        }
+        MacroRecordHeader header;
+        if (length < sizeof(header) || !LogStore::read(ref, 0, &header, sizeof(header)) ||
+            header.numSteps > MACRO_MAX_STEPS || length != recordLength(header.numSteps))
+            return; // Registro de outro formato: mantém a versão anterior
+        header.name[POSE_NAME_LEN - 1] = '\0';
+        setSlot(id, header.name, ref, header.numSteps);
+        dirtySlot[id] = false; // Já está no log
     }
 
-    void listMacros()
+    bool flush(bool all)
     {
-        Serial.println(F("\n--- Macros Salvas ---"));
-        int count = 0;
         for (int i = 0; i < MAX_MACROS; i++)
         {
-            Macro m;
-            readMacro(i, m);
-            if (m.name[0] != 0)
+            if (!all && !dirtySlot[i])
+                continue;
+            // Os slots só mudam neste core: a leitura dispensa o indexMux
+            const bool used = nameIndex.contains(i);
+            if (used || dirtySlot[i]) // Slot vazio: só o delete pendente (um snapshot cortado ainda o aplica)
+            {
+                LogStore::RecordRef ref = {0, 0};
+                uint16_t numSteps = stepCounts[i];
+                bool ok;
+                if (!used)
+                    ok = LogStore::append(LOG_RECORD_MACRO, i, NULL, 0);
+                else if (i == stagedSlot)
+                {
+                    numSteps = stagedSteps();
+                    ok = LogStore::append(LOG_RECORD_MACRO, i, recordBuffer, recordLength(numSteps), &ref);
+                }
+                else
+                    ok = LogStore::copy(LOG_RECORD_MACRO, i, records[i], recordLength(numSteps), &ref);
+                if (!ok)
+                    return false;
+                if (used)
+                {
+                    portENTER_CRITICAL(&indexMux);
+                    records[i] = ref;
+                    stepCounts[i] = numSteps;
+                    portEXIT_CRITICAL(&indexMux);
+                }
+                if (i == stagedSlot)
+                    stagedSlot = -1;
+            }
+            dirtySlot[i] = false;
+        }
+        return true;
+    }
+
+    uint32_t logBytes(bool all)
+    {
+        uint32_t bytes = 0;
+        for (int i = 0; i < MAX_MACROS; i++)
+        {
+            const bool used = nameIndex.contains(i);
+            if (!dirtySlot[i] && !(all && used))
+                continue;
+            if (!used)
+                bytes += LogStore::recordSize(0);
+            else
+                bytes += LogStore::storedSize(recordLength(i == stagedSlot ? stagedSteps() : stepCounts[i]));
+        }
+        return bytes;
+    }
+
+    bool importMacro(int index, const char *name, const MacroStepRecord *steps, int count)
+    {
+        MacroRecordHeader header = {};
+        strncpy(header.name, name, POSE_NAME_LEN - 1);
+        header.numSteps = (uint16_t)constrain(count, 0, MACRO_MAX_STEPS);
+        memcpy(recordBuffer, &header, sizeof(header));
+        memcpy(bufferSteps(), steps, header.numSteps * sizeof(MacroStepRecord));
+        LogStore::RecordRef ref;
+        if (!LogStore::append(LOG_RECORD_MACRO, index, recordBuffer, recordLength(header.numSteps), &ref))
+            return false;
+        setSlot(index, header.name, ref, header.numSteps);
+        return true;
+    }
+
+    int importEeprom()
+    {
+        int count = 0;
+        for (int i = 0; i < MAX_MACROS_V2; i++)
+        {
+            char name[POSE_NAME_LEN];
+            MacroCompact macro;
+            const RecordState state = readSlot(i, name, macro);
+            if (state == RECORD_VALID)
+            {
+                // As poses V2 foram importadas nos mesmos slots: o slot vira o id da pose
+                MacroStepRecord steps[MAX_STEPS_PER_MACRO_V2];
+                const int numSteps = min((int)macro.numSteps, MAX_STEPS_PER_MACRO_V2);
+                for (int s = 0; s < numSteps; s++)
+                {
+                    const uint8_t poseIndex = macro.steps[s].poseIndex;
+                    steps[s].poseId = poseIndex < MAX_POSES_V2 ? PoseManager::slotId(poseIndex) : POSE_ID_NONE;
+                    steps[s].delay_ms = macro.steps[s].delay_ms;
+                }
+                if (importMacro(i, name, steps, numSteps))
+                    count++;
+            }
+            else if (state == RECORD_CORRUPT)
             {
-                Serial.print(" [");
+                Serial.print(F("AVISO: macro do slot "));
                 Serial.print(i);
-                Serial.print("] ");
-                Serial.print(m.name);
-                Serial.print(" (");
-                Serial.print(m.numSteps);
-                Serial.println(" passos)");
-                count++;
+                Serial.println(F(" corrompida na EEPROM (CRC invalido). Descartada."));
             }
         }
+        return count;
+    }
+
+    void listMacros()
+    {
+        Serial.println(F("\n--- Macros Salvas ---"));
+        int count = 0;
+        for (int i = 0; i < MAX_MACROS; i++)
+        {
+            char name[POSE_NAME_LEN];
+            portENTER_CRITICAL(&indexMux);
+            memcpy(name, nameIndex.name(i), POSE_NAME_LEN);
+            const uint16_t numSteps = i == stagedSlot ? stagedSteps() : stepCounts[i];
+            portEXIT_CRITICAL(&indexMux);
+            if (name[0] == '\0')
+                continue;
+            Serial.print(" [");
+            Serial.print(i);
+            Serial.print("] ");
+            Serial.print(name);
+            Serial.print(" (");
+            Serial.print(numSteps);
+            Serial.println(" passos)");
+            count++;
+        }
         if (count == 0)
         {
             Serial.println(F(" Nenhuma macro encontrada."));
@@ -48,56 +277,181 @@ namespace MacroManager
         Serial.print(F(" de "));
         Serial.print(MAX_MACROS);
         Serial.println(F(" slots usados."));
+        Storage::printLibrarySpace();
     }
 
-    bool saveMacro(const Macro &macro)
+    bool beginRecording(const char *name)
     {
-        int emptySlot = -1;
-        for (int i = 0; i < MAX_MACROS; i++)
+        // O buffer ainda guarda a última macro salva se ela não foi gravada na flash (falha, ou o
+        // braço estava em movimento no save)
+        if (stagedSlot >= 0)
         {
-            Macro m;
-            readMacro(i, m);
-            if (m.name[0] == 0)
+            const Storage::SyncResult result = Storage::sync();
+            if (result == Storage::SYNC_DEFERRED)
             {
-                if (emptySlot == -1)
-                    emptySlot = i;
+                Serial.println(F("ERRO: A macro salva antes sera gravada na flash quando o braco parar; tente depois."));
+                return false;
             }
-            else if (strncmp(m.name, macro.name, POSE_NAME_LEN) == 0)
+            if (result == Storage::SYNC_FAILED)
             {
-                emptySlot = i; // Sobrescreve
-                break;
+                Serial.println(F("ERRO: A macro salva antes ainda nao foi gravada na flash (tente 'sync')."));
+                return false;
             }
         }
+        memset(recordingMacroName, 0, sizeof(recordingMacroName));
+        strncpy(recordingMacroName, name, POSE_NAME_LEN - 1);
+        recordingSteps = 0;
 
-        if (emptySlot != -1)
+        // Macro existente: continua a partir dos passos salvos
+        MacroStream stream;
+        if (openStream(recordingMacroName, stream))
         {
-            writeMacro(emptySlot, macro);
-            EEPROM.commit();
-            Serial.print(F("Macro '"));
-            Serial.print(macro.name);
-            Serial.print(F("' salva no slot "));
-            Serial.print(emptySlot);
-            Serial.println(F("."));
-            return true;
+            const uint16_t numSteps = min((int)stream.numSteps, MACRO_MAX_STEPS);
+            if (!readSteps(stream, 0, bufferSteps(), numSteps))
+            {
+                Serial.println(F("ERRO: Falha ao ler os passos da macro na flash."));
+                return false;
+            }
+            recordingSteps = numSteps;
+        }
+        return true;
+    }
+
+    bool addStep(const char *poseName, unsigned long delayMs)
+    {
+        const uint16_t poseId = PoseManager::findId(poseName);
+        if (poseId == POSE_ID_NONE)
+        {
+            Serial.print(F("ERRO: Pose '"));
+            Serial.print(poseName);
+            Serial.println(F("' nao existe. Salve-a com 'pose save' antes."));
+            return false;
+        }
+        if (recordingSteps >= MACRO_MAX_STEPS)
+        {
+            Serial.println(F("AVISO: Limite de passos atingido. Salve a macro."));
+            return false;
+        }
+        if (delayMs > MACRO_MAX_DELAY_MS)
+        {
+            Serial.println(F("AVISO: Delay limitado a 65535 ms."));
+            delayMs = MACRO_MAX_DELAY_MS;
+        }
+        MacroStepRecord step;
+        step.poseId = poseId;
+        step.delay_ms = (uint16_t)delayMs;
+        memcpy(&bufferSteps()[recordingSteps], &step, sizeof(step));
+        recordingSteps++;
+        return true;
+    }
+
+    bool saveRecording()
+    {
+        if (!LogStore::available())
+        {
+            Serial.println(F("ERRO: Log da flash indisponivel (ver partitions.csv): macros nao podem ser salvas."));
+            return false;
         }
-        else
+
+        // Slot com o mesmo nome (sobrescreve) ou o primeiro livre
+        int slot = findSlot(recordingMacroName);
+        const bool replacing = slot >= 0;
+        for (int i = 0; i < MAX_MACROS && slot == -1; i++)
+        {
+            if (!nameIndex.contains(i))
+                slot = i;
+        }
+        if (slot == -1)
         {
             Serial.println(F("ERRO: Não há slots de macro disponíveis."));
             return false;
         }
+
+        const uint32_t size = LogStore::storedSize(recordLength(recordingSteps));
+        const uint32_t previous = replacing ? LogStore::storedSize(recordLength(stepCounts[slot])) : 0;
+        if (size > previous && !Storage::hasRoom(size - previous))
+        {
+            Serial.println(F("ERRO: Sem espaco na flash para esta macro."));
+            return false;
+        }
+
+        MacroRecordHeader header;
+        memcpy(header.name, recordingMacroName, POSE_NAME_LEN); // Zeros após o nome
+        header.numSteps = recordingSteps;
+        memcpy(recordBuffer, &header, sizeof(header));
+        // Até o flush, o slot mantém o registro anterior (uma execução em andamento continua nele)
+        portENTER_CRITICAL(&indexMux);
+        nameIndex.insert(slot, header.name);
+        portEXIT_CRITICAL(&indexMux);
+        stagedSlot = slot;
+        dirtySlot[slot] = true;
+        Storage::markDirty(Storage::REGION_MACROS);
+
+        Serial.print(F("Macro '"));
+        Serial.print(header.name);
+        Serial.print(F("' salva no slot "));
+        Serial.print(slot);
+        Serial.print(F(" ("));
+        Serial.print(header.numSteps);
+        Serial.println(F(" passos)."));
+        // Com o braço parado grava na hora; em movimento o service() grava quando ele parar
+        const Storage::SyncResult result = Storage::sync();
+        if (result == Storage::SYNC_DEFERRED)
+            Serial.println(F("Braco em movimento: a macro sera gravada na flash quando ele parar."));
+        else if (result == Storage::SYNC_FAILED)
+            Serial.println(F("AVISO: Falha ao gravar a macro na flash; fica pendente (tente 'sync')."));
+        recordingSteps = 0;
+        return true;
     }
 
-    bool loadMacroByName(const char *name, Macro &macro)
+    const char *recordingName()
     {
-        for (int i = 0; i < MAX_MACROS; i++)
+        return recordingMacroName;
+    }
+
+    int recordingLength()
+    {
+        return recordingSteps;
+    }
+
+    bool openStream(const char *name, MacroStream &stream)
+    {
+        bool found = false;
+        portENTER_CRITICAL(&indexMux);
+        const int slot = nameIndex.find(name);
+        if (slot >= 0 && records[slot].seq != 0)
         {
-            readMacro(i, macro);
-            if (macro.name[0] != 0 && strncmp(macro.name, name, POSE_NAME_LEN) == 0)
-            {
-                return true;
-            }
+            memcpy(stream.name, nameIndex.name(slot), POSE_NAME_LEN);
+            stream.slot = slot;
+            stream.numSteps = stepCounts[slot];
+            stream.ref = records[slot];
+            found = true;
+        }
+        portEXIT_CRITICAL(&indexMux);
+        return found;
+    }
+
+    bool readSteps(MacroStream &stream, uint16_t first, MacroStepRecord *steps, uint16_t count)
+    {
+        if ((uint32_t)first + count > stream.numSteps)
+            return false;
+        const uint32_t offset = sizeof(MacroRecordHeader) + (uint32_t)first * sizeof(MacroStepRecord);
+        const uint32_t size = (uint32_t)count * sizeof(MacroStepRecord);
+        if (LogStore::read(stream.ref, offset, steps, size))
+            return true;
+
+        // O setor do registro foi apagado (snapshot): a macro continua no mesmo slot, em outro lugar
+        bool moved = false;
+        portENTER_CRITICAL(&indexMux);
+        if (strncmp(nameIndex.name(stream.slot), stream.name, POSE_NAME_LEN) == 0 &&
+            records[stream.slot].seq != 0 &&
+            stepCounts[stream.slot] >= (uint32_t)first + count)
+        {
+            moved = records[stream.slot].seq != stream.ref.seq || records[stream.slot].address != stream.ref.address;
+            stream.ref = records[stream.slot];
         }
-        return false; // Não encontrada
+        portEXIT_CRITICAL(&indexMux);
+        return moved && LogStore::read(stream.ref, offset, steps, size);
     }
 
     void deleteMacro(const char *name)
@@ -106,28 +460,23 @@ namespace MacroManager
         {
             for (int i = 0; i < MAX_MACROS; i++)
             {
-                Macro emptyMacro = {0};
-                writeMacro(i, emptyMacro);
+                if (nameIndex.contains(i))
+                    clearSlot(i);
             }
-            EEPROM.commit();
+            Storage::markDirty(Storage::REGION_MACROS);
             Serial.println(F("Todas as macros foram apagadas."));
             return;
         }
 
-        for (int i = 0; i < MAX_MACROS; i++)
+        const int slot = findSlot(name);
+        if (slot >= 0)
         {
-            Macro m;
-            readMacro(i, m);
-            if (m.name[0] != 0 && strncmp(m.name, name, POSE_NAME_LEN) == 0)
-            {
-                Macro emptyMacro = {0};
-                writeMacro(i, emptyMacro);
-                EEPROM.commit();
-                Serial.print(F("Macro '"));
-                Serial.print(name);
-                Serial.println(F("' apagada."));
-                return;
-            }
+            clearSlot(slot);
+            Storage::markDirty(Storage::REGION_MACROS);
+            Serial.print(F("Macro '"));
+            Serial.print(name);
+            Serial.println(F("' apagada."));
+            return;
         }
         Serial.print(F("Macro '"));
         Serial.print(name);
@@ -1,36 +1,78 @@
 /**
  * MacroManager.h
  * Responsável pela lógica de salvar, carregar e gerenciar
- * as 'Macros' (sequências de poses) na EEPROM.
+ * as 'Macros' (sequências de poses): índice de nomes em RAM e passos no log da flash, lidos sob
+ * demanda (MacroStream) durante a execução.
  */
 #ifndef MACRO_MANAGER_H
 #define MACRO_MANAGER_H
 
 #include "Config.h"
+#include "LogStore.h"
 
 namespace MacroManager
 {
 
+    /**
+     * @brief Macro aberta para leitura dos passos direto da flash (Sequencer).
+     */
+    struct MacroStream
+    {
+        char name[POSE_NAME_LEN]; /**< Nome da macro. */
+        int slot;                 /**< Slot da macro (para reencontrar o registro depois de um snapshot). */
+        uint16_t numSteps;        /**< Passos da macro no momento em que foi aberta. */
+        LogStore::RecordRef ref;  /**< Registro da macro no log. */
+    };
+
     /**
      * @brief Lista todas as macros salvas na Serial.
      */
     void listMacros();
 
     /**
-     * @brief Salva uma estrutura de Macro em um slot da EEPROM.
-     * Procura um slot vazio ou com o mesmo nome.
-     * @param macro A macro a ser salva.
-     * @return true se foi salva com sucesso, false se a EEPROM estiver cheia.
+     * @brief Inicia a gravação de uma macro no buffer de gravação; se ela já existir, os passos
+     * salvos são lidos da flash para continuar a partir deles.
+     * @return false se uma macro salva antes ainda não tiver sido gravada na flash (falha ou braço em
+     * movimento).
+     */
+    bool beginRecording(const char *name);
+
+    /**
+     * @brief Acrescenta um passo à macro em gravação. O passo guarda o id da pose, então ela precisa existir.
+     * @return false se a pose não existir ou o buffer estiver cheio (MACRO_MAX_STEPS).
+     */
+    bool addStep(const char *poseName, unsigned long delayMs);
+
+    /**
+     * @brief Salva a macro em gravação no slot de mesmo nome ou no primeiro livre e grava o log
+     * (Storage::sync), liberando o buffer. Com o braço em movimento a gravação fica para quando ele
+     * parar; até lá a macro não pode ser executada e o buffer fica ocupado.
+     * @return false se não houver slot ou espaço na flash.
+     */
+    bool saveRecording();
+
+    /**
+     * @brief Nome da macro em gravação.
+     */
+    const char *recordingName();
+
+    /**
+     * @brief Passos já gravados no buffer.
      */
-    bool saveMacro(const Macro &macro);
+    int recordingLength();
 
     /**
-     * @brief Carrega uma macro da EEPROM pelo nome.
-     * @param name Nome da macro a ser procurada.
-     * @param macro [out] Referência onde a macro será carregada.
-     * @return true se encontrada, false se não.
+     * @brief Abre uma macro pelo nome para ler os passos (de qualquer core).
+     * @return false se a macro não existir ou ainda não estiver na flash.
      */
-    bool loadMacroByName(const char *name, Macro &macro);
+    bool openStream(const char *name, MacroStream &stream);
+
+    /**
+     * @brief Lê 'count' passos a partir de 'first'. Se um snapshot tiver movido o registro, reabre
+     * a macro pelo slot (se ela ainda tiver o mesmo nome) e tenta de novo.
+     * @return false se os passos não puderem ser lidos.
+     */
+    bool readSteps(MacroStream &stream, uint16_t first, MacroStepRecord *steps, uint16_t count);
 
     /**
      * @brief Deleta uma macro por nome, ou todas.
@@ -38,6 +80,49 @@ namespace MacroManager
      */
     void deleteMacro(const char *name);
 
+    // --- Acesso aos slots: usado pelo Storage (boot e commit) ---
+
+    /**
+     * @brief Lê o slot da EEPROM legada V2 e confere o CRC (nome + macro).
+     */
+    RecordState readSlot(int index, char name[POSE_NAME_LEN], MacroCompact &macro);
+
+    /**
+     * @brief Esvazia todos os slots em RAM (início do boot).
+     */
+    void reset();
+
+    /**
+     * @brief Aplica um registro LOG_RECORD_MACRO do replay, ou sem dados (slot apagado).
+     */
+    void applyRecord(uint16_t id, uint16_t length, const LogStore::RecordRef &ref);
+
+    /**
+     * @brief Acrescenta ao log os slots alterados desde o último flush (slot vazio: registro sem dados).
+     * A macro recém-salva vem do buffer de gravação; as demais são copiadas do registro atual.
+     * @param all true = todos os slots ocupados, mais os deletes pendentes (snapshot).
+     * @return false se o log recusar um registro (os slots restantes continuam pendentes).
+     */
+    bool flush(bool all);
+
+    /**
+     * @brief Espaço no log dos registros que flush(all) gravaria.
+     */
+    uint32_t logBytes(bool all);
+
+    /**
+     * @brief Grava direto no log uma macro importada da EEPROM legada (dentro do snapshot inicial).
+     * @return false se o log recusar o registro.
+     */
+    bool importMacro(int index, const char *name, const MacroStepRecord *steps, int count);
+
+    /**
+     * @brief Grava no log os slots válidos da EEPROM legada V2 (importação única no boot, dentro do
+     * snapshot inicial). Os passos passam do slot para o id da pose (PoseManager::slotId).
+     * @return Número de macros importadas.
+     */
+    int importEeprom();
+
 } // namespace MacroManager
 
 #endif // MACRO_MANAGER_H
@@ -3,29 +3,483 @@
  * Implementação da lógica de interpolação e controle de servos.
  */
 #include "MotionController.h"
-#include <Arduino.h>
+#include "ServoOutput.h"
+#include "Spline.h"
+#include "InverseKinematics.h"
+#include "Workspace.h"
+#include "LockFree.h"
+#include "CommandBus.h"
+#include "Perf.h"
+#include "Platform.h"
+#if MOTION_USE_TASK
+#include <esp_timer.h>
+#endif
 
 // --- Variáveis de Estado de Movimento (Internas) ---
 // Note: '_isMoving' usa um underscore para evitar conflito de nome
 // com a função 'isMoving()'.
-static bool _isMoving = false;
+static volatile bool _isMoving = false;
 static unsigned long moveStartTime;
 static unsigned long moveDuration;
-static int startAngles[NUM_SERVOS];
-static int targetAngles[NUM_SERVOS];
+static float startAngles[NUM_SERVOS];
+static float targetAngles[NUM_SERVOS];
+static float startVelocity[NUM_SERVOS]; // Velocidade na entrada do segmento ativo (graus/ms)
+static float endVelocity[NUM_SERVOS];   // Velocidade planejada na saída do segmento ativo (graus/ms)
+static MotionProfile::Plan moveProfile;  // Perfil do segmento ativo quando parte e termina em repouso
+#if MOTION_FIXED_POINT
+static MotionProfile::PlanQ16 moveProfileQ16; // Mesmo perfil para o kernel em ponto fixo
+static int32_t startAnglesQ16[NUM_SERVOS];   // Posição inicial em Q16 (graus * 65536)
+static int32_t targetAnglesQ16[NUM_SERVOS];  // Posição alvo em Q16
+#endif
+static bool blendedSegment = false;     // true = curva de Hermite; false = perfil repouso a repouso
+static bool stopPlanned = false;        // true = segmento ativo planeja parar (fila vazia ao iniciar)
+static bool rampSegment = false;        // true = rampa de desaceleração até o repouso (stop/pause)
+static bool splineExit = false;         // true = velocidade de saída fixada pelo spline (splineExitVelocity)
+static float splineExitVelocity[NUM_SERVOS];
+static bool linearSegment = false;      // true = reta em XYZ com IK a cada tick (movel)
+static float linearFrom[3];             // Ponto inicial da reta (mm)
+static float linearTo[3];               // Ponto final da reta (mm)
+static float linearLimits[3];           // Velocidade, aceleração e jerk ao longo da reta (mm/s, mm/s², mm/s³)
+static uint32_t segmentSerial = 0;      // Muda a cada troca do segmento ativo (o IK da reta roda fora do lock)
 
-// Objetos de Hardware (definidos aqui, pois este módulo os controla)
-Servo servos[NUM_SERVOS];
+// Velocidade interpolada (base para a mescla entre segmentos)
+static float currentVelocity[NUM_SERVOS];
+static unsigned long lastEvalTime = 0;
+
+// --- Fila de Segmentos (Look-Ahead) ---
+struct MotionSegment
+{
+  float target[NUM_SERVOS];
+  unsigned long duration;
+  MotionProfile::Plan profile; // Perfil sincronizado calculado ao enfileirar
+  bool spline;                 // true = trecho de spline: velocidade de saída calculada em startSpline()
+  float exitVelocity[NUM_SERVOS]; // Velocidade de saída do trecho de spline (graus/ms)
+  bool linear;                 // true = reta cartesiana (parte e termina em repouso); 'target' = IK do fim
+  float fromXYZ[3];
+  float toXYZ[3];
+  float limits[3];             // Limites ao longo da reta, já reduzidos pelas juntas (ver startLinearMove)
+};
+static MotionSegment segmentQueue[MOTION_QUEUE_SIZE];
+static uint8_t queueHead = 0;  // Índice do próximo segmento a ser executado
+static uint8_t queueCount = 0; // Segmentos aguardando na fila
+
+// --- Parada Controlada / Pausa ---
+static bool paused = false;               // true = fila congelada até resume()
+static bool hasInterrupted = false;       // true = há um segmento interrompido por pause() a retomar
+static MotionSegment interruptedSegment; // Alvo e tempo restante do segmento interrompido
+
+static volatile uint32_t statSegments = 0;  // Segmentos concluídos
+static volatile uint32_t statBlends = 0;    // Segmentos iniciados sem parar (velocidade de entrada != 0)
+static volatile uint32_t statUnderruns = 0; // Segmentos que chegaram quando o ativo já planejava parar
+
+static MotionProfile::Type activeProfile = (MotionProfile::Type)MOTION_DEFAULT_PROFILE;
+
+// Protege o plano e a fila: startSmoothMove() roda no loop() e update() na task de movimento.
+static portMUX_TYPE motionMux = portMUX_INITIALIZER_UNLOCKED;
+
+// --- Tick Fixo e Estatísticas ---
+static const uint32_t TICK_PERIOD_US = 1000000UL / MOTION_TICK_HZ;
+static uint32_t lastTickStartUs = 0;
+static bool hasLastTick = false;
+static volatile uint32_t statTicks = 0;
+static volatile uint32_t statOverruns = 0;
+static volatile uint32_t statMaxJitterUs = 0;
+static volatile uint32_t statMaxTickUs = 0;
+static volatile uint32_t statLastTickUs = 0;
+
+// Estado publicado a cada tick para o core de comunicação
+static SeqLock<MotionController::Snapshot> snapshotLock;
+static SeqLock<MotionController::Limits> limitsLock; // Calibração: publicada quando muda
+
+#if MOTION_USE_TASK
+static TaskHandle_t motionTaskHandle = NULL;
+static esp_timer_handle_t motionTimer = NULL;
+#endif
 
 // Variáveis de Posição (definidas aqui, pois este módulo as controla)
 // VALORES INICIAIS AQUI (DEFINIÇÃO) CORRIGEM O ERRO DE LINKER ANTERIOR
 int currentAngles[NUM_SERVOS] = {90, 90, 90, 90, 90, 90, 90};
+float currentAnglesF[NUM_SERVOS] = {90, 90, 90, 90, 90, 90, 90};
 int minAngles[NUM_SERVOS] = {0, 0, 0, 0, 0, 0, 0};
 int maxAngles[NUM_SERVOS] = {180, 180, 180, 180, 180, 180, 180};
 int offsets[NUM_SERVOS] = {0, 0, 0, 0, 0, 0, 0};
 
 namespace MotionController
 {
+  /**
+   * @brief Publica o estado atual no seqlock. Chamada apenas pelo dono do tick
+   * (único escritor), com motionMux travado.
+   */
+  void publishSnapshot()
+  {
+    Snapshot snap;
+    for (int i = 0; i < NUM_SERVOS; i++)
+      snap.angles[i] = currentAnglesF[i];
+    snap.moving = _isMoving || queueCount > 0 || hasInterrupted;
+    snap.paused = paused;
+    snap.queueDepth = queueCount;
+    snapshotLock.write(snap);
+  }
+
+  void getSnapshot(Snapshot &snapshot)
+  {
+    snapshotLock.read(snapshot);
+  }
+
+  void publishLimits()
+  {
+    Limits limits;
+    memcpy(limits.minAngles, minAngles, sizeof(limits.minAngles));
+    memcpy(limits.maxAngles, maxAngles, sizeof(limits.maxAngles));
+    memcpy(limits.offsets, offsets, sizeof(limits.offsets));
+    limitsLock.write(limits);
+  }
+
+  void getLimits(Limits &limits)
+  {
+    limitsLock.read(limits);
+  }
+
+  /**
+   * @brief Velocidade de passagem em um ponto intermediário (tangente de Fritsch-Butland).
+   * Usa a média harmônica das inclinações vizinhas e zera em reversões, o que evita
+   * overshoot além dos pontos (e, portanto, além dos limites de software).
+   */
+  float junctionVelocity(float a, float b, float c, unsigned long d1, unsigned long d2)
+  {
+    if (d1 == 0 || d2 == 0)
+      return 0.0f;
+    const float s1 = (b - a) / (float)d1;
+    const float s2 = (c - b) / (float)d2;
+    if (s1 * s2 <= 0.0f)
+      return 0.0f;
+    return 2.0f * s1 * s2 / (s1 + s2);
+  }
+
+  /**
+   * @brief Define a velocidade de saída do segmento ativo olhando o próximo segmento da fila.
+   * Deve ser chamada com motionMux travado.
+   */
+  void planExit()
+  {
+    stopPlanned = (queueCount == 0);
+    bool anyVelocity = false;
+    for (int i = 0; i < NUM_SERVOS; i++)
+    {
+      endVelocity[i] = 0.0f;
+      if (!stopPlanned)
+      {
+        const MotionSegment &next = segmentQueue[queueHead];
+        if (splineExit)
+          endVelocity[i] = splineExitVelocity[i]; // Dentro do spline: velocidade C2 do nó
+        else if (!next.spline && !next.linear && !linearSegment)
+          endVelocity[i] = junctionVelocity(startAngles[i], targetAngles[i], next.target[i],
+                                            moveDuration, next.duration);
+        // Um spline sempre parte do repouso (velocidade zero no primeiro nó); uma reta parte e termina em repouso
+      }
+      if (startVelocity[i] != 0.0f || endVelocity[i] != 0.0f)
+        anyVelocity = true;
+    }
+    blendedSegment = anyVelocity;
+  }
+
+  /**
+   * @brief Retira o próximo segmento da fila e o torna ativo.
+   * Deve ser chamada com motionMux travado.
+   * @param startTime Instante (millis) de início do segmento.
+   * @param entryVelocity Velocidade de entrada por junta (NULL = parte do repouso).
+   */
+  void beginNextSegment(unsigned long startTime, const float *entryVelocity)
+  {
+    const MotionSegment &seg = segmentQueue[queueHead];
+    moveStartTime = startTime;
+    moveDuration = seg.duration;
+    moveProfile = seg.profile;
+#if MOTION_FIXED_POINT
+    moveProfileQ16 = MotionProfile::toQ16(seg.profile);
+#endif
+    bool blended = false;
+    rampSegment = false;
+    splineExit = seg.spline;
+    linearSegment = seg.linear;
+    for (int k = 0; k < 3; k++)
+    {
+      linearFrom[k] = seg.fromXYZ[k];
+      linearTo[k] = seg.toXYZ[k];
+      linearLimits[k] = seg.limits[k];
+    }
+    for (int i = 0; i < NUM_SERVOS; i++)
+    {
+      splineExitVelocity[i] = seg.exitVelocity[i];
+      startAngles[i] = currentAnglesF[i];
+      targetAngles[i] = seg.target[i];
+      startVelocity[i] = (entryVelocity != NULL && !seg.linear) ? entryVelocity[i] : 0.0f;
+      if (startVelocity[i] != 0.0f)
+        blended = true;
+#if MOTION_FIXED_POINT
+      startAnglesQ16[i] = (int32_t)lroundf(startAngles[i] * MotionProfile::Q16_ONE);
+      targetAnglesQ16[i] = (int32_t)lroundf(targetAngles[i] * MotionProfile::Q16_ONE);
+#endif
+    }
+    queueHead = (queueHead + 1) % MOTION_QUEUE_SIZE;
+    queueCount--;
+    if (blended)
+      statBlends++;
+
+    planExit();
+    segmentSerial++;
+    _isMoving = true;
+  }
+
+  /**
+   * @brief Substitui o segmento ativo por uma rampa de desaceleração até o repouso.
+   * Todas as juntas param juntas: o tempo de parada é o da junta que mais precisa
+   * (|v| / JOINT_MAX_ACCEL), e cada uma desacelera de forma constante a partir da
+   * velocidade atual, então nenhuma excede o seu limite de aceleração.
+   * Deve ser chamada com motionMux travado.
+   */
+  void beginRamp()
+  {
+    float stopMs = 0.0f;
+    for (int i = 0; i < NUM_SERVOS; i++)
+    {
+      const float accel = JOINT_MAX_ACCEL[i] / 1000000.0f; // graus/ms²
+      const float t = fabsf(currentVelocity[i]) / accel;
+      if (t > stopMs)
+        stopMs = t;
+    }
+
+    if (stopMs <= 0.0f)
+    {
+      // Já está em repouso (ex: primeiro tick do segmento)
+      _isMoving = false;
+      return;
+    }
+
+    moveStartTime = lastEvalTime;
+    moveDuration = (unsigned long)ceilf(stopMs);
+    for (int i = 0; i < NUM_SERVOS; i++)
+    {
+      startAngles[i] = currentAnglesF[i];
+      startVelocity[i] = currentVelocity[i];
+      endVelocity[i] = 0.0f;
+      targetAngles[i] = constrain(startAngles[i] + startVelocity[i] * (float)moveDuration * 0.5f,
+                                  (float)minAngles[i], (float)maxAngles[i]);
+    }
+    rampSegment = true;
+    splineExit = false;
+    linearSegment = false; // A rampa é em espaço de juntas (desvio da reta de poucos décimos de mm)
+    segmentSerial++;
+    blendedSegment = false;
+    stopPlanned = true;
+  }
+
+  /**
+   * @brief Posição da ponta (cinemática direta) em um array XYZ.
+   */
+  bool estimateXYZ(const float angles[NUM_SERVOS], float xyz[3])
+  {
+    return InverseKinematics::estimateXYZ(angles, xyz[0], xyz[1], xyz[2]);
+  }
+
+  float linearDistance(const float a[3], const float b[3])
+  {
+    const float dx = b[0] - a[0];
+    const float dy = b[1] - a[1];
+    const float dz = b[2] - a[2];
+    return sqrtf(dx * dx + dy * dy + dz * dz);
+  }
+
+  /**
+   * @brief Resolve o IK de um ponto pelo kernel sem desvios de solveBatch (sem sinf/acosf por tick).
+   * @return Flags InverseKinematics::BatchStatus do ponto.
+   */
+  uint8_t solvePoint(const float point[3], float out[NUM_SERVOS])
+  {
+    float *joints[NUM_SERVOS];
+    for (int i = 0; i < NUM_SERVOS; i++)
+      joints[i] = &out[i];
+    uint8_t status;
+    InverseKinematics::solveBatch(&point[0], &point[1], &point[2], 1, joints, &status);
+    return status;
+  }
+
+  /**
+   * @brief Ponto da reta e ângulo da garra no segmento linear ativo após 'elapsed' ms.
+   * Só lê o segmento (motionMux travado); o IK do ponto é resolvido depois, fora do lock.
+   */
+  void sampleLinear(unsigned long elapsed, float point[3], float &gripper)
+  {
+    const float s = MotionProfile::evaluate(moveProfile, (float)elapsed);
+    for (int k = 0; k < 3; k++)
+      point[k] = linearFrom[k] + (linearTo[k] - linearFrom[k]) * s;
+    const int g = ActiveArm::GRIPPER;
+    gripper = startAngles[g] + (targetAngles[g] - startAngles[g]) * s; // Garra mantida
+  }
+
+  /**
+   * @brief Avalia a posição de todas as juntas no segmento ativo após 'elapsed' ms.
+   * O perfil (ou a base de Hermite) é calculado uma única vez por tick. Segmentos lineares
+   * não passam por aqui (ver sampleLinear).
+   */
+  void evaluateSegment(unsigned long elapsed, float out[NUM_SERVOS])
+  {
+    if (rampSegment)
+    {
+      // Desaceleração constante: x = x0 + v0·(t - t²/2T)
+      const float t = (float)elapsed;
+      const float travel = t - (t * t) / (2.0f * (float)moveDuration);
+      for (int i = 0; i < NUM_SERVOS; i++)
+      {
+        out[i] = constrain(startAngles[i] + startVelocity[i] * travel, (float)minAngles[i], (float)maxAngles[i]);
+      }
+      return;
+    }
+
+    if (!blendedSegment)
+    {
+      // Perfil sincronizado (EaseInOutQuad, trapezoidal ou curva S): todas as juntas terminam juntas
+#if MOTION_FIXED_POINT
+      const int64_t s = MotionProfile::evaluateQ16(moveProfileQ16, (uint32_t)elapsed);
+      for (int i = 0; i < NUM_SERVOS; i++)
+      {
+        const int32_t deltaQ16 = targetAnglesQ16[i] - startAnglesQ16[i];
+        const int32_t angleQ16 = startAnglesQ16[i] + (int32_t)((deltaQ16 * s) >> 16);
+        out[i] = (float)angleQ16 * (1.0f / MotionProfile::Q16_ONE);
+      }
+#else
+      const float s = MotionProfile::evaluate(moveProfile, (float)elapsed);
+      for (int i = 0; i < NUM_SERVOS; i++)
+      {
+        out[i] = startAngles[i] + (targetAngles[i] - startAngles[i]) * s;
+      }
+#endif
+      return;
+    }
+
+    // Curva cúbica de Hermite: continua a velocidade do segmento anterior e entrega
+    // a velocidade de passagem planejada para o próximo.
+    const float progress = (float)elapsed / (float)moveDuration;
+    const float p2 = progress * progress;
+    const float p3 = p2 * progress;
+    const float h10 = p3 - 2.0f * p2 + progress;
+    const float h01 = -2.0f * p3 + 3.0f * p2;
+    const float h11 = p3 - p2;
+    const float d = (float)moveDuration;
+    for (int i = 0; i < NUM_SERVOS; i++)
+    {
+      const float delta = targetAngles[i] - startAngles[i];
+      const float angle = startAngles[i] + delta * h01 + d * (h10 * startVelocity[i] + h11 * endVelocity[i]);
+      // Um spline C2 pode ultrapassar levemente os pontos; nunca além dos limites de software
+      out[i] = constrain(angle, (float)minAngles[i], (float)maxAngles[i]);
+    }
+  }
+
+  /**
+   * @brief Executa um tick de interpolação e atualiza as estatísticas de temporização.
+   * @param missedTicks Disparos do timer perdidos desde o último tick (somente no modo task).
+   */
+  void runTick(uint32_t missedTicks)
+  {
+    const uint32_t startUs = micros();
+
+    if (hasLastTick)
+    {
+      const uint32_t interval = startUs - lastTickStartUs;
+      const uint32_t jitter = interval > TICK_PERIOD_US ? interval - TICK_PERIOD_US : TICK_PERIOD_US - interval;
+      if (jitter > statMaxJitterUs)
+        statMaxJitterUs = jitter;
+    }
+    lastTickStartUs = startUs;
+    hasLastTick = true;
+
+    {
+      PERF_SCOPE(Perf::MOTION_TICK);
+      interpolate();
+    }
+
+    const uint32_t tickUs = micros() - startUs;
+    statLastTickUs = tickUs;
+    if (tickUs > statMaxTickUs)
+      statMaxTickUs = tickUs;
+    if (tickUs > TICK_PERIOD_US || missedTicks > 0)
+      statOverruns++;
+    statTicks++;
+  }
+
+#if MOTION_USE_TASK
+  /**
+   * @brief Callback do timer de hardware: apenas acorda a task de movimento.
+   */
+  void onMotionTimer(void *arg)
+  {
+    (void)arg;
+    xTaskNotifyGive(motionTaskHandle);
+  }
+
+  /**
+   * @brief Task dedicada que executa a interpolação na taxa fixa MOTION_TICK_HZ.
+   */
+  void motionTask(void *arg)
+  {
+    (void)arg;
+    for (;;)
+    {
+      // Retorna o número de notificações acumuladas; mais de uma indica ticks perdidos.
+      const uint32_t pending = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      runTick(pending > 1 ? pending - 1 : 0);
+    }
+  }
+#endif
+
+  /**
+   * @brief Inicia a fonte de ticks fixos (task + timer) quando MOTION_USE_TASK=1.
+   */
+  void startTicker()
+  {
+#if MOTION_USE_TASK
+    if (motionTaskHandle != NULL)
+      return;
+
+    xTaskCreatePinnedToCore(motionTask, "motion", MOTION_TASK_STACK_SIZE, NULL,
+                            MOTION_TASK_PRIORITY, &motionTaskHandle, MOTION_TASK_CORE);
+
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = &onMotionTimer;
+    timerArgs.name = "motion_tick";
+    if (esp_timer_create(&timerArgs, &motionTimer) != ESP_OK ||
+        esp_timer_start_periodic(motionTimer, TICK_PERIOD_US) != ESP_OK)
+    {
+      Serial.println(F("ERRO: Falha ao iniciar o timer de movimento."));
+    }
+#endif
+  }
+
+  void holdTicker(bool hold)
+  {
+    if (!hold)
+      hasLastTick = false; // O intervalo suspenso não conta como jitter
+#if MOTION_USE_TASK
+    if (motionTimer == NULL)
+      return;
+    if (hold)
+    {
+      esp_timer_stop(motionTimer);
+      vTaskDelay(1); // Deixa a task consumir um disparo que já estava pendente
+    }
+    else
+    {
+      esp_timer_start_periodic(motionTimer, TICK_PERIOD_US);
+    }
+#endif
+    // No modo legado não há o que suspender: os ticks só rodam pelo loop(), ocupado com o chamador
+  }
+
+  void refreshServo(int servoIdx)
+  {
+    // O offset mudou: o pulso pode mudar mesmo com o ângulo lógico parado
+    ServoOutput::writeAngle(servoIdx, currentAnglesF[servoIdx]);
+  }
 
   /**
    * @brief Inicializa os pinos dos servos, define a posição neutra inicial e
@@ -33,20 +487,18 @@ namespace MotionController
    */
   void setup(bool hasCalibration)
   {
-    int safeMin[NUM_SERVOS] = {0, 95, 95, 50, 0, 60, 55};
-    int safeMax[NUM_SERVOS] = {180, 180, 180, 180, 180, 180, 155};
-    int safeNeutral[NUM_SERVOS] = {90, 130, 130, 100, 70, 120, 100};
-
     for (int i = 0; i < NUM_SERVOS; i++)
     {
-      servos[i].attach(servoPins[i]);
+      ServoOutput::attach(i);
 
       if (!hasCalibration)
       {
-        minAngles[i] = safeMin[i];
-        maxAngles[i] = safeMax[i];
+        // Limites seguros e repouso do modelo ativo (ArmModel.h)
+        const JointSpec joint = ActiveArm::joint(i);
+        minAngles[i] = joint.safeMin;
+        maxAngles[i] = joint.safeMax;
         offsets[i] = 0;
-        currentAngles[i] = safeNeutral[i];
+        currentAngles[i] = joint.home;
       }
       else
       {
@@ -55,10 +507,18 @@ namespace MotionController
         currentAngles[i] = constrain(currentAngles[i], minAngles[i], maxAngles[i]);
       }
 
-      const int corrected = constrain(currentAngles[i] + offsets[i], 0, 180);
-      servos[i].write(corrected);
+      currentAnglesF[i] = (float)currentAngles[i];
+      ServoOutput::writeAngle(i, currentAnglesF[i]);
       delay(30);
     }
+    Workspace::rebuild();
+    publishLimits();
+
+    portENTER_CRITICAL(&motionMux);
+    publishSnapshot();
+    portEXIT_CRITICAL(&motionMux);
+
+    startTicker();
   }
 
   /**
@@ -66,120 +526,791 @@ namespace MotionController
    */
   bool isMoving()
   {
-    return _isMoving;
+    return _isMoving || queueCount > 0 || hasInterrupted;
+  }
+
+  void stop()
+  {
+    portENTER_CRITICAL(&motionMux);
+    queueCount = 0;
+    hasInterrupted = false;
+    paused = false;
+    if (_isMoving && !rampSegment)
+      beginRamp();
+    portEXIT_CRITICAL(&motionMux);
+  }
+
+  bool pause()
+  {
+    portENTER_CRITICAL(&motionMux);
+    if (paused)
+    {
+      portEXIT_CRITICAL(&motionMux);
+      return false;
+    }
+    paused = true;
+    if (_isMoving && !rampSegment)
+    {
+      // Guarda o alvo e o tempo restante do segmento para resume()
+      const unsigned long activeEnd = moveStartTime + moveDuration;
+      for (int i = 0; i < NUM_SERVOS; i++)
+      {
+        interruptedSegment.target[i] = targetAngles[i];
+        interruptedSegment.exitVelocity[i] = 0.0f;
+      }
+      interruptedSegment.spline = false;
+      interruptedSegment.linear = linearSegment;
+      for (int k = 0; k < 3; k++)
+      {
+        interruptedSegment.toXYZ[k] = linearTo[k];
+        interruptedSegment.limits[k] = linearLimits[k];
+      }
+      interruptedSegment.duration = (long)(activeEnd - lastEvalTime) > 0 ? activeEnd - lastEvalTime : 0;
+      hasInterrupted = true;
+      beginRamp();
+    }
+    portEXIT_CRITICAL(&motionMux);
+    return true;
+  }
+
+  bool resume()
+  {
+    portENTER_CRITICAL(&motionMux);
+    if (!paused)
+    {
+      portEXIT_CRITICAL(&motionMux);
+      return false;
+    }
+    if (hasInterrupted)
+    {
+      // O segmento interrompido é retomado a partir do ponto de parada da rampa
+      // (ou da posição atual, se a rampa já terminou), com o tempo que faltava,
+      // respeitando a duração mínima permitida pelos limites das juntas.
+      MotionSegment &seg = interruptedSegment;
+      const unsigned long minTicks = 2000UL / MOTION_TICK_HZ; // 2 ticks
+      if (seg.linear)
+      {
+        // Reta interrompida: segue em reta do ponto de parada até o mesmo fim, com os mesmos limites
+        estimateXYZ(_isMoving ? targetAngles : currentAnglesF, seg.fromXYZ);
+        const float distance = linearDistance(seg.fromXYZ, seg.toXYZ);
+        const unsigned long minimum = (unsigned long)ceilf(MotionProfile::minimumDuration(
+            activeProfile, &distance, &seg.limits[0], &seg.limits[1], &seg.limits[2], 1));
+        seg.duration = max(seg.duration, max(minimum, minTicks));
+        seg.profile = MotionProfile::plan(activeProfile, (float)seg.duration, &distance, &seg.limits[0],
+                                          &seg.limits[1], 1);
+      }
+      else
+      {
+        float deltas[NUM_SERVOS];
+        for (int i = 0; i < NUM_SERVOS; i++)
+          deltas[i] = seg.target[i] - (_isMoving ? targetAngles[i] : currentAnglesF[i]);
+        const unsigned long minimum = (unsigned long)ceilf(MotionProfile::minimumDuration(
+            activeProfile, deltas, JOINT_MAX_VELOCITY, JOINT_MAX_ACCEL, JOINT_MAX_JERK, NUM_SERVOS));
+        seg.duration = max(seg.duration, max(minimum, minTicks));
+        seg.profile = MotionProfile::plan(activeProfile, (float)seg.duration, deltas, JOINT_MAX_VELOCITY,
+                                          JOINT_MAX_ACCEL, NUM_SERVOS);
+      }
+
+      // Volta para a frente da fila (o espaço foi reservado em startSmoothMove)
+      queueHead = (queueHead + MOTION_QUEUE_SIZE - 1) % MOTION_QUEUE_SIZE;
+      segmentQueue[queueHead] = seg;
+      queueCount++;
+      hasInterrupted = false;
+    }
+    paused = false;
+    portEXIT_CRITICAL(&motionMux);
+    return true;
+  }
+
+  bool isPaused()
+  {
+    return paused;
+  }
+
+  void getPlannedTarget(float target[NUM_SERVOS])
+  {
+    portENTER_CRITICAL(&motionMux);
+    for (int i = 0; i < NUM_SERVOS; i++)
+    {
+      if (queueCount > 0)
+        target[i] = segmentQueue[(queueHead + queueCount - 1) % MOTION_QUEUE_SIZE].target[i];
+      else if (hasInterrupted)
+        target[i] = interruptedSegment.target[i];
+      else if (_isMoving)
+        target[i] = targetAngles[i];
+      else
+        target[i] = currentAnglesF[i];
+    }
+    portEXIT_CRITICAL(&motionMux);
+  }
+
+  void getPlannedTarget(int target[NUM_SERVOS])
+  {
+    float precise[NUM_SERVOS];
+    getPlannedTarget(precise);
+    for (int i = 0; i < NUM_SERVOS; i++)
+      target[i] = (int)roundf(precise[i]);
   }
 
   /**
    * @brief Calcula a duração ideal do movimento baseado na velocidade padrão.
    */
-  unsigned long calculateDurationBySpeed(const int target[NUM_SERVOS])
+  unsigned long calculateDurationBySpeed(const float target[NUM_SERVOS])
+  {
+    // O movimento parte do fim do que já está planejado (último segmento da fila)
+    float plannedStart[NUM_SERVOS];
+    getPlannedTarget(plannedStart);
+    return (unsigned long)durationBetween(plannedStart, target);
+  }
+
+  float durationBetween(const float plannedStart[NUM_SERVOS], const float target[NUM_SERVOS])
   {
-    int maxDelta = 0;
+    if (activeProfile != MotionProfile::EASE_QUAD)
+    {
+      float deltas[NUM_SERVOS];
+      for (int i = 0; i < NUM_SERVOS; i++)
+        deltas[i] = target[i] - plannedStart[i];
+      const float minimum = MotionProfile::minimumDuration(activeProfile, deltas, JOINT_MAX_VELOCITY,
+                                                           JOINT_MAX_ACCEL, JOINT_MAX_JERK, NUM_SERVOS);
+      // Alvo igual ao fim planejado: 0 ms seria o salto imediato de startSmoothMove
+      return max(ceilf(minimum), (float)MIN_PROFILE_DURATION);
+    }
+
+    float maxDelta = 0.0f;
     // Encontra o servo que tem o maior trajeto a percorrer
     for (int i = 0; i < NUM_SERVOS; i++)
     {
-      int delta = abs(target[i] - currentAngles[i]);
+      float delta = fabsf(target[i] - plannedStart[i]);
       if (delta > maxDelta)
       {
         maxDelta = delta;
       }
     }
     // Calcula a duração e garante que seja pelo menos o mínimo
-    unsigned long duration = (unsigned long)maxDelta * DEFAULT_SPEED_MS_PER_DEGREE;
-    return max(duration, (unsigned long)MIN_MOVE_DURATION);
+    unsigned long duration = (unsigned long)lroundf(maxDelta * DEFAULT_SPEED_MS_PER_DEGREE);
+    return (float)max(duration, (unsigned long)MIN_MOVE_DURATION);
+  }
+
+  unsigned long calculateDurationBySpeed(const int target[NUM_SERVOS])
+  {
+    float precise[NUM_SERVOS];
+    for (int i = 0; i < NUM_SERVOS; i++)
+      precise[i] = (float)target[i];
+    return calculateDurationBySpeed(precise);
+  }
+
+  void setProfile(MotionProfile::Type type)
+  {
+    activeProfile = type;
+  }
+
+  MotionProfile::Type getProfile()
+  {
+    return activeProfile;
+  }
+
+  bool startSmoothMove(const int newTargetAngles[NUM_SERVOS], unsigned long duration)
+  {
+    float precise[NUM_SERVOS];
+    for (int i = 0; i < NUM_SERVOS; i++)
+      precise[i] = (float)newTargetAngles[i];
+    return startSmoothMove(precise, duration);
   }
 
-  void startSmoothMove(const int newTargetAngles[NUM_SERVOS], unsigned long duration)
+  /**
+   * @brief Validação de servos: verifica se os ângulos estão dentro dos limites permitidos.
+   */
+  bool withinLimits(const float angles[NUM_SERVOS])
   {
-    // Validação de servos: verifica se os ângulos estão dentro dos limites permitidos
     for (int i = 0; i < NUM_SERVOS; i++)
     {
-      if (newTargetAngles[i] < minAngles[i] || newTargetAngles[i] > maxAngles[i])
+      if (angles[i] < minAngles[i] || angles[i] > maxAngles[i])
       {
-        Serial.print(F("ERRO: Servo "));
-        Serial.print(i);
-        Serial.print(F(" fora dos limites ("));
-        Serial.print(minAngles[i]);
-        Serial.print(F("-"));
-        Serial.print(maxAngles[i]);
-        Serial.print(F("). Valor recebido: "));
-        Serial.println(newTargetAngles[i]);
-        return; // Aborta o movimento se qualquer servo estiver fora dos limites
+        CommandBus::Reply error = CommandBus::makeReply(CommandBus::Reply::OUT_OF_LIMITS);
+        error.ints[0] = (uint32_t)i;
+        error.ints[1] = (uint32_t)minAngles[i];
+        error.ints[2] = (uint32_t)maxAngles[i];
+        error.reals[0] = angles[i];
+        CommandBus::reply(error);
+        return false;
       }
     }
+    return true;
+  }
+
+  bool startSmoothMove(const float newTargetAngles[NUM_SERVOS], unsigned long duration)
+  {
+    if (!withinLimits(newTargetAngles))
+      return false; // Aborta o movimento se qualquer servo estiver fora dos limites
+
+    MotionSegment seg;
+    seg.spline = false;
+    seg.linear = false;
+    for (int i = 0; i < NUM_SERVOS; i++)
+    {
+      seg.target[i] = constrain(newTargetAngles[i], (float)minAngles[i], (float)maxAngles[i]);
+      seg.exitVelocity[i] = 0.0f;
+    }
+
+    // Calcula o perfil sincronizado a partir do fim do que já está planejado
+    float plannedStart[NUM_SERVOS];
+    float deltas[NUM_SERVOS];
+    getPlannedTarget(plannedStart);
+    for (int i = 0; i < NUM_SERVOS; i++)
+      deltas[i] = seg.target[i] - plannedStart[i];
 
-    // Se a duração for 0, executa o movimento instantâneo
+    if (duration > 0 && activeProfile != MotionProfile::EASE_QUAD)
+    {
+      const unsigned long minimum = (unsigned long)ceilf(MotionProfile::minimumDuration(
+          activeProfile, deltas, JOINT_MAX_VELOCITY, JOINT_MAX_ACCEL, JOINT_MAX_JERK, NUM_SERVOS));
+      if (duration < minimum)
+      {
+        CommandBus::reply(CommandBus::Reply::DURATION_EXTENDED, minimum);
+        duration = minimum;
+      }
+    }
+    seg.duration = duration;
+    seg.profile = MotionProfile::plan(activeProfile, (float)duration, deltas, JOINT_MAX_VELOCITY,
+                                      JOINT_MAX_ACCEL, NUM_SERVOS);
+
+    portENTER_CRITICAL(&motionMux);
     if (duration == 0)
     {
+      // Movimento instantâneo: descarta o plano atual e salta no próximo tick
+      queueCount = 0;
+      hasInterrupted = false;
+      paused = false;
+      _isMoving = false;
+    }
+    else if (queueCount + (hasInterrupted ? 1 : 0) >= MOTION_QUEUE_SIZE)
+    {
+      portEXIT_CRITICAL(&motionMux);
+      CommandBus::reply(CommandBus::Reply::MOTION_QUEUE_FULL);
+      return false;
+    }
+
+    bool replanned = false;
+    if (_isMoving && stopPlanned && !rampSegment && !linearSegment && !paused && queueCount == 0)
+    {
+      // O segmento chegou depois que o ativo já planejava parar (underrun do host).
+      // Se ainda houver tempo, replaneja o restante do segmento ativo a partir do estado
+      // atual para seguir sem parar; caso contrário o novo segmento parte do repouso.
+      statUnderruns++;
+      const unsigned long activeEnd = moveStartTime + moveDuration;
+      const unsigned long minRemaining = 2000UL / MOTION_TICK_HZ; // 2 ticks
+      if (lastEvalTime >= moveStartTime && (long)(activeEnd - lastEvalTime) >= (long)minRemaining)
+      {
+        moveStartTime = lastEvalTime;
+        moveDuration = activeEnd - lastEvalTime;
+        for (int i = 0; i < NUM_SERVOS; i++)
+        {
+          startAngles[i] = currentAnglesF[i];
+          startVelocity[i] = currentVelocity[i];
+        }
+        replanned = true;
+      }
+    }
+
+    segmentQueue[(queueHead + queueCount) % MOTION_QUEUE_SIZE] = seg;
+    queueCount++;
+    if (replanned)
+      planExit();
+    portEXIT_CRITICAL(&motionMux);
+    return true;
+  }
+
+  bool startSpline(const float waypoints[][NUM_SERVOS], int count)
+  {
+    if (count < 1 || count > MOTION_QUEUE_SIZE)
+    {
+      CommandBus::reply(CommandBus::Reply::SPLINE_SIZE);
+      return false;
+    }
+    for (int k = 0; k < count; k++)
+    {
+      if (!withinLimits(waypoints[k]))
+        return false;
+    }
+    if (count == 1)
+      return startSmoothMove(waypoints[0], calculateDurationBySpeed(waypoints[0]));
+
+    // Nós: fim do que já está planejado + pontos de passagem
+    const int nodes = count + 1;
+    float points[MOTION_QUEUE_SIZE + 1][NUM_SERVOS];
+    float velocities[MOTION_QUEUE_SIZE + 1][NUM_SERVOS];
+    float durations[MOTION_QUEUE_SIZE];
+    float scratch[MOTION_QUEUE_SIZE + 1];
+    getPlannedTarget(points[0]);
+    for (int k = 0; k < count; k++)
+      for (int i = 0; i < NUM_SERVOS; i++)
+        points[k + 1][i] = waypoints[k][i];
+
+    // 1. Duração inicial de cada trecho: a corda percorrida na velocidade máxima da junta mais lenta
+    const float minLegMs = 2000.0f / MOTION_TICK_HZ; // 2 ticks
+    for (int k = 0; k < count; k++)
+    {
+      float legMs = minLegMs;
       for (int i = 0; i < NUM_SERVOS; i++)
       {
-        currentAngles[i] = constrain(newTargetAngles[i], minAngles[i], maxAngles[i]);
-        int correctedAngle = constrain(currentAngles[i] + offsets[i], 0, 180);
-        servos[i].write(correctedAngle);
+        const float t = fabsf(points[k + 1][i] - points[k][i]) * 1000.0f / JOINT_MAX_VELOCITY[i];
+        if (t > legMs)
+          legMs = t;
       }
-      _isMoving = false;
-      return;
+      durations[k] = legMs;
     }
 
-    // Prepara para o movimento suave
-    moveStartTime = millis();
-    moveDuration = duration;
+    // 2. Escala o tempo para que nenhuma junta exceda JOINT_MAX_VELOCITY/JOINT_MAX_ACCEL.
+    // Esticar o tempo por r divide as velocidades por r e as acelerações por r².
     for (int i = 0; i < NUM_SERVOS; i++)
+      Spline::clampedVelocities(&points[0][i], NUM_SERVOS, durations, nodes, &velocities[0][i], scratch);
+    float scale = 0.0f;
+    for (int k = 0; k < count; k++)
     {
-      startAngles[i] = currentAngles[i]; // Inicia da posição interpolada ATUAL
-      targetAngles[i] = constrain(newTargetAngles[i], minAngles[i], maxAngles[i]);
+      for (int i = 0; i < NUM_SERVOS; i++)
+      {
+        const float delta = points[k + 1][i] - points[k][i];
+        const float vel = Spline::peakVelocity(delta, durations[k], velocities[k][i], velocities[k + 1][i]);
+        const float acc = Spline::peakAcceleration(delta, durations[k], velocities[k][i], velocities[k + 1][i]);
+        const float byVel = vel * 1000.0f / JOINT_MAX_VELOCITY[i];
+        const float byAcc = sqrtf(acc * 1000000.0f / JOINT_MAX_ACCEL[i]);
+        if (byVel > scale)
+          scale = byVel;
+        if (byAcc > scale)
+          scale = byAcc;
+      }
     }
-    _isMoving = true;
+    for (int k = 0; k < count; k++)
+    {
+      durations[k] = ceilf(durations[k] * scale);
+      if (durations[k] < minLegMs)
+        durations[k] = minLegMs;
+    }
+    for (int i = 0; i < NUM_SERVOS; i++)
+      Spline::clampedVelocities(&points[0][i], NUM_SERVOS, durations, nodes, &velocities[0][i], scratch);
+
+    // 3. Enfileira cada trecho com a velocidade de saída do nó
+    portENTER_CRITICAL(&motionMux);
+    if (queueCount + (hasInterrupted ? 1 : 0) + count > MOTION_QUEUE_SIZE)
+    {
+      portEXIT_CRITICAL(&motionMux);
+      CommandBus::reply(CommandBus::Reply::SPLINE_NO_ROOM);
+      return false;
+    }
+    for (int k = 0; k < count; k++)
+    {
+      MotionSegment &seg = segmentQueue[(queueHead + queueCount) % MOTION_QUEUE_SIZE];
+      float deltas[NUM_SERVOS];
+      seg.spline = true;
+      seg.linear = false;
+      seg.duration = (unsigned long)durations[k];
+      for (int i = 0; i < NUM_SERVOS; i++)
+      {
+        seg.target[i] = points[k + 1][i];
+        seg.exitVelocity[i] = velocities[k + 1][i];
+        deltas[i] = points[k + 1][i] - points[k][i];
+      }
+      // Usado apenas se o trecho acabar sem velocidade nas pontas (ex: spline de um trecho)
+      seg.profile = MotionProfile::plan(activeProfile, durations[k], deltas, JOINT_MAX_VELOCITY,
+                                        JOINT_MAX_ACCEL, NUM_SERVOS);
+      queueCount++;
+    }
+    portEXIT_CRITICAL(&motionMux);
+    return true;
   }
 
   /**
-   * @brief Atualiza a posição dos servos com base no tempo decorrido.
-   * Deve ser chamado na função loop() principal.
+   * @brief Verifica a reta de 'from' a 'to' em pontos a cada LINEAR_CHECK_STEP_MM (IK em lotes).
+   * Recusa pontos fora do alcance, juntas no limite e saltos de junta entre pontos vizinhos
+   * (singularidade ou troca de ramo do IK), informando onde o trecho falha.
+   * @param first [out] Juntas no início da reta.
+   * @param last [out] Juntas no fim da reta.
+   * @param slopes [out] Maior variação de cada junta por mm de reta (graus/mm).
    */
+  bool checkLinearPath(const float from[3], const float to[3], float first[NUM_SERVOS], float last[NUM_SERVOS],
+                       float slopes[NUM_SERVOS])
+  {
+    const int CHUNK = 16;
+    float xs[CHUNK];
+    float ys[CHUNK];
+    float zs[CHUNK];
+    float solved[NUM_SERVOS][CHUNK];
+    uint8_t status[CHUNK];
+    float *joints[NUM_SERVOS];
+    for (int i = 0; i < NUM_SERVOS; i++)
+      joints[i] = solved[i];
+
+    const float length = linearDistance(from, to);
+    const int steps = max(1, (int)ceilf(length / LINEAR_CHECK_STEP_MM));
+    const float stepMm = length / (float)steps;
+    for (int i = 0; i < NUM_SERVOS; i++)
+      slopes[i] = 0.0f;
+
+    for (int base = 0; base <= steps; base += CHUNK)
+    {
+      const int count = min(CHUNK, steps + 1 - base);
+      for (int k = 0; k < count; k++)
+      {
+        const float t = (float)(base + k) / (float)steps;
+        xs[k] = from[0] + (to[0] - from[0]) * t;
+        ys[k] = from[1] + (to[1] - from[1]) * t;
+        zs[k] = from[2] + (to[2] - from[2]) * t;
+      }
+      InverseKinematics::solveBatch(xs, ys, zs, count, joints, status);
+
+      for (int k = 0; k < count; k++)
+      {
+        const int index = base + k;
+        bool jump = false;
+        for (int i = 0; i < NUM_SERVOS; i++)
+        {
+          if (index > 0)
+          {
+            const float delta = fabsf(solved[i][k] - last[i]);
+            jump = jump || delta > LINEAR_MAX_JOINT_STEP;
+            if (delta / stepMm > slopes[i])
+              slopes[i] = delta / stepMm;
+          }
+          last[i] = solved[i][k];
+          if (index == 0)
+            first[i] = solved[i][k];
+        }
+        if (status[k] == InverseKinematics::IK_OK && !jump)
+          continue;
+
+        // Status IK_OK aqui significa salto de junta (singularidade)
+        CommandBus::Reply error = CommandBus::makeReply(CommandBus::Reply::LINEAR_UNREACHABLE);
+        error.reals[0] = xs[k];
+        error.reals[1] = ys[k];
+        error.reals[2] = zs[k];
+        error.ints[0] = (uint32_t)(index * 100 / steps);
+        error.ints[1] = status[k];
+        CommandBus::reply(error);
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool startLinearMove(const float target[3], float speed)
+  {
+    if (speed <= 0.0f)
+      speed = LINEAR_DEFAULT_SPEED;
+    speed = min(speed, LINEAR_MAX_SPEED);
+
+    // A reta parte da ponta no fim do que já está planejado
+    float startJoints[NUM_SERVOS];
+    getPlannedTarget(startJoints);
+    MotionSegment seg;
+    if (!estimateXYZ(startJoints, seg.fromXYZ))
+    {
+      CommandBus::reply(CommandBus::Reply::LINEAR_BAD_START);
+      return false;
+    }
+    for (int k = 0; k < 3; k++)
+      seg.toXYZ[k] = target[k];
+    const float length = linearDistance(seg.fromXYZ, seg.toXYZ);
+    if (length < 0.5f)
+    {
+      CommandBus::reply(CommandBus::Reply::LINEAR_AT_POINT);
+      return false;
+    }
+
+    // Alvo fora da grade de alcançabilidade: rejeitado sem resolver a reta
+    if (Workspace::classify(target[0], target[1], target[2]) == Workspace::OUTSIDE)
+    {
+      CommandBus::reply(CommandBus::Reply::LINEAR_OUTSIDE);
+      return false;
+    }
+
+    // 1. Toda a reta é verificada antes de mover
+    float first[NUM_SERVOS];
+    float slopes[NUM_SERVOS];
+    if (!checkLinearPath(seg.fromXYZ, seg.toXYZ, first, seg.target, slopes))
+      return false;
+    first[6] = startJoints[6]; // A garra não participa do IK
+    seg.target[6] = startJoints[6];
+    slopes[6] = 0.0f;
+
+    // 2. Limites ao longo da reta: cada junta anda até slopes[i] graus por mm, então a reta
+    // não pode passar de JOINT_MAX_*[i] / slopes[i] (o termo de curvatura é desprezado)
+    seg.limits[0] = speed;
+    seg.limits[1] = LINEAR_MAX_ACCEL;
+    seg.limits[2] = LINEAR_MAX_JERK;
+    for (int i = 0; i < NUM_SERVOS; i++)
+    {
+      if (slopes[i] <= 0.0f)
+        continue;
+      seg.limits[0] = min(seg.limits[0], JOINT_MAX_VELOCITY[i] / slopes[i]);
+      seg.limits[1] = min(seg.limits[1], JOINT_MAX_ACCEL[i] / slopes[i]);
+      seg.limits[2] = min(seg.limits[2], JOINT_MAX_JERK[i] / slopes[i]);
+    }
+    if (seg.limits[0] < speed)
+    {
+      CommandBus::Reply warning = CommandBus::makeReply(CommandBus::Reply::LINEAR_SPEED_LIMITED);
+      warning.reals[0] = seg.limits[0];
+      CommandBus::reply(warning);
+    }
+    const unsigned long minTicks = 2000UL / MOTION_TICK_HZ; // 2 ticks
+    seg.duration = max((unsigned long)ceilf(MotionProfile::minimumDuration(
+                           activeProfile, &length, &seg.limits[0], &seg.limits[1], &seg.limits[2], 1)),
+                       minTicks);
+    seg.profile = MotionProfile::plan(activeProfile, (float)seg.duration, &length, &seg.limits[0],
+                                      &seg.limits[1], 1);
+    seg.spline = false;
+    seg.linear = true;
+    for (int i = 0; i < NUM_SERVOS; i++)
+      seg.exitVelocity[i] = 0.0f;
+
+    // 3. Se a pose planejada não é a do IK no início da reta (outro ângulo de punho para o
+    // mesmo ponto), alinha antes em espaço de juntas: a ponta sai e volta ao mesmo ponto
+    bool align = false;
+    for (int i = 0; i < NUM_SERVOS; i++)
+      align = align || fabsf(first[i] - startJoints[i]) > LINEAR_ALIGN_TOLERANCE;
+
+    portENTER_CRITICAL(&motionMux);
+    const int freeSlots = MOTION_QUEUE_SIZE - queueCount - (hasInterrupted ? 1 : 0);
+    portEXIT_CRITICAL(&motionMux);
+    if (freeSlots < (align ? 2 : 1))
+    {
+      CommandBus::reply(CommandBus::Reply::MOTION_QUEUE_FULL);
+      return false;
+    }
+    if (align && !startSmoothMove(first, calculateDurationBySpeed(first)))
+      return false;
+
+    // Parte do repouso: sem replanejamento de underrun (a reta nunca herda velocidade)
+    portENTER_CRITICAL(&motionMux);
+    segmentQueue[(queueHead + queueCount) % MOTION_QUEUE_SIZE] = seg;
+    queueCount++;
+    portEXIT_CRITICAL(&motionMux);
+
+    CommandBus::Reply queued = CommandBus::makeReply(CommandBus::Reply::LINEAR_QUEUED);
+    queued.reals[0] = length;
+    queued.ints[0] = seg.duration;
+    queued.ints[1] = align ? 1 : 0;
+    CommandBus::reply(queued);
+    return true;
+  }
+
   void update()
-  { // <-- DEFINIÇÃO PARA O LINKER
-    if (!_isMoving)
-      return; // Economiza processamento se não estiver movendo
+  {
+#if !MOTION_USE_TASK
+    // Modo legado: o loop() chama update() continuamente, mas o tick respeita a taxa fixa.
+    if (hasLastTick && (uint32_t)(micros() - lastTickStartUs) < TICK_PERIOD_US)
+      return;
+    runTick(0);
+#endif
+  }
 
-    unsigned long elapsedTime = millis() - moveStartTime;
+  /**
+   * @brief Atualiza a posição dos servos com base no tempo decorrido.
+   * Executado a cada tick do motor de movimento: avança o segmento ativo e encadeia
+   * os próximos da fila sem passar por velocidade zero.
+   */
+  void interpolate()
+  {
+    float outAngles[NUM_SERVOS];
 
-    if (elapsedTime >= moveDuration)
+    // Calcula a nova posição sob o lock; as escritas nos servos ficam fora dele.
+    portENTER_CRITICAL(&motionMux);
+    if (!_isMoving && (queueCount == 0 || paused))
     {
-      // Movimento concluído, garante a posição final
+      // Parado: só republica o estado (stop/pause/resume podem ter mudado os flags)
+      publishSnapshot();
+      portEXIT_CRITICAL(&motionMux);
+      return; // Economiza processamento se não estiver movendo (ou se a fila estiver pausada)
+    }
+
+    const unsigned long now = millis();
+
+    if (!_isMoving)
+    {
+      // Parte do repouso. Se a posição inteira foi alterada por outro módulo (ex: Storage),
+      // ela prevalece sobre a posição fracionária.
       for (int i = 0; i < NUM_SERVOS; i++)
       {
-        currentAngles[i] = targetAngles[i]; // Define a posição lógica final
-        int correctedAngle = constrain(currentAngles[i] + offsets[i], 0, 180);
-        servos[i].write(correctedAngle);
+        if ((int)roundf(currentAnglesF[i]) != currentAngles[i])
+          currentAnglesF[i] = (float)currentAngles[i];
+        currentVelocity[i] = 0.0f;
       }
-      _isMoving = false;
-      // Serial.println(F("Movimento concluído.")); // Opcional: Debug
+      lastEvalTime = now;
+      beginNextSegment(now, NULL);
     }
-    else
+
+    float previousPosition[NUM_SERVOS];
+    for (int i = 0; i < NUM_SERVOS; i++)
+      previousPosition[i] = currentAnglesF[i];
+
+    unsigned long elapsedTime = now - moveStartTime;
+
+    while (_isMoving && elapsedTime >= moveDuration)
     {
-      // Interpolação (Easing Quadrático)
-      float progress = (float)elapsedTime / (float)moveDuration;
-      float easeProgress;
+      // Segmento concluído, garante a posição final
+      for (int i = 0; i < NUM_SERVOS; i++)
+      {
+        currentAnglesF[i] = targetAngles[i];
+      }
+      statSegments++;
+
+      if (queueCount > 0 && !paused)
+      {
+        // Encadeia o próximo segmento mantendo a velocidade de passagem
+        float entryVelocity[NUM_SERVOS];
+        for (int i = 0; i < NUM_SERVOS; i++)
+          entryVelocity[i] = endVelocity[i];
+        beginNextSegment(moveStartTime + moveDuration, entryVelocity);
+        elapsedTime = now - moveStartTime;
+      }
+      else
+      {
+        _isMoving = false;
+        // Serial.println(F("Movimento concluído.")); // Opcional: Debug
+      }
+    }
 
-      // Fórmula EaseInOutQuad (suave no início e no fim)
-      if (progress < 0.5f)
+    bool solveLinear = false;
+    float linearPoint[3];
+    float linearGripper = 0.0f;
+    uint32_t serial = 0;
+    if (_isMoving)
+    {
+      if (linearSegment)
       {
-        easeProgress = 2.0f * progress * progress;
+        // Reta cartesiana: o perfil avança a ponta sobre a reta; o IK sai do lock (abaixo)
+        sampleLinear(elapsedTime, linearPoint, linearGripper);
+        serial = segmentSerial;
+        solveLinear = true;
       }
       else
       {
-        easeProgress = 1.0f - pow(-2.0f * progress + 2.0f, 2.0f) / 2.0f;
+        evaluateSegment(elapsedTime, currentAnglesF);
       }
+    }
 
-      // Aplica o ângulo interpolado a cada servo
+    if (solveLinear)
+    {
+      // O IK não roda com as interrupções desligadas. Se um stop/pause trocou o segmento
+      // nesse intervalo, o ponto resolvido é descartado e a posição do tick anterior fica.
+      portEXIT_CRITICAL(&motionMux);
+      float solved[NUM_SERVOS];
+      solvePoint(linearPoint, solved);
+      solved[ActiveArm::GRIPPER] = linearGripper;
+      portENTER_CRITICAL(&motionMux);
+      if (!_isMoving || serial != segmentSerial)
+      {
+        publishSnapshot();
+        portEXIT_CRITICAL(&motionMux);
+        return;
+      }
       for (int i = 0; i < NUM_SERVOS; i++)
+        currentAnglesF[i] = solved[i];
+    }
+
+    const float dt = (float)(now - lastEvalTime);
+    for (int i = 0; i < NUM_SERVOS; i++)
+    {
+      if (_isMoving)
+      {
+        if (dt > 0.0f)
+          currentVelocity[i] = (currentAnglesF[i] - previousPosition[i]) / dt;
+      }
+      else
       {
-        int interpolatedAngle = startAngles[i] + (targetAngles[i] - startAngles[i]) * easeProgress;
-        currentAngles[i] = interpolatedAngle; // Atualiza a posição lógica atual
-        int correctedAngle = constrain(interpolatedAngle + offsets[i], 0, 180);
-        servos[i].write(correctedAngle);
+        currentVelocity[i] = 0.0f;
       }
+
+      currentAngles[i] = (int)roundf(currentAnglesF[i]); // Espelho inteiro da posição lógica (compatibilidade)
+      outAngles[i] = currentAnglesF[i];
     }
+    lastEvalTime = now;
+    publishSnapshot();
+    portEXIT_CRITICAL(&motionMux);
+
+    // Apenas os canais cujo pulso mudou são escritos no periférico
+    for (int i = 0; i < NUM_SERVOS; i++)
+    {
+      ServoOutput::writeAngle(i, outAngles[i]);
+    }
+  }
+
+  void getTickStats(TickStats &stats)
+  {
+    stats.ticks = statTicks;
+    stats.overruns = statOverruns;
+    stats.maxJitterUs = statMaxJitterUs;
+    stats.maxTickUs = statMaxTickUs;
+    stats.lastTickUs = statLastTickUs;
+  }
+
+  void resetTickStats()
+  {
+    statTicks = 0;
+    statOverruns = 0;
+    statMaxJitterUs = 0;
+    statMaxTickUs = 0;
+    statLastTickUs = 0;
+    hasLastTick = false;
+  }
+
+  void getQueueStats(QueueStats &stats)
+  {
+    portENTER_CRITICAL(&motionMux);
+    stats.depth = queueCount;
+    portEXIT_CRITICAL(&motionMux);
+    stats.capacity = MOTION_QUEUE_SIZE;
+    stats.segments = statSegments;
+    stats.blends = statBlends;
+    stats.underruns = statUnderruns;
+  }
+
+  void printStats()
+  {
+    TickStats stats;
+    getTickStats(stats);
+    QueueStats queue;
+    getQueueStats(queue);
+
+    Serial.println(F("\n--- Motor de Movimento ---"));
+#if MOTION_USE_TASK
+    Serial.print(F("Modo: task dedicada (core "));
+    Serial.print(MOTION_TASK_CORE);
+    Serial.print(F(", prio "));
+    Serial.print(MOTION_TASK_PRIORITY);
+    Serial.print(F(")"));
+#else
+    Serial.print(F("Modo: loop()"));
+#endif
+    Serial.print(F(" | Taxa: "));
+    Serial.print(MOTION_TICK_HZ);
+    Serial.print(F(" Hz ("));
+    Serial.print(TICK_PERIOD_US);
+    Serial.println(F(" us)"));
+    Serial.print(F("Ticks: "));
+    Serial.print(stats.ticks);
+    Serial.print(F(" | Overruns: "));
+    Serial.print(stats.overruns);
+    Serial.print(F(" | Jitter max: "));
+    Serial.print(stats.maxJitterUs);
+    Serial.print(F(" us | Tick max: "));
+    Serial.print(stats.maxTickUs);
+    Serial.print(F(" us | Ultimo tick: "));
+    Serial.print(stats.lastTickUs);
+    Serial.println(F(" us"));
+    Serial.print(F("Fila: "));
+    Serial.print(queue.depth);
+    Serial.print(F("/"));
+    Serial.print(queue.capacity);
+    Serial.print(F(" | Segmentos: "));
+    Serial.print(queue.segments);
+    Serial.print(F(" | Mesclados: "));
+    Serial.print(queue.blends);
+    Serial.print(F(" | Underruns: "));
+    Serial.println(queue.underruns);
+    Serial.print(F("Perfil: "));
+    Serial.print(MotionProfile::name(activeProfile));
+    if (paused)
+      Serial.print(F(" | PAUSADO"));
+    Serial.println();
   }
 
 } // namespace MotionController
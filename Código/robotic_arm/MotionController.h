@@ -7,42 +7,236 @@
 #define MOTION_CONTROLLER_H
 
 #include "Config.h"
+#include "MotionProfile.h"
 
 namespace MotionController
 {
 
     /**
-     * @brief Inicializa os pinos dos servos, define a posição neutra inicial e
-     * configura os limites seguros.
+     * @brief Inicializa os pinos dos servos, define a posição neutra inicial,
+     * configura os limites seguros e inicia o tick fixo de movimento.
      */
     void setup(bool hasCalibration);
 
     /**
-     * @brief Inicia um movimento suave (interpolado) para a posição alvo.
-     * @param target Array com os ângulos alvo lógicos (0-180°).
+     * @brief Enfileira um movimento suave (interpolado) para a posição alvo.
+     * Segmentos enfileirados são encadeados sem parar nos pontos intermediários.
+     * Duração 0 descarta a fila e move instantaneamente no próximo tick. Nos perfis
+     * trapezoidal e curva S, durações menores que a permitida pelos limites das juntas são estendidas.
+     * @param target Array com os ângulos alvo lógicos (0-180°, aceita fração de grau).
      * @param duration Duração total do movimento em milissegundos.
+     * @return true se o segmento foi aceito, false se fora dos limites ou com a fila cheia.
      */
-    void startSmoothMove(const int target[NUM_SERVOS], unsigned long duration);
+    bool startSmoothMove(const float target[NUM_SERVOS], unsigned long duration);
 
     /**
-     * @brief Atualiza a posição dos servos com base no tempo decorrido para um movimento suave.
-     * Deve ser chamado repetidamente na função loop().
+     * @brief Versão com ângulos inteiros (compatibilidade com poses e macros).
+     */
+    bool startSmoothMove(const int target[NUM_SERVOS], unsigned long duration);
+
+    /**
+     * @brief Enfileira uma trajetória spline cúbica C2 passando por vários pontos, sem parar
+     * nos pontos intermediários. Parte do fim do que já está planejado e termina em repouso
+     * no último ponto. As durações dos trechos são escolhidas para respeitar JOINT_MAX_VELOCITY
+     * e JOINT_MAX_ACCEL em todas as juntas.
+     * @param waypoints Pontos de passagem (ângulos lógicos), em ordem.
+     * @param count Número de pontos (1 a MOTION_QUEUE_SIZE, limitado pelo espaço livre da fila).
+     * @return true se todos os trechos foram enfileirados.
+     */
+    bool startSpline(const float waypoints[][NUM_SERVOS], int count);
+
+    /**
+     * @brief Enfileira um movimento linear da ponta: parte da ponta no fim do que já está
+     * planejado e percorre a reta até 'target' em XYZ, resolvendo o IK a cada tick.
+     * A reta inteira é verificada antes (alcance, limites das juntas e saltos de junta); a
+     * velocidade é reduzida se alguma junta exceder JOINT_MAX_*. Parte e termina em repouso.
+     * A garra mantém o ângulo atual.
+     * @param target Ponto final em mm.
+     * @param speed Velocidade de cruzeiro em mm/s (0 = LINEAR_DEFAULT_SPEED; limitada a LINEAR_MAX_SPEED).
+     * @return true se a reta (e o alinhamento do punho, se necessário) foi enfileirada.
+     */
+    bool startLinearMove(const float target[3], float speed);
+
+    /**
+     * @brief Retorna a posição ao final de tudo que já está planejado
+     * (último segmento da fila, alvo do segmento ativo ou a posição atual).
+     * @param target [out] Ângulos lógicos planejados.
+     */
+    void getPlannedTarget(float target[NUM_SERVOS]);
+
+    /**
+     * @brief Versão arredondada para graus inteiros.
+     */
+    void getPlannedTarget(int target[NUM_SERVOS]);
+
+    /**
+     * @brief Reescreve o pulso de um servo a partir da posição atual (ex: após mudar o offset).
+     */
+    void refreshServo(int servoIdx);
+
+    /**
+     * @brief Estado publicado pelo motor de movimento a cada tick.
+     * Lido pelo core de comunicação (ROS, 'status', 'pose save') sem lock.
+     */
+    struct Snapshot
+    {
+        float angles[NUM_SERVOS]; /**< Posição lógica interpolada (graus, com fração). */
+        bool moving;              /**< Movimento em progresso, enfileirado ou pausado a meio caminho. */
+        bool paused;              /**< Fila pausada por pause(). */
+        uint8_t queueDepth;       /**< Segmentos aguardando na fila. */
+    };
+
+    /**
+     * @brief Copia o último estado publicado (seqlock: nunca bloqueia o tick de movimento).
+     */
+    void getSnapshot(Snapshot &snapshot);
+
+    /**
+     * @brief Calibração em uso (minAngles, maxAngles, offsets), publicada pelo core de movimento.
+     * O core de comunicação ('save', 'status') lê esta cópia, nunca os arrays globais.
+     */
+    struct Limits
+    {
+        int minAngles[NUM_SERVOS];
+        int maxAngles[NUM_SERVOS];
+        int offsets[NUM_SERVOS];
+    };
+
+    /**
+     * @brief Publica minAngles/maxAngles/offsets (somente o core de movimento, depois de alterá-los).
+     */
+    void publishLimits();
+
+    /**
+     * @brief Copia a última calibração publicada (seqlock).
+     */
+    void getLimits(Limits &limits);
+
+    /**
+     * @brief Ponto de chamada do motor de movimento no loop() principal.
+     * Com MOTION_USE_TASK=1 não faz nada (a task dedicada executa os ticks).
+     * Com MOTION_USE_TASK=0 executa um tick sempre que o período de MOTION_TICK_HZ tiver passado.
      */
     void update(); // <-- NOME PADRONIZADO: Agora corresponde à chamada em robotic_arm.ino
 
     /**
-     * @brief Verifica se um movimento suave está em progresso.
+     * @brief Executa um tick de interpolação imediatamente, fora da taxa fixa (usado pelo benchmark).
+     * O chamador deve segurar o ticker (holdTicker) para não concorrer com a task de movimento.
+     */
+    void interpolate();
+
+    /**
+     * @brief Suspende (true) ou retoma (false) os ticks periódicos da task de movimento.
+     * Ao retomar, o intervalo suspenso não é contado como jitter.
+     */
+    void holdTicker(bool hold);
+
+    /**
+     * @brief Estatísticas de temporização dos ticks de movimento.
+     */
+    struct TickStats
+    {
+        uint32_t ticks;       /**< Número de ticks executados. */
+        uint32_t overruns;    /**< Ticks que excederam o período ou perderam disparos do timer. */
+        uint32_t maxJitterUs; /**< Maior desvio do intervalo entre ticks em relação ao período nominal. */
+        uint32_t maxTickUs;   /**< Pior tempo de execução de um tick. */
+        uint32_t lastTickUs;  /**< Tempo de execução do último tick. */
+    };
+
+    /**
+     * @brief Copia as estatísticas atuais do motor de movimento.
+     */
+    void getTickStats(TickStats &stats);
+
+    /**
+     * @brief Zera os contadores de jitter, overruns e pior tempo de tick.
+     */
+    void resetTickStats();
+
+    /**
+     * @brief Estatísticas da fila de segmentos.
+     */
+    struct QueueStats
+    {
+        uint8_t depth;      /**< Segmentos aguardando na fila. */
+        uint8_t capacity;   /**< Capacidade da fila (MOTION_QUEUE_SIZE). */
+        uint32_t segments;  /**< Segmentos concluídos. */
+        uint32_t blends;    /**< Segmentos iniciados sem parar no ponto anterior. */
+        uint32_t underruns; /**< Segmentos recebidos quando o ativo já planejava parar. */
+    };
+
+    /**
+     * @brief Copia as estatísticas atuais da fila de segmentos.
+     */
+    void getQueueStats(QueueStats &stats);
+
+    /**
+     * @brief Exibe as estatísticas do motor de movimento e da fila na Serial (usado pelo comando 'status').
+     */
+    void printStats();
+
+    /**
+     * @brief Verifica se um movimento suave está em progresso, enfileirado ou pausado a meio caminho.
      * @return true se estiver movendo, false caso contrário.
      */
     bool isMoving();
 
     /**
-     * @brief Calcula a duração do movimento necessária para manter a velocidade padrão.
+     * @brief Parada controlada: descarta a fila e leva todas as juntas ao repouso por uma
+     * rampa de desaceleração a partir da velocidade atual, limitada por JOINT_MAX_ACCEL.
+     */
+    void stop();
+
+    /**
+     * @brief Pausa o movimento com a mesma rampa de stop(), mas mantém a fila e guarda
+     * o segmento interrompido. Novos segmentos continuam sendo aceitos (e aguardam).
+     * @return false se já estava pausado.
+     */
+    bool pause();
+
+    /**
+     * @brief Retoma após pause(): o segmento interrompido continua do ponto de parada até
+     * o mesmo alvo (com o tempo que faltava, ou a duração mínima permitida), seguido da fila.
+     * @return false se não estava pausado.
+     */
+    bool resume();
+
+    /**
+     * @brief Retorna se o movimento está pausado.
+     */
+    bool isPaused();
+
+    /**
+     * @brief Calcula a duração do movimento partindo do fim do movimento já planejado.
+     * Nos perfis trapezoidal e curva S é a menor duração que respeita os limites de
+     * velocidade, aceleração e jerk de todas as juntas (JOINT_MAX_*); no perfil legado
+     * EaseInOutQuad usa DEFAULT_SPEED_MS_PER_DEGREE.
      * @param target Array com os ângulos alvo lógicos.
      * @return Duração mínima do movimento em milissegundos.
      */
+    unsigned long calculateDurationBySpeed(const float target[NUM_SERVOS]);
+
+    /**
+     * @brief Versão com ângulos inteiros.
+     */
     unsigned long calculateDurationBySpeed(const int target[NUM_SERVOS]);
 
+    /**
+     * @brief Mesmo modelo de calculateDurationBySpeed entre duas poses quaisquer (ms).
+     * Serve de custo para InverseKinematics::solveBranches (somente o core de movimento).
+     */
+    float durationBetween(const float plannedStart[NUM_SERVOS], const float target[NUM_SERVOS]);
+
+    /**
+     * @brief Define o perfil de velocidade usado pelos próximos segmentos.
+     */
+    void setProfile(MotionProfile::Type type);
+
+    /**
+     * @brief Retorna o perfil de velocidade ativo.
+     */
+    MotionProfile::Type getProfile();
+
 } // namespace MotionController
 
 #endif // MOTION_CONTROLLER_H
@@ -0,0 +1,312 @@
+/**
+ * @file MotionProfile.cpp
+ * @brief Implementação dos perfis trapezoidal, curva S (jerk mínimo) e EaseInOutQuad.
+ *
+ * Os limites de cada junta são convertidos para limites do progresso comum s(t):
+ *   V = max(|delta_i| / vmax_i)  [s]     -> s'   <= 1/V
+ *   A = max(|delta_i| / amax_i)  [s²]    -> s''  <= 1/A
+ *   J = max(|delta_i| / jmax_i)  [s³]    -> s''' <= 1/J
+ * e a duração mínima é a do perfil normalizado que respeita esses três limites.
+ */
+#include "MotionProfile.h"
+
+#include <math.h>
+
+namespace
+{
+    // Fração da duração usada para acelerar quando o trapézio tem folga (duração > mínima)
+    constexpr float TRAPEZOID_ACCEL_FRACTION = 0.25f;
+
+    // Picos do polinômio de jerk mínimo s = 10t³ - 15t⁴ + 6t⁵ (com T = 1)
+    constexpr float MIN_JERK_PEAK_VEL = 1.875f;
+    constexpr float MIN_JERK_PEAK_ACCEL = 5.7735027f; // 10 / sqrt(3)
+    constexpr float MIN_JERK_PEAK_JERK = 60.0f;
+
+    // Picos do EaseInOutQuad (com T = 1)
+    constexpr float EASE_PEAK_VEL = 2.0f;
+    constexpr float EASE_PEAK_ACCEL = 4.0f;
+
+    // --- Tabelas de Easing Geradas em Tempo de Compilação (C++11) ---
+    // Cada entrada i vale s(i / 256) em Q16, calculada com aritmética inteira exata.
+
+    template <int... I>
+    struct IndexList
+    {
+    };
+
+    template <int N, int... I>
+    struct MakeIndexList : MakeIndexList<N - 1, N - 1, I...>
+    {
+    };
+
+    template <int... I>
+    struct MakeIndexList<0, I...>
+    {
+        typedef IndexList<I...> type;
+    };
+
+    struct EaseLut
+    {
+        int32_t v[MotionProfile::EASE_LUT_SEGMENTS + 1];
+    };
+
+    // EaseInOutQuad: 2x² e 1 - 2(1-x)²; com N = 256, 65536 / N² = 1
+    constexpr int32_t easeQuadEntry(int i)
+    {
+        return i < MotionProfile::EASE_LUT_SEGMENTS / 2
+                   ? 2 * i * i
+                   : MotionProfile::Q16_ONE - 2 * (MotionProfile::EASE_LUT_SEGMENTS - i) * (MotionProfile::EASE_LUT_SEGMENTS - i);
+    }
+
+    // Jerk mínimo: (10·i³·N² - 15·i⁴·N + 6·i⁵) · 65536 / N⁵, com N = 256 (divisão por 2^24 com arredondamento)
+    constexpr int32_t minJerkEntry(int i)
+    {
+        return (int32_t)(((10LL * i * i * i * 65536LL) - (15LL * i * i * i * i * 256LL) +
+                          (6LL * i * i * i * i * i) + (1LL << 23)) >>
+                         24);
+    }
+
+    template <int... I>
+    constexpr EaseLut makeEaseQuadLut(IndexList<I...>)
+    {
+        return EaseLut{{easeQuadEntry(I)...}};
+    }
+
+    template <int... I>
+    constexpr EaseLut makeMinJerkLut(IndexList<I...>)
+    {
+        return EaseLut{{minJerkEntry(I)...}};
+    }
+
+    typedef MakeIndexList<MotionProfile::EASE_LUT_SEGMENTS + 1>::type LutIndices;
+
+    constexpr EaseLut EASE_QUAD_LUT = makeEaseQuadLut(LutIndices());
+    constexpr EaseLut MIN_JERK_LUT = makeMinJerkLut(LutIndices());
+
+    static_assert(EASE_QUAD_LUT.v[0] == 0 && EASE_QUAD_LUT.v[MotionProfile::EASE_LUT_SEGMENTS] == MotionProfile::Q16_ONE,
+                  "Tabela EaseInOutQuad deve ir de 0 a 1.0");
+    static_assert(MIN_JERK_LUT.v[0] == 0 && MIN_JERK_LUT.v[MotionProfile::EASE_LUT_SEGMENTS] == MotionProfile::Q16_ONE,
+                  "Tabela de jerk mínimo deve ir de 0 a 1.0");
+
+    /**
+     * @brief Interpola linearmente uma tabela de easing para um progresso em Q16.
+     */
+    inline int32_t lookup(const EaseLut &lut, uint32_t progressQ16)
+    {
+        const uint32_t idx = progressQ16 >> 8; // 65536 / 256 = 256 passos por intervalo
+        const int32_t frac = (int32_t)(progressQ16 & 0xFF);
+        const int32_t a = lut.v[idx];
+        const int32_t b = lut.v[idx + 1];
+        return a + ((((b - a) * frac) + 128) >> 8);
+    }
+
+    /**
+     * @brief Maior razão |delta| / limite entre as juntas (limites <= 0 são ignorados).
+     */
+    float worstRatio(const float *deltas, const float *limits, int count)
+    {
+        float worst = 0.0f;
+        if (limits == nullptr)
+            return worst;
+        for (int i = 0; i < count; i++)
+        {
+            if (limits[i] <= 0.0f)
+                continue;
+            const float ratio = fabsf(deltas[i]) / limits[i];
+            if (ratio > worst)
+                worst = ratio;
+        }
+        return worst;
+    }
+}
+
+namespace MotionProfile
+{
+    float minimumDuration(Type type, const float *deltas, const float *maxVel, const float *maxAccel,
+                          const float *maxJerk, int count)
+    {
+        const float V = worstRatio(deltas, maxVel, count);
+        const float A = worstRatio(deltas, maxAccel, count);
+        float seconds = 0.0f;
+
+        switch (type)
+        {
+        case TRAPEZOID:
+        {
+            // T = u + A/u, com u = tempo de cruzeiro + aceleração; mínimo em u = sqrt(A)
+            const float sqrtA = sqrtf(A);
+            const float u = V > sqrtA ? V : sqrtA;
+            seconds = u > 0.0f ? u + (A / u) : 0.0f;
+            break;
+        }
+        case MIN_JERK:
+        {
+            const float J = worstRatio(deltas, maxJerk, count);
+            seconds = MIN_JERK_PEAK_VEL * V;
+            const float byAccel = sqrtf(MIN_JERK_PEAK_ACCEL * A);
+            const float byJerk = cbrtf(MIN_JERK_PEAK_JERK * J);
+            if (byAccel > seconds)
+                seconds = byAccel;
+            if (byJerk > seconds)
+                seconds = byJerk;
+            break;
+        }
+        case EASE_QUAD:
+        default:
+        {
+            seconds = EASE_PEAK_VEL * V;
+            const float byAccel = sqrtf(EASE_PEAK_ACCEL * A);
+            if (byAccel > seconds)
+                seconds = byAccel;
+            break;
+        }
+        }
+        return seconds * 1000.0f;
+    }
+
+    Plan plan(Type type, float durationMs, const float *deltas, const float *maxVel, const float *maxAccel,
+              int count)
+    {
+        Plan p;
+        p.type = type;
+        p.durationMs = durationMs;
+        p.accelMs = 0.0f;
+
+        if (type != TRAPEZOID || durationMs <= 0.0f)
+            return p;
+
+        // Intervalo viável do tempo de aceleração ta (em s):
+        //   ta * (T - ta) >= A   (aceleração)   e   T - ta >= V   (velocidade)
+        const float T = durationMs / 1000.0f;
+        const float V = worstRatio(deltas, maxVel, count);
+        const float A = worstRatio(deltas, maxAccel, count);
+        const float disc = (T * T) - (4.0f * A);
+        const float taLow = (T - sqrtf(disc > 0.0f ? disc : 0.0f)) / 2.0f;
+        float taHigh = T - V;
+        if (taHigh > T / 2.0f)
+            taHigh = T / 2.0f;
+
+        float ta = T * TRAPEZOID_ACCEL_FRACTION;
+        if (ta < taLow)
+            ta = taLow;
+        if (ta > taHigh)
+            ta = taHigh > taLow ? taHigh : taLow;
+        p.accelMs = ta * 1000.0f;
+        return p;
+    }
+
+    float evaluate(const Plan &p, float elapsedMs)
+    {
+        if (p.durationMs <= 0.0f || elapsedMs >= p.durationMs)
+            return 1.0f;
+        if (elapsedMs <= 0.0f)
+            return 0.0f;
+
+        const float progress = elapsedMs / p.durationMs;
+
+        switch (p.type)
+        {
+        case TRAPEZOID:
+        {
+            const float ta = p.accelMs;
+            if (ta <= 0.0f)
+                return progress;
+            const float peak = 1.0f / (p.durationMs - ta); // velocidade de cruzeiro normalizada (1/ms)
+            if (elapsedMs < ta)
+                return 0.5f * peak * elapsedMs * elapsedMs / ta;
+            const float remaining = p.durationMs - elapsedMs;
+            if (remaining < ta)
+                return 1.0f - (0.5f * peak * remaining * remaining / ta);
+            return (0.5f * peak * ta) + (peak * (elapsedMs - ta));
+        }
+        case MIN_JERK:
+        {
+            const float p3 = progress * progress * progress;
+            return p3 * (10.0f + progress * (-15.0f + 6.0f * progress));
+        }
+        case EASE_QUAD:
+        default:
+        {
+            // Fórmula EaseInOutQuad (suave no início e no fim)
+            if (progress < 0.5f)
+                return 2.0f * progress * progress;
+            const float inv = -2.0f * progress + 2.0f;
+            return 1.0f - (inv * inv) / 2.0f;
+        }
+        }
+    }
+
+    PlanQ16 toQ16(const Plan &p)
+    {
+        PlanQ16 q;
+        q.type = p.type;
+        q.durationMs = p.durationMs > 0.0f ? (uint32_t)(p.durationMs + 0.5f) : 0;
+        q.accelQ16 = 0;
+        q.accelGainQ16 = 0;
+        q.peakQ16 = Q16_ONE;
+
+        if (p.type == TRAPEZOID && p.durationMs > 0.0f && p.accelMs > 0.0f)
+        {
+            float alpha = p.accelMs / p.durationMs;
+            if (alpha < 1.0f / 256.0f)
+                alpha = 1.0f / 256.0f; // Limita o ganho para caber no cálculo em 64 bits
+            if (alpha > 0.5f)
+                alpha = 0.5f;
+            q.accelQ16 = (int32_t)(alpha * Q16_ONE + 0.5f);
+            q.accelGainQ16 = (uint32_t)(65536.0f / (2.0f * alpha * (1.0f - alpha)) + 0.5f);
+            q.peakQ16 = (uint32_t)(Q16_ONE / (1.0f - alpha) + 0.5f);
+        }
+        return q;
+    }
+
+    int32_t evaluateQ16(const PlanQ16 &p, uint32_t elapsedMs)
+    {
+        if (p.durationMs == 0 || elapsedMs >= p.durationMs)
+            return Q16_ONE;
+
+        // Progresso linear em Q16 (uma divisão inteira por tick, arredondada)
+        const uint32_t progress = (uint32_t)((((uint64_t)elapsedMs << 16) + (p.durationMs >> 1)) / p.durationMs);
+
+        switch (p.type)
+        {
+        case TRAPEZOID:
+        {
+            if (p.accelQ16 == 0)
+                return (int32_t)progress;
+            const uint32_t alpha = (uint32_t)p.accelQ16;
+            if (progress < alpha)
+            {
+                // s = x² / (2·alpha·(1-alpha))
+                return (int32_t)(((uint64_t)progress * progress * p.accelGainQ16) >> 32);
+            }
+            const uint32_t remaining = Q16_ONE - progress;
+            if (remaining < alpha)
+            {
+                return Q16_ONE - (int32_t)(((uint64_t)remaining * remaining * p.accelGainQ16) >> 32);
+            }
+            // s = (x - alpha/2) / (1 - alpha)
+            return (int32_t)(((uint64_t)(progress - (alpha >> 1)) * p.peakQ16) >> 16);
+        }
+        case MIN_JERK:
+            return lookup(MIN_JERK_LUT, progress);
+        case EASE_QUAD:
+        default:
+            return lookup(EASE_QUAD_LUT, progress);
+        }
+    }
+
+    const char *name(Type type)
+    {
+        switch (type)
+        {
+        case TRAPEZOID:
+            return "trap";
+        case MIN_JERK:
+            return "scurve";
+        case EASE_QUAD:
+        default:
+            return "ease";
+        }
+    }
+
+} // namespace MotionProfile
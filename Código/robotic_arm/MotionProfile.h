@@ -0,0 +1,116 @@
+/**
+ * @file MotionProfile.h
+ * @brief Perfis de movimento repouso-a-repouso sincronizados no tempo.
+ *
+ * Todos os servos de um segmento compartilham o mesmo progresso normalizado s(t) (0 a 1),
+ * então terminam juntos. A duração mínima é a menor que respeita os limites de velocidade,
+ * aceleração e jerk de TODAS as juntas. Módulo puro (sem dependências do Arduino).
+ */
+#ifndef MOTION_PROFILE_H
+#define MOTION_PROFILE_H
+
+#include <stdint.h>
+
+namespace MotionProfile
+{
+
+    /**
+     * @brief Tipos de perfil de velocidade.
+     */
+    enum Type : uint8_t
+    {
+        EASE_QUAD = 0, /**< EaseInOutQuad legado (duração pela velocidade padrão). */
+        TRAPEZOID = 1, /**< Trapezoidal: aceleração constante, cruzeiro, desaceleração. */
+        MIN_JERK = 2   /**< Curva S de jerk mínimo (polinômio de 5º grau). */
+    };
+
+    /**
+     * @brief Parâmetros de um perfil calculado para um segmento.
+     */
+    struct Plan
+    {
+        Type type;        /**< Tipo do perfil. */
+        float durationMs; /**< Duração total do segmento (ms). */
+        float accelMs;    /**< Tempo de aceleração (e de desaceleração) do trapézio (ms). */
+    };
+
+    /**
+     * @brief Calcula a menor duração que respeita os limites de todas as juntas.
+     * @param type Tipo do perfil (EASE_QUAD usa apenas os limites de velocidade e aceleração).
+     * @param deltas Deslocamento de cada junta (graus, sinal ignorado).
+     * @param maxVel Velocidade máxima por junta (graus/s).
+     * @param maxAccel Aceleração máxima por junta (graus/s²).
+     * @param maxJerk Jerk máximo por junta (graus/s³).
+     * @param count Número de juntas.
+     * @return Duração mínima em ms (0 se nenhuma junta se move).
+     */
+    float minimumDuration(Type type, const float *deltas, const float *maxVel, const float *maxAccel,
+                          const float *maxJerk, int count);
+
+    /**
+     * @brief Monta o perfil para uma duração escolhida (>= minimumDuration).
+     * Para o trapézio, escolhe o tempo de aceleração que respeita os limites.
+     * @param type Tipo do perfil.
+     * @param durationMs Duração desejada do segmento (ms).
+     * @param deltas Deslocamento de cada junta (graus).
+     * @param maxVel Velocidade máxima por junta (graus/s).
+     * @param maxAccel Aceleração máxima por junta (graus/s²).
+     * @param count Número de juntas.
+     */
+    Plan plan(Type type, float durationMs, const float *deltas, const float *maxVel, const float *maxAccel,
+              int count);
+
+    /**
+     * @brief Avalia o progresso normalizado s(t) do perfil.
+     * @param p Perfil calculado.
+     * @param elapsedMs Tempo decorrido desde o início do segmento (ms).
+     * @return Progresso de 0.0 a 1.0.
+     */
+    float evaluate(const Plan &p, float elapsedMs);
+
+    // --- Kernel em Ponto Fixo (Q16) ---
+    // Valores Q16: 65536 = 1.0. Usado pelo MotionController quando MOTION_FIXED_POINT=1.
+
+    /** @brief 1.0 em Q16. */
+    constexpr int32_t Q16_ONE = 65536;
+
+    /** @brief Número de intervalos das tabelas de easing (257 entradas, geradas em tempo de compilação). */
+    constexpr int EASE_LUT_SEGMENTS = 256;
+
+    /**
+     * @brief Perfil pré-calculado para o kernel em ponto fixo.
+     * Para o trapézio, guarda os coeficientes no tempo normalizado (sem divisões por tick).
+     */
+    struct PlanQ16
+    {
+        Type type;            /**< Tipo do perfil. */
+        uint32_t durationMs;  /**< Duração total (ms). */
+        int32_t accelQ16;     /**< Fração de aceleração alpha = ta/T (Q16), apenas trapézio. */
+        uint32_t accelGainQ16; /**< 1 / (2·alpha·(1-alpha)) em Q16, apenas trapézio. */
+        uint32_t peakQ16;     /**< Velocidade de cruzeiro normalizada 1/(1-alpha) em Q16, apenas trapézio. */
+    };
+
+    /**
+     * @brief Converte um perfil em ponto flutuante para o formato Q16 (chamado uma vez por segmento).
+     */
+    PlanQ16 toQ16(const Plan &p);
+
+    /**
+     * @brief Avalia o progresso s(t) em Q16 usando apenas aritmética inteira.
+     * EaseInOutQuad e curva S usam tabelas constexpr com interpolação linear.
+     * Erro máximo em relação a evaluate(): 3e-5 (fração do deslocamento), ou seja,
+     * menos de 0.006° em um movimento de 180°.
+     * @param p Perfil em Q16.
+     * @param elapsedMs Tempo decorrido (ms).
+     * @return Progresso em Q16 (0 a Q16_ONE).
+     */
+    int32_t evaluateQ16(const PlanQ16 &p, uint32_t elapsedMs);
+
+    /**
+     * @brief Nome curto do perfil (para a Serial).
+     */
+    const char *name(Type type);
+
+} // namespace MotionProfile
+
+#endif // MOTION_PROFILE_H
@@ -0,0 +1,187 @@
+/**
+ * @file NameIndex.h
+ * @brief Índices em RAM dos slots de poses e macros: chave de 16 bits -> slot (ProbeTable) e,
+ * sobre ela, nome -> slot (NameIndex).
+ *
+ * Tabela de espalhamento com sondagem linear e o dobro de posições da capacidade (potência de 2),
+ * então uma busca compara em média uma ou duas chaves. O NameIndex guarda uma cópia dos nomes para
+ * confirmar o acerto e para as listagens; o PoseManager usa a ProbeTable direto para o id da pose.
+ * São montados no boot (Storage::begin) e mantidos por quem grava os slots. Não têm sincronização
+ * própria: PoseManager e MacroManager os acessam sob o seu portMUX.
+ */
+#ifndef NAME_INDEX_H
+#define NAME_INDEX_H
+
+#include "Config.h"
+
+#include <string.h>
+
+/**
+ * @brief Hash de 16 bits de cada slot -> slot, sem lápides. Quem usa guarda a chave completa e
+ * sabe quais slots estão na tabela (insert e remove não conferem).
+ */
+template <uint16_t CAPACITY>
+class ProbeTable
+{
+    static_assert(CAPACITY > 0 && CAPACITY < 0x8000, "ProbeTable: o dobro da capacidade precisa caber em 16 bits");
+
+public:
+    ProbeTable() { clear(); }
+
+    void clear()
+    {
+        memset(hashes, 0, sizeof(hashes));
+        memset(buckets, 0, sizeof(buckets));
+    }
+
+    /**
+     * @brief Primeiro slot com o hash 'h' para o qual match(slot) é verdadeiro, ou -1.
+     */
+    template <class Match>
+    int find(uint16_t h, Match match) const
+    {
+        for (uint16_t b = h & MASK, probes = 0; probes < BUCKETS; b = (b + 1) & MASK, probes++)
+        {
+            if (buckets[b] == 0)
+                return -1; // Posição vazia: a chave não foi inserida
+            const uint16_t slot = buckets[b] - 1;
+            if (hashes[slot] == h && match(slot))
+                return slot;
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Slot com o hash 'h' (chaves de 16 bits, em que o hash é a própria chave), ou -1.
+     */
+    int find(uint16_t h) const { return find(h, AnySlot()); }
+
+    /**
+     * @brief Põe o slot na tabela com o hash 'h' (o slot não pode estar nela).
+     */
+    void insert(uint16_t slot, uint16_t h)
+    {
+        hashes[slot] = h;
+        uint16_t b = h & MASK;
+        while (buckets[b] != 0)
+            b = (b + 1) & MASK;
+        buckets[b] = slot + 1;
+    }
+
+    /**
+     * @brief Retira o slot da tabela (o slot precisa estar nela).
+     */
+    void remove(uint16_t slot)
+    {
+        uint16_t hole = hashes[slot] & MASK;
+        while (buckets[hole] != slot + 1)
+            hole = (hole + 1) & MASK;
+        // Sem lápides: recua para o buraco as chaves seguintes do mesmo trecho contíguo cuja
+        // posição de origem não fica entre o buraco e a posição atual (a busca ainda as alcança)
+        for (uint16_t b = (hole + 1) & MASK; buckets[b] != 0; b = (b + 1) & MASK)
+        {
+            const uint16_t home = hashes[buckets[b] - 1] & MASK;
+            if (((b - home) & MASK) >= ((b - hole) & MASK))
+            {
+                buckets[hole] = buckets[b];
+                hole = b;
+            }
+        }
+        buckets[hole] = 0;
+    }
+
+private:
+    struct AnySlot
+    {
+        bool operator()(uint16_t) const { return true; }
+    };
+
+    static constexpr uint16_t bucketsFor(uint16_t n, uint16_t b = 1) { return b >= n ? b : bucketsFor(n, b * 2); }
+    static const uint16_t BUCKETS = bucketsFor(2 * CAPACITY);
+    static const uint16_t MASK = BUCKETS - 1;
+
+    uint16_t hashes[CAPACITY];
+    uint16_t buckets[BUCKETS]; // Slot + 1 (0 = posição vazia)
+};
+
+/**
+ * @brief Nome (até POSE_NAME_LEN) -> slot, pelo hash FNV-1a do nome.
+ */
+template <uint16_t CAPACITY>
+class NameIndex
+{
+public:
+    NameIndex() { clear(); }
+
+    /**
+     * @brief Esvazia o índice.
+     */
+    void clear()
+    {
+        memset(names, 0, sizeof(names));
+        table.clear();
+    }
+
+    /**
+     * @brief Slot do nome, ou -1 se não estiver no índice.
+     */
+    int find(const char *name) const
+    {
+        if (name[0] == '\0')
+            return -1;
+        return table.find(hash(name), [this, name](uint16_t slot) {
+            return strncmp(names[slot], name, POSE_NAME_LEN) == 0;
+        });
+    }
+
+    /**
+     * @brief Associa o nome ao slot (substitui o nome anterior do slot, se houver).
+     */
+    void insert(uint16_t slot, const char *name)
+    {
+        remove(slot);
+        if (name[0] == '\0')
+            return;
+        // Zeros após o nome: os registros do log levam os POSE_NAME_LEN bytes
+        memset(names[slot], 0, POSE_NAME_LEN);
+        memcpy(names[slot], name, strnlen(name, POSE_NAME_LEN - 1));
+        table.insert(slot, hash(names[slot]));
+    }
+
+    /**
+     * @brief Retira o slot do índice.
+     */
+    void remove(uint16_t slot)
+    {
+        if (!contains(slot))
+            return;
+        names[slot][0] = '\0';
+        table.remove(slot);
+    }
+
+    bool contains(uint16_t slot) const { return names[slot][0] != '\0'; }
+
+    /**
+     * @brief Nome do slot ("" se vazio).
+     */
+    const char *name(uint16_t slot) const { return names[slot]; }
+
+    /**
+     * @brief FNV-1a de 32 bits sobre o nome (até POSE_NAME_LEN), dobrado em 16 bits.
+     */
+    static uint16_t hash(const char *name)
+    {
+        uint32_t h = 2166136261UL;
+        for (int i = 0; i < POSE_NAME_LEN && name[i] != '\0'; i++)
+        {
+            h = (h ^ (uint8_t)name[i]) * 16777619UL;
+        }
+        return (uint16_t)(h ^ (h >> 16));
+    }
+
+private:
+    char names[CAPACITY][POSE_NAME_LEN];
+    ProbeTable<CAPACITY> table;
+};
+
+#endif // NAME_INDEX_H
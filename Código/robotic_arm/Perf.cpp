@@ -0,0 +1,151 @@
+/**
+ * @file Perf.cpp
+ * @brief Implementação das sondas de desempenho.
+ */
+#include "Perf.h"
+
+namespace Perf
+{
+#if PERF_PROBES
+    struct ProbeData
+    {
+        uint32_t count;
+        uint32_t minCycles;
+        uint32_t maxCycles;
+        uint64_t sumCycles;
+        uint32_t buckets[HIST_BUCKETS];
+        volatile bool resetPending; // Pedido pelo leitor, aplicado pelo escritor
+    };
+
+    static ProbeData probes[PROBE_COUNT];
+    static const char *const PROBE_NAMES[PROBE_COUNT] = {
+        "loop", "motion_update", "motion_tick", "bus_dispatch", "sequencer",
+        "serial_input", "ros_update", "storage_commit", "serial_print"};
+#endif
+
+    static unsigned long emitPeriodMs = PERF_EMIT_PERIOD_MS;
+    static unsigned long lastEmit = 0;
+
+#if PERF_PROBES
+    /**
+     * @brief Índice do bucket: valores < 8 são exatos; acima, 4 buckets por potência de 2.
+     */
+    static int bucketIndex(uint32_t cycles)
+    {
+        if (cycles < 8)
+            return (int)cycles;
+        const int msb = 31 - __builtin_clz(cycles);
+        return 8 + (msb - 3) * 4 + (int)((cycles >> (msb - 2)) & 3);
+    }
+
+    /**
+     * @brief Maior valor que cai no bucket (limite superior usado no p99).
+     */
+    static uint32_t bucketUpper(int index)
+    {
+        if (index < 8)
+            return (uint32_t)index;
+        const int msb = (index - 8) / 4 + 3;
+        const uint32_t sub = (uint32_t)((index - 8) % 4);
+        const uint64_t lower = (uint64_t)(4 + sub) << (msb - 2);
+        return (uint32_t)(lower + ((uint64_t)1 << (msb - 2)) - 1);
+    }
+
+    static void clear(ProbeData &p)
+    {
+        p.count = 0;
+        p.minCycles = UINT32_MAX;
+        p.maxCycles = 0;
+        p.sumCycles = 0;
+        memset(p.buckets, 0, sizeof(p.buckets));
+    }
+
+    static uint32_t percentile(const ProbeData &p, uint32_t permille)
+    {
+        const uint64_t rank = ((uint64_t)p.count * permille + 999) / 1000;
+        uint64_t seen = 0;
+        for (int i = 0; i < HIST_BUCKETS; i++)
+        {
+            seen += p.buckets[i];
+            if (seen >= rank)
+                return min(bucketUpper(i), p.maxCycles);
+        }
+        return p.maxCycles;
+    }
+
+    static void printMicros(uint32_t cycles, uint32_t mhz)
+    {
+        Serial.print(F(","));
+        Serial.print((double)cycles / mhz, 2);
+    }
+#endif
+
+    void record(Probe probe, uint32_t cycles)
+    {
+#if PERF_PROBES
+        ProbeData &p = probes[probe];
+        if (p.resetPending || p.count == 0)
+        {
+            clear(p);
+            p.resetPending = false;
+        }
+        p.count++;
+        p.sumCycles += cycles;
+        if (cycles < p.minCycles)
+            p.minCycles = cycles;
+        if (cycles > p.maxCycles)
+            p.maxCycles = cycles;
+        p.buckets[bucketIndex(cycles)]++;
+#else
+        (void)probe;
+        (void)cycles;
+#endif
+    }
+
+    void reset()
+    {
+#if PERF_PROBES
+        for (int i = 0; i < PROBE_COUNT; i++)
+            probes[i].resetPending = true;
+#endif
+    }
+
+    void print()
+    {
+#if PERF_PROBES
+        const uint32_t mhz = ESP.getCpuFreqMHz();
+        Serial.println(F("PERF,probe,count,min_us,avg_us,p99_us,max_us"));
+        for (int i = 0; i < PROBE_COUNT; i++)
+        {
+            const ProbeData p = probes[i]; // Cópia: o escritor pode estar em outro core
+            const bool empty = p.count == 0 || p.resetPending;
+            Serial.print(F("PERF,"));
+            Serial.print(PROBE_NAMES[i]);
+            Serial.print(F(","));
+            Serial.print(empty ? 0 : p.count);
+            printMicros(empty ? 0 : p.minCycles, mhz);
+            printMicros(empty ? 0 : (uint32_t)(p.sumCycles / p.count), mhz);
+            printMicros(empty ? 0 : percentile(p, 990), mhz);
+            printMicros(empty ? 0 : p.maxCycles, mhz);
+            Serial.println();
+        }
+#else
+        Serial.println(F("Sondas de desempenho desativadas (PERF_PROBES=0)."));
+#endif
+    }
+
+    void setEmitPeriod(unsigned long periodMs)
+    {
+        emitPeriodMs = periodMs;
+        lastEmit = millis();
+    }
+
+    void update()
+    {
+        if (emitPeriodMs == 0 || millis() - lastEmit < emitPeriodMs)
+            return;
+        lastEmit = millis();
+        print();
+    }
+
+} // namespace Perf
@@ -0,0 +1,91 @@
+/**
+ * @file Perf.h
+ * @brief Instrumentação leve do loop e dos módulos (comando 'perf').
+ *
+ * Cada sonda (Probe) mede a duração de um trecho em ciclos (ESP.getCycleCount()) e acumula
+ * contagem, mínimo, média, máximo e um histograma log-linear em RAM fixa, de onde sai o p99.
+ * Cada sonda tem um único escritor (um core/task), então o registro não usa lock.
+ * Com PERF_PROBES=0 as sondas (PERF_SCOPE) somem do código.
+ */
+#ifndef PERF_H
+#define PERF_H
+
+#include "Config.h"
+
+namespace Perf
+{
+
+    /**
+     * @brief Trechos medidos (e o core/task que escreve em cada um).
+     */
+    enum Probe : uint8_t
+    {
+        LOOP,           /**< loop() completo (core de movimento). */
+        MOTION_UPDATE,  /**< MotionController::update() no loop(). */
+        MOTION_TICK,    /**< Um tick de interpolação (task de movimento, ou loop() no modo legado). */
+        BUS_DISPATCH,   /**< CommandBus::dispatch() (execução dos comandos, core de movimento). */
+        SEQUENCER,      /**< Sequencer::update() (core de movimento). */
+        SERIAL_INPUT,   /**< CommandParser::handleSerialInput(): leitura e interpretação (comunicação). */
+        ROS_UPDATE,     /**< RosInterface::update() (comunicação). */
+        STORAGE_COMMIT, /**< Storage::commit(): gravação no log da flash (comunicação). */
+        SERIAL_PRINT,   /**< Saídas longas na Serial: status, help e listas (comunicação). */
+        PROBE_COUNT
+    };
+
+    /** @brief Buckets do histograma: 8 exatos + 4 por potência de 2 até 2^32 ciclos (±12%). */
+    const int HIST_BUCKETS = 8 + 29 * 4;
+
+    /**
+     * @brief Registra uma medição (somente o escritor da sonda).
+     */
+    void record(Probe probe, uint32_t cycles);
+
+    /**
+     * @brief Zera todas as sondas. Cada sonda é zerada pelo seu escritor no próximo registro.
+     */
+    void reset();
+
+    /**
+     * @brief Exibe as sondas em CSV:
+     * PERF,probe,count,min_us,avg_us,p99_us,max_us
+     */
+    void print();
+
+    /**
+     * @brief Define o período de emissão automática (0 = desligada).
+     */
+    void setEmitPeriod(unsigned long periodMs);
+
+    /**
+     * @brief Emite o relatório quando o período configurado tiver passado.
+     * Chamado pela comunicação (serviceComms no robotic_arm.ino).
+     */
+    void update();
+
+#if PERF_PROBES
+    /**
+     * @brief Mede o escopo em que é declarado (use PERF_SCOPE).
+     */
+    class Scope
+    {
+    public:
+        explicit Scope(Probe probe) : probe(probe), start(ESP.getCycleCount()) {}
+        ~Scope() { record(probe, ESP.getCycleCount() - start); }
+
+    private:
+        Probe probe;
+        uint32_t start;
+    };
+#endif
+
+} // namespace Perf
+
+#if PERF_PROBES
+#define PERF_CONCAT_(a, b) a##b
+#define PERF_CONCAT(a, b) PERF_CONCAT_(a, b)
+#define PERF_SCOPE(probe) Perf::Scope PERF_CONCAT(perfScope_, __LINE__)(probe)
+#else
+#define PERF_SCOPE(probe) ((void)0)
+#endif
+
+#endif // PERF_H
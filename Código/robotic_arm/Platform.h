@@ -0,0 +1,23 @@
+/**
+ * @file Platform.h
+ * @brief Fronteira de hardware (HAL) do firmware.
+ * Único ponto em que os módulos incluem o core do Arduino, a EEPROM, as partições da flash e a
+ * biblioteca de servos.
+ *
+ * - ESP32 (Arduino IDE): bibliotecas reais.
+ * - Build nativo (HOST_BUILD, ver host/CMakeLists.txt): implementações para Linux com relógio
+ *   virtual, EEPROM e flash em memória/arquivo, Serial em stdin/stdout e servos que só guardam o pulso.
+ */
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#ifdef HOST_BUILD
+#include "host/HostPlatform.h"
+#else
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <esp_partition.h>
+#include <ESP32Servo.h>
+#endif
+
+#endif // PLATFORM_H
@@ -1,39 +1,319 @@
 /**
  * PoseManager.cpp
  * Implementação da lógica de persistência das Poses.
+ * Os slots vivem em RAM (índice de nomes + ângulos + id); cada slot alterado vira um PoseRecord no
+ * log da flash quando o Storage faz o commit (flush). No boot os slots voltam pelo replay do log
+ * (applyRecord) ou, uma única vez, pela importação da EEPROM legada V2 (importEeprom).
+ * Cada pose ganha um id que não muda com o slot: é ele que os passos das macros guardam.
  */
 #include "PoseManager.h"
+#include "LogStore.h"
 #include "MotionController.h"
+#include "CommandBus.h"
+#include "NameIndex.h"
+#include "Storage.h"
+
+#include <stddef.h>
 
 namespace PoseManager
 {
-  void readPose(int index, Pose &pose)
+  namespace
+  {
+    // Slots em RAM: nome -> slot e os ângulos salvos.
+    // Escritos só pelo core de comunicação (save/delete/boot); lidos também pelo core de movimento
+    // (CommandBus, Sequencer), por isso toda cópia passa por indexMux.
+    NameIndex<MAX_POSES> nameIndex;
+    uint8_t cachedAngles[MAX_POSES][NUM_SERVOS];
+    uint16_t poseIds[MAX_POSES]; // POSE_ID_NONE = slot vazio
+    // Id -> slot (os passos das macros guardam o id); os ids são sequenciais, então o próprio id serve de hash
+    ProbeTable<MAX_POSES> idTable;
+    bool dirtySlot[MAX_POSES];   // Alterado desde o último flush (só o core de comunicação)
+    uint16_t lastId = POSE_ID_NONE; // Maior id já usado (persistido nos snapshots)
+    portMUX_TYPE indexMux = portMUX_INITIALIZER_UNLOCKED;
+
+    int nameAddress(int index)
+    {
+      return NAMES_START_V2 + offsetof(NameTable, poseNames) + index * POSE_NAME_LEN;
+    }
+
+    int poseAddress(int index)
+    {
+      return POSES_START_V2 + index * sizeof(PoseCompact);
+    }
+
+    uint16_t poseCrc(const char name[POSE_NAME_LEN], const PoseCompact &pose)
+    {
+      const uint16_t crc = calcCRC16((const uint8_t *)name, POSE_NAME_LEN);
+      return calcCRC16((const uint8_t *)&pose, sizeof(pose) - 2, crc);
+    }
+
+    /**
+     * @brief Slot da pose com o id, ou -1 (chamar sob indexMux, ou no core de comunicação).
+     */
+    int idSlot(uint16_t id)
+    {
+      return id == POSE_ID_NONE ? -1 : idTable.find(id);
+    }
+
+    /**
+     * @brief Troca o id do slot no mapa id -> slot (chamar sob indexMux).
+     */
+    void setSlotId(int index, uint16_t id)
+    {
+      if (poseIds[index] == id)
+        return;
+      if (poseIds[index] != POSE_ID_NONE)
+        idTable.remove(index);
+      poseIds[index] = id;
+      if (id != POSE_ID_NONE)
+        idTable.insert(index, id);
+    }
+
+    void clearSlot(int index)
+    {
+      portENTER_CRITICAL(&indexMux);
+      nameIndex.remove(index);
+      setSlotId(index, POSE_ID_NONE);
+      portEXIT_CRITICAL(&indexMux);
+      dirtySlot[index] = true;
+    }
+
+    bool idInUse(uint16_t id)
+    {
+      return idSlot(id) >= 0;
+    }
+
+    /**
+     * @brief Próximo id. Depois de 65535 poses criadas o contador volta ao início e pula os ids em
+     * uso; um passo de macro de uma pose apagada há muito tempo poderia então achar uma pose nova.
+     */
+    uint16_t nextId()
+    {
+      do
+      {
+        lastId++;
+      } while (lastId == POSE_ID_NONE || idInUse(lastId));
+      return lastId;
+    }
+
+    /**
+     * @brief Pose válida pelo nome (índice em RAM), com os ângulos já convertidos para int.
+     */
+    bool lookup(const char *name, int angles[NUM_SERVOS])
+    {
+      uint8_t stored[NUM_SERVOS];
+      portENTER_CRITICAL(&indexMux);
+      const int slot = nameIndex.find(name);
+      if (slot >= 0)
+        memcpy(stored, cachedAngles[slot], sizeof(stored));
+      portEXIT_CRITICAL(&indexMux);
+      if (slot < 0)
+        return false;
+      for (int j = 0; j < NUM_SERVOS; j++)
+        angles[j] = stored[j];
+      return true;
+    }
+  }
+
+  RecordState readSlot(int index, char name[POSE_NAME_LEN], PoseCompact &pose)
   {
-    EEPROM.get(POSES_START + index * sizeof(Pose), pose);
+    EEPROM.get(poseAddress(index), pose);
+    for (int i = 0; i < POSE_NAME_LEN; i++)
+      name[i] = (char)EEPROM.read(nameAddress(index) + i);
+    if (!(pose.flags & RECORD_USED))
+    {
+      name[0] = '\0';
+      return RECORD_EMPTY;
+    }
+    if (name[POSE_NAME_LEN - 1] != '\0' || poseCrc(name, pose) != pose.crc16)
+    {
+      name[POSE_NAME_LEN - 1] = '\0';
+      return RECORD_CORRUPT;
+    }
+    return RECORD_VALID;
   }
 
-  void writePose(int index, const Pose &pose)
+  void writeSlot(int index, const char *name, const uint8_t angles[NUM_SERVOS], uint16_t id)
   {
-    EEPROM.put(POSES_START + index * sizeof(Pose), pose);
+    char storedName[POSE_NAME_LEN] = {0}; // Zeros após o nome: o registro do log leva os 10 bytes
+    memcpy(storedName, name, strnlen(name, POSE_NAME_LEN - 1));
+    if (id == POSE_ID_NONE)
+      id = poseIds[index] != POSE_ID_NONE ? poseIds[index] : nextId();
+    portENTER_CRITICAL(&indexMux);
+    nameIndex.insert(index, storedName);
+    memcpy(cachedAngles[index], angles, NUM_SERVOS);
+    setSlotId(index, id);
+    portEXIT_CRITICAL(&indexMux);
+    dirtySlot[index] = true;
   }
 
-  void listPoses()
+  uint16_t slotId(int index)
   {
-    Serial.println(F("\n--- Poses Salvas ---"));
-    int count = 0;
+    return poseIds[index]; // Escrito só pelo core de comunicação, que é quem chama
+  }
+
+  uint16_t findId(const char *name)
+  {
+    portENTER_CRITICAL(&indexMux);
+    const int slot = nameIndex.find(name);
+    const uint16_t id = slot >= 0 ? poseIds[slot] : POSE_ID_NONE;
+    portEXIT_CRITICAL(&indexMux);
+    return id;
+  }
+
+  bool findPoseById(uint16_t id, float angles[NUM_SERVOS], char name[POSE_NAME_LEN])
+  {
+    uint8_t stored[NUM_SERVOS];
+    portENTER_CRITICAL(&indexMux);
+    const int slot = idSlot(id);
+    if (slot >= 0)
+    {
+      memcpy(stored, cachedAngles[slot], sizeof(stored));
+      memcpy(name, nameIndex.name(slot), POSE_NAME_LEN);
+    }
+    portEXIT_CRITICAL(&indexMux);
+    if (slot < 0)
+      return false;
+    for (int j = 0; j < NUM_SERVOS; j++)
+      angles[j] = (float)stored[j];
+    return true;
+  }
+
+  int findSlot(const char *name)
+  {
+    portENTER_CRITICAL(&indexMux);
+    const int slot = nameIndex.find(name);
+    portEXIT_CRITICAL(&indexMux);
+    return slot;
+  }
+
+  bool slotName(int index, char name[POSE_NAME_LEN])
+  {
+    portENTER_CRITICAL(&indexMux);
+    memcpy(name, nameIndex.name(index), POSE_NAME_LEN);
+    portEXIT_CRITICAL(&indexMux);
+    return name[0] != '\0';
+  }
+
+  void reset()
+  {
+    portENTER_CRITICAL(&indexMux);
+    nameIndex.clear();
+    memset(poseIds, 0, sizeof(poseIds));
+    idTable.clear();
+    portEXIT_CRITICAL(&indexMux);
+    memset(dirtySlot, 0, sizeof(dirtySlot));
+    lastId = POSE_ID_NONE;
+  }
+
+  void applyRecord(uint8_t type, uint16_t id, const uint8_t *data, uint16_t length)
+  {
+    if (type == LOG_RECORD_POSE_LAST_ID)
+    {
+      uint16_t last;
+      if (length == sizeof(last))
+      {
+        memcpy(&last, data, sizeof(last));
+        lastId = max(lastId, last);
+      }
+      return;
+    }
+    if (id >= MAX_POSES)
+      return;
+    if (length == sizeof(PoseRecord))
+    {
+      PoseRecord record;
+      memcpy(&record, data, sizeof(record));
+      if (record.id == POSE_ID_NONE)
+        return; // Registro de outro formato: mantém a versão anterior
+      record.name[POSE_NAME_LEN - 1] = '\0';
+      lastId = max(lastId, record.id);
+      writeSlot(id, record.name, record.angles, record.id);
+    }
+    else if (length == 0)
+    {
+      clearSlot(id);
+    }
+    else
+    {
+      return; // Registro de outro formato: mantém a versão anterior
+    }
+    dirtySlot[id] = false; // Já está no log
+  }
+
+  bool flush(bool all)
+  {
+    if (all && !LogStore::append(LOG_RECORD_POSE_LAST_ID, 0, &lastId, sizeof(lastId)))
+      return false;
     for (int i = 0; i < MAX_POSES; i++)
     {
-      Pose p;
-      readPose(i, p);
-      // Verifica se o primeiro caractere do nome não é nulo
-      if (p.name[0] != 0)
+      if (!all && !dirtySlot[i])
+        continue;
+      // Os slots só mudam neste core: a leitura dispensa o indexMux
+      const bool used = nameIndex.contains(i);
+      if (used || dirtySlot[i]) // Slot vazio: só o delete pendente (um snapshot cortado ainda o aplica)
       {
-        Serial.print(" [");
-        Serial.print(i);
-        Serial.print("] ");
-        Serial.println(p.name);
+        PoseRecord record;
+        memcpy(record.name, nameIndex.name(i), POSE_NAME_LEN);
+        memcpy(record.angles, cachedAngles[i], NUM_SERVOS);
+        record.id = poseIds[i];
+        if (!LogStore::append(LOG_RECORD_POSE, i, used ? &record : NULL, used ? sizeof(record) : 0))
+          return false;
+      }
+      dirtySlot[i] = false;
+    }
+    return true;
+  }
+
+  uint32_t logBytes(bool all)
+  {
+    uint32_t bytes = all ? LogStore::recordSize(sizeof(lastId)) : 0;
+    for (int i = 0; i < MAX_POSES; i++)
+    {
+      const bool used = nameIndex.contains(i);
+      if (dirtySlot[i] || (all && used))
+        bytes += LogStore::recordSize(used ? sizeof(PoseRecord) : 0);
+    }
+    return bytes;
+  }
+
+  int importEeprom()
+  {
+    int count = 0;
+    for (int i = 0; i < MAX_POSES_V2; i++)
+    {
+      char name[POSE_NAME_LEN];
+      PoseCompact pose;
+      const RecordState state = readSlot(i, name, pose);
+      if (state == RECORD_VALID)
+      {
+        writeSlot(i, name, pose.angles);
         count++;
       }
+      else if (state == RECORD_CORRUPT)
+      {
+        Serial.print(F("AVISO: pose do slot "));
+        Serial.print(i);
+        Serial.println(F(" corrompida na EEPROM (CRC invalido). Descartada."));
+      }
+    }
+    return count;
+  }
+
+  void listPoses()
+  {
+    Serial.println(F("\n--- Poses Salvas ---"));
+    int count = 0;
+    for (int i = 0; i < MAX_POSES; i++)
+    {
+      char name[POSE_NAME_LEN];
+      if (!slotName(i, name))
+        continue;
+      Serial.print(" [");
+      Serial.print(i);
+      Serial.print("] ");
+      Serial.println(name);
+      count++;
     }
     if (count == 0)
     {
@@ -44,6 +324,7 @@ namespace PoseManager
     Serial.print(F(" de "));
     Serial.print(MAX_POSES);
     Serial.println(F(" slots usados."));
+    Storage::printLibrarySpace();
   }
 
   void savePose(const char *name)
@@ -51,36 +332,31 @@ namespace PoseManager
     if (name[0] == 0)
       return; // Não salva com nome vazio
 
-    int emptySlot = -1;
-    // Procura um slot vazio ou um com o mesmo nome (para sobrescrever)
-    for (int i = 0; i < MAX_POSES; i++)
+    // Slot com o mesmo nome (sobrescreve) ou o primeiro livre
+    int emptySlot = findSlot(name);
+    for (int i = 0; i < MAX_POSES && emptySlot == -1; i++)
     {
-      Pose p;
-      readPose(i, p);
-      if (p.name[0] == 0)
-      {
-        if (emptySlot == -1)
-          emptySlot = i; // Guarda o primeiro slot vazio
-      }
-      else if (strncmp(p.name, name, POSE_NAME_LEN) == 0)
-      {
-        emptySlot = i; // Encontrou slot com mesmo nome
-        break;
-      }
+      if (!nameIndex.contains(i))
+        emptySlot = i;
     }
 
+    if (emptySlot != -1 && !nameIndex.contains(emptySlot) && !Storage::hasRoom(LogStore::recordSize(sizeof(PoseRecord))))
+    {
+      Serial.println(F("ERRO: Sem espaco na flash para mais poses."));
+      return;
+    }
     if (emptySlot != -1)
     {
-      Pose newPose;
-      strncpy(newPose.name, name, POSE_NAME_LEN - 1);
-      newPose.name[POSE_NAME_LEN - 1] = '\0'; // Garante terminação nula
-
+      // Salva a posição LÓGICA atual (snapshot publicado pelo tick de movimento)
+      MotionController::Snapshot snap;
+      MotionController::getSnapshot(snap);
+      uint8_t angles[NUM_SERVOS];
       for (int j = 0; j < NUM_SERVOS; j++)
       {
-        newPose.angles[j] = currentAngles[j]; // Salva a posição LÓGICA atual
+        angles[j] = (uint8_t)constrain((int)lroundf(snap.angles[j]), 0, 180);
       }
-      writePose(emptySlot, newPose);
-      EEPROM.commit();
+      writeSlot(emptySlot, name, angles);
+      Storage::markDirty(Storage::REGION_POSES);
       Serial.print(F("Pose '"));
       Serial.print(name);
       Serial.print(F("' salva no slot "));
@@ -101,31 +377,31 @@ namespace PoseManager
     // Comando especial para apagar todas
     if (strncmp(name, "all", 3) == 0)
     {
+      // Os passos das macros guardam o id: passam a abortar na pose apagada, sem regravar as macros
+      portENTER_CRITICAL(&indexMux);
       for (int i = 0; i < MAX_POSES; i++)
       {
-        Pose emptyPose = {0}; // Cria uma estrutura zerada
-        writePose(i, emptyPose);
+        dirtySlot[i] |= poseIds[i] != POSE_ID_NONE;
+        poseIds[i] = POSE_ID_NONE;
       }
-      EEPROM.commit();
+      idTable.clear();
+      nameIndex.clear();
+      portEXIT_CRITICAL(&indexMux);
+      Storage::markDirty(Storage::REGION_POSES);
       Serial.println(F("Todas as poses foram apagadas."));
       return;
     }
 
     // Procura a pose pelo nome para apagar
-    for (int i = 0; i < MAX_POSES; i++)
+    const int slot = findSlot(name);
+    if (slot >= 0)
     {
-      Pose p;
-      readPose(i, p);
-      if (p.name[0] != 0 && strncmp(p.name, name, POSE_NAME_LEN) == 0)
-      {
-        Pose emptyPose = {0};
-        writePose(i, emptyPose);
-        EEPROM.commit();
-        Serial.print(F("Pose '"));
-        Serial.print(name);
-        Serial.println(F("' apagada."));
-        return;
-      }
+      clearSlot(slot);
+      Storage::markDirty(Storage::REGION_POSES);
+      Serial.print(F("Pose '"));
+      Serial.print(name);
+      Serial.println(F("' apagada."));
+      return;
     }
     Serial.print(F("Pose '"));
     Serial.print(name);
@@ -140,28 +416,27 @@ namespace PoseManager
     if (name[0] == 0)
       return false;
 
-    Pose p;
-    for (int i = 0; i < MAX_POSES; i++)
+    int angles[NUM_SERVOS];
+    if (lookup(name, angles))
     {
-      readPose(i, p);
-      if (p.name[0] != 0 && strncmp(p.name, name, POSE_NAME_LEN) == 0)
-      {
-        Serial.print(F("Carregando pose '"));
-        Serial.print(name);
-        Serial.print(F("' (duracao: "));
-        Serial.print(duration);
-        Serial.println(F(" ms)..."));
-        // Inicia o movimento via MotionController
-        MotionController::startSmoothMove(p.angles, duration);
-        return true;
-      }
+      CommandBus::replyNamed(CommandBus::Reply::POSE_LOADING, name, duration, 0);
+      // Enfileira o movimento via MotionController
+      return MotionController::startSmoothMove(angles, duration);
     }
-    Serial.print(F("ERRO: Pose '"));
-    Serial.print(name);
-    Serial.println(F("' nao encontrada."));
+    CommandBus::replyNamed(CommandBus::Reply::POSE_NOT_FOUND, name);
     return false;
   }
 
+  bool findPose(const char *name, float angles[NUM_SERVOS])
+  {
+    int stored[NUM_SERVOS];
+    if (name[0] == 0 || !lookup(name, stored))
+      return false;
+    for (int j = 0; j < NUM_SERVOS; j++)
+      angles[j] = (float)stored[j];
+    return true;
+  }
+
   /**
    * @brief Implementação da sobrecarga (com velocidade padrão).
    */
@@ -170,26 +445,15 @@ namespace PoseManager
     if (name[0] == 0)
       return false;
 
-    Pose p;
-    for (int i = 0; i < MAX_POSES; i++)
+    int angles[NUM_SERVOS];
+    if (lookup(name, angles))
     {
-      readPose(i, p);
-      if (p.name[0] != 0 && strncmp(p.name, name, POSE_NAME_LEN) == 0)
-      {
-        // Calcula a duração automaticamente
-        unsigned long duration = MotionController::calculateDurationBySpeed(p.angles); // <-- CORRIGIDO
-        Serial.print(F("Carregando pose '"));
-        Serial.print(name);
-        Serial.print(F("' (duracao calc: "));
-        Serial.print(duration);
-        Serial.println(F(" ms)..."));
-        MotionController::startSmoothMove(p.angles, duration);
-        return true;
-      }
+      // Calcula a duração automaticamente
+      unsigned long duration = MotionController::calculateDurationBySpeed(angles);
+      CommandBus::replyNamed(CommandBus::Reply::POSE_LOADING, name, duration, 1);
+      return MotionController::startSmoothMove(angles, duration);
     }
-    Serial.print(F("ERRO: Pose '"));
-    Serial.print(name);
-    Serial.println(F("' nao encontrada."));
+    CommandBus::replyNamed(CommandBus::Reply::POSE_NOT_FOUND, name);
     return false;
   }
 
@@ -1,7 +1,7 @@
 /**
  * PoseManager.h
  * Responsável pela lógica de salvar, carregar e gerenciar
- * as 'Poses' (pontos estáticos) na EEPROM.
+ * as 'Poses' (pontos estáticos): slots em RAM com índice de nomes, gravados no log da flash.
  */
 #ifndef POSE_MANAGER_H
 #define POSE_MANAGER_H
@@ -28,6 +28,14 @@ namespace PoseManager
      */
     void deletePose(const char *name);
 
+    /**
+     * @brief Procura uma pose pelo nome sem mover o braço.
+     * @param name Nome da pose.
+     * @param angles [out] Ângulos da pose.
+     * @return true se a pose foi encontrada.
+     */
+    bool findPose(const char *name, float angles[NUM_SERVOS]);
+
     /**
      * @brief Carrega uma pose pelo nome e inicia o movimento.
      * Calcula a duração do movimento com base na velocidade padrão.
@@ -44,6 +52,82 @@ namespace PoseManager
      */
     bool loadPoseByName(const char *name, unsigned long duration); // <-- SOBRECARGA ADICIONADA
 
+    /**
+     * @brief Id permanente da pose pelo nome (os passos das macros guardam o id, não o slot).
+     * @return O id, ou POSE_ID_NONE se a pose não existir.
+     */
+    uint16_t findId(const char *name);
+
+    /**
+     * @brief Procura uma pose pelo id (passo de macro), de qualquer core.
+     * @param angles [out] Ângulos da pose.
+     * @param name [out] Nome atual da pose.
+     * @return false se nenhuma pose tiver esse id (apagada).
+     */
+    bool findPoseById(uint16_t id, float angles[NUM_SERVOS], char name[POSE_NAME_LEN]);
+
+    // --- Acesso aos slots: usado pelo Storage (boot e commit) e pelas macros ---
+
+    /**
+     * @brief Lê o slot da EEPROM legada V2 e confere o CRC (nome + pose).
+     * @param name [out] Nome da pose (terminado em nulo).
+     * @param pose [out] Registro compacto.
+     */
+    RecordState readSlot(int index, char name[POSE_NAME_LEN], PoseCompact &pose);
+
+    /**
+     * @brief Grava nome e ângulos no slot em RAM e o marca para o próximo flush.
+     * @param id Id da pose; POSE_ID_NONE mantém o do slot ocupado ou gera um novo.
+     */
+    void writeSlot(int index, const char *name, const uint8_t angles[NUM_SERVOS], uint16_t id = POSE_ID_NONE);
+
+    /**
+     * @brief Slot de uma pose válida pelo nome (índice em RAM).
+     * @return Índice do slot, ou -1 se não existir.
+     */
+    int findSlot(const char *name);
+
+    /**
+     * @brief Nome da pose do slot, pelo índice em RAM.
+     * @param name [out] Nome ("" se o slot estiver vazio).
+     * @return true se o slot tiver uma pose válida.
+     */
+    bool slotName(int index, char name[POSE_NAME_LEN]);
+
+    /**
+     * @brief Esvazia todos os slots em RAM (início do boot, antes do replay ou da importação).
+     */
+    void reset();
+
+    /**
+     * @brief Id da pose do slot (POSE_ID_NONE se vazio).
+     */
+    uint16_t slotId(int index);
+
+    /**
+     * @brief Aplica um registro do replay: LOG_RECORD_POSE (PoseRecord, ou sem dados: slot apagado)
+     * ou LOG_RECORD_POSE_LAST_ID.
+     */
+    void applyRecord(uint8_t type, uint16_t id, const uint8_t *data, uint16_t length);
+
+    /**
+     * @brief Acrescenta ao log os slots alterados desde o último flush (slot vazio: registro sem dados).
+     * @param all true = todos os slots ocupados, mais os deletes pendentes e o maior id (snapshot).
+     * @return false se o log recusar um registro (os slots restantes continuam pendentes).
+     */
+    bool flush(bool all);
+
+    /**
+     * @brief Espaço no log dos registros que flush(all) gravaria.
+     */
+    uint32_t logBytes(bool all);
+
+    /**
+     * @brief Copia para a RAM os slots válidos da EEPROM legada V2 (importação única no boot).
+     * @return Número de poses importadas.
+     */
+    int importEeprom();
+
 } // namespace PoseManager
 
 #endif // POSE_MANAGER_H
@@ -19,9 +19,10 @@
 
 // --- Módulos do Braço Robótico ---
 #include "Config.h"
+#include "CommandBus.h"
 #include "MotionController.h"
 #include "Sequencer.h"
-#include "PoseManager.h"
+#include "Perf.h"
 
 // =================================================================
 // 1. Variáveis Globais do micro-ROS
@@ -48,9 +49,11 @@ std_msgs__msg__String arm_status_msg;         // Mensagem de status (IDLE, MOVIN
 rcl_subscription_t sub_joint_goals;
 rcl_subscription_t sub_run_macro;
 rcl_subscription_t sub_run_pose;
+rcl_subscription_t sub_arm_command;
 sensor_msgs__msg__JointState joint_goals_msg; // Mensagem de ângulos alvo
 std_msgs__msg__String run_macro_msg;          // Mensagem para rodar macro
 std_msgs__msg__String run_pose_msg;           // Mensagem para rodar pose
+std_msgs__msg__String arm_command_msg;        // Mensagem de controle (stop/pause/resume)
 
 // Nomes das juntas (deve corresponder ao seu URDF no ROS)
 const char *joint_names[NUM_SERVOS] = {"junta_base", "junta_ombro1", "junta_ombro2", "junta_cotovelo", "junta_mao", "junta_pulso", "junta_garra"};
@@ -77,18 +80,18 @@ void jointGoalsCallback(const void *msgin)
         return;
     }
 
-    int targetAngles[NUM_SERVOS];
+    CommandBus::Command cmd = CommandBus::make(CommandBus::MOVE);
     for (int i = 0; i < NUM_SERVOS; i++)
     {
         // Converte de Radianos (ROS) para Graus (Braço)
-        targetAngles[i] = (int)RAD_TO_DEG(msg->position.data[i]);
+        cmd.angles[i] = (float)RAD_TO_DEG(msg->position.data[i]);
     }
 
-    // Usa a velocidade padrão do MotionController
-    unsigned long duration = MotionController::calculateDurationBySpeed(targetAngles);
+    // duration = 0: usa a velocidade padrão do MotionController (calculada no core de movimento)
+    cmd.arg = CommandBus::ALL_JOINTS;
 
     Serial.println("ROS: Recebido comando /joint_goals.");
-    MotionController::startSmoothMove(targetAngles, duration);
+    CommandBus::post(cmd);
 }
 
 /**
@@ -100,7 +103,9 @@ void runMacroCallback(const void *msgin)
     Serial.print(F("ROS: Recebido comando /run_macro: '"));
     Serial.print(msg->data.data);
     Serial.println(F("'"));
-    Sequencer::startMacro(msg->data.data);
+    CommandBus::Command cmd = CommandBus::make(CommandBus::MACRO_PLAY);
+    snprintf(cmd.name, sizeof(cmd.name), "%s", msg->data.data);
+    CommandBus::post(cmd);
 }
 
 /**
@@ -112,7 +117,28 @@ void runPoseCallback(const void *msgin)
     Serial.print(F("ROS: Recebido comando /run_pose: '"));
     Serial.print(msg->data.data);
     Serial.println(F("'"));
-    PoseManager::loadPoseByName(msg->data.data);
+    CommandBus::Command cmd = CommandBus::make(CommandBus::POSE_LOAD);
+    snprintf(cmd.name, sizeof(cmd.name), "%s", msg->data.data);
+    CommandBus::post(cmd);
+}
+
+/**
+ * @brief Callback para o tópico /arm_command ("stop", "pause" ou "resume").
+ */
+void armCommandCallback(const void *msgin)
+{
+    const std_msgs__msg__String *msg = (const std_msgs__msg__String *)msgin;
+    Serial.print(F("ROS: Recebido comando /arm_command: '"));
+    Serial.print(msg->data.data);
+    Serial.println(F("'"));
+
+    // Mesma lógica dos comandos seriais (macro, se houver, ou movimento), no core de movimento
+    if (strcmp(msg->data.data, "stop") == 0)
+        CommandBus::post(CommandBus::make(CommandBus::STOP));
+    else if (strcmp(msg->data.data, "pause") == 0)
+        CommandBus::post(CommandBus::make(CommandBus::PAUSE));
+    else if (strcmp(msg->data.data, "resume") == 0)
+        CommandBus::post(CommandBus::make(CommandBus::RESUME));
 }
 
 // =================================================================
@@ -128,12 +154,16 @@ void timerCallback(rcl_timer_t *timer, int64_t last_call_time)
     if (timer == NULL)
         return;
 
+    // Cópia consistente do estado publicado pelo tick de movimento (outro core)
+    MotionController::Snapshot snap;
+    MotionController::getSnapshot(snap);
+
     // --- Publicar /joint_states ---
     // Atualiza a mensagem com os ângulos LÓGICOS atuais
     for (int i = 0; i < NUM_SERVOS; i++)
     {
         // Converte de Graus (Braço) para Radianos (ROS)
-        joint_state_msg.position.data[i] = DEG_TO_RAD(currentAngles[i]);
+        joint_state_msg.position.data[i] = DEG_TO_RAD(snap.angles[i]);
     }
     // Define o timestamp
     struct timespec ts;
@@ -145,11 +175,15 @@ void timerCallback(rcl_timer_t *timer, int64_t last_call_time)
 
     // --- Publicar /arm_status ---
     const char *status = "IDLE";
-    if (Sequencer::isRunning())
+    if (snap.paused || Sequencer::isPaused())
+    {
+        status = "PAUSED";
+    }
+    else if (Sequencer::isRunning())
     {
         status = "RUNNING_MACRO";
     }
-    else if (MotionController::isMoving())
+    else if (snap.moving)
     {
         status = "MOVING";
     }
@@ -211,6 +245,15 @@ namespace RosInterface
         arm_status_msg.data.capacity = max_status_len;
     }
 
+    // Função auxiliar para inicializar o buffer de recepção de /arm_command
+    void initArmCommandMsg()
+    {
+        const int max_command_len = 16; // "resume" é o maior
+        arm_command_msg.data.data = (char *)malloc(max_command_len * sizeof(char));
+        arm_command_msg.data.size = 0;
+        arm_command_msg.data.capacity = max_command_len;
+    }
+
     void setup()
     {
         Serial.println("Iniciando RosInterface (modo SERIAL)...");
@@ -254,6 +297,12 @@ namespace RosInterface
             ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, String),
             "/run_macro");
 
+        // /arm_command é mantido ativo: é o único meio de parar o braço pelo ROS
+        rclc_subscription_init_default(
+            &sub_arm_command, &node,
+            ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, String),
+            "/arm_command");
+
         /*
         rclc_subscription_init_default(
             &sub_run_pose, &node,
@@ -266,21 +315,24 @@ namespace RosInterface
         rclc_timer_init_default(&timer, &support, RCL_MS_TO_NS(timer_period), timerCallback);
 
         // 7. Inicializar o Executor
-        rclc_executor_init(&executor, &support.context, 2, &allocator); // 2 = 1 sub + 1 timer (otimizado)
+        rclc_executor_init(&executor, &support.context, 3, &allocator); // 3 = 2 subs + 1 timer (otimizado)
         rclc_executor_add_timer(&executor, &timer);
         // rclc_executor_add_subscription(&executor, &sub_joint_goals, &joint_goals_msg, &jointGoalsCallback, ON_NEW_DATA);
         rclc_executor_add_subscription(&executor, &sub_run_macro, &run_macro_msg, &runMacroCallback, ON_NEW_DATA);
+        rclc_executor_add_subscription(&executor, &sub_arm_command, &arm_command_msg, &armCommandCallback, ON_NEW_DATA);
         // rclc_executor_add_subscription(&executor, &sub_run_pose, &run_pose_msg, &runPoseCallback, ON_NEW_DATA);
 
         // 8. Inicializar as mensagens (Alocação Dinâmica)
         initJointStateMsg();
         initArmStatusMsg();
+        initArmCommandMsg();
 
         Serial.println("micro-ROS (Serial) configurado e pronto.");
     }
 
     void update()
     {
+        PERF_SCOPE(Perf::ROS_UPDATE);
         // Processa todas as tarefas pendentes do micro-ROS (callbacks, timers)
         // O timeout 0 torna o spin não-bloqueante
         rclc_executor_spin_some(&executor, 0);
@@ -11,10 +11,11 @@
  *   - /joint_goals (sensor_msgs/JointState) - Ângulos alvo em radianos
  *   - /run_macro (std_msgs/String) - Nome da macro para executar
  *   - /run_pose (std_msgs/String) - Nome da pose para carregar
+ *   - /arm_command (std_msgs/String) - Controle do movimento: "stop", "pause" ou "resume"
  *
  * Tópicos Publishers (envia feedback):
  *   - /joint_states (sensor_msgs/JointState) - Estado atual das juntas
- *   - /arm_status (std_msgs/String) - Status do braço (IDLE/MOVING/RUNNING_MACRO)
+ *   - /arm_status (std_msgs/String) - Status do braço (IDLE/MOVING/RUNNING_MACRO/PAUSED)
  */
 #ifndef ROS_INTERFACE_H
 #define ROS_INTERFACE_H
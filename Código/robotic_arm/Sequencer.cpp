@@ -7,6 +7,7 @@
 #include "MacroManager.h"
 #include "PoseManager.h"
 #include "MotionController.h"
+#include "CommandBus.h"
 
 namespace Sequencer
 {
@@ -19,60 +20,153 @@ namespace Sequencer
         WAITING
     };
 
-    static State currentState = IDLE;
-    static Macro runningMacro;
+    // currentState e paused são escritos só pelo core de movimento e lidos pelo de
+    // comunicação (isRunning/isPaused no status ROS)
+    static volatile State currentState = IDLE;
+    static MacroManager::MacroStream runningMacro; // Os passos são lidos da flash em janelas
+    static MacroStepRecord stepWindow[MACRO_STEP_WINDOW];
+    static int windowFirst = 0;
+    static int windowCount = 0;
     static int currentStep = 0;
+    static unsigned long stepDelay = 0;      // Espera do passo atual
     static unsigned long waitStartTime = 0;
+    static volatile bool paused = false;
+    static bool splineMode = false;          // true = passos sem espera são percorridos em spline
+    static unsigned long pauseStartTime = 0; // Início da pausa (para descontar da espera)
 
     bool isRunning()
     {
         return currentState != IDLE;
     }
 
-    void startMacro(const char *name)
+    bool isPaused()
+    {
+        return paused;
+    }
+
+    /**
+     * @brief Erro de pose ausente: o passo guarda o id de uma pose que foi apagada.
+     */
+    void replyMissingPose(int stepIndex, uint16_t poseId)
+    {
+        CommandBus::reply(CommandBus::Reply::MACRO_MISSING_POSE, (uint32_t)(stepIndex + 1), poseId);
+    }
+
+    /**
+     * @brief Passo 'index' da macro, lendo da flash a janela seguinte quando ele não está na atual.
+     * @return false se os passos não puderam ser lidos (a macro deve ser abortada).
+     */
+    bool stepAt(int index, MacroStepRecord &step)
+    {
+        if (index < windowFirst || index >= windowFirst + windowCount)
+        {
+            const int count = min(MACRO_STEP_WINDOW, (int)runningMacro.numSteps - index);
+            if (!MacroManager::readSteps(runningMacro, index, stepWindow, count))
+            {
+                windowCount = 0;
+                CommandBus::reply(CommandBus::Reply::MACRO_READ_FAILED);
+                return false;
+            }
+            windowFirst = index;
+            windowCount = count;
+        }
+        step = stepWindow[index - windowFirst];
+        return true;
+    }
+
+    /**
+     * @brief Inicia o movimento do passo atual.
+     * No modo spline, junta o passo atual e os seguintes até o próximo passo com espera
+     * (ou o último) em uma única trajetória, e avança currentStep até ele. Um trecho sem espera
+     * maior que a fila de movimento é dividido em splines de MOTION_QUEUE_SIZE poses.
+     * @return false se alguma pose não foi encontrada (a macro deve ser abortada).
+     */
+    bool beginStep()
+    {
+        MacroStepRecord step;
+        char poseName[POSE_NAME_LEN];
+        if (!splineMode)
+        {
+            float angles[NUM_SERVOS];
+            if (!stepAt(currentStep, step))
+                return false;
+            stepDelay = step.delay_ms;
+            if (!PoseManager::findPoseById(step.poseId, angles, poseName))
+            {
+                replyMissingPose(currentStep, step.poseId);
+                return false;
+            }
+            // Move direto pelos ângulos já copiados do índice (sem nova busca pelo nome)
+            const unsigned long duration = MotionController::calculateDurationBySpeed(angles);
+            CommandBus::replyNamed(CommandBus::Reply::MACRO_STEP_POSE, poseName, (uint32_t)(currentStep + 1), duration);
+            if (MotionController::startSmoothMove(angles, duration))
+            {
+                return true;
+            }
+            CommandBus::reply(CommandBus::Reply::MACRO_ENQUEUE_FAILED);
+            return false;
+        }
+
+        float waypoints[MOTION_QUEUE_SIZE][NUM_SERVOS];
+        const int first = currentStep;
+        int count = 0;
+        for (;;)
+        {
+            if (!stepAt(currentStep, step))
+                return false;
+            if (!PoseManager::findPoseById(step.poseId, waypoints[count], poseName))
+            {
+                replyMissingPose(currentStep, step.poseId);
+                return false;
+            }
+            count++;
+            stepDelay = step.delay_ms;
+            // Para no passo com espera, no último passo ou com a fila cheia
+            if (step.delay_ms > 0 || currentStep + 1 >= runningMacro.numSteps || count >= MOTION_QUEUE_SIZE)
+                break;
+            currentStep++;
+        }
+
+        CommandBus::reply(CommandBus::Reply::MACRO_STEP_SPLINE, (uint32_t)(first + 1), (uint32_t)(currentStep + 1),
+                          (uint32_t)count);
+        if (!MotionController::startSpline(waypoints, count))
+        {
+            CommandBus::reply(CommandBus::Reply::MACRO_SPLINE_FAILED);
+            return false;
+        }
+        return true;
+    }
+
+    void startMacro(const char *name, bool spline)
     {
         if (isRunning())
         {
-            Serial.println(F("ERRO: Sequenciador já está em execução."));
+            CommandBus::reply(CommandBus::Reply::MACRO_BUSY);
             return;
         }
 
-        if (MacroManager::loadMacroByName(name, runningMacro))
+        if (MacroManager::openStream(name, runningMacro))
         {
             if (runningMacro.numSteps == 0)
             {
-                Serial.println(F("ERRO: Macro está vazia."));
+                CommandBus::reply(CommandBus::Reply::MACRO_EMPTY);
                 return;
             }
 
-            Serial.print(F("Iniciando Macro '"));
-            Serial.print(runningMacro.name);
-            Serial.print(F("' ("));
-            Serial.print(runningMacro.numSteps);
-            Serial.println(F(" passos)..."));
+            CommandBus::replyNamed(CommandBus::Reply::MACRO_STARTED, runningMacro.name, runningMacro.numSteps,
+                                   spline ? 1 : 0);
             currentStep = 0;
+            windowFirst = 0;
+            windowCount = 0;
+            splineMode = spline;
+            paused = false;
 
             // Inicia o primeiro passo
-            Serial.print(F("  Passo 1: Carregando pose '"));
-            Serial.print(runningMacro.steps[0].poseName);
-            Serial.println(F("'..."));
-            if (PoseManager::loadPoseByName(runningMacro.steps[0].poseName))
-            {
-                currentState = MOVING;
-            }
-            else
-            {
-                Serial.print(F("ERRO: Pose '"));
-                Serial.print(runningMacro.steps[0].poseName);
-                Serial.println(F("' nao encontrada. Abortando macro."));
-                currentState = IDLE;
-            }
+            currentState = beginStep() ? MOVING : IDLE;
         }
         else
         {
-            Serial.print(F("ERRO: Macro '"));
-            Serial.print(name);
-            Serial.println(F("' nao encontrada."));
+            CommandBus::replyNamed(CommandBus::Reply::MACRO_NOT_FOUND, name);
         }
     }
 
@@ -81,15 +175,44 @@ namespace Sequencer
         if (isRunning())
         {
             currentState = IDLE;
-            // O MotionController continua o movimento atual, mas a sequência para.
-            // Para parar o movimento físico, teríamos que chamar MotionController::stopMove() (não implementado)
-            Serial.println(F("Macro interrompida."));
+            paused = false;
+            // Descarta os passos enfileirados e desacelera o braço até o repouso
+            MotionController::stop();
+            CommandBus::reply(CommandBus::Reply::MACRO_STOPPED);
+        }
+    }
+
+    void pauseMacro()
+    {
+        if (!isRunning() || paused)
+        {
+            return;
+        }
+        paused = true;
+        pauseStartTime = millis();
+        MotionController::pause();
+        CommandBus::reply(CommandBus::Reply::MACRO_PAUSED, (uint32_t)(currentStep + 1));
+    }
+
+    void resumeMacro()
+    {
+        if (!isRunning() || !paused)
+        {
+            return;
+        }
+        if (currentState == WAITING)
+        {
+            // A espera continua de onde parou: o tempo pausado não conta
+            waitStartTime += millis() - pauseStartTime;
         }
+        paused = false;
+        MotionController::resume();
+        CommandBus::reply(CommandBus::Reply::MACRO_RESUMED, (uint32_t)(currentStep + 1));
     }
 
     void update()
     {
-        if (!isRunning())
+        if (!isRunning() || paused)
         {
             return;
         }
@@ -106,12 +229,8 @@ namespace Sequencer
             // Espera o MotionController terminar o movimento atual
             if (!MotionController::isMoving())
             {
-                unsigned long delay = runningMacro.steps[currentStep].delay_ms;
-                Serial.print(F("  Passo "));
-                Serial.print(currentStep + 1);
-                Serial.print(F(" concluido. Aguardando "));
-                Serial.print(delay);
-                Serial.println(F(" ms..."));
+                unsigned long delay = stepDelay;
+                CommandBus::reply(CommandBus::Reply::MACRO_STEP_DONE, (uint32_t)(currentStep + 1), delay);
 
                 if (delay > 0)
                 {
@@ -129,7 +248,7 @@ namespace Sequencer
 
         case WAITING:
             // Espera o tempo de delay_ms do passo atual
-            unsigned long delayNeeded = runningMacro.steps[currentStep].delay_ms;
+            unsigned long delayNeeded = stepDelay;
             if (now - waitStartTime >= delayNeeded)
             {
                 // Tempo de espera concluído, avança para o próximo passo
@@ -138,30 +257,13 @@ namespace Sequencer
                 if (currentStep >= runningMacro.numSteps)
                 {
                     // Macro concluída
-                    Serial.print(F("Macro '"));
-                    Serial.print(runningMacro.name);
-                    Serial.println(F("' concluida."));
+                    CommandBus::replyNamed(CommandBus::Reply::MACRO_DONE, runningMacro.name);
                     currentState = IDLE;
                 }
                 else
                 {
                     // Inicia o próximo passo
-                    Serial.print(F("  Passo "));
-                    Serial.print(currentStep + 1);
-                    Serial.print(F(": Carregando pose '"));
-                    Serial.print(runningMacro.steps[currentStep].poseName);
-                    Serial.println(F("'..."));
-                    if (PoseManager::loadPoseByName(runningMacro.steps[currentStep].poseName))
-                    {
-                        currentState = MOVING;
-                    }
-                    else
-                    {
-                        Serial.print(F("ERRO: Pose '"));
-                        Serial.print(runningMacro.steps[currentStep].poseName);
-                        Serial.println(F("' nao encontrada. Abortando macro."));
-                        currentState = IDLE;
-                    }
+                    currentState = beginStep() ? MOVING : IDLE;
                 }
             }
             break;
@@ -11,14 +11,34 @@ namespace Sequencer {
 /**
  * @brief Inicializa e inicia a execução de uma macro pelo nome.
  * @param name Nome da macro a ser carregada e executada.
+ * @param spline true = passa pelas poses em uma trajetória spline contínua, parando
+ * apenas nos passos com espera (delay > 0) e no último passo.
  */
-void startMacro(const char* name);
+void startMacro(const char* name, bool spline = false);
 
 /**
- * @brief Para imediatamente a execução da macro atual.
+ * @brief Para a execução da macro atual e leva o braço ao repouso
+ * com a rampa de desaceleração do MotionController::stop().
  */
 void stopMacro();
 
+/**
+ * @brief Pausa a macro atual: congela o passo (movimento ou espera) e
+ * desacelera o braço até o repouso (MotionController::pause()).
+ */
+void pauseMacro();
+
+/**
+ * @brief Retoma a macro pausada exatamente no passo interrompido: o movimento
+ * continua até a mesma pose e a espera conta apenas o tempo que faltava.
+ */
+void resumeMacro();
+
+/**
+ * @brief Retorna se há uma macro pausada.
+ */
+bool isPaused();
+
 /**
  * @brief Retorna se o sequenciador está atualmente executando uma macro.
  */
@@ -0,0 +1,114 @@
+/**
+ * @file ServoOutput.cpp
+ * @brief Implementação do estágio de saída com cache por canal.
+ *
+ * As escritas normalmente vêm da task de movimento; o comando SET_OFFSET do CommandBus também
+ * reescreve um canal a partir do loop(). Os contadores são apenas estatísticas e não
+ * precisam de lock.
+ */
+#include "ServoOutput.h"
+#include "Platform.h"
+
+// Objetos de Hardware (definidos aqui, pois este módulo os controla)
+Servo servos[NUM_SERVOS];
+
+namespace ServoOutput
+{
+    static const int NO_PULSE = -1; // Canal sem valor conhecido (força a próxima escrita)
+    static const unsigned long RATE_WINDOW_MS = 1000;
+
+    static int lastPulseUs[NUM_SERVOS] = {NO_PULSE, NO_PULSE, NO_PULSE, NO_PULSE, NO_PULSE, NO_PULSE, NO_PULSE};
+
+    static volatile uint32_t statWrites = 0;
+    static volatile uint32_t statSkipped = 0;
+    static volatile uint32_t windowWrites = 0;
+    static volatile uint32_t lastWindowRate = 0;
+    static volatile unsigned long windowStart = 0;
+
+    /**
+     * @brief Fecha a janela de 1 s da taxa de escritas quando ela tiver passado.
+     * Uma janela longa sem nenhuma escrita conta como taxa zero.
+     */
+    static void rollRateWindow(unsigned long now)
+    {
+        const unsigned long elapsed = now - windowStart;
+        if (elapsed < RATE_WINDOW_MS)
+            return;
+        lastWindowRate = elapsed < 2 * RATE_WINDOW_MS ? windowWrites : 0;
+        windowWrites = 0;
+        windowStart = now;
+    }
+
+    void attach(int servoIdx)
+    {
+        servos[servoIdx].attach(ActiveArm::joint(servoIdx).pin, SERVO_PULSE_MIN_US[servoIdx], SERVO_PULSE_MAX_US[servoIdx]);
+        lastPulseUs[servoIdx] = NO_PULSE;
+    }
+
+    int angleToPulseUs(int servoIdx, float logicalAngle)
+    {
+        return physicalToPulseUs(servoIdx, logicalAngle + offsets[servoIdx]);
+    }
+
+    int physicalToPulseUs(int servoIdx, float physicalAngle)
+    {
+        float corrected = physicalAngle;
+        if (corrected < 0.0f)
+            corrected = 0.0f;
+        if (corrected > 180.0f)
+            corrected = 180.0f;
+        const float span = (float)(SERVO_PULSE_MAX_US[servoIdx] - SERVO_PULSE_MIN_US[servoIdx]);
+        return SERVO_PULSE_MIN_US[servoIdx] + (int)lroundf(corrected * span / 180.0f);
+    }
+
+    bool writeAngle(int servoIdx, float logicalAngle)
+    {
+        const int pulse = angleToPulseUs(servoIdx, logicalAngle);
+        rollRateWindow(millis());
+        if (pulse == lastPulseUs[servoIdx])
+        {
+            statSkipped++;
+            return false;
+        }
+        servos[servoIdx].writeMicroseconds(pulse);
+        lastPulseUs[servoIdx] = pulse;
+        statWrites++;
+        windowWrites++;
+        return true;
+    }
+
+    void invalidate(int servoIdx)
+    {
+        lastPulseUs[servoIdx] = NO_PULSE;
+    }
+
+    void getStats(Stats &stats)
+    {
+        rollRateWindow(millis());
+        stats.writes = statWrites;
+        stats.skipped = statSkipped;
+        stats.writesPerSecond = lastWindowRate;
+    }
+
+    void resetStats()
+    {
+        statWrites = 0;
+        statSkipped = 0;
+        windowWrites = 0;
+        lastWindowRate = 0;
+        windowStart = millis();
+    }
+
+    void printStats()
+    {
+        Stats stats;
+        getStats(stats);
+        Serial.print(F("Saida PWM: "));
+        Serial.print(stats.writesPerSecond);
+        Serial.print(F(" escritas/s | Total: "));
+        Serial.print(stats.writes);
+        Serial.print(F(" | Ignoradas (sem mudanca): "));
+        Serial.println(stats.skipped);
+    }
+
+} // namespace ServoOutput
@@ -0,0 +1,76 @@
+/**
+ * @file ServoOutput.h
+ * @brief Estágio de saída entre o motor de movimento e os objetos Servo.
+ * Guarda o último pulso emitido em cada canal e só escreve no periférico (LEDC)
+ * quando o valor muda, contando as escritas por segundo.
+ */
+#ifndef SERVO_OUTPUT_H
+#define SERVO_OUTPUT_H
+
+#include "Config.h"
+
+namespace ServoOutput
+{
+
+    /**
+     * @brief Anexa um servo ao seu pino com a faixa de pulso configurada e descarta o cache do canal.
+     * @param servoIdx Índice do servo.
+     */
+    void attach(int servoIdx);
+
+    /**
+     * @brief Converte um ângulo lógico no pulso do servo (µs), aplicando offset e
+     * a faixa SERVO_PULSE_MIN_US/SERVO_PULSE_MAX_US da junta.
+     * @param servoIdx Índice do servo.
+     * @param logicalAngle Ângulo lógico (graus, com fração).
+     * @return Largura de pulso em microssegundos.
+     */
+    int angleToPulseUs(int servoIdx, float logicalAngle);
+
+    /**
+     * @brief Converte um ângulo físico (offset já aplicado) no pulso do servo (µs).
+     * Usado pelo 'status' com o offset publicado (MotionController::getLimits).
+     */
+    int physicalToPulseUs(int servoIdx, float physicalAngle);
+
+    /**
+     * @brief Escreve o pulso correspondente ao ângulo lógico, se diferente do último emitido.
+     * @param servoIdx Índice do servo.
+     * @param logicalAngle Ângulo lógico (graus, com fração).
+     * @return true se o periférico foi escrito, false se o valor já estava no canal.
+     */
+    bool writeAngle(int servoIdx, float logicalAngle);
+
+    /**
+     * @brief Descarta o cache de um canal, forçando a próxima escrita.
+     */
+    void invalidate(int servoIdx);
+
+    /**
+     * @brief Estatísticas do estágio de saída.
+     */
+    struct Stats
+    {
+        uint32_t writes;          /**< Escritas efetivas no periférico desde o boot (ou reset). */
+        uint32_t skipped;         /**< Escritas evitadas porque o pulso não mudou. */
+        uint32_t writesPerSecond; /**< Escritas efetivas na última janela completa de 1 s. */
+    };
+
+    /**
+     * @brief Copia as estatísticas atuais.
+     */
+    void getStats(Stats &stats);
+
+    /**
+     * @brief Zera os contadores de escritas.
+     */
+    void resetStats();
+
+    /**
+     * @brief Exibe as estatísticas na Serial (usado pelo comando 'status').
+     */
+    void printStats();
+
+} // namespace ServoOutput
+
+#endif // SERVO_OUTPUT_H
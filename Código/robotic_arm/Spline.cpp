@@ -0,0 +1,90 @@
+/**
+ * @file Spline.cpp
+ * @brief Implementação do spline cúbico C2 (velocidades nos nós).
+ *
+ * Para um nó interior k, com trechos de duração h[k-1] (antes) e h[k] (depois), a
+ * continuidade da aceleração entre os dois trechos de Hermite exige:
+ *   h[k]·v[k-1] + 2·(h[k-1] + h[k])·v[k] + h[k-1]·v[k+1]
+ *       = 3·( h[k]·(p[k] - p[k-1]) / h[k-1] + h[k-1]·(p[k+1] - p[k]) / h[k] )
+ * com v[0] = v[n] = 0.
+ */
+#include "Spline.h"
+
+#include <math.h>
+
+namespace Spline
+{
+    void clampedVelocities(const float *points, int stride, const float *durations, int count,
+                           float *velocities, float *scratch)
+    {
+        velocities[0] = 0.0f;
+        velocities[(count - 1) * stride] = 0.0f;
+        if (count < 3)
+            return;
+
+        // Eliminação direta: scratch guarda o coeficiente superior normalizado (c'),
+        // e as velocidades recebem temporariamente o lado direito normalizado (d').
+        for (int k = 1; k < count - 1; k++)
+        {
+            const float hPrev = durations[k - 1];
+            const float hNext = durations[k];
+            const float lower = (k > 1) ? hNext : 0.0f; // v[0] = 0 sai do sistema
+            const float diag = 2.0f * (hPrev + hNext);
+            const float upper = (k < count - 2) ? hPrev : 0.0f; // v[n] = 0 sai do sistema
+            const float rhs = 3.0f * ((hNext * (points[k * stride] - points[(k - 1) * stride]) / hPrev) +
+                                      (hPrev * (points[(k + 1) * stride] - points[k * stride]) / hNext));
+
+            const float prevUpper = (k > 1) ? scratch[k - 1] : 0.0f;
+            const float prevRhs = (k > 1) ? velocities[(k - 1) * stride] : 0.0f;
+            const float denom = diag - lower * prevUpper;
+            scratch[k] = upper / denom;
+            velocities[k * stride] = (rhs - lower * prevRhs) / denom;
+        }
+
+        // Substituição reversa
+        for (int k = count - 3; k >= 1; k--)
+        {
+            velocities[k * stride] -= scratch[k] * velocities[(k + 1) * stride];
+        }
+    }
+
+    namespace
+    {
+        /**
+         * @brief Aceleração nos extremos do trecho, multiplicada pela duração (ela é linear entre eles).
+         */
+        void endAccelerations(float slope, float v0, float v1, float &atStart, float &atEnd)
+        {
+            atStart = (6.0f * slope) - (4.0f * v0) - (2.0f * v1);
+            atEnd = (-6.0f * slope) + (2.0f * v0) + (4.0f * v1);
+        }
+    }
+
+    float peakVelocity(float delta, float durationMs, float v0, float v1)
+    {
+        // Com s = t/h: v(s) = 6·(s - s²)·delta/h + v0·(3s² - 4s + 1) + v1·(3s² - 2s), uma parábola;
+        // além dos extremos, o máximo pode estar no vértice, onde a aceleração (linear) se anula
+        const float slope = delta / durationMs;
+        float peak = fabsf(v0) > fabsf(v1) ? fabsf(v0) : fabsf(v1);
+        float atStart, atEnd;
+        endAccelerations(slope, v0, v1, atStart, atEnd);
+        if ((atStart > 0.0f && atEnd < 0.0f) || (atStart < 0.0f && atEnd > 0.0f))
+        {
+            const float s = atStart / (atStart - atEnd);
+            const float vertex = fabsf((6.0f * (s - s * s) * slope) + (v0 * ((3.0f * s * s) - (4.0f * s) + 1.0f)) +
+                                       (v1 * ((3.0f * s * s) - (2.0f * s))));
+            peak = vertex > peak ? vertex : peak;
+        }
+        return peak;
+    }
+
+    float peakAcceleration(float delta, float durationMs, float v0, float v1)
+    {
+        float atStart, atEnd;
+        endAccelerations(delta / durationMs, v0, v1, atStart, atEnd);
+        atStart = fabsf(atStart) / durationMs;
+        atEnd = fabsf(atEnd) / durationMs;
+        return atStart > atEnd ? atStart : atEnd;
+    }
+
+} // namespace Spline
@@ -0,0 +1,48 @@
+/**
+ * @file Spline.h
+ * @brief Spline cúbico C2 no espaço das juntas (trajetórias por vários pontos de passagem).
+ *
+ * O spline é representado como uma sequência de segmentos cúbicos de Hermite: cada nó
+ * recebe uma velocidade tal que a aceleração também é contínua (C2). Os extremos partem e
+ * terminam em repouso (spline "clamped"). Módulo puro (sem dependências do Arduino).
+ */
+#ifndef SPLINE_H
+#define SPLINE_H
+
+namespace Spline
+{
+
+    /**
+     * @brief Calcula as velocidades nos nós de um spline cúbico C2 com velocidade zero nos extremos.
+     * Resolve o sistema tridiagonal da continuidade da aceleração (algoritmo de Thomas).
+     * @param points Posições dos nós (count valores, espaçados por 'stride').
+     * @param stride Distância entre nós consecutivos em 'points' e 'velocities' (ex: NUM_SERVOS).
+     * @param durations Duração de cada trecho (count - 1 valores, em ms, > 0).
+     * @param count Número de nós (>= 2).
+     * @param velocities [out] Velocidade em cada nó (unidade de points por ms), mesmo 'stride'.
+     * @param scratch Área de trabalho com pelo menos count floats.
+     */
+    void clampedVelocities(const float *points, int stride, const float *durations, int count,
+                           float *velocities, float *scratch);
+
+    /**
+     * @brief Maior velocidade de um trecho de Hermite (exata: a velocidade é uma parábola no tempo,
+     * então o máximo está em um dos extremos ou no vértice, onde a aceleração se anula).
+     * @param delta Deslocamento do trecho.
+     * @param durationMs Duração do trecho (ms).
+     * @param v0 Velocidade inicial (por ms).
+     * @param v1 Velocidade final (por ms).
+     * @return |velocidade| máxima (por ms).
+     */
+    float peakVelocity(float delta, float durationMs, float v0, float v1);
+
+    /**
+     * @brief Maior aceleração de um trecho de Hermite (exata: a aceleração de uma cúbica é
+     * linear no tempo, então o máximo está em um dos extremos).
+     * @return |aceleração| máxima (por ms²).
+     */
+    float peakAcceleration(float delta, float durationMs, float v0, float v1);
+
+} // namespace Spline
+
+#endif // SPLINE_H
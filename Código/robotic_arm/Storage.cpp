@@ -1,131 +1,491 @@
 /**
  * @file Storage.cpp
- * @brief Implementação da lógica de persistência (EEPROM).
+ * @brief Implementação da lógica de persistência (log na flash; EEPROM legada só na importação).
  */
 #include "Storage.h"
-#include "MotionController.h" // Para iniciar o movimento ao carregar
+#include "LogStore.h"
+#include "MacroManager.h"
+#include "CommandBus.h"
+#include "MotionController.h" // Snapshot e calibração publicados pelo core de movimento
+#include "Perf.h"
+#include "PoseManager.h"
+#include "Sequencer.h"
 
 // As variáveis globais (currentAngles, minAngles, etc.) são definidas em MotionController.cpp
 // e declaradas 'extern' em Config.h, portanto, estão disponíveis aqui.
 
 namespace Storage {
 
+// --- Estado salvo (cópia em RAM do último registro de configuração) ---
+static StoredDataV2 stored;
+static bool storedValid = false;
+static bool wasIdle = true;                                 // Para detectar o fim de cada movimento
+
+// --- Commits adiados (escritos e lidos só pelo core de comunicação) ---
+static uint8_t dirtyRegions = 0;                            // Máscara de Region
+static uint32_t pendingEdits = 0;                           // markDirty() desde o último commit
+static unsigned long lastEditMs = 0;
+static unsigned long quietCommitMs = STORAGE_QUIET_COMMIT_MS;
+static uint32_t commitCount = 0;
+static uint32_t coalescedEdits = 0;                         // Edições gravadas pelos commits acima
+static unsigned long lastCommitUs = 0;
+static unsigned long maxCommitUs = 0;
+static unsigned long totalCommitUs = 0;
+
 /**
- * @brief Migra dados V1 para V2 (compatibilidade com versão anterior).
+ * @brief Completa o cabeçalho e o CRC de 'stored' depois de uma alteração.
  */
-bool migrateToV2() {
-    StoredData oldData;
-    EEPROM.get(0, oldData);
-    
-    if (oldData.magic != EEPROM_MAGIC) {
-        return false;  // Sem dados para migrar
+static void sealStored() {
+    stored.magic = EEPROM_MAGIC;
+    stored.version = 2;
+    stored.crc16 = calcCRC16((uint8_t*)&stored, sizeof(stored) - 2);
+}
+
+/**
+ * @brief Espaço no log dos registros que um commit gravaria (all = snapshot completo).
+ */
+static uint32_t logBytes(bool all) {
+    uint32_t bytes = PoseManager::logBytes(all) + MacroManager::logBytes(all);
+    if (all ? storedValid : (dirtyRegions & REGION_CONFIG) != 0) {
+        bytes += LogStore::recordSize(sizeof(stored));
+    } else if (dirtyRegions & REGION_POSITION) {
+        bytes += LogStore::recordSize(sizeof(stored.current));
     }
-    
-    Serial.println(F("Migrando EEPROM V1 -> V2..."));
-    
-    // Converte para novo formato
-    StoredDataV2 newData;
-    newData.magic = EEPROM_MAGIC;
-    newData.version = 2;
-    
-    for (int i = 0; i < NUM_SERVOS; i++) {
-        newData.current[i] = (uint8_t)constrain(oldData.current[i], 0, 180);
-        newData.minv[i] = (uint8_t)constrain(oldData.minv[i], 0, 180);
-        newData.maxv[i] = (uint8_t)constrain(oldData.maxv[i], 0, 180);
-        newData.offs[i] = (int8_t)constrain(oldData.offs[i], -127, 127);
+    return bytes;
+}
+
+/**
+ * @brief Snapshot completo: configuração, todos os slots ocupados e o marcador de fim.
+ */
+static bool writeSnapshot() {
+    return LogStore::beginSnapshot() &&
+           (!storedValid || LogStore::append(LOG_RECORD_CONFIG, 0, &stored, sizeof(stored))) &&
+           PoseManager::flush(true) && MacroManager::flush(true) &&
+           LogStore::endSnapshot();
+}
+
+/**
+ * @brief Registros avulsos das regiões sujas (a posição já vai junto com a configuração).
+ */
+static bool writeChanges() {
+    if (dirtyRegions & REGION_CONFIG) {
+        if (!LogStore::append(LOG_RECORD_CONFIG, 0, &stored, sizeof(stored))) return false;
+    } else if (dirtyRegions & REGION_POSITION) {
+        if (!LogStore::append(LOG_RECORD_POSITION, 0, stored.current, sizeof(stored.current))) return false;
     }
-    
-    // Calcula CRC
-    newData.crc16 = calcCRC16((uint8_t*)&newData, sizeof(newData) - 2);
-    
-    // Salva novo formato
-    EEPROM.put(0, newData);
-    EEPROM.commit();
-    
-    Serial.println(F("Migracao completa!"));
-    return true;
+    // Os passos das macros guardam o id da pose: a ordem entre poses e macros não importa
+    return PoseManager::flush(false) && MacroManager::flush(false);
 }
 
-void saveToEEPROM() {
-    StoredDataV2 sd;
-    sd.magic = EEPROM_MAGIC;
-    sd.version = 2;
-    
-    for (int i = 0; i < NUM_SERVOS; i++) {
-        sd.current[i] = (uint8_t)constrain(currentAngles[i], 0, 180);
-        sd.minv[i] = (uint8_t)constrain(minAngles[i], 0, 180);
-        sd.maxv[i] = (uint8_t)constrain(maxAngles[i], 0, 180);
-        sd.offs[i] = (int8_t)constrain(offsets[i], -127, 127);
+/**
+ * @brief Aplica um registro do log durante o replay do boot.
+ */
+static void applyRecord(uint8_t type, uint16_t id, const uint8_t *data, uint16_t length,
+                        const LogStore::RecordRef &ref) {
+    switch (type) {
+    case LOG_RECORD_CONFIG:
+        if (length == sizeof(stored)) {
+            memcpy(&stored, data, sizeof(stored));
+            storedValid = stored.magic == EEPROM_MAGIC && stored.version == 2;
+        }
+        break;
+    case LOG_RECORD_POSITION:
+        if (length == sizeof(stored.current) && storedValid) {
+            memcpy(stored.current, data, sizeof(stored.current));
+            sealStored();
+        }
+        break;
+    case LOG_RECORD_POSE:
+    case LOG_RECORD_POSE_LAST_ID:
+        PoseManager::applyRecord(type, id, data, length);
+        break;
+    case LOG_RECORD_MACRO:
+        MacroManager::applyRecord(id, length, ref); // Pode vir fragmentado (data == NULL)
+        break;
+    default:
+        break; // Tipo desconhecido (firmware mais novo): ignorado
     }
-    
-    // Calcula CRC (exclui o próprio campo CRC)
-    sd.crc16 = calcCRC16((uint8_t*)&sd, sizeof(sd) - 2);
-    
-    EEPROM.put(0, sd);
-    if (EEPROM.commit()) {
-        Serial.println(F("EEPROM V2 salva com sucesso (35B)"));
+}
+
+bool commit() {
+    PERF_SCOPE(Perf::STORAGE_COMMIT);
+    if (!LogStore::available()) {
+        return false;
+    }
+    const unsigned long startUs = micros();
+    // Anel quase cheio: o snapshot grava tudo e libera os setores anteriores a ele
+    const bool ok = LogStore::needsCompaction(logBytes(true), logBytes(false)) ? writeSnapshot() : writeChanges();
+    lastCommitUs = micros() - startUs;
+    maxCommitUs = max(maxCommitUs, lastCommitUs);
+    totalCommitUs += lastCommitUs;
+    commitCount++;
+    if (ok) {
+        coalescedEdits += pendingEdits;
+        pendingEdits = 0;
+        dirtyRegions = 0;
+    }
+    return ok;
+}
+
+void markDirty(uint8_t regions) {
+    dirtyRegions |= regions;
+    pendingEdits++;
+    lastEditMs = millis();
+}
+
+bool isDirty() {
+    return dirtyRegions != 0;
+}
+
+void setQuietTime(unsigned long ms) {
+    quietCommitMs = ms;
+}
+
+void service() {
+    MotionController::Snapshot snap;
+    MotionController::getSnapshot(snap);
+    const bool idle = !snap.moving && !Sequencer::isRunning();
+#if STORAGE_SAVE_POSITION_ON_STOP
+    if (idle && !wasIdle && storedValid) {
+        // Fim de um movimento: a última posição vira um registro de 16 B (só se mudou)
+        bool changed = false;
+        for (int i = 0; i < NUM_SERVOS; i++) {
+            const uint8_t angle = (uint8_t)constrain((int)lroundf(snap.angles[i]), 0, 180);
+            changed |= stored.current[i] != angle;
+            stored.current[i] = angle;
+        }
+        if (changed) {
+            sealStored();
+            markDirty(REGION_POSITION);
+        }
+    }
+#endif
+    wasIdle = idle;
+
+    if (dirtyRegions == 0 || !LogStore::available()) {
+        return;
+    }
+    // Com o braço em movimento não grava: o commit desliga o cache da flash nos dois cores e o tick
+    // de movimento (fora da IRAM) ficaria parado até ele terminar
+    if (snap.moving) {
+        return;
+    }
+    const unsigned long quietMs = millis() - lastEditMs;
+    if ((idle && quietMs >= STORAGE_IDLE_COMMIT_MS) || quietMs >= quietCommitMs) {
+        if (!commit()) {
+            Serial.println(F("ERRO ao gravar o log da flash! Nova tentativa apos o tempo sem edicoes."));
+            lastEditMs = millis();
+        }
+    }
+}
+
+SyncResult sync() {
+    if (dirtyRegions == 0) {
+        return SYNC_DONE;
+    }
+    MotionController::Snapshot snap;
+    MotionController::getSnapshot(snap);
+    if (snap.moving) {
+        return SYNC_DEFERRED;
+    }
+    return commit() ? SYNC_DONE : SYNC_FAILED;
+}
+
+bool hasRoom(uint32_t bytes) {
+    return !LogStore::available() || logBytes(true) + bytes <= LogStore::capacity();
+}
+
+void printLibrarySpace() {
+    if (!LogStore::available()) {
+        Serial.println(F(" Flash: log indisponivel (poses so em RAM, macros nao podem ser salvas)."));
+        return;
+    }
+    const uint32_t used = logBytes(true);
+    const uint32_t capacity = LogStore::capacity();
+    Serial.print(F(" Flash: "));
+    Serial.print(used);
+    Serial.print(F(" B usados de "));
+    Serial.print(capacity);
+    Serial.print(F(" B ("));
+    Serial.print(used < capacity ? capacity - used : 0);
+    Serial.println(F(" B livres para poses e macros)."));
+}
+
+void printCommitStats() {
+    Serial.print(F("Armazenamento: "));
+    if (dirtyRegions == 0) {
+        Serial.println(F("nada pendente."));
     } else {
-        Serial.println(F("ERRO ao salvar EEPROM!"));
+        Serial.print(F("pendente ["));
+        if (dirtyRegions & REGION_CONFIG) Serial.print(F(" config"));
+        if (dirtyRegions & REGION_POSITION) Serial.print(F(" posicao"));
+        if (dirtyRegions & REGION_POSES) Serial.print(F(" poses"));
+        if (dirtyRegions & REGION_MACROS) Serial.print(F(" macros"));
+        Serial.print(F(" ], "));
+        Serial.print(pendingEdits);
+        Serial.print(F(" edicoes, ultima ha "));
+        Serial.print(millis() - lastEditMs);
+        Serial.println(F(" ms."));
     }
+    Serial.print(F(" Commits: "));
+    Serial.print(commitCount);
+    Serial.print(F(" ("));
+    Serial.print(coalescedEdits);
+    Serial.print(F(" edicoes) | latencia ultima/media/max: "));
+    Serial.print(lastCommitUs);
+    Serial.print(F("/"));
+    Serial.print(commitCount > 0 ? totalCommitUs / commitCount : 0);
+    Serial.print(F("/"));
+    Serial.print(maxCommitUs);
+    Serial.print(F(" us | grava apos "));
+    Serial.print(STORAGE_IDLE_COMMIT_MS);
+    Serial.print(F(" ms parado ou "));
+    Serial.print(quietCommitMs);
+    Serial.println(F(" ms sem edicoes."));
+    printLibrarySpace();
+    LogStore::printStats();
 }
 
-bool loadFromEEPROM(bool move) {
+/**
+ * @brief Lê a calibração da EEPROM legada (V1 convertida para V2) para 'stored'.
+ */
+static bool importConfig() {
     StoredDataV2 sd;
     EEPROM.get(0, sd);
-    
-    // Validação 1: Magic number
     if (sd.magic != EEPROM_MAGIC) {
-        Serial.println(F("EEPROM vazia ou corrompida"));
-        return false;
+        return false; // EEPROM vazia
     }
-    
-    // Validação 2: Versão
+
     if (sd.version == 1 || sd.version == 0) {
-        // Dados V1 detectados, tentar migrar
-        Serial.println(F("Versao V1 detectada"));
-        if (migrateToV2()) {
-            return loadFromEEPROM(move);  // Tenta novamente após migração
+        // Dados V1: converte para o formato V2
+        StoredData oldData;
+        EEPROM.get(0, oldData);
+        for (int i = 0; i < NUM_SERVOS; i++) {
+            stored.current[i] = (uint8_t)constrain(oldData.current[i], 0, 180);
+            stored.minv[i] = (uint8_t)constrain(oldData.minv[i], 0, 180);
+            stored.maxv[i] = (uint8_t)constrain(oldData.maxv[i], 0, 180);
+            stored.offs[i] = (int8_t)constrain(oldData.offs[i], -127, 127);
         }
+        sealStored();
+        Serial.println(F("Calibracao V1 importada da EEPROM."));
+        return storedValid = true;
+    }
+
+    if (sd.version != 2 || calcCRC16((uint8_t*)&sd, sizeof(sd) - 2) != sd.crc16) {
+        Serial.println(F("AVISO: calibracao da EEPROM invalida (versao ou CRC). Ignorada."));
         return false;
     }
+    stored = sd;
+    Serial.println(F("Calibracao V2 importada da EEPROM."));
+    return storedValid = true;
+}
+
+void saveState() {
+    // Posição e calibração pelas cópias publicadas pelo core de movimento (o save roda no core de comunicação)
+    MotionController::Snapshot snap;
+    MotionController::getSnapshot(snap);
+    MotionController::Limits limits;
+    MotionController::getLimits(limits);
     
-    if (sd.version != 2) {
-        Serial.print(F("Versao desconhecida: "));
-        Serial.println(sd.version);
-        return false;
+    for (int i = 0; i < NUM_SERVOS; i++) {
+        stored.current[i] = (uint8_t)constrain((int)lroundf(snap.angles[i]), 0, 180);
+        stored.minv[i] = (uint8_t)constrain(limits.minAngles[i], 0, 180);
+        stored.maxv[i] = (uint8_t)constrain(limits.maxAngles[i], 0, 180);
+        stored.offs[i] = (int8_t)constrain(limits.offsets[i], -127, 127);
     }
     
-    // Validação 3: CRC
-    uint16_t calculatedCRC = calcCRC16((uint8_t*)&sd, sizeof(sd) - 2);
-    if (calculatedCRC != sd.crc16) {
-        Serial.println(F("ERRO: CRC invalido! Dados corrompidos!"));
-        Serial.print(F("Calculado: 0x"));
-        Serial.print(calculatedCRC, HEX);
-        Serial.print(F(" | Salvo: 0x"));
-        Serial.println(sd.crc16, HEX);
+    // Calcula CRC (exclui o próprio campo CRC)
+    sealStored();
+    storedValid = true;
+    markDirty(REGION_CONFIG);
+    Serial.println(F("Estado salvo (35B, gravacao adiada)"));
+}
+
+bool loadState(bool move) {
+    if (!storedValid) {
+        Serial.println(F("Nenhum estado salvo."));
         return false;
     }
+    const StoredDataV2 sd = stored;
     
-    // Dados válidos, carrega
+    int loadedMin[NUM_SERVOS], loadedMax[NUM_SERVOS], loadedOffsets[NUM_SERVOS];
     int initialAngles[NUM_SERVOS];
     for (int i = 0; i < NUM_SERVOS; i++) {
-        minAngles[i] = constrain(sd.minv[i], 0, 180);
-        maxAngles[i] = constrain(sd.maxv[i], minAngles[i], 180);
-        offsets[i] = constrain(sd.offs[i], -127, 127);
-        initialAngles[i] = constrain(sd.current[i], minAngles[i], maxAngles[i]);
+        loadedMin[i] = constrain(sd.minv[i], 0, 180);
+        loadedMax[i] = constrain(sd.maxv[i], loadedMin[i], 180);
+        loadedOffsets[i] = constrain(sd.offs[i], -127, 127);
+        initialAngles[i] = constrain(sd.current[i], loadedMin[i], loadedMax[i]);
     }
 
     if (move) {
-        Serial.println(F("EEPROM V2 carregada. Movendo..."));
-        unsigned long autoDuration = MotionController::calculateDurationBySpeed(initialAngles);
-        MotionController::startSmoothMove(initialAngles, autoDuration);
+        // Core de comunicação: a calibração e o movimento vão pelo CommandBus ao core de
+        // movimento, único escritor dos limites (os quatro comandos entram juntos ou nenhum)
+        if (!CommandBus::hasRoom(4)) {
+            Serial.println(F("ERRO: fila de comandos cheia; estado nao carregado."));
+            return false;
+        }
+        CommandBus::Command setMin = CommandBus::make(CommandBus::SET_MIN);
+        CommandBus::Command setMax = CommandBus::make(CommandBus::SET_MAX);
+        CommandBus::Command setOffset = CommandBus::make(CommandBus::SET_OFFSET);
+        CommandBus::Command moveTo = CommandBus::make(CommandBus::MOVE);
+        setMin.arg = setMax.arg = setOffset.arg = moveTo.arg = CommandBus::ALL_JOINTS;
+        for (int i = 0; i < NUM_SERVOS; i++) {
+            setMin.angles[i] = (float)loadedMin[i];
+            setMax.angles[i] = (float)loadedMax[i];
+            setOffset.angles[i] = (float)loadedOffsets[i];
+            moveTo.angles[i] = (float)initialAngles[i];
+        }
+        CommandBus::post(setMin);
+        CommandBus::post(setMax);
+        CommandBus::post(setOffset);
+        CommandBus::post(moveTo); // Duração 0: calculada pela velocidade no core de movimento
+        Serial.println(F("Estado carregado. Movendo..."));
     } else {
+        // Boot: roda antes do tick e da task de comunicação, então escreve direto
+        for (int i = 0; i < NUM_SERVOS; i++) {
+            minAngles[i] = loadedMin[i];
+            maxAngles[i] = loadedMax[i];
+            offsets[i] = loadedOffsets[i];
+        }
+        MotionController::publishLimits();
         for (int i = 0; i < NUM_SERVOS; i++) {
             currentAngles[i] = initialAngles[i];
         }
-        Serial.println(F("EEPROM V2 carregada (sem movimento)."));
+        Serial.println(F("Estado carregado (sem movimento)."));
     }
     return true;
 }
 
+/**
+ * @brief Nome V1 válido: só caracteres visíveis (sscanf %s) e terminado em nulo dentro do campo.
+ * Slots nunca gravados (0x00 ou 0xFF) não passam.
+ */
+static bool isV1Name(const char name[POSE_NAME_LEN]) {
+    if (name[0] == '\0') {
+        return false;
+    }
+    for (int i = 0; i < POSE_NAME_LEN; i++) {
+        if (name[i] == '\0') {
+            return true;
+        }
+        if (name[i] < 0x21 || name[i] > 0x7E) {
+            return false;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Importa poses V1 da EEPROM legada para os slots em RAM (mesmos índices) e grava as macros V1
+ * no log (dentro do snapshot inicial).
+ * @return false se o log recusar uma macro.
+ */
+static bool importLibraryV1() {
+    int poseCount = 0;
+    int macroCount = 0;
+
+    for (int i = 0; i < MAX_POSES_V1; i++) {
+        Pose p;
+        EEPROM.get(POSES_START + i * sizeof(Pose), p);
+        if (!isV1Name(p.name)) {
+            continue;
+        }
+        uint8_t angles[NUM_SERVOS];
+        for (int j = 0; j < NUM_SERVOS; j++) {
+            angles[j] = (uint8_t)constrain(p.angles[j], 0, 180);
+        }
+        PoseManager::writeSlot(i, p.name, angles);
+        poseCount++;
+    }
+
+    for (int i = 0; i < MAX_MACROS_V1 && LogStore::available(); i++) {
+        Macro m;
+        EEPROM.get(MACROS_START + i * sizeof(Macro), m);
+        if (!isV1Name(m.name) || m.numSteps < 0 || m.numSteps > MAX_STEPS_PER_MACRO_V2) {
+            continue;
+        }
+        MacroStepRecord steps[MAX_STEPS_PER_MACRO_V2];
+        for (int s = 0; s < m.numSteps; s++) {
+            // Os passos V1 guardavam o nome; agora guardam o id da pose (as V1 já estão nos slots)
+            char poseName[POSE_NAME_LEN];
+            memcpy(poseName, m.steps[s].poseName, POSE_NAME_LEN);
+            poseName[POSE_NAME_LEN - 1] = '\0';
+            steps[s].poseId = PoseManager::findId(poseName);
+            steps[s].delay_ms = (uint16_t)min(m.steps[s].delay_ms, MACRO_MAX_DELAY_MS);
+        }
+        if (!MacroManager::importMacro(i, m.name, steps, m.numSteps)) {
+            return false;
+        }
+        macroCount++;
+    }
+
+    if (poseCount > 0 || macroCount > 0) {
+        Serial.print(F("Poses/macros V1 importadas da EEPROM: "));
+        Serial.print(poseCount);
+        Serial.print(F(" poses, "));
+        Serial.print(macroCount);
+        Serial.println(F(" macros."));
+    }
+    return true;
+}
+
+/**
+ * @brief Importa a biblioteca da EEPROM legada: slots V2 se o cabeçalho for válido, senão V1.
+ * As poses vão para os slots em RAM; as macros, que só existem no log, são gravadas direto nele
+ * (sem o log elas não são importadas).
+ * @return false se o log recusar uma macro.
+ */
+static bool importLibrary() {
+    if (!LogStore::available()) {
+        Serial.println(F("AVISO: sem o log da flash as macros da EEPROM nao sao importadas."));
+    }
+    LibraryHeaderV2 header;
+    EEPROM.get(LIBRARY_START_V2, header);
+    if (header.magic != LIBRARY_MAGIC) {
+        return importLibraryV1();
+    } else if (calcCRC16((uint8_t*)&header, sizeof(header) - 2) != header.crc16 || header.version != 2 ||
+               header.poseCapacity != MAX_POSES_V2 || header.macroCapacity != MAX_MACROS_V2) {
+        // Outro layout: os slots não estariam nos endereços esperados
+        Serial.println(F("AVISO: biblioteca de poses/macros da EEPROM incompativel. Nao importada."));
+    } else {
+        const int poses = PoseManager::importEeprom();
+        const int macros = LogStore::available() ? MacroManager::importEeprom() : 0;
+        Serial.print(F("Poses/macros V2 importadas da EEPROM: "));
+        Serial.print(poses);
+        Serial.print(F(" poses, "));
+        Serial.print(macros);
+        Serial.println(F(" macros."));
+    }
+    return true;
+}
+
+bool begin() {
+    storedValid = false;
+    dirtyRegions = 0;
+    pendingEdits = 0;
+    PoseManager::reset();
+    MacroManager::reset();
+
+    bool fromLog = false;
+    if (!LogStore::begin()) {
+        Serial.println(F("ERRO: log da flash indisponivel. Dados da EEPROM legada so em RAM."));
+        importConfig();
+        importLibrary();
+    } else if (LogStore::hasSnapshot()) {
+        LogStore::replay(applyRecord);
+        fromLog = true;
+    } else {
+        // Log vazio (primeiro boot com o log): importa a EEPROM uma única vez. As macros importadas
+        // entram no snapshot assim que são lidas; as poses vão depois, com os ids já atribuídos.
+        LogStore::format();
+        importConfig();
+        if (!LogStore::beginSnapshot() ||
+            (storedValid && !LogStore::append(LOG_RECORD_CONFIG, 0, &stored, sizeof(stored))) ||
+            !importLibrary() || !PoseManager::flush(true) || !LogStore::endSnapshot()) {
+            Serial.println(F("ERRO ao gravar o snapshot inicial no log da flash!"));
+        }
+    }
+    return fromLog;
+}
+
 } // namespace Storage
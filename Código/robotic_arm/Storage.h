@@ -1,7 +1,10 @@
 /**
  * @file Storage.h
- * @brief Define a interface do módulo de persistência (EEPROM).
- * Salva e carrega o estado de calibração e a última posição.
+ * @brief Define a interface do módulo de persistência (log na flash, LogStore).
+ * Salva e carrega o estado de calibração e a última posição, e coordena a gravação das poses e macros.
+ * O estado vive em RAM; os saves marcam regiões sujas e service() grava só o que mudou (um registro
+ * por slot) em um único commit quando o braço para ou depois de um tempo sem edições.
+ * A EEPROM antiga (V1/V2) só é lida uma vez, para importar os dados para o log.
  */
 #ifndef STORAGE_H
 #define STORAGE_H
@@ -12,17 +15,101 @@ namespace Storage
 {
 
     /**
-     * @brief Salva o estado atual (calibração e posição) na EEPROM.
+     * @brief Regiões alteradas desde o último commit (máscara de bits).
      */
-    void saveToEEPROM();
+    enum Region : uint8_t
+    {
+        REGION_CONFIG = 0x01,  /**< StoredDataV2: calibração e última posição. */
+        REGION_POSES = 0x02,   /**< Slots de pose alterados. */
+        REGION_MACROS = 0x04,  /**< Slots de macro alterados. */
+        REGION_POSITION = 0x08 /**< Só a última posição (fim de movimento). */
+    };
 
     /**
-     * @brief Carrega o estado da EEPROM.
-     * @param move Se true, move suavemente para a posição salva.
-     * Se false, apenas define os valores sem mover.
-     * @return true se dados válidos foram carregados, false caso contrário.
+     * @brief Restaura o estado no boot: replay do último snapshot do log, ou, com o log vazio,
+     * importação da EEPROM legada (calibração V1/V2, poses e macros V1/V2) dentro de um snapshot.
+     * Chamar depois de EEPROM.begin() e antes de loadState().
+     * @return true se o estado veio do log da flash.
      */
-    bool loadFromEEPROM(bool move);
+    bool begin();
+
+    /**
+     * @brief Salva o estado atual (calibração e posição) em RAM (gravação adiada).
+     */
+    void saveState();
+
+    /**
+     * @brief Aplica o estado salvo (calibração e posição).
+     * @param move Se true (comando 'load', core de comunicação), publica a calibração e o
+     * movimento até a posição salva no CommandBus. Se false (boot, antes do tick), apenas
+     * define os valores sem mover.
+     * @return true se havia um estado válido, false caso contrário.
+     */
+    bool loadState(bool move);
+
+    /**
+     * @brief Grava agora as regiões sujas no log (único ponto de gravação; medido pela sonda
+     * STORAGE_COMMIT e pelas estatísticas do 'sync'). Quando o anel de setores está quase cheio,
+     * grava um snapshot completo no lugar dos registros avulsos. Limpa as regiões sujas.
+     * @return true se a gravação foi bem-sucedida.
+     */
+    bool commit();
+
+    /**
+     * @brief Registra uma edição já feita em RAM; o commit fica para service().
+     * @param regions Regiões alteradas (Region, combináveis com |).
+     */
+    void markDirty(uint8_t regions);
+
+    /**
+     * @brief Política de gravação, chamada a cada passada da comunicação: ao fim de cada movimento
+     * registra a posição (STORAGE_SAVE_POSITION_ON_STOP); faz o commit se o braço estiver parado há
+     * STORAGE_IDLE_COMMIT_MS sem edições, ou após o tempo sem edições de setQuietTime() se só a macro
+     * estiver em execução. Nunca grava com o braço em movimento: o commit trava o tick (cache desligado).
+     */
+    void service();
+
+    /**
+     * @brief Resultado de sync().
+     */
+    enum SyncResult : uint8_t
+    {
+        SYNC_DONE,     /**< Nada pendente, ou o commit foi bem-sucedido. */
+        SYNC_DEFERRED, /**< Braço em movimento: as edições ficam pendentes para service(). */
+        SYNC_FAILED    /**< O commit falhou; as edições continuam pendentes. */
+    };
+
+    /**
+     * @brief Grava agora as edições pendentes (comando 'sync'), só com o braço parado: como em
+     * service(), em movimento o commit travaria o tick.
+     */
+    SyncResult sync();
+
+    /**
+     * @brief Cabem mais 'bytes' de registros vivos no log (sempre true sem o log: nada é gravado).
+     */
+    bool hasRoom(uint32_t bytes);
+
+    /**
+     * @brief Exibe o espaço ocupado pelas poses e macros no log e quanto ainda cabe.
+     */
+    void printLibrarySpace();
+
+    /**
+     * @brief Há edições em RAM ainda não gravadas na flash.
+     */
+    bool isDirty();
+
+    /**
+     * @brief Tempo sem edições após o qual service() grava com uma macro em execução (braço parado).
+     */
+    void setQuietTime(unsigned long ms);
+
+    /**
+     * @brief Exibe as pendências, as estatísticas de commit (quantidade, edições agrupadas, latência)
+     * e as do log (LogStore::printStats).
+     */
+    void printCommitStats();
 
 } // namespace Storage
 
@@ -0,0 +1,437 @@
+/**
+ * @file Workspace.cpp
+ * @brief Implementação da grade de alcançabilidade do IK.
+ */
+#include "Workspace.h"
+#include "InverseKinematics.h"
+#include "FastMath.h"
+#include "Platform.h"
+
+#include <math.h>
+
+namespace
+{
+    // --- Grade (distância planar r, elevação e) ---
+    // r de 0 a maxReachMm; e de -maxReachMm a +maxReachMm em relação ao ombro.
+    constexpr float CELL = static_cast<float>(WORKSPACE_CELL_MM);
+    constexpr int COLS = static_cast<int>(ARM_KINEMATICS.maxReachMm / CELL + 0.999f) + 1;
+    constexpr int ROWS = 2 * (COLS - 1) + 1;
+    constexpr float ORIGIN_E = -(COLS - 1) * CELL;
+    constexpr float EPSILON = 1e-3f; // Mesmo limiar de solveXYZ
+
+    /**
+     * Ângulos lógicos (décimos de grau, sem os limites de software) de um nó.
+     */
+    struct Node
+    {
+        int16_t shoulder;
+        int16_t elbow;
+        int16_t wrist;
+    };
+
+    // --- Matemática constexpr (C++11: uma expressão por função, precisão de double) ---
+    constexpr double PI_D = 3.14159265358979323846;
+    constexpr double DEG_PER_RAD = 180.0 / PI_D;
+    constexpr float RAD_PER_DEG = static_cast<float>(PI_D / 180.0);
+
+    constexpr double cxSqrtIter(double x, double guess, int n)
+    {
+        return n == 0 ? guess : cxSqrtIter(x, 0.5 * (guess + x / guess), n - 1);
+    }
+
+    constexpr double cxSqrt(double x)
+    {
+        return x <= 0.0 ? 0.0 : cxSqrtIter(x, x > 1.0 ? x : 1.0, 30);
+    }
+
+    // Série de Taylor do atan, soma alternada: x - x³/3 + x⁵/5 - ...
+    constexpr double cxAtanSeries(double x2, double power, int k)
+    {
+        return k > 12 ? 0.0 : power / (2 * k + 1) - cxAtanSeries(x2, power * x2, k + 1);
+    }
+
+    // atan(x) = 2·atan(x / (1 + sqrt(1 + x²))): duas reduções levam |x| <= 1 a |x| < 0.2
+    constexpr double cxHalve(double x)
+    {
+        return x / (1.0 + cxSqrt(1.0 + x * x));
+    }
+
+    constexpr double cxAtanReduced(double h)
+    {
+        return 4.0 * cxAtanSeries(h * h, h, 0);
+    }
+
+    constexpr double cxAtan(double x)
+    {
+        return x > 1.0    ? PI_D / 2.0 - cxAtanReduced(cxHalve(cxHalve(1.0 / x)))
+               : x < -1.0 ? -PI_D / 2.0 - cxAtanReduced(cxHalve(cxHalve(1.0 / x)))
+                          : cxAtanReduced(cxHalve(cxHalve(x)));
+    }
+
+    constexpr double cxAtan2(double y, double x)
+    {
+        return x > 0.0   ? cxAtan(y / x)
+               : x < 0.0 ? (y >= 0.0 ? cxAtan(y / x) + PI_D : cxAtan(y / x) - PI_D)
+                         : (y > 0.0 ? PI_D / 2.0 : (y < 0.0 ? -PI_D / 2.0 : 0.0));
+    }
+
+    constexpr int16_t toDeci(double deg)
+    {
+        return static_cast<int16_t>(deg >= 0.0 ? deg * 10.0 + 0.5 : deg * 10.0 - 0.5);
+    }
+
+    // --- Mesmo modelo de InverseKinematics::solveXYZ, em etapas (cada uma recebe o que a anterior calculou) ---
+    constexpr double L1 = ARM_KINEMATICS.upperLenMm;
+    constexpr double L2 = ARM_KINEMATICS.forearmLenMm;
+    constexpr double WRIST_EXTENSION = ARM_KINEMATICS.wristOffsetMm + ARM_KINEMATICS.gripperLenMm;
+
+    constexpr Node nodeFromJoints(double shoulder, double elbow, double pitch)
+    {
+        return Node{toDeci(shoulder * DEG_PER_RAD + IK_NEUTRAL.shoulder), toDeci(elbow * DEG_PER_RAD + IK_NEUTRAL.elbow),
+                    toDeci((pitch - (shoulder + elbow)) * DEG_PER_RAD + IK_NEUTRAL.hand)};
+    }
+
+    // Cotovelo todo dobrado: solveXYZ cai no ramo -PI do atan2 (ver solveBatch)
+    constexpr Node nodeFromElbow(double effPlanar, double effElevation, double cosElbow, double sinElbow, double pitch)
+    {
+        return nodeFromJoints(cxAtan2(effElevation, effPlanar) -
+                                  cxAtan2(cosElbow > -1.0 ? L2 * sinElbow : -1e-30, L1 + L2 * cosElbow),
+                              cxAtan2(sinElbow, cosElbow), pitch);
+    }
+
+    constexpr double clampUnit(double c)
+    {
+        return c < -1.0 ? -1.0 : (c > 1.0 ? 1.0 : c);
+    }
+
+    constexpr Node nodeFromCos(double effPlanar, double effElevation, double cosElbow, double pitch)
+    {
+        return nodeFromElbow(effPlanar, effElevation, cosElbow, cxSqrt(1.0 - cosElbow * cosElbow), pitch);
+    }
+
+    constexpr Node nodeFromEffective(double effPlanar, double effElevation, double pitch)
+    {
+        return nodeFromCos(effPlanar, effElevation,
+                           clampUnit((effPlanar * effPlanar + effElevation * effElevation - L1 * L1 - L2 * L2) /
+                                     (2.0 * L1 * L2)),
+                           pitch);
+    }
+
+    constexpr double clippedDistance(double d)
+    {
+        return d < ARM_KINEMATICS.minReachMm   ? ARM_KINEMATICS.minReachMm
+               : d > ARM_KINEMATICS.maxReachMm ? ARM_KINEMATICS.maxReachMm
+                                               : d;
+    }
+
+    constexpr double atLeast(double value, double minimum)
+    {
+        return value < minimum ? minimum : value;
+    }
+
+    constexpr double wristDistance(double d)
+    {
+        return atLeast(atLeast(clippedDistance(d), WRIST_EXTENSION + 5.0) - WRIST_EXTENSION, 5.0);
+    }
+
+    constexpr Node nodeAt(double r, double e, double d)
+    {
+        return d < EPSILON ? Node{0, 0, 0}
+                           : nodeFromEffective(r * (wristDistance(d) / d), e * (wristDistance(d) / d), cxAtan2(e, r));
+    }
+
+    constexpr Node makeNode(int row, int col)
+    {
+        return nodeAt(col * static_cast<double>(CELL), ORIGIN_E + row * static_cast<double>(CELL),
+                      cxSqrt((col * static_cast<double>(CELL)) * (col * static_cast<double>(CELL)) +
+                             (ORIGIN_E + row * static_cast<double>(CELL)) * (ORIGIN_E + row * static_cast<double>(CELL))));
+    }
+
+    // --- Tabela gerada em tempo de compilação (C++11), uma linha de r por elevação ---
+    template <int... I>
+    struct IndexList
+    {
+    };
+
+    template <int N, int... I>
+    struct MakeIndexList : MakeIndexList<N - 1, N - 1, I...>
+    {
+    };
+
+    template <int... I>
+    struct MakeIndexList<0, I...>
+    {
+        typedef IndexList<I...> type;
+    };
+
+    struct Row
+    {
+        Node v[COLS];
+    };
+
+    struct Table
+    {
+        Row rows[ROWS];
+    };
+
+    template <int... C>
+    constexpr Row makeRow(int row, IndexList<C...>)
+    {
+        return Row{{makeNode(row, C)...}};
+    }
+
+    template <int... R>
+    constexpr Table makeTable(IndexList<R...>)
+    {
+        return Table{{makeRow(R, typename MakeIndexList<COLS>::type())...}};
+    }
+
+    constexpr Table TABLE = makeTable(MakeIndexList<ROWS>::type());
+
+    // Sobre o eixo vertical acima do ombro o braço aponta para cima: pitch = 90°
+    // (cada ângulo é arredondado ao décimo de grau, então a soma pode diferir em 1)
+    constexpr int TOP_PITCH_DECI = TABLE.rows[ROWS - 1].v[0].shoulder + TABLE.rows[ROWS - 1].v[0].elbow +
+                                   TABLE.rows[ROWS - 1].v[0].wrist -
+                                   (IK_NEUTRAL.shoulder + IK_NEUTRAL.elbow + IK_NEUTRAL.hand + 90) * 10;
+    static_assert(TOP_PITCH_DECI >= -1 && TOP_PITCH_DECI <= 1, "Tabela do Workspace diverge do modelo do IK");
+
+    // --- Estado em RAM (refeito por rebuild) ---
+    uint8_t reachable[(ROWS * COLS + 7) / 8]; // 1 bit por nó: IK_OK com os limites atuais
+    uint8_t nearby[(ROWS * COLS + 7) / 8];    // 1 bit por nó: ele ou um vizinho (3x3) é alcançável
+    float thetaLoCos = 0.0f;                  // Direções limite da base no plano XY (base e rotação do punho)
+    float thetaLoSin = 0.0f;
+    float thetaHiCos = 0.0f;
+    float thetaHiSin = 0.0f;
+    bool anyDirection = false;
+    int reachableNodes = 0;
+
+    inline bool testBit(const uint8_t *bits, int row, int col)
+    {
+        const int index = row * COLS + col;
+        return (bits[index >> 3] >> (index & 7)) & 1;
+    }
+
+    inline void setBit(uint8_t *bits, int row, int col)
+    {
+        const int index = row * COLS + col;
+        bits[index >> 3] |= (uint8_t)(1 << (index & 7));
+    }
+
+    inline int cornerCount(const uint8_t *bits, int row, int col)
+    {
+        return testBit(bits, row, col) + testBit(bits, row, col + 1) + testBit(bits, row + 1, col) +
+               testBit(bits, row + 1, col + 1);
+    }
+
+    /**
+     * A base (servo 0) e a rotação do punho (servo 5) dependem só da direção no plano XY.
+     */
+    inline bool directionAllowed(float x, float y)
+    {
+        return anyDirection && (thetaLoCos * y - thetaLoSin * x) >= 0.0f && (thetaHiSin * x - thetaHiCos * y) >= 0.0f;
+    }
+
+    inline float nodeValue(int16_t deci)
+    {
+        return deci * 0.1f;
+    }
+
+    /**
+     * Localiza a célula de (r, e). fx/fy recebem a posição dentro dela (0 a 1).
+     */
+    bool locate(float x, float y, float z, int &row, int &col, float &fx, float &fy)
+    {
+        const float gx = sqrtf(x * x + y * y) / CELL;
+        const float gy = (z - ARM_KINEMATICS.baseHeightMm - ORIGIN_E) / CELL;
+        if (!(gx >= 0.0f && gx <= COLS - 1 && gy >= 0.0f && gy <= ROWS - 1)) // Falso também para NaN
+            return false;
+        col = min(static_cast<int>(gx), COLS - 2);
+        row = min(static_cast<int>(gy), ROWS - 2);
+        fx = gx - col;
+        fy = gy - row;
+        return true;
+    }
+
+    float bilinear(int16_t a, int16_t b, int16_t c, int16_t d, float fx, float fy)
+    {
+        const float bottom = nodeValue(a) + (nodeValue(b) - nodeValue(a)) * fx;
+        const float top = nodeValue(c) + (nodeValue(d) - nodeValue(c)) * fx;
+        return bottom + (top - bottom) * fy;
+    }
+}
+
+namespace Workspace
+{
+    void rebuild()
+    {
+        // Ombro: os servos 1 e 2 recebem o mesmo ângulo, então valem os dois limites
+        const float shoulderLo = max(minAngles[1], minAngles[2]);
+        const float shoulderHi = min(maxAngles[1], maxAngles[2]);
+        const bool gripperOk = IK_NEUTRAL.gripper >= minAngles[6] && IK_NEUTRAL.gripper <= maxAngles[6];
+        const float minClip = ARM_KINEMATICS.wristOffsetMm + ARM_KINEMATICS.gripperLenMm + 5.0f;
+
+        memset(reachable, 0, sizeof(reachable));
+        reachableNodes = 0;
+        for (int row = 0; row < ROWS; row++)
+        {
+            const float e = ORIGIN_E + row * CELL;
+            for (int col = 0; col < COLS; col++)
+            {
+                const float r = col * CELL;
+                const float d = sqrtf(r * r + e * e);
+                const Node &n = TABLE.rows[row].v[col];
+                const bool ok = gripperOk && d >= EPSILON && d >= ARM_KINEMATICS.minReachMm &&
+                                d <= ARM_KINEMATICS.maxReachMm && d >= minClip &&
+                                nodeValue(n.shoulder) >= shoulderLo && nodeValue(n.shoulder) <= shoulderHi &&
+                                nodeValue(n.elbow) >= minAngles[3] && nodeValue(n.elbow) <= maxAngles[3] &&
+                                nodeValue(n.wrist) >= minAngles[4] && nodeValue(n.wrist) <= maxAngles[4];
+                if (ok)
+                {
+                    setBit(reachable, row, col);
+                    reachableNodes++;
+                }
+            }
+        }
+
+        // Faixas alcançáveis mais finas que uma célula passam entre os nós: só é OUTSIDE a célula
+        // cujas quinas não têm nenhum vizinho alcançável
+        memset(nearby, 0, sizeof(nearby));
+        for (int row = 0; row < ROWS; row++)
+            for (int col = 0; col < COLS; col++)
+                if (testBit(reachable, row, col))
+                    for (int dr = -1; dr <= 1; dr++)
+                        for (int dc = -1; dc <= 1; dc++)
+                            if (row + dr >= 0 && row + dr < ROWS && col + dc >= 0 && col + dc < COLS)
+                                setBit(nearby, row + dr, col + dc);
+
+        // Direções permitidas: base = theta + IK_NEUTRAL.base; rotação = theta + IK_NEUTRAL.wristRotate
+        const float thetaLo = max(minAngles[0] - IK_NEUTRAL.base, minAngles[5] - IK_NEUTRAL.wristRotate);
+        const float thetaHi = min(maxAngles[0] - IK_NEUTRAL.base, maxAngles[5] - IK_NEUTRAL.wristRotate);
+        anyDirection = thetaLo <= thetaHi;
+        thetaLoCos = cosf(thetaLo * RAD_PER_DEG);
+        thetaLoSin = sinf(thetaLo * RAD_PER_DEG);
+        thetaHiCos = cosf(thetaHi * RAD_PER_DEG);
+        thetaHiSin = sinf(thetaHi * RAD_PER_DEG);
+    }
+
+    Region classify(float x, float y, float z)
+    {
+        int row, col;
+        float fx, fy;
+        if (!directionAllowed(x, y) || !locate(x, y, z, row, col, fx, fy))
+            return OUTSIDE;
+        if (cornerCount(reachable, row, col) == 4)
+            return INSIDE;
+        return cornerCount(nearby, row, col) == 0 ? OUTSIDE : BOUNDARY;
+    }
+
+    bool seed(float x, float y, float z, float angles[NUM_SERVOS])
+    {
+        int row, col;
+        float fx, fy;
+        if (!locate(x, y, z, row, col, fx, fy))
+            return false;
+        const Node &a = TABLE.rows[row].v[col];
+        const Node &b = TABLE.rows[row].v[col + 1];
+        const Node &c = TABLE.rows[row + 1].v[col];
+        const Node &d = TABLE.rows[row + 1].v[col + 1];
+
+        const float baseDeg = KinMath::atan2(y, x) * static_cast<float>(DEG_PER_RAD) + IK_NEUTRAL.base;
+        angles[0] = baseDeg;
+        angles[1] = bilinear(a.shoulder, b.shoulder, c.shoulder, d.shoulder, fx, fy);
+        angles[2] = angles[1];
+        angles[3] = bilinear(a.elbow, b.elbow, c.elbow, d.elbow, fx, fy);
+        angles[4] = bilinear(a.wrist, b.wrist, c.wrist, d.wrist, fx, fy);
+        angles[5] = IK_NEUTRAL.wristRotate + (baseDeg - IK_NEUTRAL.base);
+        angles[6] = IK_NEUTRAL.gripper;
+        for (int i = 0; i < NUM_SERVOS; i++)
+            angles[i] = constrain(angles[i], (float)minAngles[i], (float)maxAngles[i]);
+        return true;
+    }
+
+    void printStatus()
+    {
+        Serial.println(F("\n--- Area de Trabalho (Workspace) ---"));
+        Serial.print(F("Grade: "));
+        Serial.print(COLS);
+        Serial.print(F(" x "));
+        Serial.print(ROWS);
+        Serial.print(F(" nos de "));
+        Serial.print(WORKSPACE_CELL_MM);
+        Serial.print(F(" mm (distancia planar x elevacao) | Alcancaveis: "));
+        Serial.print(reachableNodes);
+        Serial.print(F(" de "));
+        Serial.println(ROWS * COLS);
+        Serial.print(F("Memoria: tabela "));
+        Serial.print((unsigned long)sizeof(TABLE));
+        Serial.print(F(" B (flash, gerada na compilacao) | mapa "));
+        Serial.print((unsigned long)(sizeof(reachable) + sizeof(nearby)));
+        Serial.println(F(" B (RAM)"));
+
+        // Erros medidos no centro de cada célula, na direção central permitida, contra o IK completo
+        const float thetaMid = atan2f(thetaLoSin + thetaHiSin, thetaLoCos + thetaHiCos);
+        const float dirX = cosf(thetaMid);
+        const float dirY = sinf(thetaMid);
+        static float xs[COLS - 1]; // Estáticos: ~1.3 KB fora da pilha da task de comunicação
+        static float ys[COLS - 1];
+        static float zs[COLS - 1];
+        static float solved[NUM_SERVOS][COLS - 1];
+        static uint8_t status[COLS - 1];
+        float *joints[NUM_SERVOS];
+        for (int j = 0; j < NUM_SERVOS; j++)
+            joints[j] = solved[j];
+        float maxSeedError = 0.0f;
+        int inside = 0;
+        int boundary = 0;
+        int falseInside = 0;
+        int falseOutside = 0;
+        for (int row = 0; row < ROWS - 1; row++)
+        {
+            for (int col = 0; col < COLS - 1; col++)
+            {
+                const float r = (col + 0.5f) * CELL;
+                xs[col] = r * dirX;
+                ys[col] = r * dirY;
+                zs[col] = ARM_KINEMATICS.baseHeightMm + ORIGIN_E + (row + 0.5f) * CELL;
+            }
+            InverseKinematics::solveBatch(xs, ys, zs, COLS - 1, joints, status);
+            for (int col = 0; col < COLS - 1; col++)
+            {
+                const Region region = classify(xs[col], ys[col], zs[col]);
+                const bool exactOk = status[col] == InverseKinematics::IK_OK;
+                if (region == BOUNDARY)
+                {
+                    boundary++;
+                    continue;
+                }
+                if (region == OUTSIDE)
+                {
+                    falseOutside += exactOk ? 1 : 0;
+                    continue;
+                }
+                inside++;
+                if (!exactOk)
+                {
+                    falseInside++;
+                    continue;
+                }
+                float guess[NUM_SERVOS];
+                seed(xs[col], ys[col], zs[col], guess);
+                for (int i = 1; i <= 4; i++)
+                    maxSeedError = max(maxSeedError, fabsf(guess[i] - solved[i][col]));
+            }
+        }
+        Serial.print(F("Celulas: "));
+        Serial.print(inside);
+        Serial.print(F(" internas | "));
+        Serial.print(boundary);
+        Serial.println(F(" na borda (IK completo decide)"));
+        Serial.print(F("Erro (centro das celulas): semente max "));
+        Serial.print(maxSeedError, 2);
+        Serial.print(F("° | internas fora do IK: "));
+        Serial.print(falseInside);
+        Serial.print(F(" | externas alcancaveis: "));
+        Serial.println(falseOutside);
+    }
+
+} // namespace Workspace
@@ -0,0 +1,57 @@
+/**
+ * @file Workspace.h
+ * @brief Área de trabalho pré-calculada: alcançabilidade em O(1) e semente interpolada para o IK.
+ *
+ * O IK separa a base (ângulo no plano XY) do braço planar (distância planar r e elevação e).
+ * Uma grade sobre (r, e), com nós a cada WORKSPACE_CELL_MM, guarda os ângulos de ombro, cotovelo
+ * e punho do mesmo modelo de solveXYZ. A tabela é gerada em tempo de compilação a partir de
+ * ARM_KINEMATICS e IK_NEUTRAL e fica na flash. Um mapa de 1 bit por nó, em RAM, marca os nós em
+ * que solveBatch devolveria IK_OK com os limites atuais (e outro, os nós com vizinho alcançável);
+ * rebuild() os refaz sem trigonometria.
+ */
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+
+#include "Config.h"
+
+namespace Workspace
+{
+
+    /**
+     * @brief Classificação de um ponto pelas quatro quinas da célula que o contém.
+     */
+    enum Region : uint8_t
+    {
+        INSIDE,   /**< As quatro quinas são alcançáveis. */
+        BOUNDARY, /**< Quinas mistas: só o IK completo decide. */
+        OUTSIDE   /**< Nenhuma quina é alcançável, ou a base/rotação do punho está fora dos limites. */
+    };
+
+    /**
+     * @brief Refaz o mapa de alcançabilidade a partir de minAngles/maxAngles.
+     * Chamar no core de movimento após qualquer mudança de limites (setup, 'min'/'max', 'load').
+     */
+    void rebuild();
+
+    /**
+     * @brief Classifica o ponto XYZ (mm) em O(1): uma raiz quadrada e quatro bits lidos.
+     * Regiões mais finas que uma célula podem ser classificadas como OUTSIDE (ver printStatus()).
+     */
+    Region classify(float x, float y, float z);
+
+    /**
+     * @brief Solução inicial interpolada (bilinear) da grade, com os ângulos limitados como em solveXYZ.
+     * @param angles [out] Ângulos lógicos dos servos.
+     * @return false se o ponto estiver fora da grade (além de maxReachMm).
+     */
+    bool seed(float x, float y, float z, float angles[NUM_SERVOS]);
+
+    /**
+     * @brief Exibe a grade, o custo de memória e os erros medidos no centro de cada célula
+     * contra solveBatch (erro máximo da semente e células classificadas errado).
+     */
+    void printStatus();
+
+} // namespace Workspace
+
+#endif // WORKSPACE_H
@@ -0,0 +1,414 @@
+/**
+ * @file HostPlatform.cpp
+ * @brief Implementação nativa (Linux) do relógio, Serial, EEPROM e Servo.
+ */
+#include "HostPlatform.h"
+
+#include <chrono>
+#include <thread>
+#include <poll.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+HostSerial Serial;
+HostEEPROM EEPROM;
+HostFlash Flash;
+HostEsp ESP;
+
+// =================================================================
+// Relógio
+// =================================================================
+
+namespace HostClock
+{
+    static bool virtualMode = false;
+    static uint64_t virtualUs = 0;
+    static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+    static uint64_t realUs()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now() - startTime)
+            .count();
+    }
+
+    void setVirtual(bool enabled)
+    {
+        if (enabled && !virtualMode)
+            virtualUs = realUs(); // Continua do instante atual
+        virtualMode = enabled;
+    }
+
+    bool isVirtual()
+    {
+        return virtualMode;
+    }
+
+    void advanceUs(uint64_t us)
+    {
+        if (virtualMode)
+            virtualUs += us;
+    }
+
+    void advanceMs(uint32_t ms)
+    {
+        advanceUs((uint64_t)ms * 1000);
+    }
+
+    uint64_t nowUs()
+    {
+        return virtualMode ? virtualUs : realUs();
+    }
+}
+
+unsigned long millis()
+{
+    return (unsigned long)(HostClock::nowUs() / 1000);
+}
+
+unsigned long micros()
+{
+    return (unsigned long)HostClock::nowUs();
+}
+
+void delay(unsigned long ms)
+{
+    if (HostClock::isVirtual())
+        HostClock::advanceMs(ms);
+    else
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    if (HostClock::isVirtual())
+        HostClock::advanceUs(us);
+    else
+        std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+// =================================================================
+// ESP (contador de ciclos)
+// =================================================================
+
+uint32_t HostEsp::getCycleCount()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return (uint32_t)__rdtsc();
+#else
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+uint32_t HostEsp::getCpuFreqMHz()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    // Frequência do TSC, calibrada uma vez contra o relógio monotônico
+    static uint32_t mhz = 0;
+    if (mhz == 0)
+    {
+        const auto t0 = std::chrono::steady_clock::now();
+        const uint64_t c0 = __rdtsc();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        const uint64_t c1 = __rdtsc();
+        const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+        mhz = (uint32_t)(((double)(c1 - c0) / us) + 0.5);
+    }
+    return mhz;
+#else
+    return 1000;
+#endif
+}
+
+// =================================================================
+// Serial
+// =================================================================
+
+void HostSerial::flush()
+{
+    fflush(stdout);
+}
+
+void HostSerial::pollStdin()
+{
+    if (!stdinEnabled)
+        return;
+    struct pollfd pfd = {STDIN_FILENO, POLLIN, 0};
+    while (poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLIN | POLLHUP)))
+    {
+        char chunk[256];
+        const ssize_t n = ::read(STDIN_FILENO, chunk, sizeof(chunk));
+        if (n <= 0)
+        {
+            stdinEnabled = false; // EOF: não há mais entrada
+            return;
+        }
+        input.insert(input.end(), chunk, chunk + n);
+    }
+}
+
+int HostSerial::available()
+{
+    if (inputPos >= input.size())
+    {
+        input.clear();
+        inputPos = 0;
+        pollStdin();
+    }
+    return (int)(input.size() - inputPos);
+}
+
+int HostSerial::read()
+{
+    if (available() == 0)
+        return -1;
+    return (unsigned char)input[inputPos++];
+}
+
+void HostSerial::inject(const char *text)
+{
+    input.insert(input.end(), text, text + strlen(text));
+}
+
+size_t HostSerial::print(const char *str)
+{
+    if (!outputEnabled)
+        return 0;
+    return fputs(str, stdout) >= 0 ? strlen(str) : 0;
+}
+
+size_t HostSerial::print(char c)
+{
+    if (!outputEnabled)
+        return 0;
+    return fputc(c, stdout) != EOF ? 1 : 0;
+}
+
+size_t HostSerial::print(long long value, int base)
+{
+    if (base != DEC)
+        return print((unsigned long long)value, base); // Como no Arduino: fora da base 10 não há sinal
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%lld", value);
+    return print(buf);
+}
+
+size_t HostSerial::print(unsigned long long value, int base)
+{
+    char buf[72];
+    char *p = buf + sizeof(buf) - 1;
+    *p = '\0';
+    if (base < 2)
+        base = DEC;
+    do
+    {
+        const int digit = (int)(value % base);
+        *--p = (char)(digit < 10 ? '0' + digit : 'A' + digit - 10);
+        value /= base;
+    } while (value > 0);
+    return print(p);
+}
+
+size_t HostSerial::print(double value, int digits)
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", digits, value);
+    return print(buf);
+}
+
+// =================================================================
+// EEPROM
+// =================================================================
+
+bool HostEEPROM::begin(size_t size)
+{
+    data.assign(size, 0); // Área nova zerada, como a EEPROM do ESP32 (blob no NVS)
+    if (backingFile[0] != '\0')
+    {
+        FILE *f = fopen(backingFile, "rb");
+        if (f != NULL)
+        {
+            const size_t n = fread(&data[0], 1, size, f);
+            (void)n; // Arquivo menor que a área: o restante fica apagado
+            fclose(f);
+        }
+    }
+    return true;
+}
+
+bool HostEEPROM::commit()
+{
+    commits++;
+    if (backingFile[0] == '\0')
+        return true;
+    FILE *f = fopen(backingFile, "wb");
+    if (f == NULL)
+        return false;
+    const bool ok = fwrite(&data[0], 1, data.size(), f) == data.size();
+    fclose(f);
+    return ok;
+}
+
+void HostEEPROM::setBackingFile(const char *path)
+{
+    if (path == NULL)
+    {
+        backingFile[0] = '\0';
+        return;
+    }
+    strncpy(backingFile, path, sizeof(backingFile) - 1);
+    backingFile[sizeof(backingFile) - 1] = '\0';
+}
+
+// =================================================================
+// Partição de dados da flash
+// =================================================================
+
+bool HostFlash::read(size_t offset, void *dst, size_t size) const
+{
+    if (offset + size > data.size())
+        return false;
+    memcpy(dst, &data[offset], size);
+    return true;
+}
+
+bool HostFlash::write(size_t offset, const void *src, size_t size)
+{
+    if (offset + size > data.size() || powerLost())
+        return false;
+    const uint8_t *bytes = (const uint8_t *)src;
+    size_t n = size;
+    if (powerBudget >= 0 && (long)n > powerBudget)
+        n = (size_t)powerBudget; // Gravação cortada no meio
+    for (size_t i = 0; i < n; i++)
+        data[offset + i] &= bytes[i]; // NOR: só leva bits de 1 para 0
+    written += n;
+    if (powerBudget >= 0)
+        powerBudget -= (long)n;
+    persist();
+    return n == size;
+}
+
+bool HostFlash::erase(size_t offset, size_t size)
+{
+    if (offset % SECTOR_SIZE != 0 || size % SECTOR_SIZE != 0 || offset + size > data.size() || powerLost())
+        return false;
+    for (size_t s = offset; s < offset + size; s += SECTOR_SIZE)
+    {
+        if (powerBudget >= 0 && powerBudget < (long)SECTOR_SIZE)
+        {
+            // Apagamento interrompido: metade do setor fica com lixo
+            memset(&data[s], 0xA5, SECTOR_SIZE / 2);
+            powerBudget = 0;
+            persist();
+            return false;
+        }
+        memset(&data[s], 0xFF, SECTOR_SIZE);
+        erases[s / SECTOR_SIZE]++;
+        if (powerBudget >= 0)
+            powerBudget -= (long)SECTOR_SIZE;
+    }
+    persist();
+    return true;
+}
+
+void HostFlash::resize(uint32_t size)
+{
+    data.assign(size - size % SECTOR_SIZE, 0xFF);
+    erases.assign(data.size() / SECTOR_SIZE, 0);
+    written = 0;
+    powerBudget = -1;
+}
+
+void HostFlash::setBackingFile(const char *path)
+{
+    strncpy(backingFile, path, sizeof(backingFile) - 1);
+    backingFile[sizeof(backingFile) - 1] = '\0';
+    FILE *f = fopen(backingFile, "rb");
+    if (f != NULL)
+    {
+        const size_t n = fread(&data[0], 1, data.size(), f);
+        (void)n; // Arquivo menor que a partição: o restante fica apagado
+        fclose(f);
+    }
+}
+
+void HostFlash::persist() const
+{
+    if (backingFile[0] == '\0')
+        return;
+    FILE *f = fopen(backingFile, "wb");
+    if (f == NULL)
+        return;
+    const size_t n = fwrite(&data[0], 1, data.size(), f);
+    (void)n;
+    fclose(f);
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label)
+{
+    (void)subtype;
+    static esp_partition_t partition;
+    if (type != ESP_PARTITION_TYPE_DATA)
+        return NULL;
+    partition.type = type;
+    partition.subtype = ESP_PARTITION_SUBTYPE_ANY;
+    partition.address = 0;
+    partition.size = Flash.size();
+    strncpy(partition.label, label != NULL ? label : "", sizeof(partition.label) - 1);
+    return &partition;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size)
+{
+    (void)partition;
+    return Flash.read(src_offset, dst, size) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size)
+{
+    (void)partition;
+    return Flash.write(dst_offset, src, size) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size)
+{
+    (void)partition;
+    return Flash.erase(offset, size) ? ESP_OK : ESP_FAIL;
+}
+
+// =================================================================
+// Servo
+// =================================================================
+
+int Servo::attach(int newPin, int minUs, int maxUs)
+{
+    pin = newPin;
+    minPulseUs = minUs;
+    maxPulseUs = maxUs;
+    return 0;
+}
+
+void Servo::write(int angle)
+{
+    angle = constrain(angle, 0, 180);
+    writeMicroseconds(minPulseUs + (maxPulseUs - minPulseUs) * angle / 180);
+}
+
+void Servo::writeMicroseconds(int us)
+{
+    pulseUs = constrain(us, minPulseUs, maxPulseUs);
+    writes++;
+}
+
+int Servo::read() const
+{
+    if (maxPulseUs == minPulseUs)
+        return 0;
+    return (int)lround((double)(pulseUs - minPulseUs) * 180.0 / (maxPulseUs - minPulseUs));
+}
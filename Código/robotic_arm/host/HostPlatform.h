@@ -0,0 +1,307 @@
+/**
+ * @file HostPlatform.h
+ * @brief Implementação nativa (Linux) da fronteira de hardware (Platform.h).
+ *
+ * Cobre apenas o subconjunto do Arduino/ESP32 usado pelo firmware:
+ *   - Relógio (millis/micros/delay): tempo real ou virtual (HostClock), em que uma macro
+ *     de 60 s roda em milissegundos;
+ *   - Serial: saída em stdout e entrada em stdin (não-bloqueante) ou injetada (HostSerial::inject);
+ *   - EEPROM: buffer em memória, opcionalmente persistido em arquivo no commit();
+ *   - Partição de dados da flash (esp_partition_*): NOR em memória (gravar só zera bits, apagar
+ *     volta o setor a 0xFF), com arquivo de apoio opcional e simulação de queda de energia;
+ *   - Servo: guarda o último pulso escrito e conta as escritas.
+ * O build nativo roda em uma única thread (MOTION_USE_TASK=0, COMMS_USE_TASK=0), por isso
+ * as seções críticas do FreeRTOS são vazias.
+ */
+#ifndef HOST_PLATFORM_H
+#define HOST_PLATFORM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+// =================================================================
+// Core do Arduino
+// =================================================================
+
+#define PI 3.1415926535897932384626433832795
+#define DEC 10
+#define HEX 16
+#define F(str) (str)
+#define IRAM_ATTR
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+using std::max;
+using std::min;
+
+template <typename T, typename L, typename H>
+inline auto constrain(T x, L low, H high) -> decltype(x + low + high)
+{
+    return x < low ? low : (x > high ? high : x);
+}
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+/**
+ * @brief Relógio do build nativo.
+ * Em modo real segue o relógio monotônico do sistema; em modo virtual o tempo só anda
+ * por advance*() e por delay(), o que torna as execuções determinísticas.
+ */
+namespace HostClock
+{
+    /** @brief Liga/desliga o relógio virtual (o tempo atual é preservado na troca). */
+    void setVirtual(bool enabled);
+
+    /** @brief true se o relógio virtual estiver ativo. */
+    bool isVirtual();
+
+    /** @brief Avança o relógio virtual (sem efeito no modo real). */
+    void advanceUs(uint64_t us);
+
+    /** @brief Avança o relógio virtual em milissegundos. */
+    void advanceMs(uint32_t ms);
+
+    /** @brief Tempo desde o início do programa (µs). */
+    uint64_t nowUs();
+}
+
+/**
+ * @brief Serial do build nativo: stdout para saída, stdin e/ou buffer injetado para entrada.
+ */
+class HostSerial
+{
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    void flush();
+
+    int available();
+    int read();
+
+    /** @brief Acrescenta texto à entrada (como se tivesse sido digitado). */
+    void inject(const char *text);
+
+    /** @brief Lê também do stdin (não-bloqueante). Desligado por padrão. */
+    void setStdinEnabled(bool enabled) { stdinEnabled = enabled; }
+
+    /** @brief true enquanto houver entrada pendente ou o stdin não tiver chegado ao EOF. */
+    bool inputOpen() const { return stdinEnabled || inputPos < input.size(); }
+
+    /** @brief Liga/desliga a saída em stdout (benchmarks rodam em silêncio). */
+    void setOutputEnabled(bool enabled) { outputEnabled = enabled; }
+
+    size_t print(const char *str);
+    size_t print(char c);
+    size_t print(int value, int base = DEC) { return print((long long)value, base); }
+    size_t print(unsigned int value, int base = DEC) { return print((unsigned long long)value, base); }
+    size_t print(long value, int base = DEC) { return print((long long)value, base); }
+    size_t print(unsigned long value, int base = DEC) { return print((unsigned long long)value, base); }
+    size_t print(long long value, int base = DEC);
+    size_t print(unsigned long long value, int base = DEC);
+    size_t print(double value, int digits = 2);
+
+    size_t println() { return print('\n'); }
+    template <typename T>
+    size_t println(T value) { return print(value) + println(); }
+    template <typename T>
+    size_t println(T value, int format) { return print(value, format) + println(); }
+
+private:
+    void pollStdin();
+
+    std::vector<char> input;
+    size_t inputPos = 0;
+    bool stdinEnabled = false;
+    bool outputEnabled = true;
+};
+
+extern HostSerial Serial;
+
+/**
+ * @brief Subconjunto do objeto ESP usado pelo benchmark.
+ * Em x86 os ciclos vêm do TSC; nas demais arquiteturas, de nanossegundos (1000 MHz).
+ */
+class HostEsp
+{
+public:
+    uint32_t getCycleCount();
+    uint32_t getCpuFreqMHz();
+};
+
+extern HostEsp ESP;
+
+// =================================================================
+// EEPROM (emulação em memória, como a do ESP32)
+// =================================================================
+
+class HostEEPROM
+{
+public:
+    /**
+     * @brief Aloca a área (zerada) e carrega o arquivo de apoio, se houver.
+     */
+    bool begin(size_t size);
+
+    /** @brief Grava a área no arquivo de apoio (se configurado) e conta o commit. */
+    bool commit();
+
+    uint8_t read(int address) const { return data[address]; }
+    void write(int address, uint8_t value) { data[address] = value; }
+    uint8_t *getDataPtr() { return data.empty() ? NULL : &data[0]; }
+    uint16_t length() const { return (uint16_t)data.size(); }
+
+    template <typename T>
+    T &get(int address, T &value) const
+    {
+        memcpy(&value, &data[address], sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    const T &put(int address, const T &value)
+    {
+        memcpy(&data[address], &value, sizeof(T));
+        return value;
+    }
+
+    /** @brief Arquivo que persiste a EEPROM entre execuções (NULL = só memória). */
+    void setBackingFile(const char *path);
+
+    /** @brief Número de commits desde o início (cada um seria um apagamento de setor no ESP32). */
+    uint32_t commitCount() const { return commits; }
+
+private:
+    std::vector<uint8_t> data;
+    char backingFile[256] = {0};
+    uint32_t commits = 0;
+};
+
+extern HostEEPROM EEPROM;
+
+// =================================================================
+// Partição de dados da flash (esp_partition.h)
+// =================================================================
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+typedef enum
+{
+    ESP_PARTITION_TYPE_APP = 0x00,
+    ESP_PARTITION_TYPE_DATA = 0x01
+} esp_partition_type_t;
+
+typedef enum
+{
+    ESP_PARTITION_SUBTYPE_ANY = 0xff
+} esp_partition_subtype_t;
+
+typedef struct
+{
+    esp_partition_type_t type;
+    uint8_t subtype;
+    uint32_t address;
+    uint32_t size;
+    char label[17];
+} esp_partition_t;
+
+/**
+ * @brief Flash de host com semântica NOR: a gravação faz AND com o conteúdo (só zera bits) e o
+ * apagamento devolve setores inteiros a 0xFF. Conta apagamentos por setor e bytes gravados.
+ */
+class HostFlash
+{
+public:
+    static const uint32_t SECTOR_SIZE = 4096;
+    static const uint32_t DEFAULT_SIZE = 256 * 1024; // Mesmo tamanho da partição 'armlog' do partitions.csv
+
+    HostFlash() : data(DEFAULT_SIZE, 0xFF), erases(DEFAULT_SIZE / SECTOR_SIZE, 0) {}
+
+    bool read(size_t offset, void *dst, size_t size) const;
+    bool write(size_t offset, const void *src, size_t size);
+    bool erase(size_t offset, size_t size);
+    uint32_t size() const { return (uint32_t)data.size(); }
+
+    /** @brief Novo tamanho (múltiplo do setor); apaga tudo e zera as estatísticas. */
+    void resize(uint32_t size);
+
+    /** @brief Arquivo que persiste a partição entre execuções (carregado na hora). */
+    void setBackingFile(const char *path);
+
+    /**
+     * @brief Queda de energia simulada: depois de 'bytes' bytes gravados (ou de um apagamento,
+     * que conta como SECTOR_SIZE) as operações param no meio e falham. -1 = sem queda.
+     */
+    void setPowerBudget(long bytes) { powerBudget = bytes; }
+    bool powerLost() const { return powerBudget == 0; }
+
+    uint32_t sectorErases(uint32_t sector) const { return erases[sector]; }
+    uint64_t bytesWritten() const { return written; }
+
+private:
+    void persist() const;
+
+    std::vector<uint8_t> data;
+    std::vector<uint32_t> erases;
+    uint64_t written = 0;
+    long powerBudget = -1;
+    char backingFile[256] = {0};
+};
+
+extern HostFlash Flash;
+
+/** @brief A única partição do host é a de dados (rótulo qualquer); APP devolve NULL. */
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label);
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size);
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size);
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size);
+
+// =================================================================
+// Servo (ESP32Servo)
+// =================================================================
+
+class Servo
+{
+public:
+    int attach(int pin) { return attach(pin, 544, 2400); }
+    int attach(int pin, int minUs, int maxUs);
+    void detach() { pin = -1; }
+    bool attached() const { return pin >= 0; }
+
+    void write(int angle);
+    void writeMicroseconds(int us);
+    int read() const;
+    int readMicroseconds() const { return pulseUs; }
+
+    /** @brief Número de escritas no "periférico" (build nativo). */
+    uint32_t writeCount() const { return writes; }
+
+private:
+    int pin = -1;
+    int minPulseUs = 544;
+    int maxPulseUs = 2400;
+    int pulseUs = 0;
+    uint32_t writes = 0;
+};
+
+// =================================================================
+// FreeRTOS (somente o que é usado fora dos blocos MOTION_USE_TASK/COMMS_USE_TASK)
+// =================================================================
+
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux)) // Uma única thread no build nativo
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+
+#endif // HOST_PLATFORM_H
@@ -0,0 +1,97 @@
+/**
+ * @file arm_models.cpp
+ * @brief Verificação (host) das variantes de ArmModel.h: instancia ArmKinematics e as estruturas da
+ * EEPROM para cada modelo e confere a ida e volta IK -> FK dos dois ramos do cotovelo em uma grade
+ * da área de trabalho, com os limites seguros de fábrica do modelo.
+ *
+ * Compilação: alvo arm_models do host/CMakeLists.txt. Sai com código 1 se algum modelo falhar.
+ */
+#include "ArmKinematics.h"
+#include "ArmModel.h"
+#include "Config.h"
+
+#include <math.h>
+#include <stdio.h>
+
+namespace
+{
+    const float GRID_MM = 5.0f;
+    const float MAX_ROUND_TRIP_MM = 0.05f; // Erro aceito (FastMath: ~0.001 mm)
+
+    template <class Arm>
+    bool checkModel(const char *name)
+    {
+        static_assert(sizeof(StoredDataV2Layout<Arm>) == 4 + 1 + (4 * Arm::JOINTS) + 2, "StoredDataV2 com padding");
+        static_assert(sizeof(PoseCompactLayout<Arm>) == Arm::JOINTS + 1 + 2, "PoseCompact com padding");
+        static_assert(Arm::SHOULDER_MIRROR < Arm::JOINTS && Arm::GRIPPER < Arm::JOINTS, "Índice de junta inválido");
+
+        int lo[Arm::JOINTS];
+        int hi[Arm::JOINTS];
+        for (int i = 0; i < Arm::JOINTS; i++)
+        {
+            lo[i] = Arm::joint(i).safeMin;
+            hi[i] = Arm::joint(i).safeMax;
+        }
+
+        // A pose de repouso precisa respeitar os próprios limites e ter FK finita
+        float home[Arm::JOINTS];
+        bool ok = true;
+        for (int i = 0; i < Arm::JOINTS; i++)
+        {
+            home[i] = Arm::joint(i).home;
+            ok = ok && Arm::joint(i).home >= lo[i] && Arm::joint(i).home <= hi[i];
+            // Faixa de pulso e limites dinâmicos da própria variante
+            ok = ok && Arm::pulseMinUs()[i] < Arm::pulseMaxUs()[i];
+            ok = ok && Arm::maxVelocity()[i] > 0.0f && Arm::maxAccel()[i] > 0.0f && Arm::maxJerk()[i] > 0.0f;
+        }
+        float hx, hy, hz;
+        ok = ok && ArmKinematics<Arm>::forward(home, hx, hy, hz);
+
+        const ArmKinematicsConfig links = Arm::kinematics();
+        const float reach = links.maxReachMm;
+        long exact[2] = {0, 0};
+        float worst = 0.0f;
+        for (float x = -reach; x <= reach; x += GRID_MM)
+        {
+            for (float y = -reach; y <= reach; y += GRID_MM)
+            {
+                for (float z = links.baseHeightMm - reach; z <= links.baseHeightMm + reach; z += GRID_MM)
+                {
+                    for (int branch = 0; branch < 2; branch++)
+                    {
+                        float angles[Arm::JOINTS];
+                        bool inexact, mirrorable;
+                        if (!ArmKinematics<Arm>::solveBranch(x, y, z, branch == 0 ? 1.0f : -1.0f, lo, hi, angles,
+                                                             inexact, mirrorable) ||
+                            inexact)
+                            continue;
+                        float fx, fy, fz;
+                        if (!ArmKinematics<Arm>::forward(angles, fx, fy, fz))
+                        {
+                            ok = false;
+                            continue;
+                        }
+                        worst = fmaxf(worst, sqrtf((fx - x) * (fx - x) + (fy - y) * (fy - y) + (fz - z) * (fz - z)));
+                        exact[branch]++;
+                    }
+                }
+            }
+        }
+        ok = ok && exact[0] > 0 && worst <= MAX_ROUND_TRIP_MM;
+
+        printf("%s,%d,%.0f,%.1f,%.1f,%.1f,%ld,%ld,%.2g,%u,%u,%s\n", name, Arm::JOINTS, reach, hx, hy, hz, exact[0],
+               exact[1], worst, (unsigned)sizeof(StoredDataV2Layout<Arm>), (unsigned)sizeof(PoseCompactLayout<Arm>),
+               ok ? "ok" : "FALHA");
+        return ok;
+    }
+}
+
+int main()
+{
+    printf("model,joints,max_reach_mm,home_x,home_y,home_z,exact_elbow_down,exact_elbow_up,max_ik_fk_error_mm,"
+           "stored_bytes,pose_bytes,result\n");
+    bool ok = checkModel<ArmModelMk1>("Mk1");
+    ok = checkModel<ArmModelMk2>("Mk2") && ok;
+    printf("active_model,%d\n", ARM_MODEL);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+/**
+ * @file arm_sim.cpp
+ * @brief Executa o firmware completo (setup()/loop() do robotic_arm.ino) no Linux.
+ *
+ * Uso:
+ *   arm_sim [--virtual] [--flash <arquivo>] [--eeprom <arquivo>] [--timeout <s>] < comandos.txt
+ *
+ * - Sem --virtual: relógio real; a Serial lê o stdin de forma não-bloqueante (uso interativo).
+ * - Com --virtual: relógio virtual; cada linha do stdin é enviada à Serial e o loop() avança
+ *   HOST_LOOP_STEP_US por iteração, então uma macro de 60 s roda em milissegundos.
+ *   A linha "wait <ms>" (diretiva do simulador) executa o loop() por <ms> de tempo virtual.
+ * - Ao fim da entrada, continua até o braço ficar ocioso (sem macro, sem movimento e sem gravação
+ *   pendente) ou até --timeout segundos (padrão 600), e informa o tempo simulado e o tempo real
+ *   no stderr.
+ * - --flash: persiste a partição do log (LogStore) em arquivo entre execuções (padrão: só memória).
+ * - --eeprom: EEPROM legada em arquivo (importada no primeiro boot com o log vazio).
+ */
+#include "../robotic_arm.ino"
+
+#include <chrono>
+#include <thread>
+
+namespace
+{
+    const uint32_t HOST_LOOP_STEP_US = 1000; // Avanço do relógio virtual por iteração do loop()
+
+    bool isIdle()
+    {
+        CommandBus::dispatch(); // Nenhum comando pendente pode ficar para trás
+        return !Sequencer::isRunning() && !MotionController::isMoving() && !Storage::isDirty();
+    }
+
+    void step()
+    {
+        loop();
+        if (HostClock::isVirtual())
+            HostClock::advanceUs(HOST_LOOP_STEP_US);
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(200)); // Não ocupa um core inteiro
+    }
+
+    void runFor(uint64_t us)
+    {
+        const uint64_t end = HostClock::nowUs() + us;
+        while (HostClock::nowUs() < end)
+            step();
+    }
+
+    // Roda até o braço ficar ocioso; false se o tempo limite acabar antes
+    bool runUntilIdle(uint64_t timeoutUs)
+    {
+        const uint64_t end = HostClock::nowUs() + timeoutUs;
+        while (!isIdle())
+        {
+            if (HostClock::nowUs() >= end)
+                return false;
+            step();
+        }
+        return true;
+    }
+
+    void runScript()
+    {
+        char line[256];
+        while (fgets(line, sizeof(line), stdin) != NULL)
+        {
+            unsigned long waitMs = 0;
+            if (sscanf(line, "wait %lu", &waitMs) == 1)
+            {
+                runFor((uint64_t)waitMs * 1000);
+                continue;
+            }
+            Serial.inject(line);
+            step();
+        }
+    }
+
+    void runInteractive()
+    {
+        setvbuf(stdout, NULL, _IOLBF, 0); // Respostas aparecem linha a linha, como no monitor serial
+        Serial.setStdinEnabled(true);     // A Serial para de ler o stdin ao encontrar EOF
+        while (Serial.inputOpen())
+            step();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bool virtualClock = false;
+    double timeoutS = 600.0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--virtual") == 0)
+            virtualClock = true;
+        else if (strcmp(argv[i], "--flash") == 0 && i + 1 < argc)
+            Flash.setBackingFile(argv[++i]);
+        else if (strcmp(argv[i], "--eeprom") == 0 && i + 1 < argc)
+            EEPROM.setBackingFile(argv[++i]);
+        else if (strcmp(argv[i], "--timeout") == 0 && i + 1 < argc)
+            timeoutS = atof(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Uso: %s [--virtual] [--flash <arquivo>] [--eeprom <arquivo>] [--timeout <s>] < comandos\n", argv[0]);
+            return 2;
+        }
+    }
+
+    HostClock::setVirtual(virtualClock);
+    const auto wallStart = std::chrono::steady_clock::now();
+
+    setup();
+    const uint64_t simStart = HostClock::nowUs();
+    if (virtualClock)
+        runScript();
+    else
+        runInteractive();
+    const bool idle = runUntilIdle((uint64_t)(timeoutS * 1e6));
+    Serial.flush();
+
+    const double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+    fprintf(stderr, "[arm_sim] tempo simulado: %.1f ms | tempo real: %.1f ms | bytes gravados na flash: %llu%s\n",
+            (HostClock::nowUs() - simStart) / 1000.0, wallMs, (unsigned long long)Flash.bytesWritten(),
+            idle ? "" : " | TEMPO LIMITE");
+    return idle ? 0 : 1;
+}
@@ -0,0 +1,212 @@
+/**
+ * @file bench_fast_math.cpp
+ * @brief Verificação (host) de FastMath.h: erro máximo de cada aproximação contra a libm em double,
+ * custo por chamada no PC e ida e volta do IK (solveXYZ -> FK) em uma grade densa da área de trabalho.
+ *
+ * O IK é comparado com uma cópia do modelo de solveXYZ em double (libm). Com
+ * -DARM_LIBM_KINEMATICS=ON o firmware usa a libm e a mesma verificação mede o caso de referência.
+ *
+ * Compilação: alvo bench_fast_math do host/CMakeLists.txt.
+ */
+#include "Config.h"
+#include "FastMath.h"
+#include "InverseKinematics.h"
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+
+namespace
+{
+    const int CALLS = 10000000;
+    const double GRID_MM = 4.0;
+
+    volatile float sink; // Impede que o compilador descarte os cálculos
+
+    template <typename Fn>
+    double nsPerCall(Fn fn)
+    {
+        const auto t0 = std::chrono::steady_clock::now();
+        float acc = 0.0f;
+        for (int n = 0; n < CALLS; n++)
+        {
+            acc += fn(n);
+        }
+        const auto t1 = std::chrono::steady_clock::now();
+        sink = acc;
+        return std::chrono::duration<double, std::nano>(t1 - t0).count() / CALLS;
+    }
+
+    void printError(const char *name, double worst, double libmWorst)
+    {
+        printf("%s,%.3g,%.3g\n", name, worst, libmWorst);
+    }
+
+    // --- Erros das funções (fast e libm float contra libm double) ---
+    void functionErrors()
+    {
+        printf("function,max_abs_error_fast,max_abs_error_libm_float\n");
+
+        double fast = 0.0;
+        double libm = 0.0;
+        for (int i = -2000; i <= 2000; i++) // Quadrado [-1, 1]² a cada 5e-4, sem cancelar a escala
+        {
+            for (int j = -2000; j <= 2000; j++)
+            {
+                const float y = i * 5e-4f;
+                const float x = j * 5e-4f;
+                const double ref = atan2((double)y, (double)x);
+                fast = fmax(fast, fabs(FastMath::atan2(y, x) - ref));
+                libm = fmax(libm, fabs(atan2f(y, x) - ref));
+            }
+        }
+        printError("atan2", fast, libm);
+
+        fast = libm = 0.0;
+        for (int i = -2000000; i <= 2000000; i++)
+        {
+            const float x = i * 5e-7f;
+            const double ref = acos((double)x);
+            fast = fmax(fast, fabs(FastMath::acos(x) - ref));
+            libm = fmax(libm, fabs(acosf(x) - ref));
+        }
+        printError("acos", fast, libm);
+
+        double fastCos = 0.0;
+        double libmCos = 0.0;
+        fast = libm = 0.0;
+        for (int i = -2000000; i <= 2000000; i++)
+        {
+            const float x = i * 5e-5f;
+            float s, c;
+            FastMath::sinCos(x, s, c);
+            fast = fmax(fast, fabs(s - sin((double)x)));
+            fastCos = fmax(fastCos, fabs(c - cos((double)x)));
+            libm = fmax(libm, fabs(sinf(x) - sin((double)x)));
+            libmCos = fmax(libmCos, fabs(cosf(x) - cos((double)x)));
+        }
+        printError("sin", fast, libm);
+        printError("cos", fastCos, libmCos);
+    }
+
+    // --- Custo por chamada no PC ---
+    void functionSpeed()
+    {
+        printf("\nfunction,ns_libm,ns_fast\n");
+        printf("atan2,%.2f,%.2f\n", nsPerCall([](int n) { return atan2f((float)(n & 1023) - 512.0f, 300.0f); }),
+               nsPerCall([](int n) { return FastMath::atan2((float)(n & 1023) - 512.0f, 300.0f); }));
+        printf("acos,%.2f,%.2f\n", nsPerCall([](int n) { return acosf((float)(n & 1023) / 512.0f - 1.0f); }),
+               nsPerCall([](int n) { return FastMath::acos((float)(n & 1023) / 512.0f - 1.0f); }));
+        printf("sincos,%.2f,%.2f\n", nsPerCall([](int n) {
+                   const float x = (float)(n & 1023) * 0.00614f - 3.14f;
+                   return sinf(x) + cosf(x);
+               }),
+               nsPerCall([](int n) {
+                   float s, c;
+                   FastMath::sinCos((float)(n & 1023) * 0.00614f - 3.14f, s, c);
+                   return s + c;
+               }));
+    }
+
+    // --- Modelo de solveXYZ em double (só pontos sem corte de alcance) ---
+    bool referenceIk(double x, double y, double z, double angles[NUM_SERVOS])
+    {
+        const double rad = 180.0 / M_PI;
+        const double planar = sqrt(x * x + y * y);
+        const double elevation = z - ARM_KINEMATICS.baseHeightMm;
+        const double distance = sqrt(planar * planar + elevation * elevation);
+        const double wristExtension = ARM_KINEMATICS.wristOffsetMm + ARM_KINEMATICS.gripperLenMm;
+        if (distance < ARM_KINEMATICS.minReachMm || distance > ARM_KINEMATICS.maxReachMm ||
+            distance <= wristExtension + 5.0)
+            return false;
+        const double scale = (distance - wristExtension) / distance;
+        const double effPlanar = planar * scale;
+        const double effElevation = elevation * scale;
+        const double L1 = ARM_KINEMATICS.upperLenMm;
+        const double L2 = ARM_KINEMATICS.forearmLenMm;
+        const double cosElbow = (effPlanar * effPlanar + effElevation * effElevation - L1 * L1 - L2 * L2) / (2.0 * L1 * L2);
+        if (cosElbow < -1.0 || cosElbow > 1.0)
+            return false;
+        const double elbow = acos(cosElbow);
+        const double shoulder = atan2(effElevation, effPlanar) - atan2(L2 * sin(elbow), L1 + L2 * cos(elbow));
+        const double wrist = atan2(elevation, planar) - (shoulder + elbow);
+        angles[0] = atan2(y, x) * rad + IK_NEUTRAL.base;
+        angles[1] = shoulder * rad + IK_NEUTRAL.shoulder;
+        angles[2] = angles[1];
+        angles[3] = elbow * rad + IK_NEUTRAL.elbow;
+        angles[4] = wrist * rad + IK_NEUTRAL.hand;
+        angles[5] = IK_NEUTRAL.wristRotate + (angles[0] - IK_NEUTRAL.base);
+        angles[6] = IK_NEUTRAL.gripper;
+        for (int i = 0; i < NUM_SERVOS; i++)
+            if (angles[i] < 0.0 || angles[i] > 180.0)
+                return false;
+        return true;
+    }
+
+    void referenceFk(const float angles[NUM_SERVOS], double &x, double &y, double &z)
+    {
+        const double rad = M_PI / 180.0;
+        const double base = (angles[0] - IK_NEUTRAL.base) * rad;
+        const double joint2 = (angles[1] - IK_NEUTRAL.shoulder) * rad;
+        const double joint3 = joint2 + (angles[3] - IK_NEUTRAL.elbow) * rad;
+        const double joint4 = joint3 + (angles[4] - IK_NEUTRAL.hand) * rad;
+        const double wristExtension = ARM_KINEMATICS.wristOffsetMm + ARM_KINEMATICS.gripperLenMm;
+        const double planar = cos(joint2) * ARM_KINEMATICS.upperLenMm + cos(joint3) * ARM_KINEMATICS.forearmLenMm +
+                              cos(joint4) * wristExtension;
+        x = planar * cos(base);
+        y = planar * sin(base);
+        z = ARM_KINEMATICS.baseHeightMm + sin(joint2) * ARM_KINEMATICS.upperLenMm +
+            sin(joint3) * ARM_KINEMATICS.forearmLenMm + sin(joint4) * wristExtension;
+    }
+
+    void ikRoundTrip()
+    {
+        for (int i = 0; i < NUM_SERVOS; i++) // Sem limites de software: só o alcance decide
+        {
+            minAngles[i] = 0;
+            maxAngles[i] = 180;
+        }
+
+        long points = 0;
+        double angleError = 0.0;
+        double roundTrip = 0.0;
+        double fkError = 0.0;
+        const double reach = ARM_KINEMATICS.maxReachMm;
+        for (double x = 0.0; x <= reach; x += GRID_MM)
+        {
+            for (double y = -reach; y <= reach; y += GRID_MM)
+            {
+                for (double z = ARM_KINEMATICS.baseHeightMm - reach; z <= ARM_KINEMATICS.baseHeightMm + reach;
+                     z += GRID_MM)
+                {
+                    double ref[NUM_SERVOS];
+                    if (!referenceIk(x, y, z, ref))
+                        continue;
+                    float angles[NUM_SERVOS];
+                    if (!InverseKinematics::solveXYZ((float)x, (float)y, (float)z, angles))
+                        continue;
+                    points++;
+                    for (int i = 0; i < NUM_SERVOS; i++)
+                        angleError = fmax(angleError, fabs(angles[i] - ref[i]));
+
+                    double rx, ry, rz;
+                    referenceFk(angles, rx, ry, rz);
+                    roundTrip = fmax(roundTrip, sqrt((rx - x) * (rx - x) + (ry - y) * (ry - y) + (rz - z) * (rz - z)));
+                    float fx, fy, fz;
+                    InverseKinematics::estimateXYZ(angles, fx, fy, fz);
+                    fkError = fmax(fkError, sqrt((fx - rx) * (fx - rx) + (fy - ry) * (fy - ry) + (fz - rz) * (fz - rz)));
+                }
+            }
+        }
+        printf("\nik_round_trip,kinematics_fast_math,points,max_angle_error_deg,max_ik_fk_error_mm,max_fk_error_mm\n");
+        printf("ik_round_trip,%d,%ld,%.2g,%.2g,%.2g\n", KINEMATICS_FAST_MATH, points, angleError, roundTrip, fkError);
+    }
+}
+
+int main()
+{
+    functionErrors();
+    functionSpeed();
+    ikRoundTrip();
+    return 0;
+}
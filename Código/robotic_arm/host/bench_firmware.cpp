@@ -0,0 +1,48 @@
+/**
+ * @file bench_firmware.cpp
+ * @brief Benchmark (host) dos caminhos críticos do firmware, com o mesmo código e o mesmo
+ * CSV do comando 'bench' no ESP32 (ver Benchmark.h).
+ *
+ * Uso: bench_firmware [iteracoes]   (padrão: BENCH_MAX_ITERATIONS)
+ */
+#include "Config.h"
+#include "MotionController.h"
+#include "PoseManager.h"
+#include "Storage.h"
+#include "Benchmark.h"
+#include "CommandBus.h"
+
+int main(int argc, char **argv)
+{
+    unsigned long iterations = BENCH_MAX_ITERATIONS;
+    if (argc > 1)
+        iterations = strtoul(argv[1], NULL, 10);
+    if (iterations == 0)
+    {
+        fprintf(stderr, "Uso: %s [iteracoes]\n", argv[0]);
+        return 2;
+    }
+
+    // Inicialização silenciosa (flash e EEPROM vazias: limites e posição de fallback)
+    Serial.setOutputEnabled(false);
+    EEPROM.begin(EEPROM_SIZE);
+    MotionController::setup(false);
+    // Biblioteca cheia: MAX_POSES poses sintéticas, só em RAM (nenhum commit durante o bench)
+    Storage::begin();
+    for (int i = 0; i < MAX_POSES; i++)
+    {
+        char name[POSE_NAME_LEN];
+        snprintf(name, sizeof(name), "pose%02d", i);
+        uint8_t angles[NUM_SERVOS];
+        for (int j = 0; j < NUM_SERVOS; j++)
+            angles[j] = (uint8_t)(60 + (i + j) % 60);
+        PoseManager::writeSlot(i, name, angles);
+    }
+    Serial.setOutputEnabled(true);
+
+    Benchmark::printHeader();
+    Benchmark::runComms(iterations);
+    const bool ran = Benchmark::runMotion(iterations);
+    CommandBus::printReplies(); // Resultado do motion_tick (no firmware: task de comunicação)
+    return ran ? 0 : 1;
+}
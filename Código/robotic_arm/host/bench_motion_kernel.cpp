@@ -0,0 +1,143 @@
+/**
+ * @file bench_motion_kernel.cpp
+ * @brief Micro-benchmark (host) do kernel de interpolação do MotionController.
+ *
+ * Compara o custo por tick (7 juntas) de:
+ *   - legado: divisão float + pow() + 7 multiplicações com truncamento (código original do update());
+ *   - float:  MotionProfile::evaluate() + 7 multiplicações;
+ *   - Q16:    MotionProfile::evaluateQ16() (tabelas constexpr) + 7 multiplicações inteiras.
+ * Também mede o erro máximo do kernel Q16 em relação ao float para cada perfil.
+ *
+ * Compilação: alvo bench_motion_kernel do host/CMakeLists.txt, ou manual (a partir de Código/robotic_arm):
+ *   g++ -O2 -std=gnu++11 -I. host/bench_motion_kernel.cpp MotionProfile.cpp -o bench_motion_kernel
+ */
+#include "MotionProfile.h"
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+
+namespace
+{
+    const int JOINTS = 7;
+    const uint32_t DURATION_MS = 1500;
+    const int ITERATIONS = 20000000;
+
+    const int START[JOINTS] = {90, 130, 130, 100, 70, 120, 100};
+    const int TARGET[JOINTS] = {30, 170, 170, 60, 110, 60, 150};
+
+    volatile int sink; // Impede que o compilador descarte os cálculos
+
+    MotionProfile::Plan makePlan(MotionProfile::Type type)
+    {
+        float deltas[JOINTS];
+        for (int i = 0; i < JOINTS; i++)
+            deltas[i] = (float)(TARGET[i] - START[i]);
+        const float vel[JOINTS] = {60, 45, 45, 60, 45, 45, 60};
+        const float acc[JOINTS] = {180, 120, 120, 180, 120, 120, 150};
+        return MotionProfile::plan(type, (float)DURATION_MS, deltas, vel, acc, JOINTS);
+    }
+
+    // Kernel original do MotionController::update() (antes do perfil sincronizado)
+    void tickLegacy(uint32_t elapsed, int out[JOINTS])
+    {
+        float progress = (float)elapsed / (float)DURATION_MS;
+        float easeProgress;
+        if (progress < 0.5f)
+            easeProgress = 2.0f * progress * progress;
+        else
+            easeProgress = 1.0f - pow(-2.0f * progress + 2.0f, 2.0f) / 2.0f;
+        for (int i = 0; i < JOINTS; i++)
+            out[i] = START[i] + (TARGET[i] - START[i]) * easeProgress;
+    }
+
+    void tickFloat(const MotionProfile::Plan &p, uint32_t elapsed, float out[JOINTS])
+    {
+        const float s = MotionProfile::evaluate(p, (float)elapsed);
+        for (int i = 0; i < JOINTS; i++)
+            out[i] = (float)START[i] + (float)(TARGET[i] - START[i]) * s;
+    }
+
+    void tickQ16(const MotionProfile::PlanQ16 &p, uint32_t elapsed, int32_t out[JOINTS])
+    {
+        const int64_t s = MotionProfile::evaluateQ16(p, elapsed);
+        for (int i = 0; i < JOINTS; i++)
+        {
+            const int32_t startQ16 = START[i] * MotionProfile::Q16_ONE;
+            const int32_t deltaQ16 = (TARGET[i] - START[i]) * MotionProfile::Q16_ONE;
+            out[i] = startQ16 + (int32_t)((deltaQ16 * s) >> 16);
+        }
+    }
+
+    template <typename Fn>
+    double nsPerTick(Fn fn)
+    {
+        uint32_t elapsed = 0;
+        const auto t0 = std::chrono::steady_clock::now();
+        for (int n = 0; n < ITERATIONS; n++)
+        {
+            fn(elapsed);
+            elapsed = elapsed < DURATION_MS ? elapsed + 1 : 0;
+        }
+        const auto t1 = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(t1 - t0).count() / ITERATIONS;
+    }
+
+    // Erro máximo |s_q16 - s_float| amostrando a cada 0.01 ms
+    double maxProfileError(MotionProfile::Type type)
+    {
+        const MotionProfile::Plan p = makePlan(type);
+        const MotionProfile::PlanQ16 q = MotionProfile::toQ16(p);
+        double worst = 0.0;
+        for (uint32_t step = 0; step <= DURATION_MS * 100; step++)
+        {
+            const uint32_t ms = step / 100;
+            const double ref = MotionProfile::evaluate(p, (float)ms);
+            const double fixed = (double)MotionProfile::evaluateQ16(q, ms) / MotionProfile::Q16_ONE;
+            const double err = fabs(ref - fixed);
+            if (err > worst)
+                worst = err;
+        }
+        return worst;
+    }
+}
+
+int main()
+{
+    printf("kernel,profile,ns_per_tick\n");
+
+    const double legacy = nsPerTick([](uint32_t e) {
+        int out[JOINTS];
+        tickLegacy(e, out);
+        sink = out[0] + out[6];
+    });
+    printf("legacy_pow,ease,%.2f\n", legacy);
+
+    const MotionProfile::Type types[] = {MotionProfile::EASE_QUAD, MotionProfile::TRAPEZOID, MotionProfile::MIN_JERK};
+    for (MotionProfile::Type type : types)
+    {
+        const MotionProfile::Plan p = makePlan(type);
+        const MotionProfile::PlanQ16 q = MotionProfile::toQ16(p);
+
+        const double f = nsPerTick([&p](uint32_t e) {
+            float out[JOINTS];
+            tickFloat(p, e, out);
+            sink = (int)(out[0] + out[6]);
+        });
+        const double fixed = nsPerTick([&q](uint32_t e) {
+            int32_t out[JOINTS];
+            tickQ16(q, e, out);
+            sink = out[0] + out[6];
+        });
+        printf("float,%s,%.2f\n", MotionProfile::name(type), f);
+        printf("q16,%s,%.2f\n", MotionProfile::name(type), fixed);
+    }
+
+    printf("\nprofile,max_abs_error,max_error_deg_180\n");
+    for (MotionProfile::Type type : types)
+    {
+        const double err = maxProfileError(type);
+        printf("%s,%.3g,%.4f\n", MotionProfile::name(type), err, err * 180.0);
+    }
+    return 0;
+}
@@ -0,0 +1,345 @@
+/**
+ * @file ik_regression.cpp
+ * @brief Regressão (host) de precisão e vazão do IK/FK do firmware.
+ *
+ * Varre um cubo em torno do ombro (lado 2 x maxReachMm) com passo configurável. Para cada ponto,
+ * solveBatch dá a classificação (exato, alcance cortado, junta limitada, inválido) e
+ * estimateXYZ(solveXYZ(p)) dá a ida e volta. O relatório traz a distribuição do erro nos pontos
+ * exatos, a fração de pontos cortados ou inalcançáveis e as soluções por segundo de solveXYZ,
+ * solveBatch e estimateXYZ.
+ *
+ * Uso:
+ *   ik_regression [--grid <mm>] [--limits safe|full] [--max-error <mm>] [--min-rate <solves/s>]
+ *                 [--baseline <arquivo>] [--write-baseline <arquivo>]
+ *                 [--error-tolerance <fração>] [--rate-tolerance <fração>]
+ *
+ * - --limits: safe (padrão) usa os limites seguros do modelo ativo (os do setup() sem calibração);
+ *   full libera 0-180° em todas as juntas (só o alcance decide).
+ * - Falha (código 1) se o erro máximo passar de --max-error (padrão 0.01 mm), se solveXYZ ficar
+ *   abaixo de --min-rate (padrão desligado) ou, com --baseline, se o erro crescer ou a vazão cair
+ *   além das tolerâncias (padrão 25%) em relação à linha de base gravada por --write-baseline.
+ *
+ * Compilação: alvo ik_regression do host/CMakeLists.txt.
+ */
+#include "Config.h"
+#include "InverseKinematics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+namespace
+{
+    const int CHUNK = 4096;               // Pontos por lote (a grade inteira não cabe folgada na memória)
+    const double MIN_TIMING_SECONDS = 0.5; // Grades grossas são varridas de novo até somar este tempo em solveXYZ
+
+    struct Options
+    {
+        float gridMm = 5.0f;
+        bool safeLimits = true;
+        float maxErrorMm = 0.01f;
+        double minRate = 0.0;
+        const char *baseline = nullptr;
+        const char *writeBaseline = nullptr;
+        double errorTolerance = 0.25;
+        double rateTolerance = 0.25;
+    };
+
+    struct Report
+    {
+        bool collect = true; // false: só acumula os tempos (varreduras extras de vazão)
+        long points = 0;
+        long exact = 0;
+        long reachClipped = 0;
+        long jointLimited = 0;
+        long invalid = 0;
+        long disagree = 0;          // solveXYZ falhou onde solveBatch resolveu (ou o contrário)
+        double clippedShiftMax = 0; // Distância entre o alvo e o ponto alcançado, nos pontos cortados
+        double clippedShiftSum = 0;
+        std::vector<float> errors; // Ida e volta nos pontos exatos (mm)
+        double solveSeconds = 0;
+        double batchSeconds = 0;
+        double forwardSeconds = 0;
+    };
+
+    struct Baseline
+    {
+        float gridMm;
+        double p99ErrorMm;
+        double maxErrorMm;
+        double solvesPerSecond;
+        double batchPerSecond;
+    };
+
+    typedef std::chrono::steady_clock Clock;
+
+    double seconds(Clock::time_point t0, Clock::time_point t1)
+    {
+        return std::chrono::duration<double>(t1 - t0).count();
+    }
+
+    bool parseArgs(int argc, char **argv, Options &opt)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            const bool hasValue = i + 1 < argc;
+            if (strcmp(argv[i], "--grid") == 0 && hasValue)
+                opt.gridMm = (float)atof(argv[++i]);
+            else if (strcmp(argv[i], "--limits") == 0 && hasValue)
+                opt.safeLimits = strcmp(argv[++i], "full") != 0;
+            else if (strcmp(argv[i], "--max-error") == 0 && hasValue)
+                opt.maxErrorMm = (float)atof(argv[++i]);
+            else if (strcmp(argv[i], "--min-rate") == 0 && hasValue)
+                opt.minRate = atof(argv[++i]);
+            else if (strcmp(argv[i], "--baseline") == 0 && hasValue)
+                opt.baseline = argv[++i];
+            else if (strcmp(argv[i], "--write-baseline") == 0 && hasValue)
+                opt.writeBaseline = argv[++i];
+            else if (strcmp(argv[i], "--error-tolerance") == 0 && hasValue)
+                opt.errorTolerance = atof(argv[++i]);
+            else if (strcmp(argv[i], "--rate-tolerance") == 0 && hasValue)
+                opt.rateTolerance = atof(argv[++i]);
+            else
+                return false;
+        }
+        return opt.gridMm >= 0.5f;
+    }
+
+    void applyLimits(bool safe)
+    {
+        for (int i = 0; i < NUM_SERVOS; i++)
+        {
+            minAngles[i] = safe ? ActiveArm::joint(i).safeMin : 0;
+            maxAngles[i] = safe ? ActiveArm::joint(i).safeMax : 180;
+        }
+    }
+
+    // Resolve um lote: classificação por solveBatch, ida e volta por solveXYZ -> estimateXYZ
+    void runChunk(const float *xs, const float *ys, const float *zs, int count, Report &rep)
+    {
+        static float batch[NUM_SERVOS][CHUNK];
+        static float solved[CHUNK][NUM_SERVOS];
+        static bool solvedOk[CHUNK];
+        static float fk[CHUNK][3];
+        static uint8_t status[CHUNK];
+        float *joints[NUM_SERVOS];
+        for (int j = 0; j < NUM_SERVOS; j++)
+            joints[j] = batch[j];
+
+        Clock::time_point t0 = Clock::now();
+        InverseKinematics::solveBatch(xs, ys, zs, count, joints, status);
+        Clock::time_point t1 = Clock::now();
+        rep.batchSeconds += seconds(t0, t1);
+
+        t0 = Clock::now();
+        for (int i = 0; i < count; i++)
+            solvedOk[i] = InverseKinematics::solveXYZ(xs[i], ys[i], zs[i], solved[i]);
+        t1 = Clock::now();
+        rep.solveSeconds += seconds(t0, t1);
+
+        t0 = Clock::now();
+        for (int i = 0; i < count; i++)
+            InverseKinematics::estimateXYZ(solved[i], fk[i][0], fk[i][1], fk[i][2]);
+        t1 = Clock::now();
+        rep.forwardSeconds += seconds(t0, t1);
+
+        if (!rep.collect)
+            return;
+        for (int i = 0; i < count; i++)
+        {
+            rep.points++;
+            const bool batchValid = status[i] != InverseKinematics::IK_INVALID;
+            if (solvedOk[i] != batchValid)
+                rep.disagree++;
+            if (!batchValid || !solvedOk[i])
+            {
+                rep.invalid++;
+                continue;
+            }
+            const double dx = fk[i][0] - xs[i];
+            const double dy = fk[i][1] - ys[i];
+            const double dz = fk[i][2] - zs[i];
+            const double shift = sqrt(dx * dx + dy * dy + dz * dz);
+            if (status[i] == InverseKinematics::IK_OK)
+            {
+                rep.exact++;
+                rep.errors.push_back((float)shift);
+                continue;
+            }
+            if (status[i] & InverseKinematics::IK_REACH_CLIPPED)
+                rep.reachClipped++;
+            else
+                rep.jointLimited++;
+            rep.clippedShiftMax = fmax(rep.clippedShiftMax, shift);
+            rep.clippedShiftSum += shift;
+        }
+    }
+
+    void sweep(float gridMm, Report &rep)
+    {
+        static float xs[CHUNK];
+        static float ys[CHUNK];
+        static float zs[CHUNK];
+        const float reach = ARM_KINEMATICS.maxReachMm;
+        const int steps = (int)floorf(2.0f * reach / gridMm) + 1;
+        int count = 0;
+        for (int ix = 0; ix < steps; ix++)
+        {
+            for (int iy = 0; iy < steps; iy++)
+            {
+                for (int iz = 0; iz < steps; iz++)
+                {
+                    xs[count] = -reach + ix * gridMm;
+                    ys[count] = -reach + iy * gridMm;
+                    zs[count] = ARM_KINEMATICS.baseHeightMm - reach + iz * gridMm;
+                    if (++count == CHUNK)
+                    {
+                        runChunk(xs, ys, zs, count, rep);
+                        count = 0;
+                    }
+                }
+            }
+        }
+        if (count > 0)
+            runChunk(xs, ys, zs, count, rep);
+    }
+
+    double percentile(std::vector<float> &values, double p)
+    {
+        if (values.empty())
+            return 0.0;
+        const size_t k = (size_t)(p * (values.size() - 1) + 0.5);
+        std::nth_element(values.begin(), values.begin() + k, values.end());
+        return values[k];
+    }
+
+    bool readBaseline(const char *path, Baseline &base)
+    {
+        FILE *f = fopen(path, "r");
+        if (!f)
+            return false;
+        char header[256];
+        const bool ok = fgets(header, sizeof(header), f) &&
+                        fscanf(f, "%f,%lf,%lf,%lf,%lf", &base.gridMm, &base.p99ErrorMm, &base.maxErrorMm,
+                               &base.solvesPerSecond, &base.batchPerSecond) == 5;
+        fclose(f);
+        return ok;
+    }
+
+    bool writeBaseline(const char *path, const Baseline &base)
+    {
+        FILE *f = fopen(path, "w");
+        if (!f)
+            return false;
+        fprintf(f, "grid_mm,p99_error_mm,max_error_mm,solves_per_s,batch_points_per_s\n");
+        fprintf(f, "%g,%.6g,%.6g,%.6g,%.6g\n", base.gridMm, base.p99ErrorMm, base.maxErrorMm, base.solvesPerSecond,
+                base.batchPerSecond);
+        fclose(f);
+        return true;
+    }
+
+    bool check(bool pass, const char *what)
+    {
+        if (!pass)
+            printf("FALHA: %s\n", what);
+        return pass;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options opt;
+    if (!parseArgs(argc, argv, opt))
+    {
+        fprintf(stderr, "Uso: ik_regression [--grid <mm>] [--limits safe|full] [--max-error <mm>] [--min-rate <n>]\n"
+                        "                     [--baseline <arquivo>] [--write-baseline <arquivo>]\n"
+                        "                     [--error-tolerance <fracao>] [--rate-tolerance <fracao>]\n");
+        return 2;
+    }
+
+    applyLimits(opt.safeLimits);
+    Report rep;
+    sweep(opt.gridMm, rep);
+
+    // Vazão: repete a varredura (sem estatísticas) até a medida ficar estável
+    long timedPoints = rep.points;
+    Report timing;
+    timing.collect = false;
+    timing.solveSeconds = rep.solveSeconds;
+    timing.batchSeconds = rep.batchSeconds;
+    timing.forwardSeconds = rep.forwardSeconds;
+    while (timing.solveSeconds < MIN_TIMING_SECONDS)
+    {
+        sweep(opt.gridMm, timing);
+        timedPoints += rep.points;
+    }
+
+    const double total = (double)rep.points;
+    Baseline now;
+    now.gridMm = opt.gridMm;
+    const double p50 = percentile(rep.errors, 0.50);
+    const double p90 = percentile(rep.errors, 0.90);
+    now.p99ErrorMm = percentile(rep.errors, 0.99);
+    now.maxErrorMm = percentile(rep.errors, 1.0);
+    now.solvesPerSecond = timedPoints / timing.solveSeconds;
+    now.batchPerSecond = timedPoints / timing.batchSeconds;
+    const double forwardPerSecond = timedPoints / timing.forwardSeconds;
+
+    printf("ik_regression,model,%d,kinematics_fast_math,%d,grid_mm,%g,limits,%s\n", ARM_MODEL, KINEMATICS_FAST_MATH,
+           opt.gridMm, opt.safeLimits ? "safe" : "full");
+    printf("\nclass,points,fraction\n");
+    printf("exact,%ld,%.4f\n", rep.exact, rep.exact / total);
+    printf("reach_clipped,%ld,%.4f\n", rep.reachClipped, rep.reachClipped / total);
+    printf("joint_limited,%ld,%.4f\n", rep.jointLimited, rep.jointLimited / total);
+    printf("invalid,%ld,%.4f\n", rep.invalid, rep.invalid / total);
+    printf("\nround_trip_mm,p50,p90,p99,max\n");
+    printf("exact,%.3g,%.3g,%.3g,%.3g\n", p50, p90, now.p99ErrorMm, now.maxErrorMm);
+    printf("clipped_shift,,,,%.1f (media %.1f)\n", rep.clippedShiftMax,
+           rep.reachClipped + rep.jointLimited > 0 ? rep.clippedShiftSum / (rep.reachClipped + rep.jointLimited) : 0.0);
+    printf("\nkernel,per_second,ns_per_point\n");
+    printf("solveXYZ,%.0f,%.1f\n", now.solvesPerSecond, 1e9 / now.solvesPerSecond);
+    printf("solveBatch,%.0f,%.1f\n", now.batchPerSecond, 1e9 / now.batchPerSecond);
+    printf("estimateXYZ,%.0f,%.1f\n", forwardPerSecond, 1e9 / forwardPerSecond);
+    printf("\n");
+
+    bool ok = check(rep.exact > 0, "nenhum ponto exato na grade");
+    ok = check(rep.disagree == 0, "solveXYZ e solveBatch discordam sobre pontos invalidos") && ok;
+    ok = check(now.maxErrorMm <= opt.maxErrorMm, "erro maximo de ida e volta acima de --max-error") && ok;
+    ok = check(opt.minRate <= 0.0 || now.solvesPerSecond >= opt.minRate, "solveXYZ abaixo de --min-rate") && ok;
+
+    if (opt.baseline)
+    {
+        Baseline base;
+        if (!readBaseline(opt.baseline, base))
+        {
+            ok = check(false, "linha de base ilegivel");
+        }
+        else
+        {
+            if (base.gridMm != opt.gridMm)
+                printf("AVISO: linha de base com grade de %g mm\n", base.gridMm);
+            // Folga absoluta: erros perto de zero variam muito em termos relativos
+            const double slack = 1e-4;
+            ok = check(now.p99ErrorMm <= base.p99ErrorMm * (1.0 + opt.errorTolerance) + slack,
+                       "p99 do erro cresceu em relacao a linha de base") && ok;
+            ok = check(now.maxErrorMm <= base.maxErrorMm * (1.0 + opt.errorTolerance) + slack,
+                       "erro maximo cresceu em relacao a linha de base") && ok;
+            ok = check(now.solvesPerSecond >= base.solvesPerSecond * (1.0 - opt.rateTolerance),
+                       "vazao de solveXYZ caiu em relacao a linha de base") && ok;
+            ok = check(now.batchPerSecond >= base.batchPerSecond * (1.0 - opt.rateTolerance),
+                       "vazao de solveBatch caiu em relacao a linha de base") && ok;
+            printf("baseline,p99 %.3g -> %.3g mm,max %.3g -> %.3g mm,solveXYZ %.0f -> %.0f/s,solveBatch %.0f -> %.0f/s\n",
+                   base.p99ErrorMm, now.p99ErrorMm, base.maxErrorMm, now.maxErrorMm, base.solvesPerSecond,
+                   now.solvesPerSecond, base.batchPerSecond, now.batchPerSecond);
+        }
+    }
+    if (opt.writeBaseline)
+        ok = check(writeBaseline(opt.writeBaseline, now), "nao foi possivel gravar a linha de base") && ok;
+
+    printf("result,%s\n", ok ? "ok" : "FALHA");
+    return ok ? 0 : 1;
+}
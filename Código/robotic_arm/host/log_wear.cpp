@@ -0,0 +1,422 @@
+/**
+ * @file log_wear.cpp
+ * @brief Desgaste e robustez (host) do log da flash (LogStore + Storage) sobre a flash NOR simulada.
+ *
+ * 1. Desgaste: com uma biblioteca grande salva (LIBRARY_POSES poses, LIBRARY_MACROS macros de até
+ *    centenas de passos, gravadas em fragmentos), repete movimentos curtos; a cada parada o
+ *    Storage grava a última posição (STORAGE_SAVE_POSITION_ON_STOP). Informa bytes gravados,
+ *    apagamentos por setor (mín/máx), snapshots, a vida estimada da partição e o custo do boot.
+ * 2. Quedas de energia: edições aleatórias (poses, gravação de macros que crescem até
+ *    MACRO_MAX_STEPS, deletes, calibração), cada uma gravada por um 'sync' (ou pelo 'macro save')
+ *    que recebe um orçamento aleatório de bytes (Flash.setPowerBudget); quando a energia acaba no
+ *    meio, reinicia (Storage::begin + loadState) e confere se o estado é o de antes ou o de depois
+ *    da edição, nunca uma mistura ou uma perda. As macros são comparadas pelos passos lidos da
+ *    flash (MacroStream), e as poses também pelo id.
+ *
+ * Uso:
+ *   log_wear [--sectors <n>] [--stops <n>] [--cuts <n>] [--seed <n>]
+ *
+ * - --sectors: tamanho da partição simulada (padrão 64 = 256 KB, o do partitions.csv).
+ * - Falha (código 1) se algum reinício divergir do estado esperado.
+ *
+ * Compilação: alvo log_wear do host/CMakeLists.txt.
+ */
+#include "Config.h"
+#include "LogStore.h"
+#include "MacroManager.h"
+#include "MotionController.h"
+#include "PoseManager.h"
+#include "Storage.h"
+
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace
+{
+    const uint32_t FLASH_ERASE_CYCLES = 100000; // Resistência típica de um setor da flash SPI
+    const int FUZZ_POSES = 12;                  // Nomes de pose usados nas edições aleatórias
+    const int FUZZ_MACROS = 4;
+    const int FUZZ_STEPS = 64;                  // Passos acrescentados por gravação (no máximo)
+    const int LIBRARY_POSES = 256;              // Biblioteca do teste de desgaste
+    const int LIBRARY_MACROS = 24;
+
+    struct Options
+    {
+        uint32_t sectors = 64;
+        long stops = 20000;
+        long cuts = 2000;
+        unsigned seed = 1;
+    };
+
+    /**
+     * @brief Estado visível do firmware: poses, macros e calibração aplicada por loadState().
+     */
+    struct State
+    {
+        char poseNames[MAX_POSES][POSE_NAME_LEN];
+        float poseAngles[MAX_POSES][NUM_SERVOS];
+        uint16_t poseIds[MAX_POSES];
+        bool macroFound[FUZZ_MACROS];
+        uint16_t macroSteps[FUZZ_MACROS];
+        MacroStepRecord steps[FUZZ_MACROS][MACRO_MAX_STEPS];
+        bool hasConfig;
+        int minv[NUM_SERVOS];
+        int maxv[NUM_SERVOS];
+        int offs[NUM_SERVOS];
+
+        bool operator==(const State &other) const
+        {
+            if (memcmp(poseAngles, other.poseAngles, sizeof(poseAngles)) != 0 ||
+                memcmp(poseIds, other.poseIds, sizeof(poseIds)) != 0 || hasConfig != other.hasConfig ||
+                memcmp(minv, other.minv, sizeof(minv)) != 0 || memcmp(maxv, other.maxv, sizeof(maxv)) != 0 ||
+                memcmp(offs, other.offs, sizeof(offs)) != 0)
+                return false;
+            for (int i = 0; i < MAX_POSES; i++)
+            {
+                if (strncmp(poseNames[i], other.poseNames[i], POSE_NAME_LEN) != 0)
+                    return false;
+            }
+            for (int i = 0; i < FUZZ_MACROS; i++)
+            {
+                if (macroFound[i] != other.macroFound[i])
+                    return false;
+                if (!macroFound[i])
+                    continue;
+                if (macroSteps[i] != other.macroSteps[i] ||
+                    memcmp(steps[i], other.steps[i], macroSteps[i] * sizeof(MacroStepRecord)) != 0)
+                    return false;
+            }
+            return true;
+        }
+    };
+
+    void poseName(int i, char name[POSE_NAME_LEN])
+    {
+        snprintf(name, POSE_NAME_LEN, "p%02d", i);
+    }
+
+    void macroName(int i, char name[POSE_NAME_LEN])
+    {
+        snprintf(name, POSE_NAME_LEN, "m%d", i);
+    }
+
+    void capture(State &state)
+    {
+        memset(&state, 0, sizeof(state));
+        for (int i = 0; i < MAX_POSES; i++)
+        {
+            if (PoseManager::slotName(i, state.poseNames[i]))
+                PoseManager::findPose(state.poseNames[i], state.poseAngles[i]);
+            state.poseIds[i] = PoseManager::slotId(i);
+        }
+        for (int i = 0; i < FUZZ_MACROS; i++)
+        {
+            char name[POSE_NAME_LEN];
+            macroName(i, name);
+            MacroManager::MacroStream stream;
+            // Passos ilegíveis contam como macro ausente (o estado nunca fica igual ao esperado)
+            state.macroFound[i] = MacroManager::openStream(name, stream) &&
+                                  MacroManager::readSteps(stream, 0, state.steps[i], stream.numSteps);
+            state.macroSteps[i] = state.macroFound[i] ? stream.numSteps : 0;
+        }
+        state.hasConfig = Storage::loadState(false);
+        for (int j = 0; j < NUM_SERVOS && state.hasConfig; j++)
+        {
+            state.minv[j] = minAngles[j];
+            state.maxv[j] = maxAngles[j];
+            state.offs[j] = offsets[j];
+        }
+    }
+
+    /**
+     * @brief Reinício: energia de volta, replay do log e calibração aplicada.
+     */
+    void reboot()
+    {
+        Flash.setPowerBudget(-1);
+        Storage::begin();
+        Storage::loadState(false);
+    }
+
+    void formatFlash(uint32_t sectors)
+    {
+        Flash.resize(sectors * HostFlash::SECTOR_SIZE);
+        reboot();
+    }
+
+    void savePose(int i, const uint8_t angles[NUM_SERVOS])
+    {
+        char name[POSE_NAME_LEN];
+        poseName(i, name);
+        const int existing = PoseManager::findSlot(name);
+        int slot = existing;
+        for (int s = 0; s < MAX_POSES && slot < 0; s++)
+        {
+            char used[POSE_NAME_LEN];
+            if (!PoseManager::slotName(s, used))
+                slot = s;
+        }
+        PoseManager::writeSlot(slot, name, angles);
+        Storage::markDirty(Storage::REGION_POSES);
+    }
+
+    /**
+     * @brief Biblioteca de referência: LIBRARY_POSES poses e LIBRARY_MACROS macros de 16 a 400 passos.
+     */
+    void fillLibrary()
+    {
+        for (int i = 0; i < LIBRARY_POSES; i++)
+        {
+            uint8_t angles[NUM_SERVOS];
+            for (int j = 0; j < NUM_SERVOS; j++)
+                angles[j] = (uint8_t)(60 + (i * 7 + j) % 60);
+            savePose(i, angles);
+        }
+        Storage::sync();
+        for (int m = 0; m < LIBRARY_MACROS; m++)
+        {
+            char name[POSE_NAME_LEN];
+            snprintf(name, POSE_NAME_LEN, "lib%d", m);
+            MacroManager::beginRecording(name);
+            const int numSteps = 16 + m * 384 / (LIBRARY_MACROS - 1);
+            for (int s = 0; s < numSteps; s++)
+            {
+                char pose[POSE_NAME_LEN];
+                poseName((m + s) % LIBRARY_POSES, pose);
+                MacroManager::addStep(pose, 100 * (s % 16));
+            }
+            MacroManager::saveRecording(); // Grava na hora
+        }
+        Storage::saveState();
+        Storage::sync();
+    }
+
+    int runWear(const Options &options)
+    {
+        formatFlash(options.sectors);
+        fillLibrary();
+        const uint64_t bytesStart = Flash.bytesWritten();
+
+        HostClock::setVirtual(true);
+        int target[NUM_SERVOS];
+        for (long n = 0; n < options.stops; n++)
+        {
+            for (int j = 0; j < NUM_SERVOS; j++)
+                target[j] = constrain(90 + (int)((n * 13 + j * 5) % 21) - 10, minAngles[j], maxAngles[j]);
+            MotionController::startSmoothMove(target, 20);
+            // Até parar e o registro da posição ser gravado (STORAGE_IDLE_COMMIT_MS depois)
+            const uint64_t deadline = HostClock::nowUs() + 5000000ULL;
+            while (HostClock::nowUs() < deadline)
+            {
+                HostClock::advanceUs(1000);
+                MotionController::update();
+                Storage::service();
+                if (!MotionController::isMoving() && !Storage::isDirty())
+                    break;
+            }
+        }
+        HostClock::setVirtual(false);
+
+        const int sectors = Flash.size() / HostFlash::SECTOR_SIZE;
+        uint32_t minErases = Flash.sectorErases(0);
+        uint32_t maxErases = minErases;
+        uint64_t totalErases = 0;
+        for (int s = 0; s < sectors; s++)
+        {
+            minErases = min(minErases, Flash.sectorErases(s));
+            maxErases = max(maxErases, Flash.sectorErases(s));
+            totalErases += Flash.sectorErases(s);
+        }
+
+        const auto bootStart = std::chrono::steady_clock::now();
+        Storage::begin();
+        const double bootUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - bootStart).count();
+
+        const uint64_t bytes = Flash.bytesWritten() - bytesStart;
+        printf("Desgaste: %ld paradas, particao de %d setores\n", options.stops, sectors);
+        printf("  bytes gravados: %llu (%.1f por parada)\n", (unsigned long long)bytes,
+               options.stops > 0 ? (double)bytes / options.stops : 0.0);
+        printf("  apagamentos: %llu no total | por setor: min %u, max %u\n",
+               (unsigned long long)totalErases, minErases, maxErases);
+        if (maxErases > 0)
+            printf("  vida estimada: %.2e paradas ate %u apagamentos no setor mais gasto\n",
+                   (double)options.stops * FLASH_ERASE_CYCLES / maxErases, FLASH_ERASE_CYCLES);
+        printf("  boot (varredura + replay no PC): %.0f us\n", bootUs);
+        Serial.setOutputEnabled(true);
+        Storage::printLibrarySpace();
+        LogStore::printStats();
+        Serial.setOutputEnabled(false);
+        return 0;
+    }
+
+    MacroStepRecord addedSteps[FUZZ_STEPS]; // Passos aceitos na última gravação de randomEdit()
+    int addedCount = 0;
+
+    /**
+     * @brief Uma edição aleatória em RAM (o commit fica para o chamador). Uma macro fica em gravação
+     * (o 'macro save' é do chamador, porque ele mesmo grava a flash).
+     * @return Índice da macro em gravação, ou -1.
+     */
+    int randomEdit(std::mt19937 &rng)
+    {
+        const int kind = rng() % 10;
+        if (kind < 4)
+        {
+            uint8_t angles[NUM_SERVOS];
+            for (int j = 0; j < NUM_SERVOS; j++)
+                angles[j] = (uint8_t)(rng() % 181);
+            savePose(rng() % FUZZ_POSES, angles);
+        }
+        else if (kind < 6)
+        {
+            char name[POSE_NAME_LEN];
+            poseName(rng() % FUZZ_POSES, name);
+            PoseManager::deletePose(name);
+        }
+        else if (kind < 8)
+        {
+            // Continua a macro salva; passos de poses que não existem são recusados
+            const int m = rng() % FUZZ_MACROS;
+            char name[POSE_NAME_LEN];
+            macroName(m, name);
+            MacroManager::beginRecording(name);
+            const int count = 1 + rng() % FUZZ_STEPS;
+            addedCount = 0;
+            for (int s = 0; s < count && MacroManager::recordingLength() < MACRO_MAX_STEPS; s++)
+            {
+                char pose[POSE_NAME_LEN];
+                poseName(rng() % FUZZ_POSES, pose);
+                const uint16_t delay = rng() % 1000;
+                if (MacroManager::addStep(pose, delay))
+                {
+                    addedSteps[addedCount].poseId = PoseManager::findId(pose);
+                    addedSteps[addedCount].delay_ms = delay;
+                    addedCount++;
+                }
+            }
+            return m;
+        }
+        else if (kind < 9)
+        {
+            char name[POSE_NAME_LEN];
+            macroName(rng() % FUZZ_MACROS, name);
+            MacroManager::deleteMacro(name);
+        }
+        else
+        {
+            const int j = rng() % NUM_SERVOS;
+            minAngles[j] = rng() % 60;
+            maxAngles[j] = 120 + rng() % 61;
+            offsets[j] = (int)(rng() % 21) - 10;
+            Storage::saveState();
+        }
+        return -1;
+    }
+
+    int runPowerCuts(const Options &options)
+    {
+        std::mt19937 rng(options.seed);
+        formatFlash(options.sectors);
+        long cuts = 0;
+        long edits = 0;
+        long failures = 0;
+        static State before, after, restored; // ~60 KB: fora da pilha
+        capture(before);
+        while (cuts < options.cuts)
+        {
+            const int recording = randomEdit(rng);
+            edits++;
+            capture(after);
+            if (recording >= 0)
+            {
+                // O que o 'macro save' deve deixar na flash: os passos salvos e os acrescentados
+                const int kept = after.macroSteps[recording];
+                memcpy(after.steps[recording] + kept, addedSteps, addedCount * sizeof(MacroStepRecord));
+                after.macroFound[recording] = true;
+                after.macroSteps[recording] = (uint16_t)(kept + addedCount);
+            }
+            // Orçamento até pouco mais de um setor: cobre registros e apagamentos cortados
+            Flash.setPowerBudget(rng() % (HostFlash::SECTOR_SIZE + 1024));
+            bool written;
+            if (recording >= 0)
+            {
+                if (!MacroManager::saveRecording())
+                    after = before; // Sem espaço: nada muda
+                written = !Storage::isDirty();
+            }
+            else
+            {
+                written = Storage::sync() == Storage::SYNC_DONE;
+            }
+            if (written)
+            {
+                Flash.setPowerBudget(-1);
+                before = after;
+                continue;
+            }
+            cuts++;
+            reboot();
+            capture(restored);
+            if (!(restored == before) && !(restored == after))
+            {
+                failures++;
+                if (failures <= 5)
+                    fprintf(stderr, "Divergencia apos a queda %ld (edicao %ld)\n", cuts, edits);
+            }
+            before = restored;
+        }
+        // Sem queda: o reinício precisa reproduzir exatamente o último estado
+        reboot();
+        capture(restored);
+        if (!(restored == before))
+        {
+            failures++;
+            fprintf(stderr, "Divergencia no reinicio final\n");
+        }
+        printf("Quedas de energia: %ld edicoes, %ld quedas no meio do sync, %ld divergencias\n",
+               edits, cuts, failures);
+        return failures == 0 ? 0 : 1;
+    }
+
+    bool parseArgs(int argc, char **argv, Options &options)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            if (i + 1 >= argc)
+                return false;
+            if (strcmp(argv[i], "--sectors") == 0)
+                options.sectors = strtoul(argv[++i], NULL, 10);
+            else if (strcmp(argv[i], "--stops") == 0)
+                options.stops = strtol(argv[++i], NULL, 10);
+            else if (strcmp(argv[i], "--cuts") == 0)
+                options.cuts = strtol(argv[++i], NULL, 10);
+            else if (strcmp(argv[i], "--seed") == 0)
+                options.seed = strtoul(argv[++i], NULL, 10);
+            else
+                return false;
+        }
+        return options.sectors >= LOG_RESERVE_SECTORS + 2 && options.sectors <= LOG_MAX_SECTORS;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseArgs(argc, argv, options))
+    {
+        fprintf(stderr, "Uso: %s [--sectors <n>] [--stops <n>] [--cuts <n>] [--seed <n>]\n", argv[0]);
+        return 2;
+    }
+
+    // Firmware sem EEPROM legada e sem Serial (as mensagens dos saves não interessam aqui)
+    Serial.setOutputEnabled(false);
+    EEPROM.begin(EEPROM_SIZE);
+    MotionController::setup(false);
+
+    const int wear = runWear(options);
+    const int cuts = runPowerCuts(options);
+    return wear != 0 ? wear : cuts;
+}
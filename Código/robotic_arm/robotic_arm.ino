@@ -10,15 +10,57 @@
 #include "Config.h"
 #include "MotionController.h"
 #include "CommandParser.h"
+#include "CommandBus.h"
+#include "Perf.h"
 #include "Storage.h"
 #include "Sequencer.h"
+#ifndef HOST_BUILD
 #include <esp_task_wdt.h>
+#endif
 
 #include "RosInterface.h"
 
 // Configuração do Watchdog Timer (15 segundos)
 // #define WDT_TIMEOUT 15
 
+/**
+ * @brief Atende a Serial (e o micro-ROS). Só interpreta os comandos e os publica no
+ * CommandBus; quem os executa é o loop(), no core de movimento.
+ */
+void serviceComms()
+{
+  // Erros e avisos do core de movimento (ver CommandBus::printReplies)
+  CommandBus::printReplies();
+
+  {
+    PERF_SCOPE(Perf::SERIAL_INPUT);
+    CommandParser::handleSerialInput();
+  }
+  //RosInterface::update();
+
+  // Gravação adiada no log da flash: braço parado ou tempo sem edições (ver Storage::service)
+  Storage::service();
+
+  // Relatório periódico das sondas ('perf every <ms>')
+  Perf::update();
+}
+
+#if COMMS_USE_TASK
+/**
+ * @brief Task de comunicação fixada em COMMS_TASK_CORE. O parsing, os prints e o
+ * spin do micro-ROS não disputam mais o core com o tick de movimento.
+ */
+void commsTask(void *param)
+{
+  (void)param;
+  for (;;)
+  {
+    serviceComms();
+    vTaskDelay(1); // Cede o core (a Serial é lida a cada tick do FreeRTOS)
+  }
+}
+#endif
+
 /**
  * @brief Configuração inicial do sistema.
  */
@@ -26,7 +68,9 @@ void setup()
 {
   Serial.begin(115200);
   delay(2000); // Aguarda estabilização e sincronização com micro-ROS agent
-  Serial.println(F("\nIniciando Sistema do Braco Robotico v5.0..."));
+  Serial.print(F("\nIniciando Sistema do Braco Robotico v"));
+  Serial.print(FIRMWARE_VERSION);
+  Serial.println(F("..."));
   Serial.flush(); // Limpa buffer de saída
 
   // Configura o Watchdog Timer
@@ -34,11 +78,13 @@ void setup()
   // esp_task_wdt_add(NULL);               // Adiciona a task atual (loop)
   Serial.println(F("Watchdog Timer configurado (15s)."));
 
-  // Inicializa a memória EEPROM
+  // EEPROM legada: só lida na importação para o log da flash
   EEPROM.begin(EEPROM_SIZE);
 
+  // Estado, poses e macros do log da flash (importa a EEPROM antiga na primeira vez)
+  Storage::begin();
   // Carrega calibrações e última pose sem iniciar movimento automático
-  const bool hasCalibration = Storage::loadFromEEPROM(false);
+  const bool hasCalibration = Storage::loadState(false);
 
   // Configura os servos preservando os dados carregados quando disponíveis
   MotionController::setup(hasCalibration);
@@ -49,7 +95,7 @@ void setup()
   }
   else
   {
-    Serial.println(F("AVISO: EEPROM vazia ou inválida. Usando valores de fallback."));
+    Serial.println(F("AVISO: nenhum estado salvo. Usando valores de fallback."));
   }
 
   // Mostra o menu de ajuda inicial
@@ -57,6 +103,12 @@ void setup()
 
   // Inicializa micro-ROS (requer agente ativo via USB)
   //RosInterface::setup();
+
+#if COMMS_USE_TASK
+  // Comunicação no outro core; o loop() fica só com movimento, comandos e macros
+  xTaskCreatePinnedToCore(commsTask, "comms", COMMS_TASK_STACK_SIZE, NULL,
+                          COMMS_TASK_PRIORITY, NULL, COMMS_TASK_CORE);
+#endif
   Serial.println(F("Sistema inicializado. micro-ROS ativo."));
 }
 
@@ -69,18 +121,31 @@ void loop()
   // Reset do Watchdog Timer a cada iteração do loop
   // esp_task_wdt_reset();
 
+  PERF_SCOPE(Perf::LOOP); // Cada etapa abaixo também tem a sua sonda ('perf')
+
   // 1. Atualiza a máquina de estados do movimento (interpolação)
-  // Isso move fisicamente os servos a cada passo.
-  MotionController::update();
+  // Com MOTION_USE_TASK=1 a interpolação roda na task de tick fixo e esta chamada não faz nada;
+  // no modo legado ela executa o tick quando o período de MOTION_TICK_HZ tiver passado.
+  {
+    PERF_SCOPE(Perf::MOTION_UPDATE);
+    MotionController::update();
+  }
 
-  // 2. Atualiza a máquina de estados do sequenciador (macros)
-  // Isso verifica se um movimento terminou para iniciar uma espera ou o próximo passo.
-  Sequencer::update();
+  // 2. Executa os comandos publicados pela Serial/ROS (fila sem lock do CommandBus)
+  {
+    PERF_SCOPE(Perf::BUS_DISPATCH);
+    CommandBus::dispatch();
+  }
 
-  // 3. Verifica e processa novos comandos da Serial
-  // Isso lê a entrada do usuário.
-  CommandParser::handleSerialInput();
+  // 3. Atualiza a máquina de estados do sequenciador (macros)
+  // Isso verifica se um movimento terminou para iniciar uma espera ou o próximo passo.
+  {
+    PERF_SCOPE(Perf::SEQUENCER);
+    Sequencer::update();
+  }
 
-  // 4. Processa mensagens ROS (subscribers, publishers, timers)
-  //RosInterface::update();
+#if !COMMS_USE_TASK
+  // 4. Modo de um core: lê a Serial e processa mensagens ROS aqui mesmo
+  serviceComms();
+#endif
 }
@@ -50,6 +50,8 @@ class RobotArmBridge(Node):
             String, '/run_pose', self.callback_run_pose, 10)
         self.sub_joint_goals = self.create_subscription(
             JointState, '/joint_goals', self.callback_joint_goals, 10)
+        self.sub_arm_command = self.create_subscription(
+            String, '/arm_command', self.callback_arm_command, 10)
         
         # Timer para publicar estado (10 Hz)
         self.timer = self.create_timer(0.1, self.publish_state)
@@ -64,7 +66,7 @@ class RobotArmBridge(Node):
         
         self.get_logger().info('Bridge ROS 2 ↔ Serial inicializado!')
         self.get_logger().info('Tópicos ativos:')
-        self.get_logger().info('  SUB: /run_macro, /run_pose, /joint_goals')
+        self.get_logger().info('  SUB: /run_macro, /run_pose, /joint_goals, /arm_command')
         self.get_logger().info('  PUB: /joint_states, /arm_status')
     
     def rad_to_deg(self, rad):
@@ -102,8 +104,12 @@ class RobotArmBridge(Node):
                         # Detecta mensagens textuais do firmware (sem palavras-chave diretas)
                         if "Macro '" in line and "concluida" in line:
                             self.arm_status = "IDLE"
-                        if "Macro interrompida" in line:
+                        if "Macro interrompida" in line or "Parando" in line:
                             self.arm_status = "IDLE"
+                        if "pausad" in line:
+                            self.arm_status = "PAUSED"
+                        if "retomad" in line:
+                            self.arm_status = "MOVING"
                         
                         # Log de debug
                         if line and not line.startswith('---'):
@@ -140,6 +146,15 @@ class RobotArmBridge(Node):
         self.send_command(cmd)
         self.arm_status = "MOVING"
     
+    def callback_arm_command(self, msg):
+        """Callback para /arm_command ("stop", "pause" ou "resume")"""
+        command = msg.data.strip().lower()
+        if command not in ('stop', 'pause', 'resume'):
+            self.get_logger().warn(f'arm_command desconhecido: "{msg.data}" (use stop, pause ou resume)')
+            return
+        self.get_logger().info(f'ROS: Comando de controle "{command}"')
+        self.send_command(command)
+
     def publish_state(self):
         """Publica estado atual do braço (10 Hz)"""
         # Publicar joint_states